@@ -14,6 +14,35 @@
 
   Written by Luciano d'Ilori.
 
+  Version 8.18
+  Symbols are kept in an open addressing hash table instead of a sorted
+  linked list, and are sorted only for the symbol table of the listing.
+  Mnemonics and dot commands are looked up in hash tables, and each
+  instruction shares the one object of its mnemonic.
+  The code table grows with the program, so source files are no longer
+  limited to 4096 lines.  Only the object code is limited, by CODE_MAX_SIZE.
+  The code, the tokens and the linked lists are allocated in arenas that
+  are released at once.
+  Symbol and equate values are kept as integers instead of hex strings.
+  The listing and object files are collected in memory and written at once,
+  and hex digits come from a table of byte values.
+  asem8 assembles any number of source files, on a pool of threads.
+  asem8 -d assembles programs framed on standard input as a service.
+  asem8 -b also writes a binary object file, ending in ".pepb".
+  The assembler can be linked into other programs through asem8.h.
+  asem8 -c keeps the results of assemblies in a cache directory.
+  The source file is read at once and scanned in place, so source lines
+  are no longer limited to 1024 characters, and comments are not copied.
+  asem8 -s reports the time of each phase of an assembly and its size.
+  Source lines may end in <CR><LF>, so DOS files need not go through stripCR.
+  asem8 -P merges the execution counts of pep8 -P into the listing.
+  asem8 -y also writes a symbol file, ending in ".peps", for pep8 -g.
+  Threads of the pool left over after one per file generate the listing
+  and object code of large programs in chunks.
+  asem8 -d and bAssembleEdit assemble the edits of a program kept between
+  requests, parsing only the lines that changed.
+  October 2026
+
   Version 8.17
   Fixed a bug in the translation of hex constants and eliminated the warnings
   due to lack of default cases in switch statements and lack of possible return
@@ -73,6 +102,18 @@
 #include <iomanip>
 #include <ctype.h>
 #include <string>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <chrono>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "asem8.h"
 using namespace std;
 
 /*Constants*/
@@ -88,7 +129,13 @@ const int COMMENT_LENGTH_NONEMPTY_NO_SYMBOLS=44; /*Maximum comment length for no
 const int STRING_LENGTH=96; /*Maximum string length*/
 const int STRING_OPRND_LENGTH=4; /*string operands can be up to 4 hex digits long*/
 const int ADDR_MODE_LENGTH=3; /*Maximum length of addr. mode (eg. sxf)*/
-const int MAX_LINES=4096; /*pACode[MAX_LINES], pAMnemon[MAX_LINES]*/
+const int BINARY_HEADER_LENGTH=16; /*Bytes before the object code in a binary object file*/
+const int PROFILE_COLUMNS=19; /*Width of the count and percent columns of a listing with -P*/
+const char* const VERSION="Pep/8 Assembler, version Unix 8.18";
+const char* const OUTPUT_VERSION="2"; /*Part of the key of the assembly cache: bump it whenever the object code, listing or messages change*/
+const unsigned long long FNV_OFFSET=14695981039346656037ULL; /*64-bit FNV-1a hash, for the assembly cache*/
+const unsigned long long FNV_PRIME=1099511628211ULL;
+const int CODE_TABLE_MIN_SIZE=1024; /*Initial number of lines in pACode and pLineErrors*/
 const int BYTE=1; /*A byte is 1 byte*/
 const int WORD=2; /*A word is 2 bytes*/
 const int UNARY=1; /*A unary instruction takes up 1 byte*/
@@ -113,11 +160,16 @@ const int MAX_BYTE=255; /*Maximum decimal value for a byte*/
 const int MAX_DEC=65535; /*Maximum decimal value*/
 const int MIN_BYTE=-256; /*Minimum decimal value for a byte*/
 const int MIN_DEC=-32768; /*Minimum decimal value*/
-const int LINE_LENGTH=1024; /*Maximum length of a line of code*/
 const int CODE_MAX_SIZE=32768; /*Maximum number of bytes of code*/
 const int FILE_NAME_LENGTH=64; /*61 characters maximum in a file name*/
 const int UNIMPLEMENTED_INSTRUCTIONS = 8; /*Number of unimplemented mnemonics*/
 const int UNARY_TRAPS = 4; /*Number of unimplemented mnemonics guaranteed to be unary*/
+const int SYMBOL_TABLE_MIN_SIZE=256; /*Initial number of slots in pSymbolTable, a power of 2*/
+const int MNEMON_HASH_SIZE=128; /*Slots in iMnemonHash, a power of 2 at least twice eM_EMPTY*/
+const int DOT_HASH_SIZE=16; /*Slots in iDotHash, a power of 2 at least twice eD_EMPTY*/
+const int GENERATE_CHUNK_LINES=4096; /*Fewest lines a thread of vGenerateLines() generates*/
+const size_t ARENA_BLOCK_SIZE=65536; /*Bytes in each block of an Arena*/
+const size_t ARENA_ALIGN=8; /*Alignment of the objects allocated in an Arena, a power of 2*/
 
 /*Enumerated Types*/
 /*All possible mnemonics*/
@@ -160,38 +212,133 @@ enum ParseState{
     ePS_DOTCOMMAND, ePS_ASCII, ePS_EQUATE, ePS_CLOSE, ePS_FINISH
 };
 
+/*Phases of an assembly timed by -s*/
+enum Phase{
+    ePH_FIRSTPASS, ePH_RESOLVE, ePH_BURN, ePH_LISTING, ePH_OBJECT, ePH_EMPTY
+};
+
+/*Bump allocator.  Objects are carved out of large blocks and released all*/
+/*at once by vReset() or vRelease(), instead of one by one.*/
+class Arena{
+private:
+    struct sBlock{
+        sBlock* pNext; /*Next older block*/
+        size_t iSize; /*Bytes in the block, including this header*/
+    };
+    sBlock* pBlocks; /*Newest block, the one allocated from*/
+    char* pFree; /*First free byte of pBlocks*/
+    char* pEnd; /*End of pBlocks*/
+    long lAllocations; /*Objects allocated, for -s*/
+    long lBytes; /*Bytes allocated to them, for -s*/
+    static size_t iRoundUp (size_t iSize) { return (iSize + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1); }
+    void vNewBlock (size_t iSize){
+        size_t iBlockSize=iRoundUp (sizeof (sBlock)) + iSize;
+        if (iBlockSize<ARENA_BLOCK_SIZE){
+            iBlockSize=ARENA_BLOCK_SIZE;
+        }
+        sBlock* p=static_cast <sBlock*> (malloc (iBlockSize));
+        if (p == NULL){
+            throw bad_alloc ();
+        }
+        p->pNext=pBlocks;
+        p->iSize=iBlockSize;
+        pBlocks=p;
+        pFree=reinterpret_cast <char*> (p) + iRoundUp (sizeof (sBlock));
+        pEnd=reinterpret_cast <char*> (p) + iBlockSize;
+    }
+public:
+    Arena () : pBlocks (NULL), pFree (NULL), pEnd (NULL), lAllocations (0), lBytes (0) { }
+    ~Arena () { vRelease (); }
+    void* pAllocate (size_t iSize){
+        iSize=iRoundUp (iSize);
+        if (static_cast <size_t> (pEnd - pFree)<iSize){
+            vNewBlock (iSize);
+        }
+        void* p=pFree;
+        pFree+=iSize;
+        lAllocations++;
+        lBytes+=iSize;
+        return p;
+    }
+    /*Gives the memory of an object back only if it was the last one allocated*/
+    void vFree (void* p, size_t iSize){
+        if (static_cast <char*> (p) + iRoundUp (iSize) == pFree){
+            pFree=static_cast <char*> (p);
+        }
+    }
+    /*Frees every object, but keeps the newest block for the next ones*/
+    void vReset (){
+        if (pBlocks!=NULL){
+            sBlock* p=pBlocks->pNext;
+            pBlocks->pNext=NULL;
+            while (p!=NULL){
+                sBlock* q=p->pNext;
+                free (p);
+                p=q;
+            }
+            pFree=reinterpret_cast <char*> (pBlocks) + iRoundUp (sizeof (sBlock));
+        }
+    }
+    long lAllocationCount () const { return lAllocations; }
+    long lAllocatedBytes () const { return lBytes; }
+    /*Frees every object and every block*/
+    void vRelease (){
+        while (pBlocks!=NULL){
+            sBlock* p=pBlocks->pNext;
+            free (pBlocks);
+            pBlocks=p;
+        }
+        pFree=NULL;
+        pEnd=NULL;
+    }
+};
+
+thread_local Arena aCodeArena; /*Owns the code, symbol, comment and equate records of the assembly*/
+thread_local Arena aTokenArena; /*Owns the tokens of the current source line*/
+thread_local bool bEditSession=false; /*bAssembleEdit() keeps the program in aCodeArena between calls*/
+
+/*Base of the records that are allocated in aCodeArena.  While an edit session*/
+/*keeps them, none is given back, because a later line may still point to it.*/
+struct ArenaObject{
+    static void* operator new (size_t iSize) { return aCodeArena.pAllocate (iSize); }
+    static void operator delete (void* p, size_t iSize){
+        if (!bEditSession){
+            aCodeArena.vFree (p, iSize);
+        }
+    }
+};
+
 /*Global Records*/
 /*Contains .EQUATE symbols to be used in a linked list*/
-struct sEquateNode{
-    char cSymValue[ADDR_LENGTH + 1]; /*Value of symbol*/
+struct sEquateNode : public ArenaObject{
+    int iSymValue; /*Value of symbol, 0 to MAX_DEC*/
     char cSymID[IDENT_LENGTH + 1]; /*Symbol identification*/
     sEquateNode* pNext;
 };
 /*Record for symbol declarations*/
-struct sSymbolNode{
-    char cSymValue[ADDR_LENGTH + 1]; /*Value of symbol*/
+struct sSymbolNode : public ArenaObject{
+    int iSymValue; /*Value of symbol, 0 to MAX_DEC*/
     int iLine;
     char cSymID[IDENT_LENGTH + 1]; /*Symbol name*/
-    sSymbolNode* pNext; /*Pointer to next sSymbolNode in the linked list*/
 };
 /*Record for symbol output declarations*/
-struct sSymbolOutputNode{
+struct sSymbolOutputNode : public ArenaObject{
     int iLine;
     char cSymID[IDENT_LENGTH + 1]; /*Symbol name*/
     sSymbolOutputNode* pNext; /*Pointer to next sSymbolOutputNode in the linked list*/
 };
 /*Record for symbol declarations*/
-struct sUndeclaredsSymbolNode{
-    char cSymValue[ADDR_LENGTH + 1]; /*Value of symbol*/
+struct sUndeclaredsSymbolNode : public ArenaObject{
     int iLine;
     char cSymID[IDENT_LENGTH + 1]; /*Symbol identification*/
     sUndeclaredsSymbolNode* pNext; /*Pointer to next sSymbolNode in the linked list*/
 };
 /*Contains information about comments to be used in a linked list*/
-struct sCommentNode{
+struct sCommentNode : public ArenaObject{
     int iLine;
     bool bNonemptyLine;
-    char cComment[COMMENT_LENGTH + 1];
+    const char* pText; /*The comment in sSourceText, not terminated*/
+    int iLength;
     sCommentNode* pNext;
 };
 
@@ -201,26 +348,92 @@ struct sUnimplementedMnemonNode{
     int iAddrMode;
 };
 
-/*Global Variables (part 1)*/
-ifstream in_file;
-ofstream out_file;
-char cLine[LINE_LENGTH]; /*Array of characters for a line of code*/
-int iLineIndex; /*Index of line array*/
-int iSecPassCodeIndex=0; /*Used in second pass of assembly to account for symbols*/
-int iCurrentAddress=0; /*Keeps track of the current address*/
-sSymbolNode* pSymbol; /*Pointer to linked list of sSymbolNodes*/
-sSymbolOutputNode* pSymbolOutput; /*Pointer to linked list of sSymbolNodes for output*/
-sUndeclaredsSymbolNode* pUndeclaredSym; /*Pointer to linked list of sUndeclaredsSymbolNodes*/
-sCommentNode* pComment=NULL; /*Pointer to first sCommentNode of the comment linked list*/
-sEquateNode* pEquate=NULL; /*Pointer to first sEquateNode of the .EQUATE linked list*/
+/*Output file that is collected in memory and handed to sTarget by close()*/
+class OutputBuffer{
+private:
+    string sBuffer; /*Contents of the file*/
+    string* pTarget;
+public:
+    OutputBuffer () : pTarget (NULL) { }
+    void open (string& sTarget){
+        pTarget=&sTarget;
+        sBuffer.clear();
+    }
+    void close (){
+        pTarget->swap(sBuffer);
+        sBuffer.clear();
+    }
+    OutputBuffer& operator<< (const char cStr[]) { sBuffer.append(cStr); return *this; }
+    OutputBuffer& operator<< (char ch) { sBuffer.push_back(ch); return *this; }
+    OutputBuffer& write (const char cStr[], size_t iLength) { sBuffer.append(cStr, iLength); return *this; }
+    OutputBuffer& operator<< (ostream& (*)(ostream&)) { sBuffer.push_back('\n'); return *this; } /*endl*/
+    size_t size () const { return sBuffer.size(); }
+    void vCutFrom (size_t iPos, string& sTail){ /*Moves the contents from iPos on to sTail*/
+        sTail.assign(sBuffer, iPos, string::npos);
+        sBuffer.resize(iPos);
+    }
+};
+
+/*Time and size of one assembly, for -s*/
+struct sAssemblyStatistics{
+    bool bCacheHit; /*Read from the assembly cache, so not assembled*/
+    double dPhaseSeconds[ePH_EMPTY];
+    long lLines;
+    long lSymbols;
+    long lTokens;
+    long lAllocations; /*Arena objects*/
+    long lBytes; /*and the bytes they take*/
+};
+
+/*A source file named on the command line and the result of assembling it*/
+struct sSourceFile{
+    char cName[FILE_NAME_LENGTH];
+    int iStatus; /*Returned by iAssembleFile()*/
+    string sReport; /*Error messages for stderr*/
+};
+
+/*Global Variables (part 1).  Each assembler thread has its own state, the*/
+/*mnemonic, dot command and trap tables are shared.*/
+bool bBinaryObject=false; /*Set by -b, also write a binary object file*/
+bool bStatistics=false; /*Set by -s, report the time and size of each assembly*/
+string sCacheDir; /*Set by -c, directory of the assembly cache, empty for none*/
+long* pProfileCount=NULL; /*Set by -P, executions of the instruction at each address*/
+bool bSymbolFile=false; /*Set by -y, also write a symbol file, ending in ".peps"*/
+int iGenerateThreads=1; /*Threads that generate the listing and object code of one large assembly*/
+long lProfileTotal=0; /*Instructions executed in all*/
+unsigned long long lCacheSeed; /*Hash of the assembler version and the trap file*/
+thread_local string sSourceText; /*The text being assembled, ending in an extra '\n'*/
+thread_local const char* pNextLine; /*Where the line after cLine starts in sSourceText*/
+thread_local const char* pSourceEnd; /*The end of sSourceText*/
+thread_local OutputBuffer out_file;
+thread_local ostringstream err_file; /*Error messages of the source file being assembled*/
+thread_local string sSymbolText; /*The symbol file of the last assembly, with -y*/
+thread_local sAssemblyStatistics statistics; /*Of the last assembly on this thread*/
+thread_local long lTokenCount=0; /*Tokens read by vGetToken()*/
+thread_local const char* cLine; /*The current line of code, in sSourceText and ending in '\n'*/
+thread_local int iLineIndex; /*Index of line array*/
+thread_local int iSecPassCodeIndex=0; /*Used in second pass of assembly to account for symbols*/
+thread_local int iCurrentAddress=0; /*Keeps track of the current address*/
+thread_local sSymbolNode** pSymbolTable=NULL; /*Open addressing hash table of sSymbolNodes, NULL if a slot is free*/
+thread_local int iSymbolTableSize=0; /*Number of slots in pSymbolTable, a power of 2*/
+thread_local int iSymbolCount=0; /*Number of symbols in pSymbolTable*/
+thread_local sSymbolOutputNode* pSymbolOutput; /*Pointer to linked list of sSymbolNodes for output*/
+thread_local sSymbolOutputNode* pSymbolOutputTail=NULL; /*Last node of pSymbolOutput*/
+thread_local sUndeclaredsSymbolNode* pUndeclaredSym; /*Pointer to linked list of sUndeclaredsSymbolNodes*/
+thread_local sUndeclaredsSymbolNode* pUndeclaredSymTail=NULL; /*Last node of pUndeclaredSym*/
+thread_local sCommentNode* pComment=NULL; /*Pointer to first sCommentNode of the comment linked list*/
+thread_local sCommentNode* pCommentTail=NULL; /*Last node of pComment*/
+thread_local sEquateNode* pEquate=NULL; /*Pointer to first sEquateNode of the .EQUATE linked list*/
 char cDotTable[eD_EMPTY + 1][IDENT_LENGTH + 1]; /*Used for vLookUpDot()*/
 char cMnemonTable [eM_EMPTY + 1][IDENT_LENGTH + 1]; /*Used for vLookUpMnemon()*/
-int iHexOutputBuffer=0; /*Used for object code output for 16 bytes per line*/
-bool bIsAscii=false; /*Keeps track of whether previous token was .ASCII pseudo-op*/
-int iBurnStart=0; /*Used first to  store the value of the operand of a .BURN*/
+int iDotHash[DOT_HASH_SIZE]; /*Hash table of the DotCommand in cDotTable, eD_EMPTY if a slot is free*/
+int iMnemonHash[MNEMON_HASH_SIZE]; /*Hash table of the Mnemon in cMnemonTable, eM_EMPTY if a slot is free*/
+thread_local int iHexOutputBuffer=0; /*Used for object code output for 16 bytes per line*/
+thread_local bool bIsAscii=false; /*Keeps track of whether previous token was .ASCII pseudo-op*/
+thread_local int iBurnStart=0; /*Used first to  store the value of the operand of a .BURN*/
 /*and then to  store the value of where the first byte of code should be written.*/
-int iBurnAddr=0; /*Used to store the address of a .BURN line*/
-int iBurnCounter=0; /*Keeps track of number of .BURNs used in the program.*/
+thread_local int iBurnAddr=0; /*Used to store the address of a .BURN line*/
+thread_local int iBurnCounter=0; /*Keeps track of number of .BURNs used in the program.*/
 sUnimplementedMnemonNode sUnimpMnemon [UNIMPLEMENTED_INSTRUCTIONS]; /*Array of unimplemented mnemon nodes*/
 /* Global variables continued after class ACode declaration*/
 
@@ -236,17 +449,63 @@ bool bIsHex(char& ch){
         return false;
 }
 
-/*Stores the next line of assembly language code to be translated in global cLine[].*/
+/*Makes sText the source text read by vGetLine().  Every line of it ends in '\n',*/
+/*so the text is scanned in place and lines have no length limit.  A line*/
+/*ending in "\r\n", as in a DOS file, ends in '\n' like the others.*/
+void vSetSource (const string& sText){
+    size_t iCR=sText.find('\r');
+    sSourceText.reserve(sText.size() + 1);
+    if (iCR == string::npos){
+        sSourceText.assign(sText);
+    }
+    else{
+        sSourceText.assign(sText, 0, iCR);
+        for (size_t i=iCR; i<sText.size(); i++){
+            if ((sText[i]!='\r') || (i + 1 == sText.size()) || (sText[i + 1]!='\n')){
+                sSourceText.push_back(sText[i]);
+            }
+        }
+    }
+    sSourceText.push_back('\n');
+    pNextLine=sSourceText.data();
+    pSourceEnd=pNextLine + sSourceText.size();
+}
+
+/*True when vGetLine() has returned the last line of the source text*/
+bool bEndOfSource (){
+    return pNextLine>=pSourceEnd;
+}
+
+/*Points global cLine at the next line of assembly language code to be translated.*/
+/*Past the end of the source text, that is an empty line.*/
 void vGetLine(){
-    in_file.getline(cLine, LINE_LENGTH);
-    if ((!in_file.eof ()) && (in_file.gcount()>0))
-        cLine[in_file.gcount() - 1]='\n';
+    if (bEndOfSource()){
+        cLine="\n";
+    }
     else{
-        cLine[in_file.gcount()]='\n';
+        cLine=pNextLine;
+        pNextLine=static_cast <const char*> (memchr(cLine, '\n', pSourceEnd - cLine)) + 1;
     }
     iLineIndex=0;
 }
 
+/*Lists the comment of the line being generated, if it has one.  A comment*/
+/*after code is cut to fit the width left on the line.*/
+void vOutputComment (){
+    if ((pComment!=NULL) && (pComment->iLine == iSecPassCodeIndex)){
+        int iLength=pComment->iLength;
+        if (pComment->bNonemptyLine){
+            int iWidth=((iSymbolCount == 0) ? COMMENT_LENGTH_NONEMPTY_NO_SYMBOLS : COMMENT_LENGTH_NONEMPTY) - 1;
+            iLength=(iLength>iWidth) ? iWidth : iLength;
+        }
+        out_file << ";";
+        out_file.write(pComment->pText, iLength);
+        sCommentNode* p=pComment;
+        pComment=pComment->pNext;
+        delete p;
+    }
+}
+
 /*Gets the next character to be processed by vGetToken().*/
 void vAdvanceInput (char& ch){
     ch=cLine[iLineIndex++];
@@ -259,7 +518,7 @@ void vBackUpInput (){
 
 /*Outputs the version number of the Pep/8 assembler*/
 void vVersionNumber (){
-    cerr << "Pep/8 Assembler, version Unix 8.17" << endl;
+    cerr << VERSION << endl;
 }
 
 /*Converts a hexadecimal number to a decimal number and returns the decimal number.*/
@@ -285,29 +544,6 @@ int iHexToDec (char ch){
     }
 }
 
-/*Converts a decimal number(0-15) to a hexadecimal number(0-F) and returns the hex number.*/
-char cDecToHex (int i){
-    switch (i){
-    case 0: return '0'; break;
-    case 1: return '1'; break;
-    case 2: return '2'; break;
-    case 3: return '3'; break;
-    case 4: return '4'; break;
-    case 5: return '5'; break;
-    case 6: return '6'; break;
-    case 7: return '7'; break;
-    case 8: return '8'; break;
-    case 9: return '9'; break;
-    case 10: return 'A'; break;
-    case 11: return 'B'; break;
-    case 12: return 'C'; break;
-    case 13: return 'D'; break;
-    case 14: return 'E'; break;
-    case 15: return 'F'; break;
-    default: return ' '; // Should not occur
-    }
-}
-
 /*Converts a hexadecimal byte to a positive decimal integer*/
 //int iHexByteToDecInt (char cHex[HEX_LENGTH + 1]){
 //   return HEX * iHexToDec(cHex[0]) + iHexToDec(cHex[1]);
@@ -318,39 +554,50 @@ int iHexWordToDecInt (char cHex[HEX_LENGTH + 1]){
     return HEX3 * iHexToDec(cHex[0]) + HEX2 * iHexToDec(cHex[1]) + HEX * iHexToDec(cHex[2]) + iHexToDec(cHex[3]);
 }
 
+/*The two hex digits of each byte, HEX_PAIRS[2 * i] and HEX_PAIRS[2 * i + 1] for byte i*/
+const char HEX_PAIRS[]=
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
 /*Converts a decimal value between -256 to 255 to a hexadecimal array of characters*/
 void vDecToHexByte (int iDec, char cHex[BYTE_LENGTH + 1]){
-    if (iDec<0){
-        iDec=iDec + MAX_BYTE + 1;
-    }
-    cHex[0]=cDecToHex(iDec / HEX);
-    cHex[1]=cDecToHex(iDec % HEX);
+    iDec&=MAX_BYTE;
+    cHex[0]=HEX_PAIRS[2 * iDec];
+    cHex[1]=HEX_PAIRS[2 * iDec + 1];
     cHex[2]='\0';
 }
 
 /*Converts a decimal value between -32768 and 65535 to a hexadecimal array of characters*/
 void vDecToHexWord (int iDec, char cHex[ADDR_LENGTH + 1]){
-    int iFirstInt;
-    int iSecondInt;
-    int iThirdInt;
-    int iFourthInt;
-    if (iDec<0){
-        iDec=iDec + MAX_DEC + 1;
-    }
-    if (iDec>MAX_DEC){
-        iDec=iDec - (MAX_DEC + 1);
-    }
-    iFirstInt=iDec / HEX3;
-    iSecondInt=(iDec - HEX3 * iFirstInt) / HEX2;
-    iThirdInt=(iDec - HEX3 * iFirstInt - iSecondInt * HEX2) / HEX;
-    iFourthInt=(iDec - HEX3 * iFirstInt - iSecondInt * HEX2 - iThirdInt * HEX);
-    cHex[0]=cDecToHex(iFirstInt);
-    cHex[1]=cDecToHex(iSecondInt);
-    cHex[2]=cDecToHex(iThirdInt);
-    cHex[3]=cDecToHex(iFourthInt);
+    iDec&=MAX_DEC;
+    int iHigh=iDec / HEX2;
+    int iLow=iDec % HEX2;
+    cHex[0]=HEX_PAIRS[2 * iHigh];
+    cHex[1]=HEX_PAIRS[2 * iHigh + 1];
+    cHex[2]=HEX_PAIRS[2 * iLow];
+    cHex[3]=HEX_PAIRS[2 * iLow + 1];
     cHex[4]='\0';
 }
 
+/*Wraps a decimal value between -65536 and 131071 to a word between 0 and MAX_DEC*/
+int iWordValue (int iDec){
+    return iDec & MAX_DEC;
+}
+
 /*Converts an array of char (decimal constant) to int using FSM implementation.*/
 int iCharToInt (char ch []){
     enum CIState {eCIS_START, eCIS_iSign, eCIS_INTEGER};
@@ -457,17 +704,84 @@ bool bSearchAddrModes (char cAddrMode[], int iAddrMode){
     return false; // Should not occur
 }
 
-/*Gives cValue[] the cValue of the symbol named in cID[]*/
-/*assertion: symbol has been defined*/
-void vGetSymbolValue(char cID[], char cValue[]){
-    sSymbolNode* pTemp=pSymbol;
-    while (pTemp!=NULL){
-        if (strcmp(cID, pTemp->cSymID) == 0){
-            strncpy(cValue, pTemp->cSymValue, HEX_LENGTH + 1);
-            return;
+/*Symbol table functions*/
+/*FNV-1a hash of the symbol name cID[]*/
+unsigned int iSymbolHash (const char cID[]){
+    unsigned int iHash=2166136261u;
+    while (*cID!='\0'){
+        iHash=(iHash ^ static_cast <unsigned char> (*cID++)) * 16777619u;
+    }
+    return iHash;
+}
+
+/*Returns the slot of pSymbolTable that holds the symbol named cID[],*/
+/*or the free slot where it belongs*/
+sSymbolNode** pFindSymbolSlot (const char cID[]){
+    unsigned int iSlot=iSymbolHash(cID) & (iSymbolTableSize - 1);
+    while ((pSymbolTable[iSlot]!=NULL) && (strcmp(cID, pSymbolTable[iSlot]->cSymID)!=0)){
+        iSlot=(iSlot + 1) & (iSymbolTableSize - 1); /*Linear probing*/
+    }
+    return &pSymbolTable[iSlot];
+}
+
+/*Doubles the size of pSymbolTable, or allocates it the first time*/
+void vGrowSymbolTable (){
+    sSymbolNode** pOldTable=pSymbolTable;
+    int iOldSize=iSymbolTableSize;
+    int i;
+    iSymbolTableSize=(iOldSize == 0) ? SYMBOL_TABLE_MIN_SIZE : 2 * iOldSize;
+    pSymbolTable=new sSymbolNode*[iSymbolTableSize];
+    for (i=0; i<iSymbolTableSize; i++){
+        pSymbolTable[i]=NULL;
+    }
+    for (i=0; i<iOldSize; i++){
+        if (pOldTable[i]!=NULL){
+            *pFindSymbolSlot(pOldTable[i]->cSymID)=pOldTable[i];
         }
-        pTemp=pTemp->pNext;
     }
+    delete [] pOldTable;
+}
+
+/*Returns the symbol named cID[], or NULL if it has not been declared*/
+sSymbolNode* pFindSymbol (const char cID[]){
+    if (iSymbolCount == 0){
+        return NULL;
+    }
+    return *pFindSymbolSlot(cID);
+}
+
+int iCompareSymbols (const void* p, const void* q){
+    return strcmp ((*static_cast <sSymbolNode* const*> (p))->cSymID,
+                   (*static_cast <sSymbolNode* const*> (q))->cSymID);
+}
+
+/*Returns a new array of the iSymbolCount symbols sorted by name,*/
+/*for the symbol table of the assembler listing*/
+sSymbolNode** pSortedSymbols (){
+    sSymbolNode** pSorted=new sSymbolNode*[iSymbolCount];
+    int i, j=0;
+    for (i=0; i<iSymbolTableSize; i++){
+        if (pSymbolTable[i]!=NULL){
+            pSorted[j++]=pSymbolTable[i];
+        }
+    }
+    qsort (pSorted, iSymbolCount, sizeof (sSymbolNode*), iCompareSymbols);
+    return pSorted;
+}
+
+/*Deallocates pSymbolTable.  Its symbols are released with aCodeArena.*/
+void vDeleteSymbolTable (){
+    delete [] pSymbolTable;
+    pSymbolTable=NULL;
+    iSymbolTableSize=0;
+    iSymbolCount=0;
+}
+
+/*Returns the value of the symbol named in cID[]*/
+/*assertion: symbol has been defined*/
+int iGetSymbolValue(char cID[]){
+    sSymbolNode* pTemp=pFindSymbol(cID);
+    return (pTemp!=NULL) ? pTemp->iSymValue : 0;
 }
 
 /*Continues the output following the first line of object code in the assembler*/
@@ -686,7 +1000,7 @@ void vBlankSymbolColumn (){
 }
 
 void vOutputSymbolDecs (){
-    if (pSymbol!=NULL){
+    if (iSymbolCount>0){
         if ((pSymbolOutput!=NULL) && (pSymbolOutput->iLine == iSecPassCodeIndex)){
             out_file << pSymbolOutput->cSymID;
             vSymbolBuffer (pSymbolOutput->cSymID);
@@ -714,6 +1028,8 @@ class AToken {
 public:
     virtual Key kTokenType ()=0;
     virtual ~AToken() { };
+    static void* operator new (size_t iSize) { return aTokenArena.pAllocate (iSize); }
+    static void operator delete (void* p, size_t iSize) { aTokenArena.vFree (p, iSize); }
 };
 
 class TAddress : public AToken{
@@ -764,10 +1080,11 @@ public:
 
 class TComment : public AToken{
 private:
-    char cCommentValue[COMMENT_LENGTH + 1];
+    const char* pCommentValue; /*In sSourceText*/
+    int iCommentLength;
 public:
-    TComment (char str[]) { strncpy (cCommentValue, str, COMMENT_LENGTH + 1); }
-    void vGetValue (char str[]) { strncpy (str, cCommentValue, COMMENT_LENGTH + 1); }
+    TComment (const char* p, int iLength) : pCommentValue (p), iCommentLength (iLength) { }
+    void vGetValue (const char*& p, int& iLength) { p=pCommentValue; iLength=iCommentLength; }
     Key kTokenType () { return eT_COMMENT; }
 };
 
@@ -1415,7 +1732,7 @@ public:
 
 /*Abstract Code Class*/
 
-class ACode{
+class ACode : public ArenaObject{
 public:
     virtual ~ACode () {};
     virtual bool bIsError ()=0;
@@ -1423,9 +1740,33 @@ public:
 };
 
 /*Global variables, part 2*/
-AToken* pPrevAT=new TEmpty; /*Used to detect strings in vGetToken() if .ASCII was previous token*/
-ACode* pACode[MAX_LINES + 1];/*Array of pointers to abstract code*/
-int iCodeIndex; /*Used as index of pACode and pAMnemon arrays*/
+thread_local ACode** pACode=NULL;/*Array of pointers to abstract code, one for each source line*/
+thread_local int* pLineErrors=NULL; /*Keeps track of lines containing errors*/
+thread_local int iCodeTableSize=0; /*Number of lines in pACode, pLineErrors has two more*/
+thread_local int iCodeIndex; /*Used as index of pACode and pAMnemon arrays*/
+AMnemon* pAMnemonTable[eM_EMPTY]; /*One shared object for each mnemonic, made by vInitMnemonObjects()*/
+
+/*Doubles the size of pACode and pLineErrors, or allocates them the first time*/
+void vGrowCodeTable (){
+    ACode** pOldCode=pACode;
+    int* pOldErrors=pLineErrors;
+    int iOldSize=iCodeTableSize;
+    int i;
+    iCodeTableSize=(iOldSize == 0) ? CODE_TABLE_MIN_SIZE : 2 * iOldSize;
+    pACode=new ACode*[iCodeTableSize];
+    pLineErrors=new int[iCodeTableSize + 2](); /*Zero filled like the static table it replaced*/
+    for (i=0; i<iOldSize; i++){
+        pACode[i]=pOldCode[i];
+    }
+    for (i=iOldSize; i<iCodeTableSize; i++){
+        pACode[i]=NULL;
+    }
+    if (iOldSize>0){
+        memcpy(pLineErrors, pOldErrors, (iOldSize + 2) * sizeof(int));
+    }
+    delete [] pOldCode;
+    delete [] pOldErrors;
+}
 
 /*Error class*/
 
@@ -1438,258 +1779,251 @@ class eNoEnd : public Error
 {
 public:
     void vGenerateCode (){
-        cerr << "Missing .END sentinal" << endl;
-    }
-};
-
-class eTooLong : public Error{
-public:
-    void vGenerateCode (){
-        cerr << "Program too long. Listing table overflow." << endl;
+        err_file << "Missing .END sentinal" << endl;
     }
 };
 
 class eSymPrevDef : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Symbol previously defined." << endl;
+        err_file << "Symbol previously defined." << endl;
     }
 };
 
 class eProgTooLong : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Program too long. Code table overflow." << endl;
+        err_file << "Program too long. Code table overflow." << endl;
     }
 };
 
 class eInstrDotExp : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Instruction or dot command expected." << endl;
+        err_file << "Instruction or dot command expected." << endl;
     }
 };
 
 class eInvSyntax : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Invalid syntax." << endl;
+        err_file << "Invalid syntax." << endl;
     }
 };
 
 class eSymInstrDotExp : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Symbol, instruction, or dot command expected." << endl;
+        err_file << "Symbol, instruction, or dot command expected." << endl;
     }
 };
 
 class eInvMnemon : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Invalid Mnemonic." << endl;
+        err_file << "Invalid Mnemonic." << endl;
     }
 };
 
 class eCommExp : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Comment expected." << endl;
+        err_file << "Comment expected." << endl;
     }
 };
 
 class eCommentTooLong : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Comment too long." << endl;
+        err_file << "Comment too long." << endl;
     }
 };
 
 class eOprndSpecExp : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Operand specifier expected." << endl;
+        err_file << "Operand specifier expected." << endl;
     }
 };
 
 class eNoDecConst : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Invalid decimal constant." << endl;
+        err_file << "Invalid decimal constant." << endl;
     }
 };
 
 class eNoHexConst : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Invalid hexadecimal constant." << endl;
+        err_file << "Invalid hexadecimal constant." << endl;
     }
 };
 
 class eNoCharConst : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Invalid character constant." << endl;
+        err_file << "Invalid character constant." << endl;
     }
 };
 
 class eAddrExp : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Addressing mode expected." << endl;
+        err_file << "Addressing mode expected." << endl;
     }
 };
 
 class eAddrCommExp : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Addressing mode or comment expected." << endl;
+        err_file << "Addressing mode or comment expected." << endl;
     }
 };
 
 class eNoAddr : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Invalid addressing mode." << endl;
+        err_file << "Invalid addressing mode." << endl;
     }
 };
 
 class eNoAddrmode : public Error{
 public:
     void vGenerateCode (){
-        cerr << "This instruction cannot have this addressing mode." << endl;
+        err_file << "This instruction cannot have this addressing mode." << endl;
     }
 };
 
 class eDecOverflow : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Decimal overflow. Range is -32768 to 65535." << endl;
+        err_file << "Decimal overflow. Range is -32768 to 65535." << endl;
     }
 };
 
 class eNoDotCom : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Invalid dot command." << endl;
+        err_file << "Invalid dot command." << endl;
     }
 };
 
 class eNoString : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Invalid string expression." << endl;
+        err_file << "Invalid string expression." << endl;
     }
 };
 
 class eDecHexExp : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Decimal or hex constant expected." << endl;
+        err_file << "Decimal or hex constant expected." << endl;
     }
 };
 
 class eConstExp : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Constant expected." << endl;
+        err_file << "Constant expected." << endl;
     }
 };
 
 class eNoAddrModeWithChar : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Addressing mode always required with char constant operands." << endl;
+        err_file << "Addressing mode always required with char constant operands." << endl;
     }
 };
 
 class eNoAddrModeWithString : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Addressing mode always required with string operands." << endl;
+        err_file << "Addressing mode always required with string operands." << endl;
     }
 };
 
 class eSymExpWithAddrss : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Symbol required after .ADDRSS pseudo-op." << endl;
+        err_file << "Symbol required after .ADDRSS pseudo-op." << endl;
     }
 };
 
 class eSymBeforeEquate : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Symbol required before .EQUATE pseudo-op." << endl;
+        err_file << "Symbol required before .EQUATE pseudo-op." << endl;
     }
 };
 
 class eConstOverflow : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Constant overflow. Range is 0 to 255 (dec)." << endl;
+        err_file << "Constant overflow. Range is 0 to 255 (dec)." << endl;
     }
 };
 
 class eByteOutOfRange : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Byte value out of range." << endl;
+        err_file << "Byte value out of range." << endl;
     }
 };
 
 class eSymNotDefined : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Reference to undefined symbol." << endl;
+        err_file << "Reference to undefined symbol." << endl;
     }
 };
 
 class eAddrOverflow : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Address overflow. Range is 0 to 65535 (dec)." << endl;
+        err_file << "Address overflow. Range is 0 to 65535 (dec)." << endl;
     }
 };
 
 class eOneBurn : public Error{
 public:
     void vGenerateCode (){
-        cerr << "More than one .BURN pseudo-op not allowed in program." << endl;
+        err_file << "More than one .BURN pseudo-op not allowed in program." << endl;
     }
 };
 
 class eStrOprndTooLong : public Error{
 public:
     void vGenerateCode (){
-        cerr << "The string is too long to be a valid operand." << endl;
+        err_file << "The string is too long to be a valid operand." << endl;
     }
 };
 
 class eByteStrTooLong : public Error{
 public:
     void vGenerateCode (){
-        cerr << "The string is too long to be used with .BYTE pseudo-op." << endl;
+        err_file << "The string is too long to be used with .BYTE pseudo-op." << endl;
     }
 };
 
 class eWordStrTooLong : public Error{
 public:
     void vGenerateCode (){
-        cerr << "The string is too long to be used with .WORD pseudo-op." << endl;
+        err_file << "The string is too long to be used with .WORD pseudo-op." << endl;
     }
 };
 class eEquateStrTooLong : public Error{
 public:
     void vGenerateCode (){
-        cerr << "The string is too long to be used with .EQUATE pseudo-op." << endl;
+        err_file << "The string is too long to be used with .EQUATE pseudo-op." << endl;
     }
 };
 
 class eOperandUnexp : public Error{
 public:
     void vGenerateCode (){
-        cerr << "Unexpected operand specifier." << endl;
+        err_file << "Unexpected operand specifier." << endl;
     }
 };
 
@@ -1704,6 +2038,8 @@ public:
     virtual int iAddressCounter ()=0; /*Returns how many bytes each class takes up*/
     virtual void vGenerateHexCode (bool asemList)=0; /*Generates the object code*/
     virtual void vBurnAddressChange ()=0; /*Changes iAddress to account for a .BURN*/
+    virtual int iInstructionAddress () { return -1; } /*Address of an instruction, -1 for other lines*/
+    bool bIsEquate () { return (iInstructionAddress()<0) && (dotcom == eD_EQUATE); }
 };
 
 class ZeroArg : public Valid{
@@ -1752,9 +2088,9 @@ public:
         pAMnemonic=pAMnemonTemp;
         strncpy (cFirstArg, fArg, IDENT_LENGTH + 1);
     }
-    ~UnaryInstruction () { delete pAMnemonic; }
     int iAddressCounter () { return UNARY; }
     void vBurnAddressChange () { iAddress+=iBurnStart; }
+    int iInstructionAddress () { return iAddress; }
     void vGenerateCode (){
         char cAddr[ADDR_LENGTH + 1];
         vDecToHexWord (iAddress, cAddr);
@@ -1789,17 +2125,19 @@ private:
     int iAddress;
     char cFirstArg[IDENT_LENGTH + 1];
     char cSecondArg[DEC_LENGTH + 1];
+    int iValue; /*Value of cSecondArg*/
 public:
     DotComDec (int iAddr, DotCommand dot, char fArg[], char sArg[]){
         iAddress=iAddr;
         dotcom=dot;
         strncpy (cFirstArg, fArg, IDENT_LENGTH + 1);
         strncpy (cSecondArg, sArg, DEC_LENGTH + 1);
+        iValue=iCharToInt(cSecondArg);
     }
     int iAddressCounter(){
         switch (dotcom){
         case eD_BLOCK:
-            return iCharToInt(cSecondArg);
+            return iValue;
             break;
         case eD_BURN:
             return 0;
@@ -1819,7 +2157,7 @@ public:
     }
     void vBurnAddressChange () { iAddress+=iBurnStart; }
     void vGenerateCode (){
-        int iDec=iCharToInt(cSecondArg);
+        int iDec=iValue;
         char cAddr[ADDR_LENGTH + 1];
                 
         if (dotcom!=eD_EQUATE){
@@ -1840,20 +2178,7 @@ public:
         vDotCommandBuffer(cFirstArg);
         out_file << cSecondArg;
         vOperandBuffer(cSecondArg, true);
-        if ((pComment!=NULL) && (pComment->iLine == iSecPassCodeIndex)){
-            if (pComment->bNonemptyLine){
-                if (pSymbol == NULL){
-                    pComment->cComment[COMMENT_LENGTH_NONEMPTY_NO_SYMBOLS - 1]='\0';
-                }
-                else{
-                    pComment->cComment[COMMENT_LENGTH_NONEMPTY - 1]='\0';
-                }
-            }
-            out_file << ";" << pComment->cComment;
-            sCommentNode* p=pComment;
-            pComment=pComment->pNext;
-            delete p;
-        }
+        vOutputComment();
         if ((dotcom == eD_BLOCK) && (iDec>OBJ_CODE_LENGTH / BYTE_LENGTH) &&
             ((iBurnCounter == 0) || (iAddress>=iBurnAddr))){
             vDotBlockOutputContinued(iDec - OBJ_CODE_LENGTH / BYTE_LENGTH);
@@ -1861,7 +2186,7 @@ public:
     }
     void vGenerateHexCode (bool asemList){
         int i;
-        int iDec=iCharToInt(cSecondArg);
+        int iDec=iValue;
         char cVal[ADDR_LENGTH + 1];
         int lineCounter=0;
         if (asemList){
@@ -1998,20 +2323,7 @@ public:
             out_file << "0x" << cSecondArg[2] << cSecondArg[3];
             vOperandBuffer(cSecondArg, true);/*true compensates for the 2 spaces*/
         }
-        if ((pComment!=NULL) && (pComment->iLine == iSecPassCodeIndex)){
-            if (pComment->bNonemptyLine){
-                if (pSymbol == NULL){
-                    pComment->cComment[COMMENT_LENGTH_NONEMPTY_NO_SYMBOLS - 1]='\0';
-                }
-                else{
-                    pComment->cComment[COMMENT_LENGTH_NONEMPTY - 1]='\0';
-                }
-            }
-            out_file << ";" << pComment->cComment;
-            sCommentNode* p=pComment;
-            pComment=pComment->pNext;
-            delete p;
-        }
+        vOutputComment();
         if ((dotcom == eD_BLOCK) && (iDec>OBJ_CODE_LENGTH / BYTE_LENGTH) && ((iBurnCounter == 0) || (iAddress>=iBurnAddr))){
             vDotBlockOutputContinued(iDec - OBJ_CODE_LENGTH / BYTE_LENGTH);
         }
@@ -2137,20 +2449,7 @@ public:
         vDotCommandBuffer(cFirstArg);
         out_file << "\'" << cSecondArg << "\'";
         vOperandBuffer(cSecondArg, false);
-        if ((pComment!=NULL) && (pComment->iLine == iSecPassCodeIndex)){
-            if (pComment->bNonemptyLine){
-                if (pSymbol == NULL){
-                    pComment->cComment[COMMENT_LENGTH_NONEMPTY_NO_SYMBOLS - 1]='\0';
-                }
-                else{
-                    pComment->cComment[COMMENT_LENGTH_NONEMPTY - 1]='\0';
-                }
-            }
-            out_file << ";" << pComment->cComment;
-            sCommentNode* p=pComment;
-            pComment=pComment->pNext;
-            delete p;
-        }
+        vOutputComment();
     }
     void vGenerateHexCode (bool asemList){
         if (asemList){
@@ -2244,20 +2543,7 @@ public:
         vDotCommandBuffer(cFirstArg);
         out_file << "\'" << cSecondArg << "\'";
         vOperandBuffer(cSecondArg, false);
-        if ((pComment!=NULL) && (pComment->iLine == iSecPassCodeIndex)){
-            if (pComment->bNonemptyLine){
-                if (pSymbol == NULL){
-                    pComment->cComment[COMMENT_LENGTH_NONEMPTY_NO_SYMBOLS - 1]='\0';
-                }
-                else{
-                    pComment->cComment[COMMENT_LENGTH_NONEMPTY - 1]='\0';
-                }
-            }
-            out_file << ";" << pComment->cComment;
-            sCommentNode* p=pComment;
-            pComment=pComment->pNext;
-            delete p;
-        }
+        vOutputComment();
     }
     void vGenerateHexCode (bool asemList){
         if (asemList){
@@ -2341,7 +2627,7 @@ public:
     }
     void vGenerateHexCode (bool asemList){
         char cVal[ADDR_LENGTH + 1];
-        vGetSymbolValue(cSecondArg, cVal);
+        vDecToHexWord(iGetSymbolValue(cSecondArg), cVal);
         if (asemList){
             out_file << cVal << "   ";
         }
@@ -2400,20 +2686,7 @@ public:
         else{
             out_file << " ";
         }
-        if ((pComment!=NULL) && (pComment->iLine == iSecPassCodeIndex)){
-            if (pComment->bNonemptyLine){
-                if (pSymbol == NULL){
-                    pComment->cComment[COMMENT_LENGTH_NONEMPTY_NO_SYMBOLS - 1]='\0';
-                }
-                else{
-                    pComment->cComment[COMMENT_LENGTH_NONEMPTY - 1]='\0';
-                }
-            }
-            out_file << ";" << pComment->cComment;
-            sCommentNode* p=pComment;
-            pComment=pComment->pNext;
-            delete p;
-        }
+        vOutputComment();
         if ((iObjLength>OBJ_CODE_LENGTH) && ((iBurnCounter == 0) || (iAddress>=iBurnAddr))){
             out_file << endl << "      "; /*6 spaces*/
             vDotAsciiOutputContinued(cByteArg, iObjLength);
@@ -2460,6 +2733,7 @@ private:
     AMnemon* pAMnemonic;
     char cFirstArg[IDENT_LENGTH + 1];
     char cSecondArg[DEC_LENGTH + 1];
+    int iValue; /*Value of cSecondArg*/
     char cThirdArg[ADDR_MODE_LENGTH + 1];
 public:
     InstructionDec (int iAddr, Mnemon mn, AMnemon* pAMnemonTemp, char fArg[], char sArg[], char tArg[]){
@@ -2468,6 +2742,7 @@ public:
         pAMnemonic=pAMnemonTemp;
         strncpy (cFirstArg, fArg, IDENT_LENGTH + 1);
         strncpy (cSecondArg, sArg, DEC_LENGTH + 1);
+        iValue=iCharToInt(cSecondArg);
         strncpy (cThirdArg, tArg, ADDR_MODE_LENGTH + 1);
     }
     InstructionDec (int iAddr, Mnemon mn, AMnemon* pAMnemonTemp, char fArg[], char sArg[]){
@@ -2476,11 +2751,12 @@ public:
         pAMnemonic=pAMnemonTemp;
         strncpy (cFirstArg, fArg, IDENT_LENGTH + 1);
         strncpy (cSecondArg, sArg, DEC_LENGTH + 1);
+        iValue=iCharToInt(cSecondArg);
         cThirdArg[0]='\0';
     }
-    ~InstructionDec () { delete pAMnemonic; }
     int iAddressCounter () { return NONUNARY; }
     void vBurnAddressChange () { iAddress+=iBurnStart; }
+    int iInstructionAddress () { return iAddress; }
     void vGenerateCode (){
         char cAddr[ADDR_LENGTH + 1];
         vDecToHexWord (iAddress, cAddr);
@@ -2501,8 +2777,7 @@ public:
     void vGenerateHexCode (bool asemList){
         char cByte[BYTE_LENGTH + 1];
         char cWord[HEX_LENGTH + 1];
-        int iDec=iCharToInt(cSecondArg);
-        vDecToHexWord(iDec, cWord);
+        vDecToHexWord(iValue, cWord);
         vDecToHexByte(pAMnemonic->iOpCode() + iAddrModeValue(cThirdArg, pAMnemonic->bNoAddrModeRequired()), cByte);
         if (asemList){
             out_file << cByte << cWord << " ";
@@ -2538,9 +2813,9 @@ public:
         strncpy (cThirdArg, tArg, ADDR_MODE_LENGTH + 1);
         strncpy (cByteArg, byteArg, BYTE_LENGTH + 1);
     }
-    ~InstructionChar () { delete pAMnemonic; }
     int iAddressCounter () { return NONUNARY; }
     void vBurnAddressChange () { iAddress+=iBurnStart; }
+    int iInstructionAddress () { return iAddress; }
     void vGenerateCode (){
         char cAddr[ADDR_LENGTH + 1];
         vDecToHexWord (iAddress, cAddr);
@@ -2595,9 +2870,9 @@ public:
         strncpy (cThirdArg, tArg, ADDR_MODE_LENGTH + 1);
         strncpy (cWordArg, wordArg, WORD_LENGTH + 1);
     }
-    ~InstructionString () { delete pAMnemonic; }
     int iAddressCounter () { return NONUNARY; }
     void vBurnAddressChange () { iAddress+=iBurnStart; }
+    int iInstructionAddress () { return iAddress; }
     void vGenerateCode (){
         char cAddr[ADDR_LENGTH + 1];
         vDecToHexWord (iAddress, cAddr);
@@ -2670,9 +2945,9 @@ public:
         cThirdArg[0]='\0';
     }
 
-    ~InstructionHex () { delete pAMnemonic; }
     int iAddressCounter () { return NONUNARY; }
     void vBurnAddressChange () { iAddress+=iBurnStart; }
+    int iInstructionAddress () { return iAddress; }
     void vGenerateCode (){
         char cAddr[ADDR_LENGTH + 1];
         vDecToHexWord (iAddress, cAddr);
@@ -2733,9 +3008,9 @@ public:
         strncpy (cSecondArg, sArg, IDENT_LENGTH + 1);
         cThirdArg[0]='\0';
     }
-    ~InstructionSym () { delete pAMnemonic; }
     int iAddressCounter () { return NONUNARY; }
     void vBurnAddressChange () { iAddress+=iBurnStart; }
+    int iInstructionAddress () { return iAddress; }
     void vGenerateCode (){
         char cAddr[ADDR_LENGTH + 1];
         vDecToHexWord (iAddress, cAddr);
@@ -2757,7 +3032,7 @@ public:
         char cTemp[HEX_LENGTH + 1];
         char cByte[BYTE_LENGTH + 1];
         vDecToHexByte(pAMnemonic->iOpCode() + iAddrModeValue(cThirdArg, pAMnemonic->bNoAddrModeRequired()), cByte);
-        vGetSymbolValue(cSecondArg, cTemp);
+        vDecToHexWord(iGetSymbolValue(cSecondArg), cTemp);
         if (asemList){
             out_file << cByte << cTemp << " ";
         }
@@ -2776,6 +3051,31 @@ public:
 
 /*Table and object initializations*/
 /*Initializes all global tables with their values*/
+/*Returns the slot of iHash[] that holds the index of cID[] in cTable[],*/
+/*or the slot with iEmpty where it belongs*/
+int iFindNameSlot (const char cID[], char cTable[][IDENT_LENGTH + 1], const int iHash[], int iSize, int iEmpty){
+    int iSlot=iSymbolHash(cID) & (iSize - 1);
+    while ((iHash[iSlot]!=iEmpty) && (strcmp(cID, cTable[iHash[iSlot]])!=0)){
+        iSlot=(iSlot + 1) & (iSize - 1);
+    }
+    return iSlot;
+}
+
+/*Fills iHash[] with the iCount names of cTable[].  A name that occurs twice,*/
+/*such as a trap mnemonic that is also an instruction, keeps its first index.*/
+void vInitNameHash (char cTable[][IDENT_LENGTH + 1], int iCount, int iHash[], int iSize){
+    int i, iSlot;
+    for (i=0; i<iSize; i++){
+        iHash[i]=iCount;
+    }
+    for (i=0; i<iCount; i++){
+        iSlot=iFindNameSlot(cTable[i], cTable, iHash, iSize, iCount);
+        if (iHash[iSlot] == iCount){
+            iHash[iSlot]=i;
+        }
+    }
+}
+
 void vInitGlobalTables (){
     strncpy (cDotTable[eD_ADDRSS], "ADDRSS", IDENT_LENGTH + 1);
     strncpy (cDotTable[eD_ASCII], "ASCII", IDENT_LENGTH + 1);
@@ -2849,6 +3149,8 @@ void vInitGlobalTables (){
     strncpy (cMnemonTable[eM_UNIMP5], sUnimpMnemon[5].cID, IDENT_LENGTH + 1);
     strncpy (cMnemonTable[eM_UNIMP6], sUnimpMnemon[6].cID, IDENT_LENGTH + 1);
     strncpy (cMnemonTable[eM_UNIMP7], sUnimpMnemon[7].cID, IDENT_LENGTH + 1);
+    vInitNameHash (cDotTable, eD_EMPTY, iDotHash, DOT_HASH_SIZE);
+    vInitNameHash (cMnemonTable, eM_EMPTY, iMnemonHash, MNEMON_HASH_SIZE);
 }
 
 /*Initializes the object of mnemon found in vLookUpMnemon() */
@@ -2924,18 +3226,21 @@ void vInitMnemonObjects  (Mnemon mnemon, AMnemon*& pAMnemonTemp){
 
 /*Table Search functions*/
 /*Looks up to see if mn is a valid mnemonic*/
+/*Makes the one object of each mnemonic that the instructions share*/
+void vInitMnemonTable (){
+    for (int i=0; i<eM_EMPTY; i++){
+        vInitMnemonObjects(Mnemon (i), pAMnemonTable[i]);
+    }
+}
+
 void vLookUpMnemon (char cID[], Mnemon& mn, AMnemon*& pAMnemonTemp, bool& bFnd){
     for (int i=0; i<=IDENT_LENGTH; i++){
         cID[i]=toupper (cID[i]);
     }
-    strncpy (cMnemonTable[eM_EMPTY], cID, IDENT_LENGTH + 1);
-    mn=eM_STOP;
-    while (strcmp (cMnemonTable[mn], cID)!=0){
-        mn=Mnemon (mn + 1);
-    }
+    mn=Mnemon (iMnemonHash[iFindNameSlot(cID, cMnemonTable, iMnemonHash, MNEMON_HASH_SIZE, eM_EMPTY)]);
     bFnd=(mn!=eM_EMPTY);
     if (bFnd){
-        vInitMnemonObjects(mn, pAMnemonTemp);
+        pAMnemonTemp=pAMnemonTable[mn];
     }
 }
 
@@ -2944,11 +3249,7 @@ void vLookUpDot (char cID[], DotCommand& dot, bool& bFnd){
     for (int i=0; i<=IDENT_LENGTH; i++){
         cID[i]=toupper (cID[i]);
     }
-    strncpy (cDotTable[eD_EMPTY], cID, IDENT_LENGTH + 1);
-    dot=eD_BLOCK;
-    while (strcmp (cDotTable[dot], cID)!=0){
-        dot=DotCommand (dot + 1);
-    }
+    dot=DotCommand (iDotHash[iFindNameSlot(cID, cDotTable, iDotHash, DOT_HASH_SIZE, eD_EMPTY)]);
     bFnd=(dot!=eD_EMPTY);
     if (dot == eD_ASCII){
         bIsAscii=true;
@@ -2958,88 +3259,58 @@ void vLookUpDot (char cID[], DotCommand& dot, bool& bFnd){
 /*Symbol and Comment functions*/
 /*Searches to see if cID[] has been declared*/
 bool bLookUpSymbol (char cID[]){
-    sSymbolNode* p=pSymbol;
-    while ((p!=NULL) && (strcmp (cID, p->cSymID)>0)){
-        p=p->pNext;
-    }
-    if (p!=NULL){
-        return (strcmp (cID, p->cSymID) == 0);
-    }
-    else{
-        return false;
-    }
+    return (pFindSymbol(cID)!=NULL);
 }
 
-/*Installs a symbol declaration in a linked list of symbols with their values*/
+/*Installs a symbol declaration in the hash table of symbols with their values*/
 void vInstallSymbol (char cID[]){
-    sSymbolNode *p, *q;
-    sSymbolNode* pTemp=new sSymbolNode;
-    char addrHex[ADDR_LENGTH + 1];
-    strncpy (pTemp->cSymID, cID, IDENT_LENGTH + 1);
-    vDecToHexWord (iCurrentAddress, addrHex);
-    strncpy (pTemp->cSymValue, addrHex, ADDR_LENGTH + 1);
-    pTemp->iLine=iCodeIndex;
-    q=NULL;
-    p=pSymbol;
-    while ((p!=NULL) && (strcmp (cID, p->cSymID)>0)){
-        q=p; /* q follows p.*/
-        p=p->pNext;
+    sSymbolNode** pSlot;
+    sSymbolNode* pTemp;
+    if (2 * (iSymbolCount + 1)>iSymbolTableSize){ /*Keep the table at most half full*/
+        vGrowSymbolTable();
     }
-    if ((p!=NULL) && (strcmp (cID, p->cSymID) == 0)){
+    pSlot=pFindSymbolSlot(cID);
+    if (*pSlot!=NULL){
         delete pACode[iCodeIndex];
         pACode[iCodeIndex]=new eSymPrevDef;
-        delete pTemp;
         return;
     }
-    pTemp->pNext=p;
-    if ((q!=NULL)){
-        q->pNext=pTemp;
-    }
-    else{
-        pSymbol=pTemp;
-    }
+    pTemp=new sSymbolNode;
+    strncpy (pTemp->cSymID, cID, IDENT_LENGTH + 1);
+    pTemp->iSymValue=iWordValue(iCurrentAddress);
+    pTemp->iLine=iCodeIndex;
+    *pSlot=pTemp;
+    iSymbolCount++;
 }
 
 /*Installs a symbol output declaration in a linked list of symbols with their lines*/
 void vInstallSymbolOutput (char cID[]){
-    sSymbolOutputNode *p, *q;
     sSymbolOutputNode* pTemp=new sSymbolOutputNode;
     strncpy (pTemp->cSymID, cID, IDENT_LENGTH + 1);
     pTemp->iLine=iCodeIndex;
-    q=NULL;
-    p=pSymbolOutput;
-    while (p!=NULL){
-        q=p;  /*q follows p.*/
-        p=p->pNext;
-    }
-    pTemp->pNext=p;
-    if (q!=NULL){
-        q->pNext=pTemp;
+    pTemp->pNext=NULL;
+    if (pSymbolOutput!=NULL){
+        pSymbolOutputTail->pNext=pTemp;
     }
     else{
         pSymbolOutput=pTemp;
     }
+    pSymbolOutputTail=pTemp;
 }
 
-/*Changes cSymValue[] to cVal[] of the symbol named cID[] to account for .EQUATE*/
-void vChangeSymValEquate (char cID[], char cVal[])
+/*Changes the value of the symbol named cID[] to iVal to account for .EQUATE*/
+void vChangeSymValEquate (char cID[], int iVal)
 {
-    sSymbolNode* p=pSymbol;
-    while (p!=NULL){
-        if (strcmp (cID, p->cSymID)!=0){
-            p=p->pNext;
-        }
-        else{
-            strncpy (p->cSymValue, cVal, ADDR_LENGTH + 1);
-            return;
-        }
+    sSymbolNode* p=pFindSymbol(cID);
+    if (p!=NULL){
+        p->iSymValue=iVal;
     }
 }
 
-/*Installs cVal[] and cID into the pEquate linked list*/
-void vInstallEquateNode (char cID[], char cVal[]){
+/*Installs iVal and cID into the pEquate linked list*/
+void vInstallEquateNode (char cID[], int iVal){
     sEquateNode* p=new sEquateNode;
-    strncpy (p->cSymValue, cVal, ADDR_LENGTH + 1);
+    p->iSymValue=iVal;
     strncpy (p->cSymID, cID, IDENT_LENGTH + 1);
     p->pNext=pEquate;
     pEquate=p;
@@ -3047,58 +3318,45 @@ void vInstallEquateNode (char cID[], char cVal[]){
 
 /*Changes the value of every symbol to account for .BURN*/
 void vChangeSymValBurn (int iBurnStartAddress){
-    sSymbolNode* p=pSymbol;
-    char cVal[ADDR_LENGTH + 1];
-    while (p!=NULL){
-        vDecToHexWord(iHexWordToDecInt (p->cSymValue) + iBurnStartAddress, cVal);
-        strncpy (p->cSymValue, cVal, ADDR_LENGTH + 1);
-        p=p->pNext;
+    sSymbolNode* p;
+    for (int i=0; i<iSymbolTableSize; i++){
+        p=pSymbolTable[i];
+        if (p!=NULL){
+            p->iSymValue=iWordValue(p->iSymValue + iBurnStartAddress);
+        }
     }
 }
 
 /*Installs an undeclared symbol in a linked list of undeclared symbols with their values*/
 void vInstallUndeclaredSymbol (char cID[]){
-    sUndeclaredsSymbolNode *p, *q;
     sUndeclaredsSymbolNode* pTemp=new sUndeclaredsSymbolNode;
     strncpy (pTemp->cSymID, cID, IDENT_LENGTH + 1);
     pTemp->iLine=iCodeIndex;
     pTemp->pNext=NULL;
-    q=NULL;
-    p=pUndeclaredSym;
-    while (p!=NULL){
-        q=p; /*q follows p.*/
-        p=p->pNext;
-    }
-    pTemp->pNext=p;
-    if ((q!=NULL)){
-        q->pNext=pTemp;
+    if (pUndeclaredSym!=NULL){
+        pUndeclaredSymTail->pNext=pTemp;
     }
     else{
         pUndeclaredSym=pTemp;
     }
+    pUndeclaredSymTail=pTemp;
 }
 
 /*Installs a comment in a linked list of comments with their lines and values*/
-void vInstallComment (char cID[], bool bNonempty){
-    sCommentNode *p, *q;
+void vInstallComment (const char* pText, int iLength, bool bNonempty){
     sCommentNode* pTemp=new sCommentNode;
-    strncpy (pTemp->cComment, cID, COMMENT_LENGTH + 1);
+    pTemp->pText=pText;
+    pTemp->iLength=iLength;
     pTemp->bNonemptyLine=bNonempty;
     pTemp->iLine=iCodeIndex;
     pTemp->pNext=NULL;
-    q=NULL;
-    p=pComment;
-    while (p!=NULL){
-        q=p; /*q follows p.*/
-        p=p->pNext;
-    }
-    pTemp->pNext=p;
-    if (q!=NULL){
-        q->pNext=pTemp;
+    if (pComment!=NULL){
+        pCommentTail->pNext=pTemp;
     }
     else{
         pComment=pTemp;
     }
+    pCommentTail=pTemp;
 }
 
 /*Lexical Analyzer (finds tokens in the language)*/
@@ -3106,13 +3364,14 @@ void vGetToken (AToken*& pAT){
     char cNextChar;
     int i;
     char cLocalIdentValue[IDENT_LENGTH + 1];
-    char cLocalCommentValue[COMMENT_LENGTH + 1];
+    const char* pLocalComment=NULL;
     char cLocalHexValue[HEX_LENGTH + 1];
     char cLocalDecValue[DEC_LENGTH + 1];
     char cLocalCharValue[CHAR_LENGTH + 1];
     char cLocalStringValue[STRING_LENGTH + 1];
     char cAddr[ADDR_MODE_LENGTH + 1];
     State state=eS_START;
+    lTokenCount++;
     pAT=new TEmpty;
     do{
         vAdvanceInput (cNextChar);
@@ -3123,8 +3382,10 @@ void vGetToken (AToken*& pAT){
                 state=eS_ADDR;
             else if (cNextChar == '\'')
                 state=eS_CHAR1;
-            else if (cNextChar == ';')
+            else if (cNextChar == ';'){
+                pLocalComment=cLine + iLineIndex;
                 state=eS_COMMENT;
+            }
             else if (cNextChar == '.')
                 state=eS_DOT1;
             else if (cNextChar == '\n')
@@ -3288,14 +3549,13 @@ void vGetToken (AToken*& pAT){
             break;
         case eS_COMMENT:
             if (cNextChar == '\n'){
-                cLocalCommentValue[i]='\0';
                 vBackUpInput ();
                 delete pAT;
-                pAT=new TComment (cLocalCommentValue);
+                pAT=new TComment (pLocalComment, i);
                 state=eS_STOP;
             }
             else if (i<COMMENT_LENGTH)
-                cLocalCommentValue[i++]=cNextChar;
+                i++;
 //          else{
 //             vBackUpInput ();
 //             delete pAT;
@@ -3467,7 +3727,6 @@ void vGetToken (AToken*& pAT){
         }
     }
     while ((state!=eS_STOP) && (pAT->kTokenType ()!=eT_INVALID));
-    pPrevAT=pAT;
 }
 
 /*Parser*/
@@ -3487,7 +3746,8 @@ void vProcessSourceLine (bool& term){
     char cLocalCharVal[CHAR_LENGTH + 1];
     char cLocalCharByteVal[BYTE_LENGTH + 1];
     char cLocalAddrModeVal[ADDR_MODE_LENGTH + 1];
-    char cLocalCommentVal[COMMENT_LENGTH + 1];
+    const char* pLocalComment;
+    int iCommentLength;
     bool bSymDeclared=false;
     TIdentifier* pTIdent=NULL;
     TDotCommand* pTDot=NULL;
@@ -3507,6 +3767,7 @@ void vProcessSourceLine (bool& term){
     int iObjLength;
     int iStrLength;
     bool bFound;
+    aTokenArena.vReset (); /*The tokens of the previous line are no longer used*/
     pACode[iCodeIndex]=new ZeroArg (eD_EMPTY);
     ParseState psState=ePS_START;
     do{
@@ -3573,8 +3834,8 @@ void vProcessSourceLine (bool& term){
             }
             else if (pAToken->kTokenType () == eT_COMMENT){
                 pTComm=static_cast <TComment*> (pAToken);
-                pTComm->vGetValue (cLocalCommentVal);
-                vInstallComment (cLocalCommentVal, false);
+                pTComm->vGetValue (pLocalComment, iCommentLength);
+                vInstallComment (pLocalComment, iCommentLength, false);
                 psState=ePS_COMMENT;
             }
             else if (pAToken->kTokenType () == eT_INVALIDCOMMENT){
@@ -3947,21 +4208,20 @@ void vProcessSourceLine (bool& term){
                 pTHex=static_cast <THexConstant*> (pAToken);
                 pTHex->vGetValue (cLocalHexVal);
                 delete pACode[iCodeIndex];
-                vChangeSymValEquate(cLocalSymVal, cLocalHexVal);
-                vInstallEquateNode(cLocalSymVal, cLocalHexVal);
+                iTemp=iHexWordToDecInt(cLocalHexVal);
+                vChangeSymValEquate(cLocalSymVal, iTemp);
+                vInstallEquateNode(cLocalSymVal, iTemp);
                 pACode[iCodeIndex]=new DotComHex (iCurrentAddress, dotcom, cLocalIdentVal, cLocalHexVal);
                 pValid=static_cast <Valid*> (pACode[iCodeIndex]);
                 iCurrentAddress+=pValid->iAddressCounter();
                 psState=ePS_CLOSE;
             }
             else if (pAToken->kTokenType () == eT_DECCONSTANT){
-                char cVal[ADDR_LENGTH + 1];
                 pTDec=static_cast <TDecConstant*> (pAToken);
                 pTDec->vGetValue (cLocalDecVal);
-                int iTemp=iCharToInt(cLocalDecVal);
-                vDecToHexWord(iTemp, cVal);
-                vChangeSymValEquate(cLocalSymVal, cVal);
-                vInstallEquateNode(cLocalSymVal, cVal);
+                iTemp=iWordValue(iCharToInt(cLocalDecVal));
+                vChangeSymValEquate(cLocalSymVal, iTemp);
+                vInstallEquateNode(cLocalSymVal, iTemp);
                 delete pACode[iCodeIndex];
                 pACode[iCodeIndex]=new DotComDec (iCurrentAddress, dotcom, cLocalIdentVal, cLocalDecVal);
                 pValid=static_cast <Valid*> (pACode[iCodeIndex]);
@@ -3978,8 +4238,9 @@ void vProcessSourceLine (bool& term){
                 cLocalStringObjVal[3]=cLocalCharByteVal[1];
                 cLocalStringObjVal[4]='\0';
                 delete pACode[iCodeIndex];
-                vChangeSymValEquate(cLocalSymVal, cLocalStringObjVal);
-                vInstallEquateNode(cLocalSymVal, cLocalStringObjVal);
+                iTemp=iHexWordToDecInt(cLocalStringObjVal);
+                vChangeSymValEquate(cLocalSymVal, iTemp);
+                vInstallEquateNode(cLocalSymVal, iTemp);
                 pACode[iCodeIndex]=new DotComChar (iCurrentAddress, dotcom, cLocalIdentVal, cLocalCharVal, cLocalCharByteVal);
                 pValid=static_cast <Valid*> (pACode[iCodeIndex]);
                 iCurrentAddress+=pValid->iAddressCounter();
@@ -3992,8 +4253,9 @@ void vProcessSourceLine (bool& term){
                     pTString->vGetValue (cLocalStringVal);
                     pTString->vGetObjValue (cLocalStringObjVal, iObjLength);
                     delete pACode[iCodeIndex];
-                    vChangeSymValEquate(cLocalSymVal, cLocalStringObjVal);
-                    vInstallEquateNode(cLocalSymVal, cLocalStringObjVal);
+                    iTemp=iHexWordToDecInt(cLocalStringObjVal);
+                    vChangeSymValEquate(cLocalSymVal, iTemp);
+                    vInstallEquateNode(cLocalSymVal, iTemp);
                     pACode[iCodeIndex]=new DotComString (iCurrentAddress, dotcom, cLocalIdentVal, cLocalStringVal, cLocalStringObjVal, iObjLength);
                     pValid=static_cast <Valid*> (pACode[iCodeIndex]);
                     iCurrentAddress+=pValid->iAddressCounter();
@@ -4008,8 +4270,9 @@ void vProcessSourceLine (bool& term){
                     cLocalStringObjVal[3]=cLocalCharByteVal[1];
                     cLocalStringObjVal[4]='\0';
                     delete pACode[iCodeIndex];
-                    vChangeSymValEquate(cLocalSymVal, cLocalStringObjVal);
-                    vInstallEquateNode(cLocalSymVal, cLocalStringObjVal);
+                    iTemp=iHexWordToDecInt(cLocalStringObjVal);
+                    vChangeSymValEquate(cLocalSymVal, iTemp);
+                    vInstallEquateNode(cLocalSymVal, iTemp);
                     pACode[iCodeIndex]=new DotComString (iCurrentAddress, dotcom, cLocalIdentVal, cLocalStringVal, cLocalStringObjVal, iObjLength);
                     pValid=static_cast <Valid*> (pACode[iCodeIndex]);
                     iCurrentAddress+=pValid->iAddressCounter();
@@ -4140,9 +4403,9 @@ void vProcessSourceLine (bool& term){
                     iCurrentAddress+=pValid->iAddressCounter();
                     psState=ePS_FINISH;
                     pTComm=static_cast <TComment*> (pAToken);
-                    pTComm->vGetValue (cLocalCommentVal);
+                    pTComm->vGetValue (pLocalComment, iCommentLength);
                     iCurrentAddress=iCurrentAddress - pValid->iAddressCounter();
-                    vInstallComment (cLocalCommentVal,true);
+                    vInstallComment (pLocalComment, iCommentLength, true);
                     iCurrentAddress+=pValid->iAddressCounter();
                     psState=ePS_COMMENT;
                 }
@@ -4191,9 +4454,9 @@ void vProcessSourceLine (bool& term){
                     iCurrentAddress+=pValid->iAddressCounter();
                     psState=ePS_FINISH;
                     pTComm=static_cast <TComment*> (pAToken);
-                    pTComm->vGetValue (cLocalCommentVal);
+                    pTComm->vGetValue (pLocalComment, iCommentLength);
                     iCurrentAddress=iCurrentAddress - pValid->iAddressCounter();
-                    vInstallComment (cLocalCommentVal, true);
+                    vInstallComment (pLocalComment, iCommentLength, true);
                     iCurrentAddress+=pValid->iAddressCounter();
                     psState=ePS_COMMENT;
                 }
@@ -4300,9 +4563,9 @@ void vProcessSourceLine (bool& term){
                     iCurrentAddress+=pValid->iAddressCounter();
                     psState=ePS_FINISH;
                     pTComm=static_cast <TComment*> (pAToken);
-                    pTComm->vGetValue (cLocalCommentVal);
+                    pTComm->vGetValue (pLocalComment, iCommentLength);
                     iCurrentAddress=iCurrentAddress - pValid->iAddressCounter();
-                    vInstallComment (cLocalCommentVal, true);
+                    vInstallComment (pLocalComment, iCommentLength, true);
                     iCurrentAddress+=pValid->iAddressCounter();
                     psState=ePS_COMMENT;
                 }
@@ -4327,9 +4590,9 @@ void vProcessSourceLine (bool& term){
             }
             else if (pAToken->kTokenType () == eT_COMMENT){
                 pTComm=static_cast <TComment*> (pAToken);
-                pTComm->vGetValue (cLocalCommentVal);
+                pTComm->vGetValue (pLocalComment, iCommentLength);
                 iCurrentAddress=iCurrentAddress - pValid->iAddressCounter();
-                vInstallComment (cLocalCommentVal, true);
+                vInstallComment (pLocalComment, iCommentLength, true);
                 iCurrentAddress+=pValid->iAddressCounter();
                 psState=ePS_COMMENT;
             }
@@ -4354,11 +4617,6 @@ void vProcessSourceLine (bool& term){
             break; // Should not occur
         }
         delete pAToken;
-        if (iCodeIndex>=MAX_LINES){
-            delete pACode[iCodeIndex];
-            pACode[iCodeIndex]=new eTooLong;
-            term=true;
-        }
         if (iCurrentAddress>=CODE_MAX_SIZE - 2){
             delete pACode[iCodeIndex];
             pACode[iCodeIndex]=new eProgTooLong;
@@ -4368,159 +4626,326 @@ void vProcessSourceLine (bool& term){
     while ((psState!=ePS_FINISH) && (!pACode[iCodeIndex]->bIsError ()));
 }
 
-int main (int argc, char *argv[]){
-    bool bTerminate=false;
+/*Resets the state of the assembler after a source file, keeping the tables*/
+/*and the arena blocks for the next file*/
+void vResetAssembler (){
+    for (int i=0; i<=iCodeIndex; i++){
+        pACode[i]=NULL;
+    }
+    vDeleteSymbolTable();
+    aCodeArena.vReset();
+    aTokenArena.vReset();
+    pSymbolOutput=NULL;
+    pSymbolOutputTail=NULL;
+    pUndeclaredSym=NULL;
+    pUndeclaredSymTail=NULL;
+    pComment=NULL;
+    pCommentTail=NULL;
+    pEquate=NULL;
     iCodeIndex=0;
-    int iLineErrors[MAX_LINES]; /*Keeps track of lines containing errors*/
-    int iErrorIndex=0; /*Index for iLineErrors[]*/
-    Valid* pValid;
-    int i;
-    int j;
-    char sourceFileName[FILE_NAME_LENGTH];
-    char objectFileName[FILE_NAME_LENGTH];
-    char listingFileName[FILE_NAME_LENGTH];
-    bool bTemp=false;
-    bool bListing=false;
-    bool bVersion=false;
-    for (j=0; j<=MAX_LINES; j++){ /*Initialize pACode array*/
-        pACode[j]=NULL;
+    iSecPassCodeIndex=0;
+    iCurrentAddress=0;
+    iHexOutputBuffer=0;
+    bIsAscii=false;
+    iBurnStart=0;
+    iBurnAddr=0;
+    iBurnCounter=0;
+}
+
+/*Resets the state of one assembly of an edit session, keeping the lines, their*/
+/*code, the symbol table and the arena for the next edit*/
+void vResetEditPass (){
+    aTokenArena.vReset();
+    pSymbolOutput=NULL;
+    pSymbolOutputTail=NULL;
+    pUndeclaredSym=NULL;
+    pUndeclaredSymTail=NULL;
+    pComment=NULL;
+    pCommentTail=NULL;
+    pEquate=NULL;
+    iSecPassCodeIndex=0;
+    iHexOutputBuffer=0;
+    bIsAscii=false;
+    iBurnStart=0;
+    iBurnAddr=0;
+    iBurnCounter=0;
+}
+
+/*Adds the time since tStart to phase ePhase of the statistics, and restarts tStart*/
+void vEndPhase (Phase ePhase, chrono::steady_clock::time_point& tStart){
+    chrono::steady_clock::time_point tNow=chrono::steady_clock::now();
+    statistics.dPhaseSeconds[ePhase]=chrono::duration <double> (tNow - tStart).count();
+    tStart=tNow;
+}
+
+/*The profile columns of a listing with -P.  vProfileLines puts the count and*/
+/*the percent of the instruction at iAddr, or blanks for other lines, in front*/
+/*of each line written to out_file since iStart.*/
+void vProfileRule (){
+    if (pProfileCount!=NULL){
+        out_file << "-------------------";/*19 dashes*/
     }
-    /*Input trap file*/
-    in_file.open("trap");
-    if (in_file.fail()){
-        cerr << "Could not open trap file." << endl;
-        return 1;
+}
+
+void vProfileHeading (const char cHeading[]){
+    if (pProfileCount!=NULL){
+        out_file << cHeading;
     }
-    for (i = 0; i < UNIMPLEMENTED_INSTRUCTIONS; i++) {
-        vGetTrapLine(i);
+}
+
+void vProfileLines (size_t iStart, int iAddr){
+    string sLines;
+    char cColumns[PROFILE_COLUMNS + 1];
+    out_file.vCutFrom(iStart, sLines);
+    if (iAddr>=0){
+        snprintf(cColumns, sizeof (cColumns), "%10ld %6.2f  ", pProfileCount[iAddr],
+                 (lProfileTotal>0) ? 100.0 * pProfileCount[iAddr] / lProfileTotal : 0.0);
     }
-    i = 0;
-    in_file.close();
-   
-    /*Analyze input command*/
-    if (argc == 1){
-        return 0;
+    else{
+        snprintf(cColumns, sizeof (cColumns), "%*s", PROFILE_COLUMNS, "");
     }
-    else if (argc == 2){
-        if (argv[1][0] == '-'){
-            if (strcmp(argv[1], "-v") == 0){
-                vVersionNumber();
-                return 0;
-            }
-            else{
-                cerr << "usage: asem8 [-v] [[-l] sourceFile]" << endl;
-                return 2;
-            }
-        }
-        else{
-            if (strlen(argv[1])>FILE_NAME_LENGTH - 3){
-                cerr << "Source file name too long" << endl;
-                return 2;
-            }
-            else{
-                strncpy (sourceFileName, argv[1], FILE_NAME_LENGTH);
-            }
-        }
+    for (size_t iLine=0; iLine<sLines.size(); ){
+        size_t iEnd=sLines.find('\n', iLine);
+        out_file << cColumns;
+        out_file.write(sLines.data() + iLine, iEnd + 1 - iLine);
+        snprintf(cColumns, sizeof (cColumns), "%*s", PROFILE_COLUMNS, "");
+        iLine=iEnd + 1;
     }
-    else if (argc == 3){
-        if (strcmp(argv[1], "-v") == 0){
-            bVersion=true;
-        }
-        else if (strcmp(argv[1], "-l") == 0){
-            bListing=true;
+}
+
+/*The symbol file of asem8 -y, one line per symbol in the order of the symbol*/
+/*table: the symbol, its value in hex after any .BURN, and whether it names*/
+/*an instruction, a dot command or a .EQUATE constant: code, data or equate.*/
+void vSymbolText (string& sSymbols){
+    sSymbolNode** pSorted=pSortedSymbols();
+    char cSymVal[ADDR_LENGTH + 1];
+    sSymbols.clear();
+    for (int i=0; i<iSymbolCount; i++){
+        Valid* pValid=static_cast <Valid*> (pACode[pSorted[i]->iLine]);
+        vDecToHexWord(pSorted[i]->iSymValue, cSymVal);
+        sSymbols+=pSorted[i]->cSymID;
+        sSymbols+=" ";
+        sSymbols+=cSymVal;
+        sSymbols+=(pValid->iInstructionAddress()>=0) ? " code\n" : pValid->bIsEquate() ? " equate\n" : " data\n";
+    }
+    delete [] pSorted;
+}
+
+/*Writes the listing line of pACode[iSecPassCodeIndex], its comment and any profile columns*/
+void vListingLine (){
+    size_t iLineStart=out_file.size();
+    pACode[iSecPassCodeIndex]->vGenerateCode ();
+    vOutputComment();
+    out_file << endl;
+    if (pProfileCount!=NULL){
+        vProfileLines(iLineStart, static_cast <Valid*> (pACode[iSecPassCodeIndex])->iInstructionAddress());
+    }
+}
+
+/*The lines iStart to iEnd - 1 of pACode that one thread of vGenerateLines()*/
+/*generates into sText.  pSymbols and pComments are the first symbol*/
+/*declaration and the first comment at or after line iStart.*/
+struct sGenerateChunk{
+    int iStart;
+    int iEnd;
+    sSymbolOutputNode* pSymbols;
+    sCommentNode* pComments;
+    string sText;
+};
+
+/*The state of the assembly that the code generators read, for the threads of vGenerateLines()*/
+struct sGenerateState{
+    ACode** pCode;
+    sSymbolNode** pSymbols;
+    int iSymbolTableSize;
+    int iSymbolCount;
+    int iBurnCounter;
+    int iBurnAddr;
+};
+
+/*Thread of vGenerateLines(): takes over the state of the assembly and generates*/
+/*the listing lines or the object code of one chunk.  The object code starts*/
+/*a line of the object file, vShiftHexLines() moves it to where it goes.*/
+void vGenerateChunk (const sGenerateState* pState, sGenerateChunk* pChunk, bool bListing){
+    pACode=pState->pCode;
+    pSymbolTable=pState->pSymbols;
+    iSymbolTableSize=pState->iSymbolTableSize;
+    iSymbolCount=pState->iSymbolCount;
+    iBurnCounter=pState->iBurnCounter;
+    iBurnAddr=pState->iBurnAddr;
+    pSymbolOutput=pChunk->pSymbols;
+    pComment=pChunk->pComments;
+    iHexOutputBuffer=0;
+    out_file.open(pChunk->sText);
+    for (iSecPassCodeIndex=pChunk->iStart; iSecPassCodeIndex<pChunk->iEnd; iSecPassCodeIndex++){
+        if (bListing){
+            vListingLine();
         }
         else{
-            cerr << "usage: asem8 [-v] [[-l] sourceFile]" << endl;
-            return 2;
+            static_cast <Valid*> (pACode[iSecPassCodeIndex])->vGenerateHexCode (false);
         }
-        if (argv[2][0] == '-'){
-            cerr << "usage: asem8 [-v] [[-l] sourceFile]" << endl;
-            return 2;
-        }
-        else{
-            if (strlen(argv[1])>FILE_NAME_LENGTH - 3){
-                cerr << "Source file name too long" << endl;
-                return 2;
+    }
+    out_file.close();
+    pACode=NULL;
+    pSymbolTable=NULL;
+}
+
+/*Each byte of object code is two hex digits and a space, or a new line after*/
+/*every OBJ_FILE_LINE_LENGTH bytes.  Lays out the separators of sText, generated*/
+/*from the start of a line, for the place iBytesBefore bytes into the file.*/
+void vShiftHexLines (string& sText, long iBytesBefore){
+    int iByte=iBytesBefore % OBJ_FILE_LINE_LENGTH;
+    if (iByte == 0){
+        return;
+    }
+    for (size_t i=BYTE_LENGTH; i<sText.size(); i+=BYTE_LENGTH + 1){
+        sText[i]=(iByte == OBJ_FILE_LINE_LENGTH - 1) ? '\n' : ' ';
+        iByte=(iByte + 1) % OBJ_FILE_LINE_LENGTH;
+    }
+}
+
+/*Generates the listing lines, or the object code, of all of pACode into out_file.*/
+/*A large program is cut into chunks of consecutive lines that iGenerateThreads*/
+/*threads generate at once, and the chunks are written in order.*/
+void vGenerateLines (bool bListing){
+    int iChunks=iCodeIndex / GENERATE_CHUNK_LINES;
+    iChunks=(iChunks>iGenerateThreads) ? iGenerateThreads : iChunks;
+    if (iChunks<=1){
+        for (iSecPassCodeIndex=0; iSecPassCodeIndex<iCodeIndex; iSecPassCodeIndex++){
+            if (bListing){
+                vListingLine();
             }
             else{
-                strncpy (sourceFileName, argv[2], FILE_NAME_LENGTH);
+                static_cast <Valid*> (pACode[iSecPassCodeIndex])->vGenerateHexCode (false);
             }
         }
+        return;
     }
-    else if (argc == 4){
-        if (strcmp(argv[1], "-v") == 0 && strcmp(argv[2], "-l") == 0 && argv[3][0]!='-'){
-            bVersion=true;
-            bListing=true;
-            if (strlen(argv[1])>FILE_NAME_LENGTH - 3){
-                cerr << "Source file name too long" << endl;
-                return 2;
-            }
-            else{
-                strncpy (sourceFileName, argv[3], FILE_NAME_LENGTH);
-            }
+    sGenerateState state={pACode, pSymbolTable, iSymbolTableSize, iSymbolCount, iBurnCounter, iBurnAddr};
+    vector<sGenerateChunk> chunks(iChunks);
+    for (int c=0; c<iChunks; c++){
+        chunks[c].iStart=static_cast <int> (static_cast <long> (iCodeIndex) * c / iChunks);
+        chunks[c].iEnd=static_cast <int> (static_cast <long> (iCodeIndex) * (c + 1) / iChunks);
+        while ((pSymbolOutput!=NULL) && (pSymbolOutput->iLine<chunks[c].iStart)){
+            pSymbolOutput=pSymbolOutput->pNext;
         }
-        else{
-            cerr << "usage: asem8 [-v] [[-l] sourceFile]" << endl;
-            return 2;
+        while ((pComment!=NULL) && (pComment->iLine<chunks[c].iStart)){
+            pComment=pComment->pNext;
         }
+        chunks[c].pSymbols=pSymbolOutput;
+        chunks[c].pComments=pComment;
+    }
+    vector<thread> workers;
+    for (int c=0; c<iChunks; c++){
+        workers.push_back (thread (vGenerateChunk, &state, &chunks[c], bListing));
+    }
+    long iBytes=iHexOutputBuffer;
+    for (int c=0; c<iChunks; c++){
+        workers[c].join();
+        if (!bListing){
+            vShiftHexLines(chunks[c].sText, iBytes);
+            iBytes+=chunks[c].sText.size() / (BYTE_LENGTH + 1);
+        }
+        out_file.write(chunks[c].sText.data(), chunks[c].sText.size());
     }
-    else{
-        cerr << "usage: asem8 [-v] [[-l] sourceFile]" << endl;
-        return 2;
-    }
-    int k = strlen(sourceFileName);
-    if ((sourceFileName[k-1]!='p') || (sourceFileName[k-2]!='e') || (sourceFileName[k-3]!='p') || (sourceFileName[k-4]!='.')){
-        cerr << "Source file should have a \".pep\" extension" << endl;
-        return 2;
-    }
-    in_file.open(sourceFileName);
-    if (in_file.fail()){
-        cerr << "Could not open " << sourceFileName << "." << endl;
-        return 3;
+    iHexOutputBuffer=iBytes % OBJ_FILE_LINE_LENGTH;
+    pSymbolOutput=NULL;
+    pComment=NULL;
+    iSecPassCodeIndex=iCodeIndex;
+}
+
+/*Starts the statistics of an assembly*/
+void vStartStatistics (){
+    memset(&statistics, 0, sizeof (statistics));
+    statistics.lTokens=-lTokenCount;
+    statistics.lAllocations=-aCodeArena.lAllocationCount() - aTokenArena.lAllocationCount();
+    statistics.lBytes=-aCodeArena.lAllocatedBytes() - aTokenArena.lAllocatedBytes();
+}
+
+bool bFinishAssembly (bool bTerminate, int iErrorIndex, bool bListing, string& sListing, string& sObject,
+                      int& iLoadAddr, chrono::steady_clock::time_point tPhase);
+void vEndEdits ();
+
+/*Assembles the program sText into sObject, and into sListing if bListing.*/
+/*iLoadAddr is the address of the first byte of the object code.*/
+/*Error messages go to err_file.  Returns true when object code was generated.*/
+bool bAssembleText (const string& sText, bool bListing, string& sListing, string& sObject, int& iLoadAddr){
+    bool bTerminate=false;
+    int iErrorIndex=0; /*Index for pLineErrors[]*/
+    if (bEditSession){
+        vEndEdits();
     }
-    if (bVersion){
-        vVersionNumber();
+    chrono::steady_clock::time_point tPhase=chrono::steady_clock::now();
+    vStartStatistics();
+    vSetSource(sText);
+    if (pACode == NULL){
+        vGrowCodeTable ();
     }
-    vInitGlobalTables ();
-    while (!(in_file.eof() || bTerminate)){ /*First pass of assembler*/
+    while (!(bEndOfSource() || bTerminate)){ /*First pass of assembler*/
         vGetLine();
         vProcessSourceLine (bTerminate);
         if (pACode[iCodeIndex]->bIsError()){
-            iLineErrors[iErrorIndex++]=iCodeIndex;
+            pLineErrors[iErrorIndex++]=iCodeIndex;
         }
         iCodeIndex++;
+        if (iCodeIndex>=iCodeTableSize){
+            vGrowCodeTable ();
+        }
     } 
-    in_file.close();
+    vEndPhase(ePH_FIRSTPASS, tPhase);
+    return bFinishAssembly(bTerminate, iErrorIndex, bListing, sListing, sObject, iLoadAddr, tPhase);
+}
+
+/*Replaces the code of line iLine with pNew.  An edit session keeps the old*/
+/*code, which is still what the first pass made of the line.*/
+void vReplaceCode (int iLine, ACode* pNew){
+    if (!bEditSession){
+        delete pACode[iLine];
+    }
+    pACode[iLine]=pNew;
+}
+
+/*The assembly after the first pass has made pACode, pLineErrors and the symbol*/
+/*table: resolves the symbols, relocates the code for a .BURN, and generates the*/
+/*listing and the object code or the error messages.  Returns true when object*/
+/*code was generated.*/
+bool bFinishAssembly (bool bTerminate, int iErrorIndex, bool bListing, string& sListing, string& sObject,
+                      int& iLoadAddr, chrono::steady_clock::time_point tPhase){
+    Valid* pValid;
+    int i;
+    int j;
+    bool bTemp=false;
+    bool bGenerated=false;
     sUndeclaredsSymbolNode* q;
     i=0;
     while (pUndeclaredSym!=NULL){ /*Check for undeclared symbols and resolve addresses*/
         if (!bLookUpSymbol(pUndeclaredSym->cSymID)){
-            delete pACode[pUndeclaredSym->iLine];
-            pACode[pUndeclaredSym->iLine]=new eSymNotDefined;
+            vReplaceCode(pUndeclaredSym->iLine, new eSymNotDefined);
             int iTemp=0;
-            while ((i<iErrorIndex) && (iLineErrors[i]<pUndeclaredSym->iLine)){
+            while ((i<iErrorIndex) && (pLineErrors[i]<pUndeclaredSym->iLine)){
                 i++;
             }
-            if (iLineErrors[i]!=pUndeclaredSym->iLine){
-                iTemp=iLineErrors[i];
-                iLineErrors[i]=pUndeclaredSym->iLine; /*Insert new error line number*/
+            if ((i == iErrorIndex) || (pLineErrors[i]!=pUndeclaredSym->iLine)){
+                iTemp=pLineErrors[i];
+                pLineErrors[i]=pUndeclaredSym->iLine; /*Insert new error line number*/
                 for (j=iErrorIndex + 1; j>i + 1; j--){
-                    iLineErrors[j]=iLineErrors[j - 1]; /*Shift values to the right*/
+                    pLineErrors[j]=pLineErrors[j - 1]; /*Shift values to the right*/
                 }
-                iLineErrors[j]=iTemp;
+                pLineErrors[j]=iTemp;
+                iErrorIndex++; /*A line with two undefined symbols is one error*/
             }
-            iErrorIndex++;
         }
         q=pUndeclaredSym; /*Deallocate pUndeclaredSym linked list*/
         pUndeclaredSym=pUndeclaredSym->pNext;
         delete q;
     }
+    vEndPhase(ePH_RESOLVE, tPhase);
     if ((iBurnCounter>0) && (iErrorIndex == 0)){ /*Change addresses and symbol values if a .BURN was encountered*/
         iBurnStart=iBurnStart - iCurrentAddress + 1;
         vChangeSymValBurn(iBurnStart);
         sEquateNode* p=pEquate;
         while (p!=NULL){
-            vChangeSymValEquate(p->cSymID, p->cSymValue);
+            vChangeSymValEquate(p->cSymID, p->iSymValue);
             p=p->pNext;
         }
         iBurnAddr=iBurnAddr + iBurnStart;
@@ -4529,53 +4954,39 @@ int main (int argc, char *argv[]){
             pValid->vBurnAddressChange();
         }
     }
+    vEndPhase(ePH_BURN, tPhase);
     if ((iErrorIndex == 0) && (bTerminate) && (bListing)){ /*Create assembler listing*/
-        strncpy (listingFileName, sourceFileName, FILE_NAME_LENGTH);
-        strcat(listingFileName, "l");
-        out_file.open(listingFileName);
-        out_file << setiosflags(ios::fixed) << setiosflags(ios::showpoint)
-                 << setprecision(2);
+        out_file.open(sListing);
+        vProfileRule();
         out_file << "-------------------------------------------------------------------------------" << endl;
+        vProfileHeading("                   ");/*19 spaces*/
         out_file << "      Object" << endl;/*6 spaces*/
-        if (pSymbol == NULL){
+        vProfileHeading("     Count      %  ");
+        if (iSymbolCount == 0){
             out_file << "Addr  code   Mnemon  Operand       Comment" << endl;/*7 spaces*/
         }
         else{
             out_file << "Addr  code   Symbol   Mnemon  Operand       Comment" << endl;
         }
+        vProfileRule();
         out_file << "-------------------------------------------------------------------------------" << endl;
-        for (iSecPassCodeIndex=0; iSecPassCodeIndex<iCodeIndex; iSecPassCodeIndex++){
-            pACode[iSecPassCodeIndex]->vGenerateCode ();
-            if ((pComment!=NULL) && (pComment->iLine == iSecPassCodeIndex)){
-                if (pComment->bNonemptyLine){
-                    if (pSymbol == NULL){
-                        pComment->cComment[COMMENT_LENGTH_NONEMPTY_NO_SYMBOLS - 1]='\0';
-                    }
-                    else{
-                        pComment->cComment[COMMENT_LENGTH_NONEMPTY - 1]='\0';
-                    }
-                }
-                out_file << ";" << pComment->cComment;
-                sCommentNode* p=pComment; /*Deallocate pComment linked list*/
-                pComment=pComment->pNext;
-                delete p;
-            }
-            out_file << endl;
-        }
+        vGenerateLines(true);
+        vProfileRule();
         out_file << "-------------------------------------------------------------------------------" << endl;
-        if (pSymbol!=NULL) { /*Output symbol table for assembler listing*/
+        if (iSymbolCount>0) { /*Output symbol table for assembler listing*/
             out_file << endl << endl;
             out_file << "Symbol table" << endl;
             out_file << "--------------------------------------" << endl;
             out_file << "Symbol    Value        Symbol    Value" << endl;/*8 spaces*/
             out_file << "--------------------------------------" << endl;
-            sSymbolNode* p=pSymbol;
+            sSymbolNode** pSorted=pSortedSymbols();
+            char cSymVal[ADDR_LENGTH + 1];
             bTemp=false;
-            while (p!=NULL){
-                out_file << p->cSymID;
-                vSymbolListingBuffer(p->cSymID);
-                out_file << " " << p->cSymValue;
-                p=p->pNext;
+            for (i=0; i<iSymbolCount; i++){
+                out_file << pSorted[i]->cSymID;
+                vSymbolListingBuffer(pSorted[i]->cSymID);
+                vDecToHexWord(pSorted[i]->iSymValue, cSymVal);
+                out_file << " " << cSymVal;
                 if (bTemp){
                     out_file << endl;
                     bTemp=false;
@@ -4585,6 +4996,7 @@ int main (int argc, char *argv[]){
                     bTemp=true;
                 }
             }
+            delete [] pSorted;
             if (bTemp){
                 out_file << endl;
             }
@@ -4592,58 +5004,799 @@ int main (int argc, char *argv[]){
         }
         out_file.close();
     }
+    vEndPhase(ePH_LISTING, tPhase);
     if ((iErrorIndex == 0) && (bTerminate)) {/*Generate object file*/
-        strncpy (objectFileName, sourceFileName, FILE_NAME_LENGTH);
-        strcat(objectFileName, "o");
-        out_file.open(objectFileName);
-        out_file << setiosflags(ios::fixed) << setiosflags(ios::showpoint)
-                 << setprecision(2);
-        for (iSecPassCodeIndex=0; iSecPassCodeIndex<iCodeIndex; iSecPassCodeIndex++){
-            pValid=static_cast <Valid*> (pACode[iSecPassCodeIndex]);
-            pValid->vGenerateHexCode (false);
-        }
+        out_file.open(sObject);
+        vGenerateLines(false);
         out_file << "zz" << endl;
         out_file.close();
+        iLoadAddr=(iBurnCounter>0) ? iBurnAddr : 0;
+        if (bSymbolFile){
+            vSymbolText(sSymbolText);
+        }
+        bGenerated=true;
+        vEndPhase(ePH_OBJECT, tPhase);
     }
     else {
         /*Errors were detected*/
         if (!bTerminate) {/*To account for absence of .END pseudo-op*/
-            delete pACode[iCodeIndex];
-            pACode[iCodeIndex]=new eNoEnd;
-            iLineErrors[iErrorIndex++]=iCodeIndex;
+            vReplaceCode(iCodeIndex, new eNoEnd);
+            pLineErrors[iErrorIndex++]=iCodeIndex;
         }
-        cerr << iErrorIndex;
+        err_file << iErrorIndex;
         if (iErrorIndex == 1){
-            cerr << " error was detected. No object code generated." << endl;
+            err_file << " error was detected. No object code generated." << endl;
         }
         else{
-            cerr << " errors were detected. No object code generated." << endl;
+            err_file << " errors were detected. No object code generated." << endl;
         }
         for (i=0; i<iErrorIndex; i++) {/*Generate error messages*/
-            cerr << "Error on line "<< iLineErrors[i] + 1 << ": ";
-            pACode[iLineErrors[i]]->vGenerateCode ();
+            err_file << "Error on line "<< pLineErrors[i] + 1 << ": ";
+            pACode[pLineErrors[i]]->vGenerateCode ();
         }
     }
-    sSymbolNode* p;
-    while (pSymbol!=NULL) {/*Deallocate pSymbol linked list*/
-        p=pSymbol;
-        pSymbol=pSymbol->pNext;
-        delete p;
+    statistics.lLines=iCodeIndex;
+    statistics.lSymbols=iSymbolCount;
+    statistics.lTokens+=lTokenCount;
+    statistics.lAllocations+=aCodeArena.lAllocationCount() + aTokenArena.lAllocationCount();
+    statistics.lBytes+=aCodeArena.lAllocatedBytes() + aTokenArena.lAllocatedBytes();
+    if (bEditSession){
+        vResetEditPass();
+    }
+    else{
+        vResetAssembler();
+    }
+    return bGenerated;
+}
+
+/*Incremental assembly.  An edit session keeps the lines of the program with*/
+/*what the first pass made of each: its code, the symbol it declares and its*/
+/*comment, symbol and .EQUATE nodes.  After an edit only the new lines are*/
+/*parsed again, and the lines after them are moved to their new addresses,*/
+/*unless what a line was parsed with has changed: whether its symbol was*/
+/*declared before, or whether it ends past CODE_MAX_SIZE.  A program with a*/
+/*.BURN is parsed again in full, because the relocation changes its code.*/
+struct sSourceLine{
+    const char* pText; /*The line, ending in '\n', in aCodeArena*/
+    int iLength; /*Characters in pText, with the '\n'*/
+    ACode* pCode; /*What the first pass made of it, NULL until it is parsed*/
+    int iAddress; /*Where it starts*/
+    int iSize; /*Bytes it takes*/
+    bool bTerm; /*It ended the first pass*/
+    bool bTooLong; /*It ends past CODE_MAX_SIZE*/
+    bool bDuplicate; /*Its symbol was declared by an earlier line*/
+    bool bBurn; /*It is a .BURN*/
+    sSymbolNode* pSymbol; /*The symbol it installed, or NULL*/
+    sEquateNode* pEquate; /*Its .EQUATE, or NULL*/
+    sSymbolOutputNode* pSymbols; /*Its nodes of the pSymbolOutput list, NULL if none*/
+    sSymbolOutputNode* pSymbolsTail;
+    sCommentNode* pComments; /*... of the pComment list*/
+    sCommentNode* pCommentsTail;
+    sUndeclaredsSymbolNode* pUndeclared; /*... of the pUndeclaredSym list*/
+    sUndeclaredsSymbolNode* pUndeclaredTail;
+};
+
+const int EDIT_RELOAD_LINES=4096; /*Lines parsed in an edit session, over four per line, before its arena is renewed*/
+thread_local vector<sSourceLine> editLines; /*The lines of the edit session, and the empty line the first pass reads after the source*/
+thread_local bool bEditBurned=false; /*The last assembly of the edit session relocated its code for a .BURN*/
+thread_local long lEditParses=0; /*Lines parsed since the arena of the edit session was new*/
+
+/*Appends the lines of sText to lines, as vSetSource() reads them: every line*/
+/*ends in '\n', and a '\r' before it is dropped.  The text is copied to aCodeArena.*/
+void vSplitEditLines (const string& sText, vector<sSourceLine>& lines){
+    size_t iStart=0;
+    while (iStart<sText.size()){
+        size_t iEnd=sText.find('\n', iStart);
+        size_t iLength=((iEnd == string::npos) ? sText.size() : iEnd) - iStart;
+        if ((iEnd!=string::npos) && (iLength>0) && (sText[iEnd - 1] == '\r')){
+            iLength--;
+        }
+        char* pText=static_cast <char*> (aCodeArena.pAllocate(iLength + 1));
+        memcpy(pText, sText.data() + iStart, iLength);
+        pText[iLength]='\n';
+        sSourceLine line;
+        memset(&line, 0, sizeof (line));
+        line.pText=pText;
+        line.iLength=iLength + 1;
+        lines.push_back(line);
+        iStart=(iEnd == string::npos) ? sText.size() : iEnd + 1;
+    }
+}
+
+/*Ends the edit session, if there is one, and frees its lines and code*/
+void vEndEdits (){
+    if (!bEditSession){
+        return;
+    }
+    for (size_t i=0; (i<editLines.size()) && (static_cast <int> (i)<iCodeTableSize); i++){
+        pACode[i]=NULL;
+    }
+    iCodeIndex=0;
+    editLines.clear();
+    bEditSession=false;
+    bEditBurned=false;
+    lEditParses=0;
+    vResetAssembler();
+}
+
+/*Starts an edit session with the program sText*/
+void vStartEdits (const string& sText){
+    vEndEdits();
+    bEditSession=true;
+    vSplitEditLines(sText, editLines);
+    sSourceLine line;
+    memset(&line, 0, sizeof (line));
+    line.pText="\n";
+    line.iLength=1;
+    editLines.push_back(line);
+}
+
+/*Parses line iCodeIndex of the edit session at iCurrentAddress, with the*/
+/*symbols of the lines before it in the symbol table*/
+void vParseEditLine (bool& bTerminate){
+    sSourceLine& line=editLines[iCodeIndex];
+    int iStart=iCurrentAddress;
+    int iBurns=iBurnCounter;
+    pSymbolOutput=NULL;
+    pComment=NULL;
+    pUndeclaredSym=NULL;
+    pEquate=NULL;
+    cLine=line.pText;
+    iLineIndex=0;
+    vProcessSourceLine(bTerminate);
+    line.pCode=pACode[iCodeIndex];
+    line.iAddress=iStart;
+    line.iSize=iCurrentAddress - iStart;
+    line.bTerm=bTerminate;
+    line.bTooLong=(iCurrentAddress>=CODE_MAX_SIZE - 2);
+    line.bBurn=(iBurnCounter!=iBurns);
+    line.pSymbols=pSymbolOutput;
+    line.pSymbolsTail=(pSymbolOutput!=NULL) ? pSymbolOutputTail : NULL;
+    line.pComments=pComment;
+    line.pCommentsTail=(pComment!=NULL) ? pCommentTail : NULL;
+    line.pUndeclared=pUndeclaredSym;
+    line.pUndeclaredTail=(pUndeclaredSym!=NULL) ? pUndeclaredSymTail : NULL;
+    line.pEquate=pEquate;
+    line.pSymbol=NULL;
+    line.bDuplicate=false;
+    if (pSymbolOutput!=NULL){
+        sSymbolNode* p=pFindSymbol(pSymbolOutput->cSymID);
+        line.bDuplicate=(p->iLine!=iCodeIndex);
+        line.pSymbol=line.bDuplicate ? NULL : p;
+    }
+    lEditParses++;
+}
+
+/*The first pass of an edit session.  Goes through the lines in order, like*/
+/*the first pass of bAssembleText(), but parses only those that are new or*/
+/*whose context has changed, or all of them if bAll.  Builds pACode,*/
+/*pLineErrors, the symbol table and the lists of the lines that were reached.*/
+/*Returns true if the program has a .BURN.*/
+bool bEditFirstPass (bool bAll, bool& bTerminate, int& iErrorIndex){
+    bool bBurn=false;
+    if (pSymbolTable == NULL){
+        vGrowSymbolTable();
+    }
+    for (int i=0; i<iSymbolTableSize; i++){
+        pSymbolTable[i]=NULL;
+    }
+    iSymbolCount=0;
+    iCurrentAddress=0;
+    iBurnCounter=0;
+    iBurnStart=0;
+    iBurnAddr=0;
+    bTerminate=false;
+    iErrorIndex=0;
+    for (iCodeIndex=0; (iCodeIndex<static_cast <int> (editLines.size())) && !bTerminate; iCodeIndex++){
+        while (iCodeIndex + 1>=iCodeTableSize){
+            vGrowCodeTable ();
+        }
+        sSourceLine& line=editLines[iCodeIndex];
+        bool bParse=bAll || (line.pCode == NULL)
+            || ((iCurrentAddress + line.iSize>=CODE_MAX_SIZE - 2)!=line.bTooLong);
+        if ((!bParse) && (line.pSymbols!=NULL)){
+            bParse=((pFindSymbol(line.pSymbols->cSymID)!=NULL)!=line.bDuplicate);
+        }
+        if (bParse){
+            vParseEditLine(bTerminate);
+        }
+        else{
+            if ((line.iAddress!=iCurrentAddress) && !line.pCode->bIsError()){
+                iBurnStart=iCurrentAddress - line.iAddress; /*As a .BURN moves the code*/
+                static_cast <Valid*> (line.pCode)->vBurnAddressChange();
+                iBurnStart=0;
+            }
+            line.iAddress=iCurrentAddress;
+            if (line.pSymbol!=NULL){
+                if (2 * (iSymbolCount + 1)>iSymbolTableSize){
+                    vGrowSymbolTable();
+                }
+                line.pSymbol->iLine=iCodeIndex;
+                if (line.pEquate == NULL){
+                    line.pSymbol->iSymValue=iWordValue(iCurrentAddress);
+                }
+                *pFindSymbolSlot(line.pSymbol->cSymID)=line.pSymbol;
+                iSymbolCount++;
+            }
+            iCurrentAddress+=line.iSize;
+            bTerminate=line.bTerm;
+            pACode[iCodeIndex]=line.pCode;
+        }
+        bBurn=bBurn || line.bBurn;
+        if (pACode[iCodeIndex]->bIsError()){
+            pLineErrors[iErrorIndex++]=iCodeIndex;
+        }
+    }
+    if (bAll){ /*The lines after the end were parsed with a .BURN before them that may be gone*/
+        for (size_t i=iCodeIndex; i<editLines.size(); i++){
+            editLines[i].pCode=NULL;
+        }
+    }
+    /*Link the nodes of the lines that were reached into the lists of the assembly*/
+    pSymbolOutput=NULL;
+    pComment=NULL;
+    pUndeclaredSym=NULL;
+    pEquate=NULL;
+    for (int i=iCodeIndex - 1; i>=0; i--){ /*Backwards, so each list is built from its end*/
+        sSourceLine& line=editLines[i];
+        if (line.pSymbols!=NULL){
+            for (sSymbolOutputNode* p=line.pSymbols; ; p=p->pNext){
+                p->iLine=i;
+                if (p == line.pSymbolsTail){
+                    break;
+                }
+            }
+            line.pSymbolsTail->pNext=pSymbolOutput;
+            pSymbolOutput=line.pSymbols;
+        }
+        if (line.pComments!=NULL){
+            for (sCommentNode* p=line.pComments; ; p=p->pNext){
+                p->iLine=i;
+                if (p == line.pCommentsTail){
+                    break;
+                }
+            }
+            line.pCommentsTail->pNext=pComment;
+            pComment=line.pComments;
+        }
+        if (line.pUndeclared!=NULL){
+            for (sUndeclaredsSymbolNode* p=line.pUndeclared; ; p=p->pNext){
+                p->iLine=i;
+                if (p == line.pUndeclaredTail){
+                    break;
+                }
+            }
+            line.pUndeclaredTail->pNext=pUndeclaredSym;
+            pUndeclaredSym=line.pUndeclared;
+        }
+    }
+    for (int i=0; i<iCodeIndex; i++){ /*pEquate is built from its front, as vInstallEquateNode() does*/
+        if (editLines[i].pEquate!=NULL){
+            editLines[i].pEquate->pNext=pEquate;
+            pEquate=editLines[i].pEquate;
+        }
+    }
+    return bBurn;
+}
+
+bool bAssembleEdit (int iFirst, int iCount, const string& sLines, bool bListing, string& sListing,
+                    string& sObject, int& iLoadAddr){
+    bool bTerminate=false;
+    int iErrorIndex=0;
+    if (!bEditSession){
+        vStartEdits("");
+    }
+    int iLines=static_cast <int> (editLines.size()) - 1;
+    if ((iFirst<1) || (iCount<0) || (iFirst - 1>iLines - iCount)){
+        err_file << "Lines " << iFirst << " to " << iFirst + iCount - 1 << " are not in the program of "
+                 << iLines << " lines." << endl;
+        return false;
+    }
+    chrono::steady_clock::time_point tPhase=chrono::steady_clock::now();
+    if (lEditParses>4L * iLines + EDIT_RELOAD_LINES){ /*Free the code of the lines that were replaced*/
+        string sText;
+        for (int i=0; i<iLines; i++){
+            sText.append(editLines[i].pText, editLines[i].iLength);
+        }
+        vStartEdits(sText);
+    }
+    vStartStatistics();
+    vector<sSourceLine> lines;
+    vSplitEditLines(sLines, lines);
+    editLines.erase(editLines.begin() + iFirst - 1, editLines.begin() + iFirst - 1 + iCount);
+    editLines.insert(editLines.begin() + iFirst - 1, lines.begin(), lines.end());
+    if (pACode == NULL){
+        vGrowCodeTable ();
+    }
+    bool bBurn=bEditFirstPass(bEditBurned, bTerminate, iErrorIndex);
+    if (bBurn && !bEditBurned){
+        bEditFirstPass(true, bTerminate, iErrorIndex);
+    }
+    bEditBurned=bBurn;
+    vEndPhase(ePH_FIRSTPASS, tPhase);
+    return bFinishAssembly(bTerminate, iErrorIndex, bListing, sListing, sObject, iLoadAddr, tPhase);
+}
+
+/*Reads the execution counts that pep8 -P writes, lines of an address in hex*/
+/*and a count, into pProfileCount.  Returns false if the file cannot be read.*/
+bool bReadProfile (const char cName[]){
+    ifstream file(cName);
+    unsigned int iAddr;
+    long lCount;
+    if (!file.is_open()){
+        return false;
+    }
+    pProfileCount=new long[MAX_ADDR + 1];
+    memset(pProfileCount, 0, (MAX_ADDR + 1) * sizeof (long));
+    lProfileTotal=0;
+    while (file >> hex >> iAddr >> dec >> lCount){
+        if ((iAddr>MAX_ADDR) || (lCount<0)){
+            return false;
+        }
+        pProfileCount[iAddr]+=lCount;
+        lProfileTotal+=lCount;
+    }
+    return file.eof();
+}
+
+/*bAssembleText for the whole text of source*/
+bool bAssembleSource (istream& source, bool bListing, string& sListing, string& sObject, int& iLoadAddr){
+    ostringstream text;
+    text << source.rdbuf();
+    return bAssembleText(text.str(), bListing, sListing, sObject, iLoadAddr);
+}
+
+/*Writes sText to the file named cName[]*/
+void vWriteFile (const char cName[], const string& sText){
+    ofstream file(cName);
+    file.write(sText.data(), sText.size());
+}
+
+/*Writes the object code sObject as a binary object file named cName[]:*/
+/*the 4 bytes PEPB, then the load address and the length as big endian words,*/
+/*the size and the 32-bit FNV-1a hash of the text sObject as big endian longs,*/
+/*the bytes themselves, and their sum modulo 65536 as a big endian word.*/
+/*pep8 uses the file only while the .pepo file still has that size and hash.*/
+void vWriteBinaryFile (const char cName[], const string& sObject, int iLoadAddr){
+    string sBinary(BINARY_HEADER_LENGTH, ' ');
+    unsigned int iHash=2166136261u;
+    unsigned int iSize=sObject.size();
+    int iSum=0;
+    int iLength;
+    for (size_t i=0; (i + 1<sObject.size()) && (sObject[i]!='z'); i++){
+        if (isxdigit(sObject[i])){
+            int iByte=HEX * iHexToDec(sObject[i]) + iHexToDec(sObject[i + 1]);
+            sBinary.push_back(static_cast <char> (iByte));
+            iSum+=iByte;
+            i++;
+        }
+    }
+    for (size_t i=0; i<sObject.size(); i++){
+        iHash=(iHash ^ static_cast <unsigned char> (sObject[i])) * 16777619u;
+    }
+    iLength=sBinary.size() - BINARY_HEADER_LENGTH;
+    sBinary.replace(0, 4, "PEPB");
+    sBinary[4]=static_cast <char> (iLoadAddr / HEX2);
+    sBinary[5]=static_cast <char> (iLoadAddr % HEX2);
+    sBinary[6]=static_cast <char> (iLength / HEX2);
+    sBinary[7]=static_cast <char> (iLength % HEX2);
+    for (int i=0; i<4; i++){
+        sBinary[8 + i]=static_cast <char> ((iSize >> (24 - 8 * i)) & MAX_BYTE);
+        sBinary[12 + i]=static_cast <char> ((iHash >> (24 - 8 * i)) & MAX_BYTE);
+    }
+    sBinary.push_back(static_cast <char> ((iSum / HEX2) & MAX_BYTE));
+    sBinary.push_back(static_cast <char> (iSum & MAX_BYTE));
+    ofstream file(cName, ios::binary);
+    file.write(sBinary.data(), sBinary.size());
+}
+
+/*Adds the bytes of sText to the 64-bit FNV-1a hash lHash*/
+unsigned long long lHashText (unsigned long long lHash, const string& sText){
+    for (size_t i=0; i<sText.size(); i++){
+        lHash=(lHash ^ static_cast <unsigned char> (sText[i])) * FNV_PRIME;
+    }
+    return lHash;
+}
+
+/*Reads the whole file cName[] into sText.  Returns false if it cannot be opened.*/
+bool bReadFile (const char cName[], string& sText){
+    ifstream file(cName, ios::binary);
+    if (!file.is_open()){
+        return false;
+    }
+    ostringstream text;
+    text << file.rdbuf();
+    sText=text.str();
+    return true;
+}
+
+/*Starts the assembly cache in directory cDir[], which is created if need be.*/
+/*The key of an entry covers the assembler and output versions and the trap*/
+/*file as well as the source text, so changing any of them misses.*/
+void vInitCache (const char cDir[]){
+    string sTrap;
+    sCacheDir=cDir;
+    mkdir(cDir, 0777);
+    bReadFile("trap", sTrap);
+    lCacheSeed=lHashText(lHashText(lHashText(FNV_OFFSET, VERSION), OUTPUT_VERSION), sTrap);
+}
+
+/*Looks sSource up in the assembly cache.  An entry is a line*/
+/*    PEPC1 generated loadaddr sourcelen objlen listlen errlen*/
+/*followed by the source text, the object code, the listing and the error messages.*/
+/*The source is compared too, so a hash collision is a miss.*/
+bool bReadCacheEntry (const string& sFile, const string& sSource, bool& bGenerated, int& iLoadAddr,
+                      string& sObject, string& sListing, string& sErrors){
+    ifstream file(sFile.c_str(), ios::binary);
+    string sMagic;
+    int iGenerated;
+    size_t iSource, iObject, iListing, iErrors;
+    if (!(file >> sMagic >> iGenerated >> iLoadAddr >> iSource >> iObject >> iListing >> iErrors)
+        || (sMagic!="PEPC1") || (file.get()!='\n') || (iSource!=sSource.size())){
+        return false;
     }
-    sSymbolOutputNode* qTemp;
-    while (pSymbolOutput!=NULL) {/*Deallocate pSymbolOutput linked list*/
-        qTemp=pSymbolOutput;
-        pSymbolOutput=pSymbolOutput->pNext;
-        delete qTemp;
+    string sText(iSource + iObject + iListing + iErrors, '\0');
+    file.read(&sText[0], sText.size());
+    if ((static_cast <size_t> (file.gcount())!=sText.size()) || (sText.compare(0, iSource, sSource)!=0)){
+        return false;
     }
-    sEquateNode* pTemp;
-    while (pEquate!=NULL) {/*Deallocate pEquate linked list*/
-        pTemp=pEquate;
-        pEquate=pEquate->pNext;
-        delete pTemp;
+    bGenerated=(iGenerated!=0);
+    sObject.assign(sText, iSource, iObject);
+    sListing.assign(sText, iSource + iObject, iListing);
+    sErrors.assign(sText, iSource + iObject + iListing, iErrors);
+    return true;
+}
+
+/*Writes a cache entry under a name of its own and renames it into place, so that*/
+/*concurrent assemblers sharing the cache never read half an entry.*/
+/*A cache that cannot be written to is skipped.*/
+void vWriteCacheEntry (const string& sFile, const string& sSource, bool bGenerated, int iLoadAddr,
+                       const string& sObject, const string& sListing, const string& sErrors){
+    ostringstream tempName;
+    tempName << sFile << "." << getpid() << "." << this_thread::get_id();
+    ofstream file(tempName.str().c_str(), ios::binary);
+    file << "PEPC1 " << (bGenerated ? 1 : 0) << " " << iLoadAddr << " " << sSource.size() << " "
+         << sObject.size() << " " << sListing.size() << " " << sErrors.size() << "\n";
+    file << sSource << sObject << sListing << sErrors;
+    file.close();
+    if (file.fail() || (rename(tempName.str().c_str(), sFile.c_str())!=0)){
+        remove(tempName.str().c_str());
     }
-    for (i=0; i<=iCodeIndex; i++) {/*Deallocate pACode array*/
-        delete pACode[i];
+}
+
+/*bAssembleSource for the source text sSource, through the assembly cache.*/
+/*A miss is assembled with the listing, so that the entry serves either way.*/
+bool bAssembleCached (const string& sSource, string& sListing, string& sObject, int& iLoadAddr){
+    ostringstream name;
+    string sErrors;
+    bool bGenerated;
+    name << sCacheDir << "/" << hex << setw(16) << setfill('0') << lHashText(lCacheSeed, sSource) << ".pepc";
+    if (bReadCacheEntry(name.str(), sSource, bGenerated, iLoadAddr, sObject, sListing, sErrors)){
+        memset(&statistics, 0, sizeof (statistics));
+        statistics.bCacheHit=true;
+        err_file << sErrors;
+        return bGenerated;
+    }
+    size_t iErrorStart=err_file.str().size();
+    iLoadAddr=0;
+    bGenerated=bAssembleText(sSource, true, sListing, sObject, iLoadAddr);
+    vWriteCacheEntry(name.str(), sSource, bGenerated, iLoadAddr, sObject, sListing, err_file.str().substr(iErrorStart));
+    return bGenerated;
+}
+
+/*Writes the statistics of the last assembly for -s*/
+void vPrintStatistics (ostream& output){
+    const char* const cPhaseName[ePH_EMPTY]={"  first pass         ", "  symbol resolution  ", "  .BURN relocation   ",
+                                             "  listing            ", "  object code        "};
+    double dTotal=0;
+    output << endl << "Assembly statistics" << endl;
+    if (statistics.bCacheHit){
+        output << "Read from the assembly cache" << endl;
+        return;
+    }
+    output << "Source lines          " << setw(14) << statistics.lLines << endl;
+    output << "Symbols               " << setw(14) << statistics.lSymbols << endl;
+    output << "Tokens                " << setw(14) << statistics.lTokens << endl;
+    output << "Arena allocations     " << setw(14) << statistics.lAllocations << endl;
+    output << "Arena bytes           " << setw(14) << statistics.lBytes << endl;
+    for (int i=0; i<ePH_EMPTY; i++){
+        dTotal+=statistics.dPhaseSeconds[i];
+    }
+    output << "Seconds               " << setw(14) << fixed << setprecision(6) << dTotal << endl;
+    for (int i=0; i<ePH_EMPTY; i++){
+        output << cPhaseName[i] << " " << setw(14) << statistics.dPhaseSeconds[i] << endl;
+    }
+    output.unsetf(ios::floatfield);
+}
+
+/*Assembles sourceFileName[] into its object file, and its listing if bListing.*/
+/*Error messages go to err_file.  Returns 0, or 3 if the file could not be opened.*/
+int iAssembleFile (const char sourceFileName[], bool bListing){
+    char objectFileName[FILE_NAME_LENGTH];
+    char listingFileName[FILE_NAME_LENGTH];
+    string sListing;
+    string sObject;
+    string sSource;
+    int iLoadAddr;
+    bool bGenerated;
+    if (!bReadFile(sourceFileName, sSource)){
+        err_file << "Could not open " << sourceFileName << "." << endl;
+        return 3;
+    }
+    bGenerated=(sCacheDir.empty() || (pProfileCount!=NULL) || bSymbolFile) ? bAssembleText(sSource, bListing, sListing, sObject, iLoadAddr)
+                                                                            : bAssembleCached(sSource, sListing, sObject, iLoadAddr);
+    if (bStatistics){
+        vPrintStatistics(err_file);
+    }
+    if (bGenerated){
+        if (bListing){
+            strncpy (listingFileName, sourceFileName, FILE_NAME_LENGTH);
+            strcat(listingFileName, "l");
+            vWriteFile(listingFileName, sListing);
+        }
+        strncpy (objectFileName, sourceFileName, FILE_NAME_LENGTH);
+        strcat(objectFileName, "o");
+        vWriteFile(objectFileName, sObject);
+        if (bBinaryObject){
+            objectFileName[strlen(objectFileName) - 1]='b';
+            vWriteBinaryFile(objectFileName, sObject, iLoadAddr);
+        }
+        if (bSymbolFile){
+            objectFileName[strlen(objectFileName) - 1]='s';
+            vWriteFile(objectFileName, sSymbolText);
+        }
     }
     return 0;
 }
+
+/*Service mode.  Each request on standard input is a line with the length of*/
+/*the source text, then the text.  A request of an edit session is a line with*/
+/*"edit", the first line and the number of lines it replaces and the length,*/
+/*then the lines that replace them, as for bAssembleEdit.  Each response on*/
+/*standard output is a line with the status, 0 if object code was generated*/
+/*and 1 if not, and the lengths of the object code, the listing and the error*/
+/*messages, then those three.  Returns 0 at the end of the input, or 2 for a*/
+/*malformed request.*/
+int iServeRequests (){
+    string sText;
+    string sListing;
+    string sObject;
+    string sErrors;
+    string sWord;
+    long lLength;
+    int iFirst=0;
+    int iCount=0;
+    int iLoadAddr;
+    while (cin >> sWord){
+        bool bEdit=(sWord == "edit");
+        char* pEnd;
+        if (bEdit){
+            if (!(cin >> iFirst >> iCount >> lLength)){
+                break;
+            }
+        }
+        else{
+            lLength=strtol(sWord.c_str(), &pEnd, 10);
+            if (*pEnd!='\0'){
+                cerr << "Malformed request" << endl;
+                return 2;
+            }
+        }
+        if ((lLength<0) || (cin.get()!='\n')){
+            cerr << "Malformed request" << endl;
+            return 2;
+        }
+        sText.resize(lLength);
+        cin.read(&sText[0], lLength);
+        if (cin.gcount()!=lLength){
+            cerr << "Request ended early" << endl;
+            return 2;
+        }
+        bool bGenerated=bEdit ? bAssembleEdit(iFirst, iCount, sText, true, sListing, sObject, iLoadAddr)
+                      : sCacheDir.empty() ? bAssembleText(sText, true, sListing, sObject, iLoadAddr)
+                                          : bAssembleCached(sText, sListing, sObject, iLoadAddr);
+        if (!bGenerated){
+            sListing.clear();
+            sObject.clear();
+        }
+        sErrors=err_file.str();
+        err_file.str("");
+        cout << (bGenerated ? 0 : 1) << " " << sObject.size() << " " << sListing.size() << " " << sErrors.size() << "\n";
+        cout << sObject << sListing << sErrors;
+        cout.flush();
+    }
+    if (!cin.eof()){
+        cerr << "Malformed request" << endl;
+        return 2;
+    }
+    return 0;
+}
+
+/*Worker thread: assembles source files in command line order until none are left*/
+void vAssembleWorker (vector<sSourceFile>* pFiles, atomic<size_t>* pNext, bool bListing){
+    size_t iFile;
+    while ((iFile=(*pNext)++)<pFiles->size()){
+        (*pFiles)[iFile].iStatus=iAssembleFile((*pFiles)[iFile].cName, bListing);
+        (*pFiles)[iFile].sReport=err_file.str();
+        err_file.str("");
+    }
+    delete [] pACode;
+    delete [] pLineErrors;
+    pACode=NULL;
+    pLineErrors=NULL;
+    iCodeTableSize=0;
+}
+
+/*Reads the unimplemented mnemonics from the trap file*/
+bool bReadTrapFile (){
+    string sTrap;
+    if (!bReadFile("trap", sTrap)){
+        cerr << "Could not open trap file." << endl;
+        return false;
+    }
+    vSetSource(sTrap);
+    for (int i = 0; i < UNIMPLEMENTED_INSTRUCTIONS; i++) {
+        vGetTrapLine(i);
+    }
+    return true;
+}
+
+bool bInitAssembler (){
+    if (!bReadTrapFile()){
+        return false;
+    }
+    vInitGlobalTables ();
+    vInitMnemonTable ();
+    return true;
+}
+
+string sAssemblerErrors (){
+    string sErrors=err_file.str();
+    err_file.str("");
+    return sErrors;
+}
+
+#ifndef ASEM8_LIBRARY
+int main (int argc, char *argv[]){
+    int i;
+    int iArg;
+    int iThreads=0;
+    int iStatus=0;
+    bool bService=false;
+    bool bListing=false;
+    bool bVersion=false;
+    const char* cCacheDir=NULL;
+    vector<sSourceFile> files;
+    chrono::steady_clock::time_point tStart=chrono::steady_clock::now();
+    /*Input trap file*/
+    if (!bReadTrapFile()){
+        return 1;
+    }
+    double dTrapSeconds=chrono::duration <double> (chrono::steady_clock::now() - tStart).count();
+   
+    /*Analyze input command*/
+    for (iArg=1; (iArg<argc) && (argv[iArg][0] == '-'); iArg++){
+        if (strcmp(argv[iArg], "-v") == 0){
+            bVersion=true;
+        }
+        else if (strcmp(argv[iArg], "-l") == 0){
+            bListing=true;
+        }
+        else if (strcmp(argv[iArg], "-d") == 0){
+            bService=true;
+        }
+        else if (strcmp(argv[iArg], "-b") == 0){
+            bBinaryObject=true;
+        }
+        else if (strcmp(argv[iArg], "-y") == 0){
+            bSymbolFile=true;
+        }
+        else if (strcmp(argv[iArg], "-s") == 0){
+            bStatistics=true;
+        }
+        else if ((strcmp(argv[iArg], "-c") == 0) && (iArg + 1<argc)){
+            cCacheDir=argv[++iArg];
+        }
+        else if ((strcmp(argv[iArg], "-t") == 0) && (iArg + 1<argc)){
+            iThreads=atoi(argv[++iArg]);
+        }
+        else if ((strcmp(argv[iArg], "-P") == 0) && (iArg + 1<argc)){
+            if (!bReadProfile(argv[++iArg])){
+                cerr << "Could not read profile " << argv[iArg] << endl;
+                return 3;
+            }
+            bListing=true;
+        }
+        else{
+            cerr << "usage: asem8 [-v] [-l] [-b] [-y] [-s] [-P profile] [-c cachedir] [-t threads] [sourceFile ...] | asem8 [-c cachedir] -d" << endl;
+            return 2;
+        }
+    }
+    for (; iArg<argc; iArg++){
+        sSourceFile file;
+        int k = strlen(argv[iArg]);
+        if (argv[iArg][0] == '-'){
+            cerr << "usage: asem8 [-v] [-l] [-b] [-y] [-s] [-P profile] [-c cachedir] [-t threads] [sourceFile ...] | asem8 [-c cachedir] -d" << endl;
+            return 2;
+        }
+        if (k>FILE_NAME_LENGTH - 3){
+            cerr << "Source file name too long" << endl;
+            return 2;
+        }
+        if ((k<4) || (strcmp(argv[iArg] + k - 4, ".pep")!=0)){
+            cerr << "Source file should have a \".pep\" extension" << endl;
+            return 2;
+        }
+        strncpy (file.cName, argv[iArg], FILE_NAME_LENGTH);
+        file.iStatus=0;
+        files.push_back(file);
+    }
+    if (bVersion){
+        vVersionNumber();
+    }
+    if (cCacheDir!=NULL){
+        vInitCache(cCacheDir);
+    }
+    if (bService){
+        if (!files.empty()){
+            cerr << "usage: asem8 [-v] [-l] [-b] [-y] [-s] [-P profile] [-c cachedir] [-t threads] [sourceFile ...] | asem8 [-c cachedir] -d" << endl;
+            return 2;
+        }
+        vInitGlobalTables ();
+        vInitMnemonTable ();
+        return iServeRequests ();
+    }
+    if (files.empty()){
+        if ((argc == 1) || ((argc == 2) && bVersion)){
+            return 0;
+        }
+        cerr << "usage: asem8 [-v] [-l] [-b] [-y] [-s] [-P profile] [-c cachedir] [-t threads] [sourceFile ...] | asem8 [-c cachedir] -d" << endl;
+        return 2;
+    }
+    vInitGlobalTables ();
+    vInitMnemonTable ();
+    if (iThreads<=0){
+        iThreads=thread::hardware_concurrency();
+        iThreads=(iThreads<1) ? 1 : iThreads;
+    }
+    if (static_cast <size_t> (iThreads)>files.size()){
+        iGenerateThreads=iThreads / files.size(); /*The threads left over generate the code of each file*/
+        iThreads=files.size();
+    }
+    atomic<size_t> iNext (0);
+    if (iThreads == 1){
+        vAssembleWorker(&files, &iNext, bListing);
+    }
+    else{
+        vector<thread> workers;
+        for (i=0; i<iThreads; i++){
+            workers.push_back (thread (vAssembleWorker, &files, &iNext, bListing));
+        }
+        for (i=0; i<iThreads; i++){
+            workers[i].join();
+        }
+    }
+    for (size_t iFile=0; iFile<files.size(); iFile++){ /*One error report per file, in command line order*/
+        if ((files.size()>1) && (!files[iFile].sReport.empty())){
+            cerr << files[iFile].cName << ":" << endl;
+        }
+        cerr << files[iFile].sReport;
+        iStatus=(files[iFile].iStatus>iStatus) ? files[iFile].iStatus : iStatus;
+    }
+    if (bStatistics){
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        cerr << endl << "Assembler statistics" << endl;
+        cerr << "Source files          " << setw(14) << files.size() << endl;
+        cerr << "Threads               " << setw(14) << iThreads << endl;
+        cerr << "Trap file seconds     " << setw(14) << fixed << setprecision(6) << dTrapSeconds << endl;
+        cerr << "Total seconds         " << setw(14)
+             << chrono::duration <double> (chrono::steady_clock::now() - tStart).count() << endl;
+        cerr << "Peak memory (KB)      " << setw(14) << usage.ru_maxrss << endl;
+    }
+    for (i=0; i<eM_EMPTY; i++) {/*Deallocate the mnemonic objects*/
+        delete pAMnemonTable[i];
+    }
+    return iStatus;
+}
+#endif
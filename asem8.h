@@ -0,0 +1,45 @@
+//  File: asem8.h
+//  Assembler for the Pep/8 computer as described in "Computer Systems",
+//  Fourth edition, J. Stanley Warford, Jones and Bartlett, Publishers,
+//  2010.  ISBN 978-0-7637-7144-7
+//  Pepperdine University, Malibu, CA 90265
+//  Stan.Warford@pepperdine.edu
+
+//  Released under the GNU General Public License without warrenty
+//  as described in http://www.gnu.org/copyleft/gpl.html
+
+//  The assembler as a library, for programs that assemble and run in one
+//  process.  asem8.cpp compiled with ASEM8_LIBRARY defined leaves out main.
+
+#ifndef ASEM8_H
+#define ASEM8_H
+
+#include <iostream>
+#include <string>
+
+/*Reads the trap file and builds the mnemonic tables.  Returns false,*/
+/*after saying so on cerr, if the trap file could not be opened.*/
+bool bInitAssembler ();
+
+/*Assembles the program read from source into sObject, and into sListing if bListing.*/
+/*iLoadAddr is the address of the first byte of the object code.*/
+/*Returns true when object code was generated.*/
+bool bAssembleSource (std::istream& source, bool bListing, std::string& sListing,
+                      std::string& sObject, int& iLoadAddr);
+
+/*Incremental assembly, for editors that assemble a program after each change.*/
+/*The program of an edit session stays on its thread between calls, and only*/
+/*the lines that changed are parsed again.  bAssembleEdit replaces iCount lines*/
+/*of the program from line iFirst on, numbered from 1 as in the error messages,*/
+/*with the lines of sLines, and assembles the result as bAssembleSource does.*/
+/*The first call, with iFirst 1 and iCount 0, gives the whole program.*/
+bool bAssembleEdit (int iFirst, int iCount, const std::string& sLines, bool bListing,
+                    std::string& sListing, std::string& sObject, int& iLoadAddr);
+
+/*Ends the edit session of this thread.  bAssembleSource ends it too.*/
+void vEndEdits ();
+
+/*The error messages of the assemblies since the last call, on this thread*/
+std::string sAssemblerErrors ();
+
+#endif
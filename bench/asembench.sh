@@ -0,0 +1,62 @@
+#!/bin/sh
+#  File: bench/asembench.sh
+#  Scaling benchmark of the assembler.  Generates a program of each kind of
+#  bench/gensource.sh at each size, assembles it with asem8 -s and prints
+#  one tab separated line per program:
+#
+#      kind  lines  status  seconds  lines_per_second  peak_kb  scaling
+#
+#  status is 0 when the program assembled, seconds the total time that
+#  asem8 reports with -s and peak_kb its peak memory.  scaling is the time
+#  per line over the time per line of the smallest size of the same kind,
+#  near 1 while asem8 stays linear.
+#  Usage, from the directory of the makefile:
+#      sh bench/asembench.sh [-l] [lines ...]     default 10000 100000 1000000
+#  With -l the listing is generated too.
+
+ROOT=`cd \`dirname "$0"\`/.. && pwd`
+WORK=`mktemp -d "${TMPDIR:-/tmp}/asembench.XXXXXX"` || exit 1
+trap 'rm -rf "$WORK"' 0
+cp "$ROOT/trap" "$WORK"
+cd "$WORK"
+
+LISTING=
+if [ "$1" = "-l" ]
+then
+    LISTING=-l
+    shift
+fi
+SIZES="$*"
+if [ -z "$SIZES" ]
+then
+    SIZES="10000 100000 1000000"
+fi
+
+printf 'kind\tlines\tstatus\tseconds\tlines_per_second\tpeak_kb\tscaling\n'
+for kind in symbols equates data comments mixed
+do
+    base=
+    for n in $SIZES
+    do
+        sh "$ROOT/bench/gensource.sh" $n $kind > prog.pep
+        rm -f prog.pepo
+        "$ROOT/asem8" $LISTING -s prog.pep > /dev/null 2> stats.txt
+        status=0
+        if [ ! -f prog.pepo ]
+        then
+            status=1
+        fi
+        line=`awk -v kind=$kind -v n=$n -v status=$status -v base="$base" '
+            /^Total seconds/ { run = $3 }
+            /^Peak memory/ { peak = $4 }
+            END {
+                perline = (n > 0) ? run / n : 0
+                if (base == "")
+                    base = perline
+                printf "%s\t%d\t%d\t%.3f\t%.0f\t%d\t%.2f\t%.9g\n", kind, n, status, run,
+                       (run > 0 ? n / run : 0), peak, (base > 0 ? perline / base : 0), base
+            }' stats.txt`
+        base=`echo "$line" | cut -f 8`
+        echo "$line" | cut -f 1-7
+    done
+done
@@ -0,0 +1,69 @@
+#!/bin/sh
+#  File: bench/bench.sh
+#  Benchmark suite for the Pep/8 simulator.  Assembles the figure programs
+#  of chap05 and chap06 and the workloads in this directory, runs each one
+#  through pep8 in batch mode with the given pep8 options, and prints one
+#  tab separated line per program:
+#
+#      program  status  instructions  run_seconds  wall_seconds  instr_per_second
+#
+#  status is the pep8 exit status, run_seconds the execution time that pep8
+#  reports with -s and wall_seconds the time of the whole pep8 process.
+#  With -b or -x a second table follows, how often each fused form of the
+#  block cache fired over the whole suite.
+#  Usage, from the directory of the makefile:
+#      sh bench/bench.sh [pep8 options]       for example  sh bench/bench.sh -b -n
+
+ROOT=`cd \`dirname "$0"\`/.. && pwd`
+WORK=`mktemp -d "${TMPDIR:-/tmp}/pep8bench.XXXXXX"` || exit 1
+trap 'rm -rf "$WORK"' 0
+cp "$ROOT/trap" "$ROOT/pep8os.pepo" "$WORK"
+cd "$WORK"
+
+#  Input for the figures without an input file of their own
+printf '12   3 13 17 34 27 23 25 29 16 10 0 2\n-5 7 x\nhello world*\n42\n0\n*\n' > figure.in
+#  Input for the I/O workload, about 1 MB of text ended by ~
+awk 'BEGIN { for (i = 0; i < 20000; i++) print "The quick brown fox jumps over the lazy dog", i; print "~" }' > io.in
+
+now () {
+    date +%s.%N
+}
+
+: > fused.txt
+printf 'program\tstatus\tinstructions\trun_seconds\twall_seconds\tinstr_per_second\n'
+for f in "$ROOT"/chap05/*.pep "$ROOT"/chap06/*.pep "$ROOT"/bench/*.pep
+do
+    n=`basename "$f" .pep`
+    cp "$f" .
+    "$ROOT/asem8" "$n.pep" > /dev/null 2>&1
+    if [ ! -f "$n.pepo" ]
+    then
+        continue
+    fi
+    in=figure.in
+    if [ -f "`dirname "$f"`/$n.in" ]
+    then
+        cp "`dirname "$f"`/$n.in" .
+        in=$n.in
+    elif [ -f "$n.in" ]
+    then
+        in=$n.in
+    fi
+    t0=`now`
+    "$ROOT/pep8" "$@" -s -m 1000000000 -i "$in" -o /dev/null "$n.pepo" 2> stats.txt
+    status=$?
+    t1=`now`
+    awk -v n="$n" -v status=$status -v t0=$t0 -v t1=$t1 '
+        /^Instructions executed/ { instr = $3 }
+        /^Seconds/ { run = $2 }
+        END {
+            printf "%s\t%d\t%d\t%.3f\t%.3f\t%.0f\n", n, status, instr, run, t1 - t0,
+                   (run > 0 ? instr / run : 0)
+        }' stats.txt
+    awk '/^Fused/ { f = 1; next } /^$/ { f = 0 } f { print $1, $2 }' stats.txt >> fused.txt
+done
+if [ -s fused.txt ]
+then
+    printf '\nfused\tcount\n'
+    awk '{ n[$1] += $2 } END { for (f in n) printf "%s\t%d\n", f, n[f] }' fused.txt | sort
+fi
@@ -0,0 +1,93 @@
+#!/bin/sh
+#  File: bench/gensource.sh
+#  Generator of synthetic Pep/8 source programs for the assembler benchmark.
+#  Writes a program of about the given number of lines to standard output,
+#  of one of these kinds:
+#
+#      symbols   labeled instructions, each a forward reference to a symbol
+#                declared further on, which asem8 keeps in pUndeclaredSym
+#                until the end of the first pass
+#      equates   .EQUATE symbols, and instructions that use them
+#      data      .ASCII strings and .BLOCK and .WORD tables under labels
+#      comments  long comment lines and comments after instructions
+#      mixed     the four kinds above in turn
+#
+#  The object code of a program is limited to CODE_MAX_SIZE bytes, so each
+#  kind spreads a budget of BYTES bytes of code evenly over the program and
+#  fills the lines between with its forms that take no memory: .EQUATE
+#  symbols, .BLOCK 0 labels and comment lines.  The result always assembles.
+#  Usage:
+#      sh bench/gensource.sh lines kind > prog.pep
+
+if [ $# -ne 2 ]
+then
+    echo "usage: sh bench/gensource.sh lines symbols|equates|data|comments|mixed" >&2
+    exit 2
+fi
+case "$2" in
+symbols|equates|data|comments|mixed)
+    ;;
+*)
+    echo "unknown kind $2" >&2
+    exit 2
+    ;;
+esac
+
+awk -v lines="$1" -v kind="$2" '
+    BEGIN {
+        BYTES = 30000
+        split("symbols equates data comments", kinds, " ")
+        #  Every code line takes at most 6 bytes, so every step-th line may be
+        #  one, and there is a filler line after each
+        step = int(lines * 6 / BYTES)
+        step = (step < 2) ? 2 : step
+        equate = ""
+        print "         BR      main        ;" kind " program of " lines " lines"
+        for (i = 1; i < lines - 3; i++) {
+            if (i % step == 0)
+                code(kindof(i), i)
+            else
+                filler(kindof(i), i)
+        }
+        print "main:    STOP"
+        print "         .END"
+    }
+    function kindof(i) {
+        return (kind == "mixed") ? kinds[int(i / 64) % 4 + 1] : kind
+    }
+    function code(k, i) {
+        if (k == "symbols") {
+            if ((kindof(i + 1) == "symbols") && (i + 1 < lines - 3))
+                printf "s%06d: LDA     f%06d,d ;forward reference\n", i, i + 1
+            else
+                printf "s%06d: LDA     main,d    ;forward reference\n", i
+        }
+        else if (k == "equates") {
+            if (equate != "")
+                printf "         LDX     %s,i ;uses an equate\n", equate
+            else
+                printf "         LDX     %d,i        ;no equate yet\n", i % 1000
+        }
+        else if (k == "data") {
+            if (i % 3 == 0)
+                printf "d%06d: .ASCII  \"row %d\\n\"\n", i, i % 100
+            else if (i % 3 == 1)
+                printf "d%06d: .BLOCK  4           ;table entry\n", i
+            else
+                printf "d%06d: .WORD   %d\n", i, i % 65536
+        }
+        else
+            printf "         ADDA    %d,i        ;a comment after code that is longer than the listing has room for\n", i % 1000
+    }
+    function filler(k, i) {
+        if (k == "symbols")
+            printf "f%06d: .EQUATE %d\n", i, i % 65536
+        else if (k == "equates") {
+            equate = sprintf("e%06d", i)
+            printf "%s: .EQUATE 0x%04X     ;equate %d\n", equate, i % 65536, i
+        }
+        else if (k == "data")
+            printf "d%06d: .BLOCK  0           ;empty table\n", i
+        else
+            printf ";Comment line %d of the program, long enough to fill the comment column in full\n", i
+    }'
@@ -10,6 +10,70 @@
 
 //  Version history:
 
+//  October 2026
+//  Unix/8.4 Decode each instruction specifier once at startup into a
+//  256-entry table used by the fetch/execute cycle. The trace now shows the
+//  n field of RETn.
+//  Registers are native 16-bit words and the ALU uses host arithmetic.
+//  NEGr no longer leaves the low byte out of range when it is zero, and
+//  ROLr and RORr rotate through the carry bit as specified.
+//  Main memory is a byte array with inline word and byte accessors.
+//  Added the -b option, an execution engine that caches pre-decoded blocks
+//  of straight-line code and dispatches them with computed goto.
+//  The execution cycle is a template specialized on the trace mode.
+//  Added the -n option, which services DECI, DECO, STRO and NOP natively
+//  when trap and pep8os.pepo are the standard ones.
+//  CHARO output is buffered and written at explicit flush points.
+//  Added batch mode: pep8 [-i infile] [-o outfile] objfile loads, runs and
+//  exits with a status that tells how the run ended.
+//  The machine is now class Machine in pep8sim.h and pep8sim.cpp, with its
+//  own memory, registers, trap table and I/O bindings.  This file is the
+//  interactive and batch front end.
+//  Added the -j option, which runs a manifest of jobs on a thread pool.
+//  Added the -m and -w watchdog options, which stop a batch run after an
+//  instruction count or a number of seconds.
+//  trap and pep8os.pepo are cached in the binary image pep8os.img, which
+//  is rebuilt when either file changes.
+//  The loader of the distributed operating system runs natively unless
+//  it is traced.
+//  CHARI input files are read whole, so input lines have no length limit.
+//  Added the -s option, which reports execution statistics after each run.
+//  Added the -T option, which records a binary trace of a batch run, and
+//  pep8trace, which prints it in the format of the (t)race command.
+//  A batch run that does not end with STOP prints its last 64 instructions.
+//  Added the (b)reak and (c)ontinue commands for breakpoints and memory
+//  watchpoints.
+//  The V and C bits are computed from the operands of the last addition or
+//  subtraction only when an instruction or the trace reads them.
+//  Object files and pep8os.pepo are read from the binary .pepb file that
+//  asem8 -b writes when it was written with the .pepo file as it is now.
+//  Added pep8run, which assembles and runs a program in one process.
+//  Object files, trap and pep8os.pepo may have <CR><LF> line ends.
+//  Added the -x option, which translates hot cached blocks to handlers
+//  specialized on mnemonic, register and addressing mode.
+//  The block cache fuses load/add/store, load/subtract/store,
+//  compare/branch and SUBSP/CALL sequences into single instructions.
+//  Added the -d, -D and -a options, which write a memory dump or a raw
+//  memory image after a batch run, and d file and d -r file, which write
+//  them from the (d)ump command.  Dumps are formatted a line at a time.
+//  Added the (s)ave and (r)estore commands and the -C and -R options, which
+//  write and read checkpoints of the whole machine.  A run stopped by the
+//  watchdog can be continued.
+//  Added the -P option, which writes the number of times the instruction at
+//  each address was executed, for the annotated listings of asem8 -P.
+//  Added pep8aot, which translates an object file to C++ that runs it with
+//  the runtime in pep8native.cpp.
+//  Added the -g option, which follows calls and traps on a shadow stack and
+//  writes a call graph with inclusive and exclusive instruction counts,
+//  named from the symbol files of asem8 -y.
+//  Each -j worker thread keeps one machine, and resets it between jobs by
+//  clearing only the RAM pages the last job wrote.
+//  Added the -e and -f options, which compare CHARO output with an expected
+//  output file as it is produced and can halt the run at the first
+//  difference, and an expected output column for -j manifests.
+//  The -s report estimates the cycles of each run from a cost per
+//  instruction specifier, and the -k option reads the costs from a file.
+
 //  February 2015
 //  Unix/8.3 Eliminated compiler warning.
 //  Stan Warford
@@ -91,1978 +155,126 @@
 #include <stdlib.h>
 #include <iomanip>
 #include <ctype.h>
-#include <unistd.h>
 #include <string>
+#include <cstring>
 #include <stdio.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "pep8sim.h"
 
 using namespace std;
 
-const int MEMORY_SIZE        = 65536;
-const int TOP_OF_MEMORY      = 65535;
-const int USER_SP            = 65528; //User stack pointer vector.
-const int SYSTEM_SP          = 65530; //System stack pointer vector.
-const int LOADER_PC          = 65532; //Program counter vector.
-const int INTR_PC            = 65534; //Interrupt program counter vector.
-const int FILE_NAME_LENGTH   = 64;
-const int HEX_BYTE_LENGTH    = 2;
-const int HEX_WORD_LENGTH    = 4;
-const int UNARY_OPCODES      = 15;
-const int BYTE_INSTRUCTION   = 4;
-const int LINE_FEED          = 10;
-const int CARRIAGE_RETURN    = 13;
-const int LINE_LENGTH        = 1024;  //Maximum length of a line of code
-const int TRAPS              = 8;     //Number of Traps
-const int MNEMON_LENGTH      = 8;
-const int UNIMPLEMENTED_INSTRUCTIONS = 8; // Number of unimplemented mnemonics
-const int UNARY_TRAPS = 4;                // Number of unimplemented mnemonics guaranteed to be unary
-const int IMMEDIATE = 1;                // 2^0. Powers of two to represent addressing mode bitset
-const int DIRECT = 2;                   // 2^1
-const int INDIRECT = 4;                 // 2^2
-const int STACK_RELATIVE = 8;           // 2^3
-const int STACK_RELATIVE_DEFERRED = 16; // 2^4
-const int INDEXED = 32;                 // 2^5
-const int STACK_INDEXED = 64;           // 2^6
-const int STACK_INDEXED_DEFERRED = 128; // 2^7
-
-//Enumerated Types
-enum MnemonicOpcodes   //All possible opcodes
-{
-    eM_STOP, eM_RETTR, eM_MOVSPA, eM_MOVFLGA, eM_BR, eM_BRLE, eM_BRLT, eM_BREQ, 
-    eM_BRNE, eM_BRGE, eM_BRGT, eM_BRV, eM_BRC, eM_CALL, eM_NOTr, eM_NEGr, 
-    eM_ASLr, eM_ASRr, eM_ROLr, eM_RORr, eM_UNIMP0, eM_UNIMP1, eM_UNIMP2, 
-    eM_UNIMP3, eM_UNIMP4, eM_UNIMP5, eM_UNIMP6, eM_UNIMP7, eM_CHARI, eM_CHARO, 
-    eM_RETn, eM_ADDSP, eM_SUBSP, eM_ADDr, eM_SUBr, eM_ANDr, eM_ORr, eM_CPr, 
-    eM_LDr, eM_LDBYTEr, eM_STr, eM_STBYTEr
-};
-
-enum eRegSpecType  { eR_R_IS_ACCUMULATOR, eR_R_IS_INDEX_REG }; // 8 bits, unsigned
-
-enum eAddrModeType 
-{ 
-    eA_IMMEDIATE, eA_DIRECT, eA_INDIRECT, eA_STACK_REL, 
-    eA_STACK_REL_DEF, eA_INDEXED, eA_STACK_IND, eA_STACK_IND_DEF 
-};
-
-enum eTraceMd { eT_TR_OFF, eT_TR_PROGRAM, eT_TR_TRAPS, eT_TR_LOADER };
-
-//**** Global Records
-struct sRegisterType                  // internal CPU registers
-{
-    int iHigh;                      // most significant byte
-    int iLow;                       // least significant byte
-};
-struct sIRRecType
-{
-    int iInstr_Spec;                //  8 bits
-    sRegisterType sR_OprndSpec;     // 16 bits
-};
-
-/*Contains information about user-defined instructions*/
-struct sUnimplementedMnemonNode{
-    char cID[MNEMON_LENGTH + 1]; //Name of unimplemented opcode
-    int iAddrMode;
-};
-
 //**** Global Variables
-char cHexTable[16];
-eTraceMd eTraceMode;
-int iMemory[MEMORY_SIZE];
-int iRomStartAddr;
-char TrapMnemon[TRAPS][MNEMON_LENGTH + 1];
-int iUnaryOpcodes[UNARY_OPCODES];
-int ByteInstructions[BYTE_INSTRUCTION];
+Machine pep8Machine;       // The simulated Pep/8
 char cCommand[LINE_LENGTH];
-bool bLoading;              // Set when loading object file
-bool bMachineReset;         // To insure initial load on startup
-bool bSingleStep;           // For tracing single step
-bool bScrollingTrace;       // For tracing until completion
-int iAddrMode;              // Addressing mode integer type
-int iRegType;               // Register type integer type
-eAddrModeType eA_AddrMode;  // Addressing mode enumerated type
-eRegSpecType eR_RegType;    // Register type enumerated type
-int nValue;                 // n values
-
-// Input/Output
-ifstream trapFile;
-ifstream chariInputStream;
-ofstream charoOutputStream;
-bool bKeyboardInput;       // for program application, used by CHARI
-bool bScreenOutput;        // for program application, used by CHARO
-bool bBufferIsEmpty;
 char cInFileName[FILE_NAME_LENGTH];
 char cOutFileName[FILE_NAME_LENGTH];
-int numTerminalLines;
-
-//**** Pep/8 CPU registers
-sRegisterType sR_Accumulator, sR_IndexRegister, sR_StackPointer, sR_ProgramCounter; // 16 bits
-sIRRecType sIR_InstrRegister; // 24 bits
-bool bStatusN, bStatusZ, bStatusV, bStatusC;
-
-//**** Constant registers
-sRegisterType sR_AtZero, sR_One, sR_Two, sR_NegOne, sR_NegTwo, sR_NegThree;
-
-//**** Keyboard buffer global variables for unbuffering the
-//**** UNIX buffered line on interactive input
-char cLine[LINE_LENGTH]; //Array of characters for a line of code
-int iLineIndex; //Index of line array
-
-//**** Stores the next line of assembly language code to be translated in global cLine[].
-void vGetLine(istream& input)
-{
-    input.getline(cLine, LINE_LENGTH);
-    if ((!input.eof ()) && (input.gcount() > 0))
-    {
-        cLine[input.gcount() - 1] = '\n';
-    }
-    else
-    {
-        cLine[input.gcount()] = '\n';
-    }
-    iLineIndex = 0;
-    bBufferIsEmpty = false;
-}
-
-//**** Gets the next character to be processed
-void vAdvanceInput (char& ch)
-{
-    ch = cLine[iLineIndex++];
-    bBufferIsEmpty = (ch == '\n');
-}
-
-//**** Backs up the input
-void vBackUpInput ()
-{
-    iLineIndex--;
-}
-
-bool bIsHexDigit (char cChar)
-{
-    return (((cChar >= 'A') && (cChar <= 'F')) ||
-            ((cChar >= 'a') && (cChar <= 'f')) || isdigit(cChar));
-}
-
-bool bSearchIntArray (int iArray[], int iArrayLength, int iNum)
-{
-    int i = 0;
-    iArray[iArrayLength] = iNum;
-    while (iArray[i] != iNum)
-    {
-        i++;
-    }
-    return i != iArrayLength;
-}
-
-//**** iInstr_Spec procedures ****
-//**** Adds 2 byte pairs and returns in result.  (One word adder)
-void Adder (sRegisterType Op1, sRegisterType Op2, sRegisterType& Result,
-            bool& Carry, bool& Ovflw)
-{
-    int Temp;
-    Temp = Op1.iLow + Op2.iLow;
-    if (Temp > 255)
-    {
-        Result.iLow = Temp - 256;
-        Temp = Op1.iHigh + Op2.iHigh + 1;                 //Carry from low order
-    }
-    else
-    {
-        Result.iLow = Temp;
-        Temp = Op1.iHigh + Op2.iHigh;
-    }
-    if (Temp > 255)
-    {
-        Result.iHigh = Temp - 256;
-        Carry = true;
-    }
-    else
-    {
-        Result.iHigh = Temp;
-        Carry = false;
-    }
-    Ovflw = (((Op1.iHigh <= 127) && (Op2.iHigh <= 127) &&   // Pos/Pos/Neg
-              (Result.iHigh > 127)) ||                       //     or
-             ((Op1.iHigh >= 128) && (Op2.iHigh >= 128) &&   // Neg/Neg/Pos
-              (Result.iHigh < 128)));
-}
-
-//**** Adds 2 byte pairs and returns in result.  (One word adder)
-//**** Same as Adder except carry and overflow are not detected.
-void FastAdder (sRegisterType Op1, sRegisterType Op2, sRegisterType& Result)
-{
-    int iTemp;
-    iTemp = Op1.iLow + Op2.iLow;
-    if (iTemp > 255)
-    {
-        Result.iLow = iTemp - 256;
-        iTemp = Op1.iHigh + Op2.iHigh + 1;                 // Carry from low order
-    }
-    else
-    {
-        Result.iLow = iTemp;
-        iTemp = Op1.iHigh + Op2.iHigh;
-    }
-    if (iTemp > 255)
-    {
-        Result.iHigh = iTemp - 256;
-    }
-    else
-    {
-        Result.iHigh = iTemp;
-    }
-}
-
-//**** Subtracts Op2 from Op1 and returns in result.  (One word)
-void Subtractor (sRegisterType Op1, sRegisterType Op2, sRegisterType& Result,
-                 bool& Carry, bool& Ovflw)
-{
-    int iTemp;
-    iTemp = Op1.iLow - Op2.iLow;
-    if (iTemp < 0)
-    {
-        Result.iLow = iTemp + 256;
-        iTemp = Op1.iHigh - Op2.iHigh - 1;               // Borrow from high order
-    }
-    else
-    {
-        Result.iLow = iTemp;
-        iTemp = Op1.iHigh - Op2.iHigh;
-    }
-    if (iTemp < 0)
-    {
-        Result.iHigh = iTemp + 256;
-        Carry = true;
-    }
-    else
-    {
-        Result.iHigh = iTemp;
-        Carry = false;
-    }
-    Ovflw = (((Op1.iHigh <= 127) && (Op2.iHigh >= 128) &&   // Pos/Neg/Neg
-              (Result.iHigh > 127)) ||                       //     or
-             ((Op1.iHigh >= 128) && (Op2.iHigh <= 127) &&   // Neg/Pos/Pos
-              (Result.iHigh < 128)));
-}
-
-//**** Process the Instruction Specifier (8 bits)
-int GetAddressingModeOneBit (int iInstr_Spec) 
-{
-    return iInstr_Spec % 2 == 0 ? 0 : 5;
-}
-
-int GetAddressingModeThreeBits (int iInstr_Spec) 
-{
-    return (iInstr_Spec % 8);
-}
-
-int GetRegisterTypeLastBit (int iInstr_Spec) 
-{
-    return (iInstr_Spec % 2);
-}
-
-int GetRegisterTypeFourthBit (int iInstr_Spec) 
-{
-    return ((iInstr_Spec / 8) % 2);
-}
-
-int GetNValueThreeBits (int iInstr_Spec) 
-{
-    return (iInstr_Spec % 8);
-}
-
-MnemonicOpcodes instr_SpecToMnemon(int iInstr_Spec) 
-{
-    if (iInstr_Spec == 0) { return eM_STOP; }
-    else if (iInstr_Spec == 1) { return eM_RETTR; }
-    else if (iInstr_Spec == 2) { return eM_MOVSPA; }
-    else if (iInstr_Spec == 3) { return eM_MOVFLGA; }
-    else if (iInstr_Spec <= 5) { return eM_BR; }
-    else if (iInstr_Spec <= 7) { return eM_BRLE; }
-    else if (iInstr_Spec <= 9) { return eM_BRLT; }
-    else if (iInstr_Spec <= 11) { return eM_BREQ; }
-    else if (iInstr_Spec <= 13) { return eM_BRNE; }
-    else if (iInstr_Spec <= 15) { return eM_BRGE; }
-    else if (iInstr_Spec <= 17) { return eM_BRGT; }
-    else if (iInstr_Spec <= 19) { return eM_BRV; }
-    else if (iInstr_Spec <= 21) { return eM_BRC; }
-    else if (iInstr_Spec <= 23) { return eM_CALL; }
-    else if (iInstr_Spec <= 25) { return eM_NOTr; }
-    else if (iInstr_Spec <= 27) { return eM_NEGr; }
-    else if (iInstr_Spec <= 29) { return eM_ASLr; }
-    else if (iInstr_Spec <= 31) { return eM_ASRr; }
-    else if (iInstr_Spec <= 33) { return eM_ROLr; }
-    else if (iInstr_Spec <= 35) { return eM_RORr; } 
-    else if (iInstr_Spec == 36) { return eM_UNIMP0; }
-    else if (iInstr_Spec == 37) { return eM_UNIMP1; }
-    else if (iInstr_Spec == 38) { return eM_UNIMP2; }
-    else if (iInstr_Spec == 39) { return eM_UNIMP3; }
-    else if (iInstr_Spec <= 47) { return eM_UNIMP4; }
-    else if (iInstr_Spec <= 55) { return eM_UNIMP5; }
-    else if (iInstr_Spec <= 63) { return eM_UNIMP6; }
-    else if (iInstr_Spec <= 71) { return eM_UNIMP7; }    
-    else if (iInstr_Spec <= 79) { return eM_CHARI; }
-    else if (iInstr_Spec <= 87) { return eM_CHARO; }
-    else if (iInstr_Spec <= 95) { return eM_RETn; }
-    else if (iInstr_Spec <= 103) { return eM_ADDSP; }
-    else if (iInstr_Spec <= 111) { return eM_SUBSP; }
-    else if (iInstr_Spec <= 127) { return eM_ADDr; }
-    else if (iInstr_Spec <= 143) { return eM_SUBr; }
-    else if (iInstr_Spec <= 159) { return eM_ANDr; }
-    else if (iInstr_Spec <= 175) { return eM_ORr; }
-    else if (iInstr_Spec <= 191) { return eM_CPr; }
-    else if (iInstr_Spec <= 207) { return eM_LDr; }
-    else if (iInstr_Spec <= 223) { return eM_LDBYTEr; }
-    else if (iInstr_Spec <= 239) { return eM_STr; }
-    else { return eM_STBYTEr; }
-}
-
-eAddrModeType ProcessAddressingMode (int AddrMode) 
-{
-    switch (AddrMode) 
-    {
-    case 0: return eA_IMMEDIATE; break;
-    case 1: return eA_DIRECT; break;
-    case 2: return eA_INDIRECT; break;
-    case 3: return eA_STACK_REL; break;
-    case 4: return eA_STACK_REL_DEF; break;
-    case 5: return eA_INDEXED; break;
-    case 6: return eA_STACK_IND; break;
-    case 7: return eA_STACK_IND_DEF; break;
-    default: return eA_IMMEDIATE;
-    }
-}
-
-eRegSpecType ProcessRegisterType (int RegType) 
-{
-    switch (RegType) 
-    {
-    case 0: return eR_R_IS_ACCUMULATOR; break;
-    case 1: return eR_R_IS_INDEX_REG; break;
-    default: return eR_R_IS_ACCUMULATOR; break; // Should not occur
-    }
-}
-
-void PrntMnemon (ostream& output)
-{
-    switch (instr_SpecToMnemon(sIR_InstrRegister.iInstr_Spec))
-    {
-    case eM_STOP: output << "STOP     "; break;
-    case eM_RETTR: output << "RETTR    "; break;
-    case eM_MOVSPA: output << "MOVESPA  "; break;
-    case eM_MOVFLGA: output << "MOVFLGA  "; break;
-
-    case eM_BR: output << "BR       "; break;
-    case eM_BRLE: output << "BRLE     "; break;
-    case eM_BRLT: output << "BRLT     "; break;
-    case eM_BREQ: output << "BREQ     "; break;
-    case eM_BRNE: output << "BRNE     "; break;
-    case eM_BRGE: output << "BRGE     "; break;
-    case eM_BRGT: output << "BRGT     "; break;
-    case eM_BRV: output << "BRV      "; break;
-    case eM_BRC: output << "BRC      "; break;
-    case eM_CALL: output << "CALL     "; break;
-
-    case eM_NOTr: output << "NOT"; break; 
-    case eM_NEGr: output << "NEG"; break;   
-    case eM_ASLr: output << "ASL"; break;    
-    case eM_ASRr: output << "ASR"; break;    
-    case eM_ROLr: output << "ROL"; break;    
-    case eM_RORr: output << "ROR"; break;   
-
-    case eM_UNIMP0: output << TrapMnemon[0]; break;  // NOP0
-    case eM_UNIMP1: output << TrapMnemon[1]; break;  // NOP1
-    case eM_UNIMP2: output << TrapMnemon[2]; break;  // NOP2
-    case eM_UNIMP3: output << TrapMnemon[3]; break;  // NOP3
-    case eM_UNIMP4: output << TrapMnemon[4]; break;  // NOP
-    case eM_UNIMP5: output << TrapMnemon[5]; break;  // DECI 
-    case eM_UNIMP6: output << TrapMnemon[6]; break;  // DECO 
-    case eM_UNIMP7: output << TrapMnemon[7]; break;  // STRO 
-
-    case eM_CHARI: output << "CHARI    "; break;
-    case eM_CHARO: output << "CHARO    "; break;
-
-    case eM_RETn: output << "RET"; break; 
-           
-    case eM_ADDSP: output << "ADDSP    "; break;
-    case eM_SUBSP: output << "SUBSP    "; break;
-                 
-    case eM_ADDr: output << "ADD"; break;
-    case eM_SUBr: output << "SUB"; break;
-    case eM_ANDr: output << "AND"; break;
-    case eM_ORr: output << "OR"; break;
-    case eM_CPr: output << "CP"; break;
-
-    case eM_LDr: output << "LD"; break; 
-    case eM_LDBYTEr: output << "LDBYTE"; break; 
-    case eM_STr: output << "ST"; break;  
-    case eM_STBYTEr: output << "STBYTE"; break;  
-    }
-      
-    MnemonicOpcodes tempMn = instr_SpecToMnemon(sIR_InstrRegister.iInstr_Spec);
-    if ((eM_NOTr <= tempMn && tempMn <= eM_RORr) || eM_ADDr <= tempMn)
-    {
-        switch (eR_RegType)
-        {
-        case eR_R_IS_ACCUMULATOR: output << "A"; break;
-        case eR_R_IS_INDEX_REG: output << "X"; break;
-        }
-      
-        //Column alignment adjustment
-        if (tempMn <= eM_ANDr) {
-            output << "     ";
-        }
-        else if (tempMn == eM_ORr || tempMn == eM_CPr || tempMn == eM_LDr || tempMn == eM_STr) {
-            output << "      ";
-        }
-        else {
-            output << "  ";
-        }
-    }
-    else if (tempMn == eM_RETn) 
-    {
-        output << nValue << "     ";
-    }
-    else if (eM_UNIMP0 <= tempMn && tempMn <= eM_UNIMP7)
-    {
-        output << " ";
-    }
-}
-
-//**** Reads one word:  Rslt.iHigh = Mem [Loc], Rslt.iLow = Mem [Loc + 1]
-void MemRead (sRegisterType Loc, sRegisterType& Rslt)
-{
-    int iTemp;
-    if (Loc.iHigh < MEMORY_SIZE / (256))
-    {
-        iTemp = Loc.iHigh * (256) + Loc.iLow;
-        Rslt.iHigh = iMemory[iTemp];
-        if (iTemp < TOP_OF_MEMORY)
-        {
-            Rslt.iLow = iMemory[iTemp + 1];
-        }
-        else
-        {
-            Rslt.iLow = 0;
-        }
-    }
-    else
-    {
-        Rslt.iHigh = 0;
-        Rslt.iLow = 0;
-    }
-}
-
-//**** Reads one byte from Mem [Loc] and returns in Byte
-void MemByteRead (sRegisterType Loc, int& iByte)
-{
-    int iTemp;
-    if (Loc.iHigh < MEMORY_SIZE / (256))
-    {
-        iTemp = Loc.iHigh * (256) + Loc.iLow;
-        iByte = iMemory[iTemp];
-    }
-    else
-    {
-        iByte = 0;
-    }
-}
-
-//**** Writes one word:  Reg.iHigh to Mem [Loc] and Reg.iLow to Mem[Loc + 1]
-void MemWrite (sRegisterType Reg, sRegisterType Loc)
-{
-    int iTemp;
-    if (Loc.iHigh < MEMORY_SIZE / (256))
-    {
-        iTemp = Loc.iHigh * (256) + Loc.iLow;
-        if (iTemp < iRomStartAddr)
-        {
-            iMemory[iTemp] = Reg.iHigh;
-        }
-        if (iTemp < iRomStartAddr - 1)
-        {
-            iMemory[iTemp + 1] = Reg.iLow;
-        }
-    }
-}
-
-//**** Writes one byte to Mem [Loc]
-void MemByteWrite (int iByte, sRegisterType Loc)
-{
-    int iTemp;
-    if (Loc.iHigh < MEMORY_SIZE / (256))
-    {
-        iTemp = Loc.iHigh * (256) + Loc.iLow;
-        if (iTemp < iRomStartAddr)
-        {
-            iMemory[iTemp] = iByte;
-        }
-    }
-}
-
-//**** Determine operand based on addressing mode in instr. register
-//**** Sets Oprnd to the operand when the addressing mode is immediate,
-//**** but to the address of the operand for the other seven modes
-void AddrProcessor (sRegisterType& Operand)
-{
-    sRegisterType temp1, temp2;
-    switch (eA_AddrMode)
-    {
-    case eA_IMMEDIATE:
-        Operand = sIR_InstrRegister.sR_OprndSpec;
-        break;
-    case eA_DIRECT:
-        Operand = sIR_InstrRegister.sR_OprndSpec;
-        break;
-    case eA_INDIRECT:
-        MemRead (sIR_InstrRegister.sR_OprndSpec, Operand);
-        break;
-    case eA_STACK_REL:
-        FastAdder (sR_StackPointer, sIR_InstrRegister.sR_OprndSpec, Operand);
-        break;
-    case eA_STACK_REL_DEF:
-        FastAdder (sR_StackPointer, sIR_InstrRegister.sR_OprndSpec, temp1);
-        MemRead (temp1, Operand);
-        break;
-    case eA_INDEXED:
-        FastAdder (sR_IndexRegister, sIR_InstrRegister.sR_OprndSpec, Operand);
-        break;
-    case eA_STACK_IND: 
-        FastAdder (sR_StackPointer, sIR_InstrRegister.sR_OprndSpec, temp1);
-        FastAdder (temp1, sR_IndexRegister, Operand);
-        break;
-    case eA_STACK_IND_DEF: 
-        FastAdder (sR_StackPointer, sIR_InstrRegister.sR_OprndSpec, temp1);
-        MemRead (temp1, temp2);
-        FastAdder (temp2, sR_IndexRegister, Operand);
-        break;
-    }
-}
+bool bBatchMode;           // Run from the command line without the menu
+long lMaxInstr = 0;        // Instruction budget of a batch run, 0 for none (-m)
+double dTimeLimit = 0;     // Seconds allowed for a batch run, 0 for none (-w)
+const char* cDumpFile = NULL;   // Memory dump after a batch run (-d)
+const char* cImageFile = NULL;  // Memory image after a batch run (-D)
+sRegisterType DumpStart = 0;    // Address range of the dump and image (-a)
+sRegisterType DumpEnd = TOP_OF_MEMORY;
+const char* cCheckpointFile = NULL;  // Checkpoint after a batch run (-C)
+const char* cRestoreFile = NULL;     // Checkpoint a batch run starts from (-R)
+const char* cProfileFile = NULL;     // Execution counts by address (-P)
+const char* cCallGraphFile = NULL;   // Call graph of a batch run (-g)
+const char* cExpectedFile = NULL;    // Expected CHARO output of a batch run (-e)
+long lOutputMargin = -1;             // Halt on a mismatch, with excess output allowed (-f)
+
+//**** One line of a job manifest for the -j option
+struct sJobType
+{
+    string sObjFile;
+    string sInFile;             // "-" for no input
+    string sOutFile;
+    string sExpectedFile;       // Empty if the output is not compared
+    int iStatus;                // Batch mode exit status of the job
+};
 
-void LoadReg (sRegisterType& Reg)
+void LoaderCommand()
 {
-    sRegisterType Operand;
-    AddrProcessor (Operand);
-    if (eA_AddrMode == eA_IMMEDIATE)
+    char FileName[FILE_NAME_LENGTH];
+   
+    if (!pep8Machine.bIsKeyboardInput())
     {
-        Reg = Operand;
+        cout << "Data input switched back to keyboard." << endl;
+        pep8Machine.SetKeyboardInput();
     }
-    else
+    cout << "Enter object file name (do not include .pepo): ";
+    cin.getline(FileName, FILE_NAME_LENGTH);
+    int iTemp = cin.gcount() - 1;
+    FileName[iTemp++] = '.';
+    FileName[iTemp++] = 'p';
+    FileName[iTemp++] = 'e';
+    FileName[iTemp++] = 'p';
+    FileName[iTemp++] = 'o';
+    FileName[iTemp] = '\0';
+    if (pep8Machine.bSetObjectFile(FileName))
     {
-        MemRead (Operand, Reg);
-    }
-}
-
-void SetNZBits (sRegisterType Reg)
-{
-    bStatusN = (Reg.iHigh > 127);
-    bStatusZ = ((Reg.iHigh == 0) && (Reg.iLow == 0));
-}
-
-//**** Prints program counter value of instruction that caused machine
-//**** error.  Message is 20 characters long.
-void PrntRunLoc()
-{
-    sRegisterType LastLoc;
-    if (bSearchIntArray(iUnaryOpcodes, UNARY_OPCODES, instr_SpecToMnemon(sIR_InstrRegister.iInstr_Spec)))
-    {  // undo increment step
-        FastAdder (sR_ProgramCounter, sR_NegOne, LastLoc);
+        cout << "Object file is " << FileName << endl;
+        pep8Machine.Load();
     }
     else
     {
-        FastAdder (sR_ProgramCounter, sR_NegThree, LastLoc);
-    }
-    cout << "Runtime error at " << cHexTable[LastLoc.iHigh / 16] <<
-        cHexTable[LastLoc.iHigh % 16] << cHexTable[LastLoc.iLow / 16] <<
-        cHexTable[LastLoc.iLow % 16] << ":  ";
-}
-
-void IllegalAddr (bool& bError)
-{
-    bError = true;
-    PrntRunLoc();
-    cout << "Illegal addressing mode ";
-    switch (eA_AddrMode)
-    {
-    case eA_IMMEDIATE: 
-        cout << "immediate "; 
-        break;
-    case eA_DIRECT: 
-        cout << "direct "; 
-        break;
-    case eA_INDIRECT: 
-        cout << "indirect "; 
-        break;
-    case eA_STACK_REL: 
-        cout << "stack relative "; 
-        break;
-    case eA_STACK_REL_DEF: 
-        cout << "stack relative deferred "; 
-        break;
-    case eA_INDEXED: 
-        cout << "indexed ";
-        break;
-    case eA_STACK_IND: 
-        cout << "stack indexed "; 
-        break;
-    case eA_STACK_IND_DEF: 
-        cout << "stack indexed deferred "; 
-        break;
-    }
-    cout << "with ";
-    PrntMnemon (cout);
-    cout << endl;
-}
-
-void SimSTOP (bool& Halt)
-{
-    Halt = true;
-}
-
-void Pop (sRegisterType& Reg, sRegisterType Size)
-{
-    MemRead (sR_StackPointer, Reg);   
-    FastAdder (sR_StackPointer, Size, sR_StackPointer);
-}
-
-void SimRETTR ()
-{
-    int Flags;
-    MemByteRead (sR_StackPointer, Flags);   
-    FastAdder (sR_StackPointer, sR_One, sR_StackPointer);
-    Flags %= 16;
-    bStatusC = Flags % 2 != 0;
-    Flags /= 2;
-    bStatusV = Flags % 2 != 0;
-    Flags /= 2;
-    bStatusZ = Flags % 2 != 0;
-    Flags /= 2;
-    bStatusN = Flags % 2 != 0;
-
-    Pop (sR_Accumulator, sR_Two);
-    Pop (sR_IndexRegister, sR_Two);
-    Pop (sR_ProgramCounter, sR_Two);
-    Pop (sR_StackPointer, sR_AtZero);
-}
-
-void SimMOVSPA (bool& Halt)
-{
-    sR_Accumulator = sR_StackPointer;
-}
-
-void SimMOVFLGA(bool& Halt)
-{
-    sR_Accumulator.iHigh = 0;
-    sR_Accumulator.iLow = (bStatusN * 8) + (bStatusZ * 4) + (bStatusV * 2) + bStatusC;
-}
-
-void SimBR ()
-{
-    iAddrMode = GetAddressingModeOneBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-   
-    LoadReg (sR_ProgramCounter);
-}
-
-void SimBRLE ()
-{
-    iAddrMode = GetAddressingModeOneBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-   
-    if (bStatusN || bStatusZ)
-    {
-        LoadReg (sR_ProgramCounter);
-    }
-}
-
-void SimBRLT ()
-{
-    iAddrMode = GetAddressingModeOneBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-   
-    if (bStatusN)
-    {
-        LoadReg (sR_ProgramCounter);
+        cout << "Could not open object file " << FileName << endl;
     }
+    pep8Machine.SetKeyboardInput();
 }
 
-void SimBREQ ()
+void ExecuteCommand()
 {
-    iAddrMode = GetAddressingModeOneBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-   
-    if (bStatusZ)
+    eRunStatus eStatus = pep8Machine.Run();
+    if (pep8Machine.bStatistics && eStatus != eS_BREAKPOINT)
     {
-        LoadReg (sR_ProgramCounter);
-    }
-}
-
-void SimBRNE ()
-{
-    iAddrMode = GetAddressingModeOneBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode); 
-   
-    if (!bStatusZ)
-    {  
-        LoadReg (sR_ProgramCounter);
+        pep8Machine.PrintStatistics(cout);
     }
-}
-
-void SimBRGE ()
-{
-    iAddrMode = GetAddressingModeOneBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode); 
-   
-    if (!bStatusN)
-    {  
-        LoadReg (sR_ProgramCounter);
-    }
-}
-
-void SimBRGT ()
-{
-    iAddrMode = GetAddressingModeOneBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-   
-    if (!bStatusN && !bStatusZ)
-    { 
-        LoadReg (sR_ProgramCounter);
-    }
-}
-
-void SimBRV ()
-{
-    iAddrMode = GetAddressingModeOneBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);  
-   
-    if (bStatusV)
-    { 
-        LoadReg (sR_ProgramCounter);
-    }
-}
-
-void SimBRC ()
-{
-    iAddrMode = GetAddressingModeOneBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-   
-    if (bStatusC)
-    {   
-        LoadReg (sR_ProgramCounter);
-    }
-}
-
-void SimCALL (bool& bError)
-{
-    iAddrMode = GetAddressingModeOneBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-   
-    if ((eA_AddrMode == eA_IMMEDIATE) || (eA_AddrMode == eA_INDEXED))
-    {
-        FastAdder (sR_StackPointer, sR_NegTwo, sR_StackPointer);
-        MemWrite (sR_ProgramCounter, sR_StackPointer);     // Mem [SP] = PC
-        LoadReg (sR_ProgramCounter);
-    }
-    else
-    {
-        IllegalAddr (bError);
-    }
-}
-
-void SimNOTr()
-{
-    iRegType = GetRegisterTypeLastBit (sIR_InstrRegister.iInstr_Spec);
-    eR_RegType = ProcessRegisterType(iRegType);
-   
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        sR_Accumulator.iHigh = 255 - sR_Accumulator.iHigh;
-        sR_Accumulator.iLow = 255 - sR_Accumulator.iLow;
-        SetNZBits (sR_Accumulator);
-        break;
-    case eR_R_IS_INDEX_REG:
-        sR_IndexRegister.iHigh = 255 - sR_IndexRegister.iHigh;
-        sR_IndexRegister.iLow = 255 - sR_IndexRegister.iLow;
-        SetNZBits (sR_IndexRegister);
-        break;
-    }
-}
-
-void SimNEGr()
-{
-    iRegType = GetRegisterTypeLastBit (sIR_InstrRegister.iInstr_Spec);
-    eR_RegType = ProcessRegisterType(iRegType);
-   
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        sR_Accumulator.iHigh = ~sR_Accumulator.iHigh + 256;
-        sR_Accumulator.iLow = ~sR_Accumulator.iLow + 257;
-        SetNZBits (sR_Accumulator);
-        break;
-    case eR_R_IS_INDEX_REG:
-        sR_IndexRegister.iHigh = ~sR_IndexRegister.iHigh + 256;
-        sR_IndexRegister.iLow = ~sR_IndexRegister.iLow + 257;
-        SetNZBits (sR_IndexRegister);
-        break;
-    }
-    // v = overflow ?
-}
-
-void SimASLr()
-{
-    iRegType = GetRegisterTypeLastBit (sIR_InstrRegister.iInstr_Spec);
-    eR_RegType = ProcessRegisterType(iRegType);
-   
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        Adder (sR_Accumulator, sR_Accumulator, sR_Accumulator, bStatusC, bStatusV);
-        SetNZBits (sR_Accumulator);
-        break;
-    case eR_R_IS_INDEX_REG:
-        Adder (sR_IndexRegister, sR_IndexRegister, sR_IndexRegister, bStatusC, bStatusV);
-        SetNZBits (sR_IndexRegister);
-        break;
-    }
-}
-
-void SimASRr()
-{
-    iRegType = GetRegisterTypeLastBit (sIR_InstrRegister.iInstr_Spec);
-    eR_RegType = ProcessRegisterType(iRegType);
-   
-    int Sign, Carry;
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        Sign = sR_Accumulator.iHigh / 128;
-        Carry = sR_Accumulator.iHigh % 2;
-        bStatusC = (sR_Accumulator.iLow % 2 != 0);
-        sR_Accumulator.iHigh = (sR_Accumulator.iHigh / 2) + (Sign * 128);
-        sR_Accumulator.iLow = (sR_Accumulator.iLow / 2) + (Carry * 128);
-        SetNZBits (sR_Accumulator);
-        break;
-    case eR_R_IS_INDEX_REG:
-        Sign = sR_IndexRegister.iHigh / 128;
-        Carry = sR_IndexRegister.iHigh % 2;
-        bStatusC = (sR_IndexRegister.iLow % 2 != 0);
-        sR_IndexRegister.iHigh = (sR_IndexRegister.iHigh / 2) + (Sign * 128);
-        sR_IndexRegister.iLow = (sR_IndexRegister.iLow / 2) + (Carry * 128);
-        SetNZBits (sR_IndexRegister);
-        break;
-    }
-}
-
-void SimROLr()
-{
-    iRegType = GetRegisterTypeLastBit (sIR_InstrRegister.iInstr_Spec);
-    eR_RegType = ProcessRegisterType(iRegType);
-   
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        bStatusC = (sR_Accumulator.iHigh % 128 != 0);
-        sR_Accumulator.iHigh = (sR_Accumulator.iHigh * 2) ;
-        sR_Accumulator.iLow = (sR_Accumulator.iLow * 2) + bStatusC;
-        break;
-    case eR_R_IS_INDEX_REG:
-        bStatusC = (sR_IndexRegister.iHigh % 128 != 0);
-        sR_IndexRegister.iHigh = (sR_IndexRegister.iHigh * 2);
-        sR_IndexRegister.iLow = (sR_IndexRegister.iLow * 2) + bStatusC;
-        break;
-    }
-}
-
-void SimRORr()
-{
-    iRegType = GetRegisterTypeLastBit (sIR_InstrRegister.iInstr_Spec);
-    eR_RegType = ProcessRegisterType(iRegType);
-   
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        bStatusC = (sR_Accumulator.iLow % 2 != 0);
-        sR_Accumulator.iHigh = (sR_Accumulator.iHigh / 2) + (bStatusC * 128);
-        sR_Accumulator.iLow = (sR_Accumulator.iLow / 2);
-        break;
-    case eR_R_IS_INDEX_REG:
-        bStatusC = (sR_IndexRegister.iLow % 2 != 0);
-        sR_IndexRegister.iHigh = (sR_IndexRegister.iHigh / 2) + (bStatusC * 128);
-        sR_IndexRegister.iLow = (sR_IndexRegister.iLow / 2);
-        break;
-    }
-}
-
-void SimCHARI (bool& bError)
-{
-    char Ch;
-    sRegisterType Operand;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-  
-    if (bBufferIsEmpty)
-    {
-        if (bLoading || !bKeyboardInput)
-        {
-            vGetLine(chariInputStream);
-            if (chariInputStream.eof())
-            {
-                bError = true;
-                PrntRunLoc();
-                cout << "File read error or read past end of file." << endl;
-                return;
-            }
-        }
-        else
-        {
-            vGetLine(cin);
-        }
-    }
-    vAdvanceInput(Ch);
-
-    if (eA_AddrMode == eA_IMMEDIATE)
-    {
-        IllegalAddr (bError);
-    }
-    else  //Addressing mode is valid
-    {
-        AddrProcessor (Operand);
-        MemByteWrite (Ch, Operand);
-    }
-}
-
-void SimCHARO()
-{
-    sRegisterType Operand;
-    int iData;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-    AddrProcessor (Operand);
-    if (eA_AddrMode == eA_IMMEDIATE)
-    {
-        iData = Operand.iLow;
-    }
-    else
-    {
-        MemByteRead (Operand, iData);
-    }
-    if (!bScreenOutput)
-    {
-        if (iData == LINE_FEED || iData == CARRIAGE_RETURN)
-        {
-            charoOutputStream << endl;
-        }
-        else
-        {
-            charoOutputStream << static_cast <char> (iData);
-        }
-    }
-    else
-    {
-        if (iData == LINE_FEED || iData == CARRIAGE_RETURN)
-        {
-            cout << endl;
-        }
-        else
-        {
-            cout << static_cast <char> (iData);
-        }
-    }
-    if (eTraceMode != eT_TR_OFF && bScreenOutput)
-    {
-        cout << endl;
-    }
-}
-
-void SimRETn()
-{
-    sRegisterType sR_N;
-   
-    sR_N.iHigh = 0;
-    sR_N.iLow = GetNValueThreeBits (sIR_InstrRegister.iInstr_Spec);
-   
-    FastAdder (sR_StackPointer, sR_N, sR_StackPointer);   // SP = SP + n
-    MemRead (sR_StackPointer, sR_ProgramCounter);         // PC = Mem [SP]
-    FastAdder (sR_StackPointer, sR_Two, sR_StackPointer); // SP = SP + 2
-}
-
-void SimADDSP (bool& bError)
-{
-    sRegisterType R0;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-   
-    LoadReg (R0);
-    Adder (sR_StackPointer, R0, sR_StackPointer, bStatusC, bStatusV);
-    SetNZBits (sR_StackPointer);
-}
-
-void SimSUBSP (bool& bError)
-{
-    sRegisterType R0;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-   
-    LoadReg (R0);
-    Subtractor (sR_StackPointer, R0, sR_StackPointer, bStatusC, bStatusV);
-    SetNZBits (sR_StackPointer);
-}
-
-void SimADDr()
-{
-    sRegisterType R0;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    iRegType = GetRegisterTypeFourthBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-    eR_RegType = ProcessRegisterType(iRegType);
-         
-    LoadReg (R0);
-        
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        Adder (sR_Accumulator, R0, sR_Accumulator, bStatusC, bStatusV);
-        SetNZBits (sR_Accumulator);
-        break;
-    case eR_R_IS_INDEX_REG:
-        Adder (sR_IndexRegister, R0, sR_IndexRegister, bStatusC, bStatusV);
-        SetNZBits (sR_IndexRegister);
-        break;
-    }
-}
-
-void SimSUBr()
-{
-    sRegisterType R0;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    iRegType = GetRegisterTypeFourthBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-    eR_RegType = ProcessRegisterType(iRegType);
-         
-    LoadReg (R0);
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        Subtractor (sR_Accumulator, R0, sR_Accumulator, bStatusC, bStatusV);
-        SetNZBits (sR_Accumulator);
-        break;
-    case eR_R_IS_INDEX_REG:
-        Subtractor (sR_IndexRegister, R0, sR_IndexRegister, bStatusC, bStatusV);
-        SetNZBits (sR_IndexRegister);
-        break;
-    }
-}
-
-void ANDReg (sRegisterType Op1, sRegisterType Op2, sRegisterType& Result)
-{
-    int iPwr;
-    iPwr = 1;
-    Result.iHigh = 0;
-    Result.iLow = 0;
-    while (((Op1.iHigh != 0) && (Op2.iHigh != 0)) ||         // while more to do
-           ((Op1.iLow != 0) && (Op2.iLow != 0)))
-    {
-        if ((Op1.iHigh % 2 != 0) && (Op2.iHigh % 2 != 0))
-        {
-            Result.iHigh = Result.iHigh + iPwr;
-        }
-        if ((Op1.iLow % 2 != 0) && (Op2.iLow % 2 != 0))
-        {
-            Result.iLow = Result.iLow + iPwr;
-        }
-        Op1.iHigh = Op1.iHigh / 2;
-        Op1.iLow = Op1.iLow / 2;
-        Op2.iHigh = Op2.iHigh / 2;
-        Op2.iLow = Op2.iLow / 2;
-        iPwr = iPwr + iPwr;
-    }
-}
-
-void SimANDr()
-{
-    sRegisterType R0;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    iRegType = GetRegisterTypeFourthBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-    eR_RegType = ProcessRegisterType(iRegType);
-   
-    LoadReg (R0);
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        ANDReg (sR_Accumulator, R0, sR_Accumulator);
-        SetNZBits (sR_Accumulator);
-        break;
-    case eR_R_IS_INDEX_REG:
-        ANDReg (sR_IndexRegister, R0, sR_IndexRegister);
-        SetNZBits (sR_IndexRegister);
-        break;
-    }
-}
-
-void ORReg (sRegisterType Op1, sRegisterType Op2, sRegisterType& Result)
-{
-    int Pwr;
-    Pwr = 1;
-    Result.iHigh = 0;
-    Result.iLow = 0;
-    while (((Op1.iHigh != 0) || (Op2.iHigh != 0)) ||          // while more to do
-           ((Op1.iLow != 0) || (Op2.iLow != 0)))
-    {
-        if ((Op1.iHigh % 2 != 0) || (Op2.iHigh % 2 != 0))
-        {
-            Result.iHigh = Result.iHigh + Pwr;
-        }
-        if ((Op1.iLow % 2 != 0) || (Op2.iLow % 2 != 0))
-        {
-            Result.iLow = Result.iLow + Pwr;
-        }
-        Op1.iHigh = Op1.iHigh / 2;
-        Op1.iLow = Op1.iLow / 2;
-        Op2.iHigh = Op2.iHigh / 2;
-        Op2.iLow = Op2.iLow / 2;
-        Pwr = Pwr + Pwr;
-    }
-}
-
-void SimORr()
-{  
-    sRegisterType R0;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    iRegType = GetRegisterTypeFourthBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-    eR_RegType = ProcessRegisterType(iRegType);
-   
-    LoadReg (R0);
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        ORReg (sR_Accumulator, R0, sR_Accumulator);
-        SetNZBits (sR_Accumulator);
-        break;
-    case eR_R_IS_INDEX_REG:
-        ORReg (sR_IndexRegister, R0, sR_IndexRegister);
-        SetNZBits (sR_IndexRegister);
-        break;
-    }
-}
-
-void SimCPr()
-{
-    sRegisterType R0, R1, R2;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    iRegType = GetRegisterTypeFourthBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-    eR_RegType = ProcessRegisterType(iRegType);
-   
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        R0 = sR_Accumulator; break;
-    case eR_R_IS_INDEX_REG:
-        R0 = sR_IndexRegister; break;
-    }
-    LoadReg (R1);
-    Subtractor (R0, R1, R2, bStatusC, bStatusV);
-    if ((R0.iHigh <= 127) && (R1.iHigh >= 128)) //Pos minus Neg
-    {
-        bStatusN = false;
-        bStatusZ = false;
-    }
-    else if ((R0.iHigh >= 128) && (R1.iHigh <= 127)) //Neg minus Pos
-    {
-        bStatusN = true;
-        bStatusZ = false;
-    }
-    else
-    {
-        SetNZBits (R2);
-    }
-}
-
-void SimLDr()
-{
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    iRegType = GetRegisterTypeFourthBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-    eR_RegType = ProcessRegisterType(iRegType);
-   
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        LoadReg (sR_Accumulator);
-        SetNZBits (sR_Accumulator);
-        break;
-    case eR_R_IS_INDEX_REG:
-        LoadReg (sR_IndexRegister);
-        SetNZBits (sR_IndexRegister);
-        break;
-    }
-}
-
-void SimLDBYTEr()
-{
-
-    int Temp;
-    sRegisterType Operand;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    iRegType = GetRegisterTypeFourthBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-    eR_RegType = ProcessRegisterType(iRegType);
-         
-    AddrProcessor (Operand);
-    if (eA_AddrMode == eA_IMMEDIATE)
-    {
-        Temp = Operand.iLow;
-    }
-    else
-    {
-        MemByteRead (Operand, Temp);
-    }
-    switch (eR_RegType)
-    {
-    case eR_R_IS_ACCUMULATOR:
-        sR_Accumulator.iLow = Temp;
-        SetNZBits (sR_Accumulator);
-        break;
-    case eR_R_IS_INDEX_REG:
-        sR_IndexRegister.iLow = Temp;
-        SetNZBits (sR_IndexRegister);
-        break;
-    }
-}
-
-void SimSTr (bool& bError)
-{
-    sRegisterType Operand;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    iRegType = GetRegisterTypeFourthBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-    eR_RegType = ProcessRegisterType(iRegType);
-   
-    if (eA_AddrMode == eA_IMMEDIATE)
-    {
-        IllegalAddr (bError);
-    }
-    else  // addressing mode is valid
-    {
-        AddrProcessor (Operand);
-        switch (eR_RegType)
-        {
-        case eR_R_IS_ACCUMULATOR:
-            MemWrite (sR_Accumulator, Operand);
-            break;
-        case eR_R_IS_INDEX_REG:
-            MemWrite (sR_IndexRegister, Operand);
-            break;
-        }
-    }
-}
-
-void SimSTBYTEr (bool& bError)
-{
-    sRegisterType Operand;
-   
-    iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-    iRegType = GetRegisterTypeFourthBit (sIR_InstrRegister.iInstr_Spec);
-    eA_AddrMode = ProcessAddressingMode(iAddrMode);
-    eR_RegType = ProcessRegisterType(iRegType);
-            
-    if (eA_AddrMode == eA_IMMEDIATE)
-    {
-        IllegalAddr (bError);
-    }
-    else  // addressing mode is valid
-    {
-        AddrProcessor (Operand);
-        switch (eR_RegType)
-        {
-        case eR_R_IS_ACCUMULATOR:
-            MemByteWrite (sR_Accumulator.iLow, Operand); break;
-        case eR_R_IS_INDEX_REG:
-            MemByteWrite (sR_IndexRegister.iLow, Operand); break;
-        }
-    }
-}
-
-void Push (sRegisterType Reg, sRegisterType Size)
-{
-    FastAdder (sR_StackPointer, Size, sR_StackPointer);
-    MemWrite (Reg, sR_StackPointer);
-}
-
-void SimTRAP(int trapNumber)
-{
-    if (4 <= trapNumber)
-    {
-        iAddrMode = GetAddressingModeThreeBits (sIR_InstrRegister.iInstr_Spec);
-        eA_AddrMode = ProcessAddressingMode(iAddrMode);
-    }
-    sRegisterType R0;
-    sRegisterType oldSP;
-   
-    oldSP = sR_StackPointer;                        // Save initial SP value to push later
-    sR_StackPointer.iHigh = iMemory[SYSTEM_SP];     // Get system SP value
-    sR_StackPointer.iLow  = iMemory[SYSTEM_SP + 1]; // Transfer instr spec to R0
-     
-    FastAdder (sR_StackPointer, sR_NegOne, sR_StackPointer);
-    MemByteWrite (sIR_InstrRegister.iInstr_Spec, sR_StackPointer);      // Push instruction specifier
-    Push (oldSP, sR_NegTwo);
-    Push (sR_ProgramCounter, sR_NegTwo);
-    Push (sR_IndexRegister, sR_NegTwo);
-    Push (sR_Accumulator, sR_NegTwo);
-
-    R0.iLow = (bStatusN * 8) + (bStatusZ * 4) + (bStatusV * 2) + bStatusC;
-    FastAdder (sR_StackPointer, sR_NegOne, sR_StackPointer);
-    MemByteWrite (R0.iLow, sR_StackPointer);               // Push status flags
-    sR_ProgramCounter.iHigh = iMemory[INTR_PC];            // Branch to Pep/8 OS
-    sR_ProgramCounter.iLow = iMemory[INTR_PC + 1];
-}
-
-//**** End of Opcode procedures ****
-
-void Initialize (bool& bError)
-{
-    char ch;
-    trapFile.open("trap");
-    if (!trapFile.is_open()) {
-        bError = true;
-        cout << "Could not open trap file." << endl;
-    } 
-    else {
-        bError = false;
-        for (int iLine = 0; iLine < UNIMPLEMENTED_INSTRUCTIONS; iLine++)
-        {
-            vGetLine(trapFile);
-            vAdvanceInput(ch);
-            for (int i = 0; i < MNEMON_LENGTH; i++)
-            {
-                if (isspace(ch)) 
-                {
-                    TrapMnemon[iLine][i] = ' ';
-                }
-                else
-                {
-                    TrapMnemon[iLine][i] = toupper(ch);
-                    vAdvanceInput(ch);
-                }
-            }
-            TrapMnemon[iLine][MNEMON_LENGTH] = '\0';
-        }
-        eTraceMode = eT_TR_OFF;
-        bLoading = false;
-        bMachineReset = false;
-        bKeyboardInput = true;
-        bScreenOutput = true;
-        bSingleStep = false;
-        bScrollingTrace = false;
-        cHexTable[0] = '0';
-        cHexTable[1] = '1';
-        cHexTable[2] = '2';
-        cHexTable[3] = '3';
-        cHexTable[4] = '4';
-        cHexTable[5] = '5';
-        cHexTable[6] = '6';
-        cHexTable[7] = '7';
-        cHexTable[8] = '8';
-        cHexTable[9] = '9';
-        cHexTable[10] = 'A';
-        cHexTable[11] = 'B';
-        cHexTable[12] = 'C';
-        cHexTable[13] = 'D';
-        cHexTable[14] = 'E';
-        cHexTable[15] = 'F';
-        iUnaryOpcodes[0] = eM_STOP;
-        iUnaryOpcodes[1] = eM_RETTR;
-        iUnaryOpcodes[2] = eM_MOVSPA;
-        iUnaryOpcodes[3] = eM_MOVFLGA;
-        iUnaryOpcodes[4] = eM_NOTr;
-        iUnaryOpcodes[5] = eM_NEGr;
-        iUnaryOpcodes[6] = eM_ASLr;
-        iUnaryOpcodes[7] = eM_ASRr;
-        iUnaryOpcodes[8] = eM_ROLr;
-        iUnaryOpcodes[9] = eM_RORr;
-        iUnaryOpcodes[10] = eM_UNIMP0;
-        iUnaryOpcodes[11] = eM_UNIMP1;
-        iUnaryOpcodes[12] = eM_UNIMP2;
-        iUnaryOpcodes[13] = eM_UNIMP3;
-        iUnaryOpcodes[14] = eM_RETn;
-        ByteInstructions[0] = eM_LDBYTEr;
-        ByteInstructions[1] = eM_STBYTEr;
-        ByteInstructions[2] = eM_CHARI;
-        ByteInstructions[3] = eM_CHARO;
-        sR_AtZero.iHigh = 0;
-        sR_AtZero.iLow = 0;
-        sR_One.iHigh = 0;
-        sR_One.iLow = 1;
-        sR_Two.iHigh = 0;
-        sR_Two.iLow = 2;
-        sR_NegOne.iHigh = 255;
-        sR_NegOne.iLow = 255;
-        sR_NegTwo.iHigh = 255;
-        sR_NegTwo.iLow = 254;
-        sR_NegThree.iHigh = 255;
-        sR_NegThree.iLow = 253;
-        sR_Accumulator = sR_AtZero;             // Must be initialized if trace used
-        sR_IndexRegister = sR_AtZero;
-        numTerminalLines = 22;
-        trapFile.close();
-        trapFile.clear();
-    }
-}
-
-//**** Converts a HEX number to a decimal number and returns the decimal number.
-int iHexToDec (char ch)
-{
-    switch (ch)
-    {
-    case '0':  return 0; break;
-    case '1':  return 1; break;
-    case '2':  return 2; break;
-    case '3':  return 3; break;
-    case '4':  return 4; break;
-    case '5':  return 5; break;
-    case '6':  return 6; break;
-    case '7':  return 7; break;
-    case '8':  return 8; break;
-    case '9':  return 9; break;
-    case 'A':  return 10; break;
-    case 'B':  return 11; break;
-    case 'C':  return 12; break;
-    case 'D':  return 13; break;
-    case 'E':  return 14; break;
-    case 'F':  return 15; break;
-    default: return -1;
-    }
-}
-
-//**** Converts a decimal value between -256 to 255 to a HEX array of characters
-//**** Used to convert opcodes to hex
-void vDecToHexByte (int iDec, char cHex[HEX_BYTE_LENGTH + 1])
-{
-    cHex[0] = cHexTable[iDec / 16];
-    cHex[1] = cHexTable[iDec % 16];
-    cHex[2] = '\0';
-}
-
-//**** Converts a HEX byte to a positive decimal integer
-int iHexByteToDecInt (char cHex[HEX_BYTE_LENGTH + 1])
-{
-    return 16 * iHexToDec(cHex[0]) + iHexToDec(cHex[1]);
-}
-
-//**** Converts a 16 bit register into a 4 digit HEX no.
-void RegToHex (sRegisterType Reg, char HexNum[])
-{
-    if (Reg.iHigh < 0 || Reg.iHigh > 255)
-    {
-        cout << "\nSimulator error: Reg.iHigh out of bounds: " << Reg.iHigh << endl;
-    }
-    else if ( Reg.iLow < 0 || Reg.iLow > 255)
-    {
-        cout << "\nSimulator error: Reg.iLow out of bounds: " << Reg.iLow << endl;
-    }
-    HexNum[0] = cHexTable[Reg.iHigh / 16];
-    HexNum[1] = cHexTable[Reg.iHigh % 16];
-    HexNum[2] = cHexTable[Reg.iLow / 16];
-    HexNum[3] = cHexTable[Reg.iLow % 16];
-    HexNum[4] = '\0';
-}
-
-//**** Initialize RAM using data from pep8os.pepo file
-void InstallRom (bool& bError)
-{
-    ifstream ROMFile;
-    int iNumBytes = 0;
-    char cByte[HEX_BYTE_LENGTH + 1];
-    int iCounter = 0;
-    char cNext;
-    ROMFile.open("pep8os.pepo");
-    if (ROMFile.fail())
-    {
-        bError = true;
-        cout << "Could not open file pep8os.pepo" << endl;
-    }
-    else
-    {
-        iCounter = 0;
-        int i;
-        vGetLine(ROMFile);
-        vAdvanceInput(cNext);
-        while (!ROMFile.eof())
-        {
-            if (bIsHexDigit(cNext))
-            {
-                iCounter++;
-            }
-            else if (cNext == '\n')
-            {
-                vGetLine(ROMFile);
-            }
-            vAdvanceInput(cNext);
-        }
-        iNumBytes = iCounter / 2;
-        ROMFile.close();
-        ROMFile.clear();
-        if (iNumBytes >= MEMORY_SIZE)
-        {
-            bError = true;
-            cout << "OS is too big to fit into main memory." << endl;
-            cout << "NumBytes = " << iNumBytes;
-            cout << ", MemorySize = " << MEMORY_SIZE << endl;
-        }
-        else
-        {
-            ROMFile.open ("pep8os.pepo");
-            iRomStartAddr = TOP_OF_MEMORY - iNumBytes + 1;
-            bool bIsEnd = false;
-            vGetLine(ROMFile);
-            vAdvanceInput(cNext);
-            iCounter = 0;
-            i = iRomStartAddr;
-            while (!ROMFile.eof() && !bIsEnd)
-            {
-                if (iCounter == 2)
-                {
-                    cByte[iCounter] = '\0';
-                    iMemory[i++] = iHexByteToDecInt(cByte);
-                    iCounter = 0;
-                    vBackUpInput();
-                }
-                else if (bIsHexDigit(cNext))
-                {
-                    cByte[iCounter++] = cNext;
-                }
-                else if (cNext == '\n')
-                {
-                    vGetLine(ROMFile);
-                }
-                else if (cNext == 'z')
-                {
-                    bIsEnd = true;
-                }
-                else if (cNext != ' ')
-                {
-                    cout << "Invalid input in pep8os.pepo" << endl;
-                    return;
-                }
-                vAdvanceInput(cNext);
-            }
-            if (bIsEnd)
-            {
-                if (cNext != 'z')
-                {
-                    cout << "File must end in 'zz'" << endl;
-                }
-            }
-            ROMFile.close();
-            ROMFile.clear();
-            cout << iRomStartAddr << " bytes RAM free." << endl;
-        }
-    }
-}
-
-void PrintLine (ostream& output)
-{
-    output << "--------------------------------------------------";
-    output << "-----------------------" << endl;
-}
-
-void PrintHeading (ostream& output)
-{
-    PrintLine (output);
-    output << "               Oprnd     Instr           Index   Stack   Status" << endl;
-    output << "Addr  Mnemon   Spec       Reg     Accum   Reg   Pointer  N Z V C  Operand" << endl;
-    PrintLine (output);
-}
-
-void PrintTraceLine (ostream& output, sRegisterType Address)
-{
-    char cHexByte[HEX_BYTE_LENGTH + 1];
-    char cHexWord[HEX_WORD_LENGTH + 1];
-    sRegisterType R0;
-    RegToHex (Address, cHexWord);
-    output << cHexWord << "  "; // Print address
-    PrntMnemon (output);                // Print mnemonic
-    if (bSearchIntArray(iUnaryOpcodes, UNARY_OPCODES, instr_SpecToMnemon(sIR_InstrRegister.iInstr_Spec)))
-    {
-        output << "                   ";
-    }
-    else
-    {
-        RegToHex (sIR_InstrRegister.sR_OprndSpec, cHexWord);
-        output << cHexWord << ",";
-        switch (eA_AddrMode)
-        {         
-        case eA_IMMEDIATE: output << "i    "; break;
-        case eA_DIRECT: output << "d    "; break;
-        case eA_INDIRECT: output << "n    "; break;
-        case eA_STACK_REL: output << "s    "; break;
-        case eA_STACK_REL_DEF: output << "sf   "; break;
-        case eA_INDEXED: output << "x    "; break;
-        case eA_STACK_IND: output << "sx   "; break;
-        case eA_STACK_IND_DEF: output << "sxf  "; break;
-        }
-      
-        vDecToHexByte (sIR_InstrRegister.iInstr_Spec, cHexByte);
-        output << cHexByte;
-        RegToHex (sIR_InstrRegister.sR_OprndSpec, cHexWord);
-        output << cHexWord << "   ";    // Print instruction reg
-    }
-    RegToHex (sR_Accumulator, cHexWord);
-    output << cHexWord << "   ";                // Print accumulator
-    RegToHex (sR_IndexRegister, cHexWord);
-    output << cHexWord << "    ";               // Print index register
-    RegToHex (sR_StackPointer, cHexWord);
-    output << cHexWord << "    ";               // Print stack pointer
-    output << bStatusN << " " << bStatusZ << " " << bStatusV << " " << bStatusC << "   ";  // Print status bit
-    if (bSearchIntArray(iUnaryOpcodes, UNARY_OPCODES, instr_SpecToMnemon(sIR_InstrRegister.iInstr_Spec)))
-    {
-        for (int i = 0; i < HEX_WORD_LENGTH; i++)
-        {
-            cHexWord[i] = '0';
-        }
-    }
-    else
-    {
-        LoadReg (R0);   // calculate operand
-        RegToHex (R0, cHexWord);
-    }
-    output << cHexWord; // Print iMemory [Oprnd Spec]
-}
-
-char GetTracePrompt ()
-{
-    char cResponse[LINE_LENGTH];
-    char ch;
-    do
-    {
-        cin.getline(cResponse, LINE_LENGTH);
-        ch = toupper(cResponse[0]);
-        if (ch != 'N' && ch != 'C' && ch != 'S' && ch != 'Q' && ch != ' ')
-        {
-            cout << "Invalid response" << endl;
-            cout << "(n)ext page  s(c)roll  (s)ingle step  (q)uit trace: ";
-        }
-    }
-    while (ch != 'N' && ch != 'C' && ch != 'S' && ch != 'Q' && ch != ' ');
-    return ch;
-}
-
-void Trace (sRegisterType Address, int& LineCount, bool& Halt)
-{
-    int iTempAddr;
-    char ch;
-
-    if (Address.iHigh < MEMORY_SIZE / 256)
-    {
-        iTempAddr = Address.iHigh * 256 + Address.iLow;
-    }
-    else
-    {
-        iTempAddr = TOP_OF_MEMORY;
-    }
-    if (iTempAddr < iRomStartAddr
-        || (iTempAddr >= iRomStartAddr && eTraceMode == eT_TR_TRAPS)
-        || eTraceMode == eT_TR_LOADER)
-    {
-        PrintTraceLine (cout, Address);
-        if (bScrollingTrace)
-        {
-            cout << endl;
-        }
-        else if (bSingleStep)
-        {
-            cout << ": ";
-            ch = GetTracePrompt ();
-            switch (ch)
-            {
-            case 'N':
-                bSingleStep = false;
-                cout << endl;
-                PrintHeading (cout);
-                LineCount = 4;
-                break;
-            case 'C':
-                bSingleStep = false;
-                bScrollingTrace = true;
-                cout << endl;
-                PrintHeading (cout);
-                break;
-            case 'Q':
-                bSingleStep = false;
-                bScrollingTrace = false;
-                cout << endl;
-                PrintLine (cout);
-                Halt = true;
-                break;
-            default:
-                break;
-            }
-        }
-        else  // Not single stepping or scrolling trace to completion
-        {
-            cout << endl;
-            LineCount++;
-            if (LineCount >= numTerminalLines)
-            {
-                cout << "(n)ext page  s(c)roll  (s)ingle step  (q)uit trace: ";
-                ch = GetTracePrompt ();
-                switch (ch)
-                {
-                case 'N':
-                    cout << endl;
-                    PrintHeading (cout);
-                    LineCount = 4;
-                    break;
-                case 'C':
-                    bScrollingTrace = true;
-                    cout << endl;
-                    PrintHeading (cout);
-                    break;
-                case 'S':
-                    bSingleStep = true;
-                    break;
-                case 'Q':
-                    bSingleStep = false;
-                    bScrollingTrace = false;
-                    cout << endl;
-                    PrintLine (cout);
-                    Halt = true;
-                    break;
-                default:
-                    break;
-                }
-            }
-        }
-    }
-}
-
-//****  The von Neumann execution cycle
-void FetchIncrPC()
-{
-    //**** Fetch instruction spec.
-    MemByteRead (sR_ProgramCounter, sIR_InstrRegister.iInstr_Spec);  // R0.iHigh = Instruction spec.
-    //**** Increment ProgramCounter by one
-    if (sR_ProgramCounter.iLow == 255)
-    {
-        sR_ProgramCounter.iLow = 0;
-        if (sR_ProgramCounter.iHigh == 255)
-        {
-            sR_ProgramCounter.iHigh = 0;
-        }
-        else
-        {
-            sR_ProgramCounter.iHigh++;
-        }
-    }
-    else
-    {
-        sR_ProgramCounter.iLow = sR_ProgramCounter.iLow + 1;
-    }
-    if (!bSearchIntArray(iUnaryOpcodes, UNARY_OPCODES, instr_SpecToMnemon(sIR_InstrRegister.iInstr_Spec)))
-    {
-        MemRead (sR_ProgramCounter, sIR_InstrRegister.sR_OprndSpec);
-        //**** Increment sR_ProgramCounter by sR_Two
-        if (sR_ProgramCounter.iLow == 254)
-        {
-            sR_ProgramCounter.iLow = 0;
-            if (sR_ProgramCounter.iHigh == 255)
-            {
-                sR_ProgramCounter.iHigh = 0;
-            }
-            else
-            {
-                sR_ProgramCounter.iHigh++;
-            }
-        }
-        else if (sR_ProgramCounter.iLow == 255)
-        {
-            sR_ProgramCounter.iLow = 1;
-            if (sR_ProgramCounter.iHigh == 255)
-            {
-                sR_ProgramCounter.iHigh = 0;
-            }
-            else
-            {
-                sR_ProgramCounter.iHigh++;
-            }
-        }
-        else
-        {
-            sR_ProgramCounter.iLow = sR_ProgramCounter.iLow + 2;
-        }
-    }
-}
-
-void Execute (bool& bHalt)
-{
-    switch (instr_SpecToMnemon(sIR_InstrRegister.iInstr_Spec)) {
-    case eM_STOP: SimSTOP(bHalt); break;
-    case eM_RETTR: SimRETTR(); break;
-    case eM_MOVSPA: SimMOVSPA (bHalt); break;
-    case eM_MOVFLGA: SimMOVFLGA (bHalt); break;
-
-    case eM_BR: SimBR(); break;                                                 
-    case eM_BRLE: SimBRLE(); break;                                 
-    case eM_BRLT: SimBRLT(); break;                                 
-    case eM_BREQ: SimBREQ(); break;                                                 
-    case eM_BRNE: SimBRNE(); break;                                                 
-    case eM_BRGE: SimBRGE(); break;                                                 
-    case eM_BRGT: SimBRGT(); break;                                                 
-    case eM_BRV: SimBRV(); break;                                                 
-    case eM_BRC: SimBRC(); break; 
-    case eM_CALL: SimCALL(bHalt); break;
-
-    case eM_NOTr: SimNOTr(); break;
-    case eM_NEGr: SimNEGr(); break;
-    case eM_ASLr: SimASLr(); break;
-    case eM_ASRr: SimASRr(); break;
-    case eM_ROLr: SimROLr(); break;
-    case eM_RORr: SimRORr(); break;
-         
-    case eM_UNIMP0: SimTRAP(0); break;
-    case eM_UNIMP1: SimTRAP(1); break;
-    case eM_UNIMP2: SimTRAP(2); break;
-    case eM_UNIMP3: SimTRAP(3); break;
-    case eM_UNIMP4: SimTRAP(4); break;
-    case eM_UNIMP5: SimTRAP(5); break;
-    case eM_UNIMP6: SimTRAP(6); break;
-    case eM_UNIMP7: SimTRAP(7); break;
-
-    case eM_CHARI: SimCHARI(bHalt); break;
-    case eM_CHARO: SimCHARO(); break;
-
-    case eM_RETn: SimRETn(); break;
-           
-    case eM_ADDSP: SimADDSP(bHalt); break;
-    case eM_SUBSP: SimSUBSP(bHalt); break;
-                 
-    case eM_ADDr: SimADDr(); break;
-    case eM_SUBr: SimSUBr(); break;
-                                                
-    case eM_ANDr: SimANDr(); break;
-    case eM_ORr: SimORr(); break;
-    case eM_CPr: SimCPr(); break;
-
-    case eM_LDr: SimLDr(); break;
-    case eM_LDBYTEr: SimLDBYTEr(); break;
-    case eM_STr: SimSTr(bHalt); break;
-    case eM_STBYTEr: SimSTBYTEr(bHalt); break;
-    }
-}
-
-void StartExecution ()
-{
-    bool Halt;
-    sRegisterType TraceAddr;
-    int iLineCount;
-    char cResponse[LINE_LENGTH];
-    if (!bMachineReset && !bLoading)
-    {
-        cout << "Execution error: Machine state not initialized." << endl;
-        cout << "Use (l)oad command." << endl;
-    }
-    else
-    {
-        if (eTraceMode != eT_TR_OFF && !bSingleStep)
-        {
-            switch (eTraceMode)
-            {
-            case eT_TR_PROGRAM : cout << "User Program Trace:" << endl; break;
-            case eT_TR_TRAPS : cout << "User Program Trace with Traps:" << endl; break;
-            case eT_TR_LOADER : cout << "Loader Trace of Operating System:" << endl; break;
-            case eT_TR_OFF : break;
-            }
-            cout << endl;
-            PrintHeading (cout);
-            iLineCount = 6;
-        }
-        //**** The von Neumann execution cycle
-        Halt = false;
-        do
-        {
-            TraceAddr = sR_ProgramCounter;
-            FetchIncrPC();
-            Execute (Halt);
-            if (eTraceMode != eT_TR_OFF)
-            {
-                Trace (TraceAddr, iLineCount, Halt);
-            }
-        }
-        while (!Halt);
-        if (eTraceMode != eT_TR_OFF)
-        {
-            PrintLine (cout);
-        }
-        if (!bKeyboardInput)
-        {
-            chariInputStream.seekg (0, ios::beg);  // Reset input file to its beginning
-        }
-    }
-}
-
-void LoaderCommand()
-{
-    char FileName[FILE_NAME_LENGTH];
-   
-    if (!bKeyboardInput)
-    {
-        cout << "Data input switched back to keyboard." << endl;
-        bKeyboardInput = true;
-        chariInputStream.close();
-        chariInputStream.clear();
-    }
-    cout << "Enter object file name (do not include .pepo): ";
-    cin.getline(FileName, FILE_NAME_LENGTH);
-    int iTemp = cin.gcount() - 1;
-    FileName[iTemp++] = '.';
-    FileName[iTemp++] = 'p';
-    FileName[iTemp++] = 'e';
-    FileName[iTemp++] = 'p';
-    FileName[iTemp++] = 'o';
-    FileName[iTemp] = '\0';
-    chariInputStream.open(FileName);
-    if (chariInputStream.is_open())
+}
+
+//**** Writes the state of the machine to a checkpoint file
+void SaveCommand()
+{
+    char cFileName[FILE_NAME_LENGTH];
+    cout << "Enter checkpoint file name: ";
+    cin.getline(cFileName, FILE_NAME_LENGTH);
+    cFileName[cin.gcount() - 1] = '\0';
+    if (pep8Machine.bSaveCheckpoint(cFileName))
     {
-        cout << "Object file is " << FileName << endl;
-        bMachineReset = true;
-        bBufferIsEmpty = true;
-        bLoading = true;
-        sR_StackPointer.iHigh = iMemory[SYSTEM_SP];
-        sR_StackPointer.iLow = iMemory[SYSTEM_SP + 1];
-        sR_ProgramCounter.iHigh = iMemory[LOADER_PC];
-        sR_ProgramCounter.iLow = iMemory[LOADER_PC + 1];
-        StartExecution ();
-        bLoading = false;
+        cout << "Checkpoint written to " << cFileName << endl;
     }
     else
     {
-        cout << "Could not open object file " << FileName << endl;
+        cout << "Error opening file " << cFileName << endl;
     }
-    chariInputStream.close();
-    chariInputStream.clear();
 }
 
-void ExecuteCommand()
+//**** Puts back the state of a checkpoint file, with the input and output
+//**** bound by the (i)nput and (o)utput commands
+void RestoreCommand()
+{
+    char cFileName[FILE_NAME_LENGTH];
+    cout << "Enter checkpoint file name: ";
+    cin.getline(cFileName, FILE_NAME_LENGTH);
+    cFileName[cin.gcount() - 1] = '\0';
+    if (pep8Machine.bRestoreCheckpoint(cFileName))
+    {
+        cout << "Checkpoint restored from " << cFileName << endl;
+        if (pep8Machine.bCanContinue())
+        {
+            cout << "Use (c)ontinue to resume the program." << endl;
+        }
+    }
+}
+
+void ContinueCommand()
 {
-    bBufferIsEmpty = true;
-    sR_StackPointer.iHigh = iMemory[USER_SP];
-    sR_StackPointer.iLow = iMemory[USER_SP + 1];
-    sR_ProgramCounter.iHigh = 0;
-    sR_ProgramCounter.iLow = 0;
-    StartExecution ();
+    eRunStatus eStatus = pep8Machine.Continue();
+    if (pep8Machine.bStatistics && eStatus != eS_BREAKPOINT && eStatus != eS_RUNTIME_ERROR)
+    {
+        pep8Machine.PrintStatistics(cout);
+    }
 }
 
 void DecodeAddress (char Digits[HEX_BYTE_LENGTH + 1], int& Value)
@@ -2090,29 +302,33 @@ void Parse (sRegisterType& StartAddress, sRegisterType& EndAddress)
     char Hex[HEX_WORD_LENGTH + 1][HEX_BYTE_LENGTH + 1];
     char c;
     int i,j;
+    int iStartHigh, iStartLow, iEndHigh, iEndLow;
     bool NoError;
+    char cLine[LINE_LENGTH] = "";
+    int iLineIndex;
     do
     {
         NoError = true;
         cout << endl;
         cout << "Enter address range of dump (HEX)" << endl;
         cout << "Example, 0020-0140: ";
-        vGetLine(cin);
+        cin.getline(cLine, LINE_LENGTH);
+        iLineIndex = 0;
         for (i = 0; i < 2; i++)
         {
             for (j = 0; j < 2; j++)
             {
-                vAdvanceInput(c);
+                c = cLine[iLineIndex++];
                 Hex[i][j] = c;
             }
             Hex[i][j] = '\0';
         }
-        vAdvanceInput(c);
+        c = cLine[iLineIndex++];
         for (i = 2; i < 4; i++)
         {
             for (j = 0;j < 2; j++)
             {
-                vAdvanceInput(c);
+                c = cLine[iLineIndex++];
                 Hex[i][j] = c;
             }
             Hex[i][j] = '\0';
@@ -2129,112 +345,163 @@ void Parse (sRegisterType& StartAddress, sRegisterType& EndAddress)
                 }
                 else
                 {
-                    DecodeAddress(Hex[0], StartAddress.iHigh);
-                    DecodeAddress(Hex[1], StartAddress.iLow);
-                    DecodeAddress(Hex[2], EndAddress.iHigh);
-                    DecodeAddress(Hex[3], EndAddress.iLow);
+                    DecodeAddress(Hex[0], iStartHigh);
+                    DecodeAddress(Hex[1], iStartLow);
+                    DecodeAddress(Hex[2], iEndHigh);
+                    DecodeAddress(Hex[3], iEndLow);
                 }
             }
         }
     }
     while (!NoError);
+    StartAddress = iStartHigh * 256 + iStartLow;
+    EndAddress = iEndHigh * 256 + iEndLow;
 }
 
-void Dump (ostream& output, sRegisterType StartAddress, sRegisterType EndAddress)
+//**** d prints the dump on the screen, d file writes it to file and
+//**** d -r file writes the bytes of the range to file as they are
+void DumpCommand()
 {
-    int Address;
-    int LineAddress;
-    char cHexByte[HEX_BYTE_LENGTH + 1];
-    char cHexWord[HEX_WORD_LENGTH + 1];
-    sRegisterType Sixteen;
-    bool Carry, Ovflw;
-    Sixteen.iHigh = 0;
-    Sixteen.iLow = 16;
-    StartAddress.iLow = (StartAddress.iLow / 16) * 16; // Start with new line
-    output << "DUMP    0  1  2  3  4  5  6  7  8  9  ";
-    output << "A  B  C  D  E  F       ASCII" << endl << endl;
-    if (StartAddress.iHigh < (MEMORY_SIZE / (256)))
-    {
-        Address = StartAddress.iHigh * (256) + StartAddress.iLow;
+    sRegisterType StartAddress;
+    sRegisterType EndAddress;
+    bool bRangeOK;
+    bool bImage = false;
+    const char* cFileName = cCommand + 1;
+    while (*cFileName == ' ')
+    {
+        cFileName++;
     }
-    else
+    if (strncmp(cFileName, "-r ", 3) == 0)
     {
-        Address = MEMORY_SIZE;
+        bImage = true;
+        cFileName += 3;
+        while (*cFileName == ' ')
+        {
+            cFileName++;
+        }
     }
-    Carry = false;
-    while (((StartAddress.iHigh < EndAddress.iHigh)
-            || (StartAddress.iHigh == EndAddress.iHigh && StartAddress.iLow <= EndAddress.iLow))
-           && !(Carry && StartAddress.iHigh == 0))
+    cout << "Pep/8 memory dump:  ";
+    do
     {
-        LineAddress = Address;
-        RegToHex (StartAddress, cHexWord);
-        output << cHexWord << ":  ";
-        for (int i = 0; i < 16; i++)
+        bRangeOK = true;
+        Parse (StartAddress, EndAddress);
+        if (EndAddress == 0)
         {
-            if (Address < MEMORY_SIZE)
-            {
-                vDecToHexByte (iMemory[Address++], cHexByte);
-            }
-            else
-            {
-                cHexByte[0] = 0;
-                cHexByte[1] = 0;
-                cHexByte[2] = '\0';
-            }
-            output << cHexByte << " ";
+            EndAddress = StartAddress;
         }
-        output << " ";
-        char cTemp;
-        for (int i = 0; i < 16; i++)
+        if (StartAddress > EndAddress)
         {
-            cTemp = static_cast <char> (iMemory[LineAddress]);
-            if (LineAddress < MEMORY_SIZE)
-            {
-                if ((iMemory[LineAddress] >= ' ') &&
-                    (iMemory[LineAddress] <= '~'))
-                {
-                    output << cTemp;
-                }
-                else
-                {
-                    output << ".";
-                }
-                LineAddress++;
-            }
-            else
-            {
-                output << ".";
-            }
+            bRangeOK = false;
+            cout << "Address range error. Start address must be less than end address." << endl;
         }
-        output << endl;
-        Adder (StartAddress, Sixteen, StartAddress, Carry, Ovflw);
+    }
+    while (!bRangeOK);
+    if (*cFileName == '\0')
+    {
+        pep8Machine.Dump (cout, StartAddress, EndAddress);
+    }
+    else if (pep8Machine.bDumpFile (cFileName, StartAddress, EndAddress, bImage))
+    {
+        cout << "Memory " << (bImage ? "image" : "dump") << " written to " << cFileName << endl;
+    }
+    else
+    {
+        cout << "Error opening file " << cFileName << endl;
     }
 }
 
-void DumpCommand()
+//**** Reads a hex address, or a range such as 0020-0140, from cLine
+bool bParseRange (const char* cLine, sRegisterType& StartAddress, sRegisterType& EndAddress)
 {
-    sRegisterType StartAddress;
-    sRegisterType EndAddress;
+    char* pEnd;
+    long lStart, lEnd;
+    if (!bIsHexDigit(toupper(cLine[0])))
+    {
+        return false;
+    }
+    lStart = strtol(cLine, &pEnd, 16);
+    lEnd = lStart;
+    if (*pEnd == '-')
+    {
+        if (!bIsHexDigit(toupper(pEnd[1])))
+        {
+            return false;
+        }
+        lEnd = strtol(pEnd + 1, &pEnd, 16);
+    }
+    if (*pEnd != '\0' || lEnd > TOP_OF_MEMORY || lStart > lEnd)
+    {
+        return false;
+    }
+    StartAddress = lStart;
+    EndAddress = lEnd;
+    return true;
+}
+
+void BreakCommand()
+{
+    char cResponse[LINE_LENGTH];
+    char ch;
+    sRegisterType StartAddress, EndAddress;
+    bool bSet;
     bool bRangeOK;
-    cout << "Pep/8 memory dump:  ";
+    eBreakType eType = eB_EXECUTE;
     do
     {
-        bRangeOK = true;
-        Parse (StartAddress, EndAddress);
-        if ((EndAddress.iHigh == 0) && (EndAddress.iLow == 0))
+        cout << "Break  (s)et  (r)ead watch  (w)rite watch  (c)lear  (l)ist: ";
+        cin.getline(cResponse, LINE_LENGTH);
+        ch = toupper(cResponse[0]);
+        if (ch != 'S' && ch != 'R' && ch != 'W' && ch != 'C' && ch != 'L' && ch != ' ')
         {
-            EndAddress = StartAddress;
+            cout << "Invalid response." << endl;
+        }
+    }
+    while (ch != 'S' && ch != 'R' && ch != 'W' && ch != 'C' && ch != 'L' && ch != ' ');
+    if (ch == 'L')
+    {
+        pep8Machine.ListBreakpoints(cout);
+        return;
+    }
+    else if (ch == ' ')
+    {
+        return;
+    }
+    bSet = (ch != 'C');
+    switch (ch)
+    {
+    case 'R': eType = eB_READ; break;
+    case 'W': eType = eB_WRITE; break;
+    default: break;
+    }
+    do
+    {
+        cout << "Enter address or address range (HEX)" << endl;
+        cout << (bSet ? "Example, 0020 or 0020-0027: " : "Example, 0020-0027, or a for all: ");
+        cin.getline(cResponse, LINE_LENGTH);
+        if (!bSet && toupper(cResponse[0]) == 'A' && cResponse[1] == '\0')
+        {
+            pep8Machine.ClearBreakpoints();
+            cout << "All breakpoints and watchpoints cleared." << endl;
+            return;
         }
-        if ((StartAddress.iHigh > EndAddress.iHigh) ||
-            ((StartAddress.iHigh == EndAddress.iHigh) &&
-             (StartAddress.iLow > EndAddress.iLow)))
+        bRangeOK = bParseRange(cResponse, StartAddress, EndAddress);
+        if (!bRangeOK)
         {
-            bRangeOK = false;
-            cout << "Address range error. Start address must be less than end address." << endl;
+            cout << "Error in hex specification. Enter Again." << endl;
         }
     }
     while (!bRangeOK);
-    Dump (cout, StartAddress, EndAddress);
+    if (bSet)
+    {
+        pep8Machine.SetBreakpoints(eType, StartAddress, EndAddress, true);
+    }
+    else
+    {
+        pep8Machine.SetBreakpoints(eB_EXECUTE, StartAddress, EndAddress, false);
+        pep8Machine.SetBreakpoints(eB_READ, StartAddress, EndAddress, false);
+        pep8Machine.SetBreakpoints(eB_WRITE, StartAddress, EndAddress, false);
+    }
+    pep8Machine.ListBreakpoints(cout);
 }
 
 void TraceCommand()
@@ -2252,35 +519,35 @@ void TraceCommand()
         }
         else if (ch == 'A')
         {
-            cout << "Number of lines per screen dump (" << numTerminalLines << "): ";
+            cout << "Number of lines per screen dump (" << pep8Machine.numTerminalLines << "): ";
             cin.getline(cResponse, LINE_LENGTH);
             ch = toupper(cResponse[0]);
-            numTerminalLines = atoi(cResponse);
-            numTerminalLines = (numTerminalLines < 8 ? 8 : numTerminalLines);
+            pep8Machine.numTerminalLines = atoi(cResponse);
+            pep8Machine.numTerminalLines = (pep8Machine.numTerminalLines < 8 ? 8 : pep8Machine.numTerminalLines);
             cout << endl;
         }
     }
     while (ch != 'P' && ch != 'T' && ch != 'L' && ch != ' ' && ch != 'A');
-    bSingleStep = false;
-    bScrollingTrace = false;
+    pep8Machine.bSingleStep = false;
+    pep8Machine.bScrollingTrace = false;
     switch (ch)
     {
     case 'P':
-        eTraceMode = eT_TR_PROGRAM; 
+        pep8Machine.eTraceMode = eT_TR_PROGRAM; 
         ExecuteCommand();
         break;
     case 'T':
-        eTraceMode = eT_TR_TRAPS;
+        pep8Machine.eTraceMode = eT_TR_TRAPS;
         ExecuteCommand();
         break;
     case 'L':
-        eTraceMode = eT_TR_LOADER;
+        pep8Machine.eTraceMode = eT_TR_LOADER;
         LoaderCommand();
         break;
     default:
         break;
     }
-    eTraceMode = eT_TR_OFF;
+    pep8Machine.eTraceMode = eT_TR_OFF;
 }
 
 void InputCommand()
@@ -2298,11 +565,9 @@ void InputCommand()
         }
     }
     while (ch != 'K' && ch != 'F' && ch != ' ');
-    chariInputStream.close();
-    chariInputStream.clear();
     if (ch == 'K')
     {
-        bKeyboardInput = true;
+        pep8Machine.SetKeyboardInput();
         cout << "Input is from keyboard." << endl;
     }
     else if (ch == 'F')
@@ -2310,18 +575,13 @@ void InputCommand()
         cout << "Enter input data file name: ";
         cin.getline(cInFileName, FILE_NAME_LENGTH);
         cInFileName[cin.gcount() - 1] = '\0';
-        chariInputStream.open(cInFileName);
-        if (chariInputStream.is_open())
+        if (pep8Machine.bSetInputFile(cInFileName))
         {
-            bKeyboardInput = false;
             cout << "Input data file is " << cInFileName << endl;
         }
         else
         {
-            bKeyboardInput = true;
             cout << "Could not open input data file " << cInFileName << endl;
-            chariInputStream.close();
-            chariInputStream.clear();
         }
     }
 }
@@ -2341,13 +601,9 @@ void OutputCommand()
         }
     }
     while (ch != 'S' && ch != 'F' && ch != ' ');
-    if (charoOutputStream.is_open())
-    {
-        charoOutputStream.close();
-    }
     if (ch == 'S')
     {
-        bScreenOutput = true;
+        pep8Machine.SetScreenOutput();
         cout << "Output is to screen." << endl;
     }
     else if (ch == 'F')
@@ -2355,15 +611,12 @@ void OutputCommand()
         cout << "Enter output data file name: ";
         cin.getline(cOutFileName, FILE_NAME_LENGTH);
         cOutFileName[cin.gcount() - 1] = '\0';
-        charoOutputStream.open(cOutFileName);
-        if (charoOutputStream.is_open())
+        if (pep8Machine.bSetOutputFile(cOutFileName))
         {
-            bScreenOutput = false;
             cout << "Output data file is " << cOutFileName << endl;
         }
         else
         {
-            bScreenOutput = true;
             cout << "Error opening file " << cOutFileName << endl;
         }
     }
@@ -2375,20 +628,25 @@ void MainPrompt()
     do
     {
         cout << endl;
-        cout << "(l)oad  e(x)ecute  (d)ump  (t)race  (i)nput  (o)utput  (q)uit: ";
+        cout << "(l)oad  e(x)ecute  (c)ontinue  (b)reak  (d)ump  (t)race  (i)nput  (o)utput" << endl;
+        cout << "(s)ave  (r)estore  (q)uit: ";
         cin.getline(cCommand, LINE_LENGTH);
         ch = toupper(cCommand[0]);
-        if (ch == 'L' || ch == 'X' || ch == 'D' || ch == 'T'
-            || ch == 'I' || ch == 'O' || ch == 'Q')
+        if (ch == 'L' || ch == 'X' || ch == 'C' || ch == 'B' || ch == 'D' || ch == 'T'
+            || ch == 'I' || ch == 'O' || ch == 'S' || ch == 'R' || ch == 'Q')
         {
             switch (ch)
             {
             case 'L' : LoaderCommand(); break;
             case 'X' : ExecuteCommand(); break;
+            case 'C' : ContinueCommand(); break;
+            case 'B' : BreakCommand(); break;
             case 'D' : DumpCommand(); break;
             case 'T' : TraceCommand(); break;
             case 'I' : InputCommand(); break;
             case 'O' : OutputCommand(); break;
+            case 'S' : SaveCommand(); break;
+            case 'R' : RestoreCommand(); break;
             case 'Q' : break;
             }
         }
@@ -2398,48 +656,443 @@ void MainPrompt()
         }
     }
     while (ch != 'Q');
-    if (charoOutputStream.is_open())
+    pep8Machine.SetScreenOutput();
+}
+
+//**** Reads the symbol files that asem8 -y writes for the operating system
+//**** and for the object file, pep8os.peps and prog.peps for prog.pepo,
+//**** to name the routines of the call graph.  Either may be missing.
+void ReadCallSymbols (const char* cObjFileName)
+{
+    pep8Machine.bReadSymbols("pep8os.peps");
+    if (cObjFileName != NULL)
+    {
+        string sSymbolFile = cObjFileName;
+        if (sSymbolFile.size() > 5 && sSymbolFile.compare(sSymbolFile.size() - 5, 5, ".pepo") == 0)
+        {
+            sSymbolFile[sSymbolFile.size() - 1] = 's';
+            pep8Machine.bReadSymbols(sSymbolFile.c_str());
+        }
+    }
+}
+
+//**** Batch mode: loads the object file, binds the CHARI and CHARO files
+//**** and executes the program without the menu. Returns the exit status.
+//**** With -R the machine comes from the checkpoint instead of the object
+//**** file, and the program continues where the checkpoint left it.  A
+//**** program that had ended is not run again.
+int BatchRun (const char* cObjFileName, const char* cInFile, const char* cOutFile,
+              const char* cTraceFile)
+{
+    eRunStatus eStatus;
+    if (cRestoreFile == NULL)
+    {
+        if (!pep8Machine.bSetObjectFile(cObjFileName))
+        {
+            cerr << "Could not open object file " << cObjFileName << endl;
+            return 4;
+        }
+        eStatus = pep8Machine.Load();
+        pep8Machine.SetKeyboardInput();
+        if (eStatus != eS_STOPPED)
+        {
+            cerr << "Could not load object file " << cObjFileName << endl;
+            return 5;
+        }
+    }
+    if (cInFile != NULL && !pep8Machine.bSetInputFile(cInFile))
+    {
+        cerr << "Could not open input data file " << cInFile << endl;
+        return 4;
+    }
+    if (cOutFile != NULL && !pep8Machine.bSetOutputFile(cOutFile, cRestoreFile != NULL))
+    {
+        cerr << "Error opening file " << cOutFile << endl;
+        return 4;
+    }
+    if (cExpectedFile != NULL && !pep8Machine.bSetExpectedOutput(cExpectedFile, lOutputMargin))
+    {
+        cerr << "Could not open expected output file " << cExpectedFile << endl;
+        return 4;
+    }
+    if (cRestoreFile != NULL)
+    {
+        pep8Machine.SetMessageStream(cerr);
+        if (!pep8Machine.bRestoreCheckpoint(cRestoreFile))
+        {
+            return 5;
+        }
+        pep8Machine.SetMessageStream(cout);
+    }
+    if (cTraceFile != NULL && !pep8Machine.bOpenBinaryTrace(cTraceFile))
+    {
+        cerr << "Error opening file " << cTraceFile << endl;
+        return 4;
+    }
+    if (cCallGraphFile != NULL)
+    {
+        ReadCallSymbols(cObjFileName);
+    }
+    if (pep8Machine.bCanContinue())
+    {
+        eStatus = pep8Machine.Continue(lMaxInstr, dTimeLimit);
+    }
+    else if (cRestoreFile != NULL)
     {
-        charoOutputStream.close ();
+        eStatus = pep8Machine.bHasStopped() ? eS_STOPPED : eS_RUNTIME_ERROR;
     }
+    else
+    {
+        eStatus = pep8Machine.Run(lMaxInstr, dTimeLimit);
+    }
+    pep8Machine.CloseBinaryTrace();
+    pep8Machine.SetScreenOutput();
+    if (cDumpFile != NULL && !pep8Machine.bDumpFile(cDumpFile, DumpStart, DumpEnd, false))
+    {
+        cerr << "Error opening file " << cDumpFile << endl;
+        return 4;
+    }
+    if (cImageFile != NULL && !pep8Machine.bDumpFile(cImageFile, DumpStart, DumpEnd, true))
+    {
+        cerr << "Error opening file " << cImageFile << endl;
+        return 4;
+    }
+    if (cCheckpointFile != NULL && !pep8Machine.bSaveCheckpoint(cCheckpointFile))
+    {
+        cerr << "Error opening file " << cCheckpointFile << endl;
+        return 4;
+    }
+    if (cProfileFile != NULL && !pep8Machine.bWriteProfile(cProfileFile))
+    {
+        cerr << "Error opening file " << cProfileFile << endl;
+        return 4;
+    }
+    if (cCallGraphFile != NULL && !pep8Machine.bWriteCallGraph(cCallGraphFile))
+    {
+        cerr << "Error opening file " << cCallGraphFile << endl;
+        return 4;
+    }
+    if (pep8Machine.bStatistics)
+    {
+        pep8Machine.PrintStatistics(cerr);
+    }
+    return iWatchdogStatus (cerr, pep8Machine, eStatus);
+}
+
+//**** Reads a manifest with one job per line:  objfile infile outfile [expected]
+//**** Blank lines and lines starting with # are skipped.
+bool bReadManifest (const char* cFileName, vector<sJobType>& jobs)
+{
+    ifstream manifest (cFileName);
+    string sLine;
+    int iLine = 0;
+    if (!manifest.is_open())
+    {
+        cerr << "Could not open manifest " << cFileName << endl;
+        return false;
+    }
+    while (getline (manifest, sLine))
+    {
+        iLine++;
+        istringstream fields (sLine);
+        sJobType job;
+        if (!(fields >> job.sObjFile) || job.sObjFile[0] == '#')
+        {
+            continue;
+        }
+        if (!(fields >> job.sInFile >> job.sOutFile))
+        {
+            cerr << cFileName << ":" << iLine << ": expected objfile infile outfile [expected]" << endl;
+            return false;
+        }
+        fields >> job.sExpectedFile;
+        job.iStatus = 0;
+        jobs.push_back (job);
+    }
+    return true;
+}
+
+//**** Runs one job on machine, which is as InstallRom left it.  CHARO
+//**** output and runtime error messages go to the job's output file.
+void RunJob (Machine& machine, sJobType& job)
+{
+    ofstream output (job.sOutFile.c_str());
+    if (!output.is_open())
+    {
+        job.iStatus = 4;
+        return;
+    }
+    machine.SetMessageStream (output);
+    if (!machine.bSetObjectFile (job.sObjFile.c_str()))
+    {
+        job.iStatus = 4;
+    }
+    else if (machine.Load () != eS_STOPPED)
+    {
+        job.iStatus = 5;
+    }
+    else
+    {
+        if (job.sInFile == "-")
+        {
+            machine.SetInputString ("");
+        }
+        else if (!machine.bSetInputFile (job.sInFile.c_str()))
+        {
+            job.iStatus = 4;
+        }
+        if (!job.sExpectedFile.empty()
+            && !machine.bSetExpectedOutput (job.sExpectedFile.c_str(), lOutputMargin))
+        {
+            job.iStatus = 4;
+        }
+        if (job.iStatus == 0)
+        {
+            machine.SetOutputStream (output);
+            eRunStatus eStatus = machine.Run (lMaxInstr, dTimeLimit);
+            machine.SetScreenOutput ();
+            job.iStatus = iWatchdogStatus (output, machine, eStatus);
+            if (machine.bStatistics)
+            {
+                machine.PrintStatistics (output);
+            }
+        }
+    }
+    machine.Reset ();
+}
+
+//**** Worker thread: takes jobs in manifest order until none are left, on
+//**** one machine whose ROM is copied from the prototype.  Between jobs
+//**** the machine is reset, which restores only the pages a job wrote.
+void JobWorker (const Machine* pPrototype, vector<sJobType>* pJobs, atomic<size_t>* pNext)
+{
+    size_t iJob;
+    Machine* pMachine = new Machine;
+    pMachine->CopyRom (*pPrototype);
+    pMachine->bBlockCache = pPrototype->bBlockCache;
+    pMachine->bTranslate = pPrototype->bTranslate;
+    pMachine->bNativeTraps = pPrototype->bNativeTraps;
+    pMachine->bStatistics = pPrototype->bStatistics;
+    memcpy (pMachine->iCycleCost, pPrototype->iCycleCost, sizeof (pMachine->iCycleCost));
+    while ((iJob = (*pNext)++) < pJobs->size())
+    {
+        RunJob (*pMachine, (*pJobs)[iJob]);
+    }
+    delete pMachine;
+}
+
+int ParallelRun (const char* cManifest, int iThreads)
+{
+    const char* const cStatus[] =
+    {
+        "stopped", "", "", "", "could not open file", "could not load", "runtime error",
+        "stopped by watchdog", "", "output differs"
+    };
+    vector<sJobType> jobs;
+    vector<thread> workers;
+    atomic<size_t> iNext (0);
+    int iWorst = 0;
+    if (!bReadManifest (cManifest, jobs))
+    {
+        return 4;
+    }
+    if (iThreads <= 0)
+    {
+        iThreads = thread::hardware_concurrency();
+        iThreads = (iThreads < 1 ? 1 : iThreads);
+    }
+    if (static_cast <size_t> (iThreads) > jobs.size())
+    {
+        iThreads = jobs.size();
+    }
+    for (int i = 0; i < iThreads; i++)
+    {
+        workers.push_back (thread (JobWorker, &pep8Machine, &jobs, &iNext));
+    }
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        cout << jobs[i].sObjFile << " " << jobs[i].sInFile << " " << jobs[i].sOutFile
+             << ": " << cStatus[jobs[i].iStatus] << endl;
+        iWorst = (jobs[i].iStatus > iWorst ? jobs[i].iStatus : iWorst);
+    }
+    return iWorst;
 }
 
 int main (int argc, char *argv[])
 {
     bool bError;
+    const char* cObjFile = NULL;
+    const char* cInFile = NULL;
+    const char* cOutFile = NULL;
+    const char* cManifest = NULL;
+    const char* cTraceFile = NULL;
+    const char* cCostFile = NULL;
+    int iThreads = 0;
+    int iBadLine;
    
-    if (argc == 2)
+    for (int iArg = 1; iArg < argc; iArg++)
     {
-        if (strcmp(argv[1], "-v") == 0)
+        if (strcmp(argv[iArg], "-v") == 0)
+        {
+            cout << "Pep/8 Simulator, version Unix 8.4, Pepperdine University" << endl;
+        }
+        else if (strcmp(argv[iArg], "-b") == 0)
+        {
+            pep8Machine.bBlockCache = true;
+        }
+        else if (strcmp(argv[iArg], "-x") == 0)
+        {
+            pep8Machine.bBlockCache = true;
+            pep8Machine.bTranslate = true;
+        }
+        else if (strcmp(argv[iArg], "-n") == 0)
+        {
+            pep8Machine.bNativeTraps = true;
+        }
+        else if (strcmp(argv[iArg], "-i") == 0 && iArg + 1 < argc)
+        {
+            cInFile = argv[++iArg];
+        }
+        else if (strcmp(argv[iArg], "-o") == 0 && iArg + 1 < argc)
+        {
+            cOutFile = argv[++iArg];
+        }
+        else if (strcmp(argv[iArg], "-s") == 0)
+        {
+            pep8Machine.bStatistics = true;
+        }
+        else if (strcmp(argv[iArg], "-k") == 0 && iArg + 1 < argc)
+        {
+            cCostFile = argv[++iArg];
+            pep8Machine.bStatistics = true;
+        }
+        else if (strcmp(argv[iArg], "-m") == 0 && iArg + 1 < argc)
+        {
+            lMaxInstr = atol(argv[++iArg]);
+        }
+        else if (strcmp(argv[iArg], "-w") == 0 && iArg + 1 < argc)
+        {
+            dTimeLimit = atof(argv[++iArg]);
+        }
+        else if (strcmp(argv[iArg], "-T") == 0 && iArg + 1 < argc)
+        {
+            cTraceFile = argv[++iArg];
+        }
+        else if (strcmp(argv[iArg], "-d") == 0 && iArg + 1 < argc)
+        {
+            cDumpFile = argv[++iArg];
+        }
+        else if (strcmp(argv[iArg], "-D") == 0 && iArg + 1 < argc)
+        {
+            cImageFile = argv[++iArg];
+        }
+        else if (strcmp(argv[iArg], "-a") == 0 && iArg + 1 < argc
+                 && bParseRange(argv[iArg + 1], DumpStart, DumpEnd))
+        {
+            iArg++;
+        }
+        else if (strcmp(argv[iArg], "-P") == 0 && iArg + 1 < argc)
+        {
+            cProfileFile = argv[++iArg];
+            pep8Machine.bProfile = true;
+        }
+        else if (strcmp(argv[iArg], "-g") == 0 && iArg + 1 < argc)
+        {
+            cCallGraphFile = argv[++iArg];
+            pep8Machine.bCallGraph = true;
+        }
+        else if (strcmp(argv[iArg], "-e") == 0 && iArg + 1 < argc)
+        {
+            cExpectedFile = argv[++iArg];
+        }
+        else if (strcmp(argv[iArg], "-f") == 0 && iArg + 1 < argc && atol(argv[iArg + 1]) >= 0)
+        {
+            lOutputMargin = atol(argv[++iArg]);
+        }
+        else if (strcmp(argv[iArg], "-C") == 0 && iArg + 1 < argc)
+        {
+            cCheckpointFile = argv[++iArg];
+        }
+        else if (strcmp(argv[iArg], "-R") == 0 && iArg + 1 < argc)
+        {
+            cRestoreFile = argv[++iArg];
+        }
+        else if (strcmp(argv[iArg], "-j") == 0 && iArg + 1 < argc)
+        {
+            cManifest = argv[++iArg];
+        }
+        else if (strcmp(argv[iArg], "-t") == 0 && iArg + 1 < argc)
+        {
+            iThreads = atoi(argv[++iArg]);
+        }
+        else if (argv[iArg][0] != '-' && cObjFile == NULL)
         {
-            cout << "Pep/8 Simulator, version Unix 8.3, Pepperdine University" << endl;
+            cObjFile = argv[iArg];
         }
         else
         {
-            cerr << "usage: pep8 [-v]" << endl;
+            cerr << "usage: pep8 [-v] [-b] [-x] [-n] [-s] [-k costfile] [-m count] [-w seconds] [-T tracefile] [-P profile] [-g callgraph] [-e expected] [-f margin] [-d dumpfile] [-D imagefile] [-a range] [-C checkpoint] [-i infile] [-o outfile] [objfile | -R checkpoint]" << endl;
+            cerr << "       pep8 [-b] [-x] [-n] [-s] [-k costfile] [-m count] [-w seconds] [-f margin] [-t threads] -j manifest" << endl;
             return 2;
         }
     }
-    else if (argc > 2)
+    if ((cObjFile == NULL && cRestoreFile == NULL
+         && (cInFile != NULL || cOutFile != NULL || cTraceFile != NULL
+             || cDumpFile != NULL || cImageFile != NULL || cCheckpointFile != NULL
+             || cProfileFile != NULL || cCallGraphFile != NULL || cExpectedFile != NULL))
+        || (cObjFile != NULL && cRestoreFile != NULL)
+        || (lOutputMargin >= 0 && cExpectedFile == NULL && cManifest == NULL)
+        || (cManifest != NULL && (cObjFile != NULL || cRestoreFile != NULL)))
     {
-        cerr << "usage: pep8 [-v]" << endl;
+        cerr << "usage: pep8 [-v] [-b] [-x] [-n] [-s] [-k costfile] [-m count] [-w seconds] [-T tracefile] [-P profile] [-g callgraph] [-e expected] [-f margin] [-d dumpfile] [-D imagefile] [-a range] [-C checkpoint] [-i infile] [-o outfile] [objfile | -R checkpoint]" << endl;
+        cerr << "       pep8 [-b] [-x] [-n] [-s] [-k costfile] [-m count] [-w seconds] [-f margin] [-t threads] -j manifest" << endl;
         return 2;
     }
-    Initialize (bError);
-    if (bError)
+    bBatchMode = (cObjFile != NULL || cRestoreFile != NULL || cManifest != NULL);
+    if (!pep8Machine.bInstallImage())
+    {
+        pep8Machine.Initialize (bError);
+        if (bError)
+        {
+            return 1;
+        }
+        else
+        {
+            pep8Machine.InstallRom (bError);
+        }
+        if (bError)
+        {
+            return 3;
+        }
+        pep8Machine.SaveImage();
+    }
+    if (cCostFile != NULL && !pep8Machine.bReadCycleCosts(cCostFile, iBadLine))
     {
-        return 1;
+        if (iBadLine == 0)
+        {
+            cerr << "Could not open cycle cost file " << cCostFile << endl;
+        }
+        else
+        {
+            cerr << "Invalid cycle cost at line " << iBadLine << " of " << cCostFile << endl;
+        }
+        return 4;
     }
-    else
+    if (cManifest != NULL)
     {
-        InstallRom (bError);
+        return ParallelRun (cManifest, iThreads);
     }
-    if (bError)
+    else if (bBatchMode)
     {
-        return 3;
+        return BatchRun (cObjFile, cInFile, cOutFile, cTraceFile);
     }
     else
     {
+        cout << pep8Machine.iRomStartAddr << " bytes RAM free." << endl;
         MainPrompt();
         return 0;
     }
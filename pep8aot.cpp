@@ -0,0 +1,477 @@
+//  File: pep8aot.cpp
+//  Translator of object programs for the Pep/8 computer as described in
+//  "Computer Systems", Fourth edition, J. Stanley Warford, Jones and
+//  Bartlett, Publishers, 2010.  ISBN 978-0-7637-7144-7
+//  Pepperdine University, Malibu, CA 90265
+//  Stan.Warford@pepperdine.edu
+
+//  Released under the GNU General Public License without warrenty
+//  as described in http://www.gnu.org/copyleft/gpl.html
+
+//  pep8aot [-l listing] objfile [cppfile]
+//
+//  Translates an object program to a C++ source file that runs it as
+//  native code, ahead of time.  Every instruction of the program becomes
+//  a labeled C++ statement on local copies of the registers, and branches
+//  with a known target become gotos.  The instructions are found by
+//  following the control flow from address 0, or from the .pepl listing
+//  given with -l, which also supplies the comments.  Traps, CHARI, CHARO,
+//  STOP and RETTR, and any address the translation does not cover, run in
+//  the runtime of pep8native.h.  The result behaves like a pep8 batch run
+//  of the object file unless the program stores into its own code.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include "pep8sim.h"
+
+using namespace std;
+
+//**** Global Variables
+uint8_t iProgram[MEMORY_SIZE];      // The object program, loaded at address 0
+int iProgramLength;
+bool bCode[MEMORY_SIZE];            // An instruction to translate starts here
+vector<string> sComment (MEMORY_SIZE);  // Its listing line
+
+//**** Four hex digits with the C++ prefix
+string sHex (int iValue)
+{
+    char cHex[8];
+    snprintf (cHex, sizeof (cHex), "0x%04X", iValue & 0xFFFF);
+    return cHex;
+}
+
+//**** Reads the hex bytes of an object file up to zz
+bool bReadObject (const char* cFileName)
+{
+    ifstream object (cFileName);
+    string sToken;
+    if (!object.is_open())
+    {
+        cerr << "Could not open object file " << cFileName << endl;
+        return false;
+    }
+    iProgramLength = 0;
+    while (object >> sToken && sToken != "zz")
+    {
+        if (sToken.size() != 2 || !bIsHexDigit (sToken[0]) || !bIsHexDigit (sToken[1])
+            || iProgramLength == MEMORY_SIZE)
+        {
+            cerr << cFileName << ": invalid object code " << sToken << endl;
+            return false;
+        }
+        iProgram[iProgramLength++] = strtol (sToken.c_str(), NULL, 16);
+    }
+    if (sToken != "zz")
+    {
+        cerr << cFileName << ": object code does not end with zz" << endl;
+        return false;
+    }
+    return true;
+}
+
+//**** Takes the addresses of the instructions from an asem8 listing,
+//**** whose lines of code start with the address and the object code and
+//**** have the mnemonic in column 22
+bool bReadListing (const char* cFileName)
+{
+    ifstream listing (cFileName);
+    string sLine;
+    if (!listing.is_open())
+    {
+        cerr << "Could not open listing " << cFileName << endl;
+        return false;
+    }
+    while (getline (listing, sLine))
+    {
+        if (!sLine.empty() && sLine[sLine.size() - 1] == '\r')
+        {
+            sLine.erase (sLine.size() - 1);
+        }
+        if (sLine.size() < 8 || !bIsHexDigit (sLine[0]) || !bIsHexDigit (sLine[1])
+            || !bIsHexDigit (sLine[2]) || !bIsHexDigit (sLine[3]) || sLine[4] != ' ')
+        {
+            continue;
+        }
+        int iAddr = strtol (sLine.substr (0, 4).c_str(), NULL, 16);
+        string sMnemon;
+        if (sLine.size() > 22)
+        {
+            istringstream (sLine.substr (22)) >> sMnemon;
+        }
+        if (sMnemon.empty() || sMnemon[0] == '.')
+        {
+            continue;                           // Data
+        }
+        string sCode = sLine.substr (6, sLine.find (' ', 6) - 6);
+        for (size_t i = 0; i + 1 < sCode.size(); i += 2)
+        {
+            if (iAddr + static_cast <int> (i / 2) >= iProgramLength
+                || strtol (sCode.substr (i, 2).c_str(), NULL, 16) != iProgram[iAddr + i / 2])
+            {
+                cerr << cFileName << " is not the listing of the object file" << endl;
+                return false;
+            }
+        }
+        bCode[iAddr] = true;
+        while (!sLine.empty() && (sLine[sLine.size() - 1] == ' ' || sLine[sLine.size() - 1] == '\\'))
+        {
+            sLine.erase (sLine.size() - 1);     // No line splice in the comment
+        }
+        sComment[iAddr] = sLine;
+    }
+    return true;
+}
+
+//**** True if the whole instruction at iAddr lies in the object program
+bool bInProgram (int iAddr)
+{
+    return iAddr < iProgramLength
+        && (Machine::Decode (iProgram[iAddr]).bUnary || iAddr + 2 < iProgramLength);
+}
+
+int iOperandSpec (int iAddr)
+{
+    return (iProgram[iAddr + 1] << 8) | iProgram[iAddr + 2];
+}
+
+int iNextAddr (int iAddr)
+{
+    return iAddr + (Machine::Decode (iProgram[iAddr]).bUnary ? 1 : 3);
+}
+
+//**** Follows the control flow from address 0.  Indexed branches and
+//**** returns are left to the dispatch at run time.
+void FindCode ()
+{
+    vector<int> work (1, 0);
+    while (!work.empty())
+    {
+        int iAddr = work.back();
+        work.pop_back();
+        if (!bInProgram (iAddr) || bCode[iAddr])
+        {
+            continue;
+        }
+        bCode[iAddr] = true;
+        const sDecodeType& sD = Machine::Decode (iProgram[iAddr]);
+        MnemonicOpcodes eMn = sD.eMnemon;
+        if (eM_BR <= eMn && eMn <= eM_CALL && sD.eAddrMode == eA_IMMEDIATE)
+        {
+            work.push_back (iOperandSpec (iAddr));
+        }
+        if (!(eMn == eM_STOP || eMn == eM_RETTR || eMn == eM_BR || eMn == eM_RETn))
+        {
+            work.push_back (iNextAddr (iAddr));
+        }
+    }
+}
+
+//**** The address of the operand, as Machine::AddrProcessor computes it
+string sAddress (eAddrModeType eMode, int iSpec)
+{
+    string sSpec = sHex (iSpec);
+    switch (eMode)
+    {
+    case eA_IMMEDIATE:
+    case eA_DIRECT: return sSpec;
+    case eA_INDIRECT: return "NativeRead (Mem, " + sSpec + ")";
+    case eA_STACK_REL: return "sRegisterType (SP + " + sSpec + ")";
+    case eA_STACK_REL_DEF: return "NativeRead (Mem, sRegisterType (SP + " + sSpec + "))";
+    case eA_INDEXED: return "sRegisterType (X + " + sSpec + ")";
+    case eA_STACK_IND: return "sRegisterType (SP + " + sSpec + " + X)";
+    case eA_STACK_IND_DEF: return "sRegisterType (NativeRead (Mem, sRegisterType (SP + " + sSpec + ")) + X)";
+    }
+    return sSpec;
+}
+
+string sWordOperand (eAddrModeType eMode, int iSpec)
+{
+    return eMode == eA_IMMEDIATE ? sHex (iSpec) : "NativeRead (Mem, " + sAddress (eMode, iSpec) + ")";
+}
+
+string sByteOperand (eAddrModeType eMode, int iSpec)
+{
+    return eMode == eA_IMMEDIATE ? sHex (iSpec & 0xFF) : "Mem[" + sAddress (eMode, iSpec) + "]";
+}
+
+//**** Control to iTarget: a goto when it is translated, otherwise the
+//**** runtime executes it
+string sJump (int iTarget)
+{
+    char cLabel[8];
+    if (bCode[iTarget & 0xFFFF])
+    {
+        snprintf (cLabel, sizeof (cLabel), "L%04X", iTarget & 0xFFFF);
+        return string ("goto ") + cLabel + ";";
+    }
+    return "PC = " + sHex (iTarget) + "; goto l_Step;";
+}
+
+//**** The C++ statements of the instruction at iAddr.  bFallsThrough is
+//**** set if control may go on to the next address.
+string sTranslate (int iAddr, bool& bFallsThrough)
+{
+    const sDecodeType& sD = Machine::Decode (iProgram[iAddr]);
+    string sReg = (sD.eRegType == eR_R_IS_ACCUMULATOR) ? "A" : "X";
+    int iSpec = sD.bUnary ? 0 : iOperandSpec (iAddr);
+    string sNext = sHex (iNextAddr (iAddr));
+    string sCondition;
+    string sCount = "lCount++; ";
+    bool bImmediate = sD.eAddrMode == eA_IMMEDIATE;
+    bFallsThrough = true;
+    switch (sD.eMnemon)
+    {
+    case eM_LDr:
+        return sCount + sReg + " = " + sWordOperand (sD.eAddrMode, iSpec) + "; NZ = " + sReg + ";";
+    case eM_LDBYTEr:
+        return sCount + sReg + " = (" + sReg + " & 0xFF00) | " + sByteOperand (sD.eAddrMode, iSpec)
+            + "; NZ = " + sReg + ";";
+    case eM_STr:
+        if (bImmediate)
+        {
+            break;
+        }
+        return sCount + "NativeWrite (Mem, iRom, " + sReg + ", " + sAddress (sD.eAddrMode, iSpec) + ");";
+    case eM_STBYTEr:
+        if (bImmediate)
+        {
+            break;
+        }
+        return sCount + "NativeByteWrite (Mem, iRom, " + sReg + " & 0xFF, "
+            + sAddress (sD.eAddrMode, iSpec) + ");";
+    case eM_ADDr:
+        return sCount + "NativeAdd (" + sReg + ", " + sWordOperand (sD.eAddrMode, iSpec) + ", NZ, V, C);";
+    case eM_SUBr:
+        return sCount + "NativeSub (" + sReg + ", " + sWordOperand (sD.eAddrMode, iSpec) + ", NZ, V, C);";
+    case eM_ANDr:
+        return sCount + sReg + " &= " + sWordOperand (sD.eAddrMode, iSpec) + "; NZ = " + sReg + ";";
+    case eM_ORr:
+        return sCount + sReg + " |= " + sWordOperand (sD.eAddrMode, iSpec) + "; NZ = " + sReg + ";";
+    case eM_CPr:
+        return sCount + "NativeCompare (" + sReg + ", " + sWordOperand (sD.eAddrMode, iSpec) + ", NZ, V, C);";
+    case eM_ADDSP:
+        return sCount + "NativeAdd (SP, " + sWordOperand (sD.eAddrMode, iSpec) + ", NZ, V, C);";
+    case eM_SUBSP:
+        return sCount + "NativeSub (SP, " + sWordOperand (sD.eAddrMode, iSpec) + ", NZ, V, C);";
+    case eM_NOTr:
+        return sCount + sReg + " = ~" + sReg + "; NZ = " + sReg + ";";
+    case eM_NEGr:
+        return sCount + sReg + " = -" + sReg + "; NZ = " + sReg + ";";
+    case eM_ASLr:
+        return sCount + "NativeAdd (" + sReg + ", " + sReg + ", NZ, V, C);";
+    case eM_ASRr:
+        return sCount + "C = (" + sReg + " & 1) != 0; " + sReg + " = (" + sReg + " >> 1) | ("
+            + sReg + " & 0x8000); NZ = " + sReg + ";";
+    case eM_ROLr:
+        return sCount + "bOldC = C; C = (" + sReg + " & 0x8000) != 0; " + sReg + " = (" + sReg
+            + " << 1) | bOldC;";
+    case eM_RORr:
+        return sCount + "bOldC = C; C = (" + sReg + " & 1) != 0; " + sReg + " = (" + sReg
+            + " >> 1) | (bOldC << 15);";
+    case eM_MOVSPA:
+        return sCount + "A = SP;";
+    case eM_MOVFLGA:
+        return sCount + "A = iNativeFlags (NZ, V, C);";
+    case eM_BR:
+        bFallsThrough = false;
+        if (bImmediate)
+        {
+            return sCount + sJump (iSpec);
+        }
+        return sCount + "PC = NativeRead (Mem, " + sAddress (sD.eAddrMode, iSpec) + "); goto l_Dispatch;";
+    case eM_BRLE: sCondition = "bNativeN (NZ) || bNativeZ (NZ)"; break;
+    case eM_BRLT: sCondition = "bNativeN (NZ)"; break;
+    case eM_BREQ: sCondition = "bNativeZ (NZ)"; break;
+    case eM_BRNE: sCondition = "!bNativeZ (NZ)"; break;
+    case eM_BRGE: sCondition = "!bNativeN (NZ)"; break;
+    case eM_BRGT: sCondition = "!bNativeN (NZ) && !bNativeZ (NZ)"; break;
+    case eM_BRV: sCondition = "V"; break;
+    case eM_BRC: sCondition = "C"; break;
+    case eM_CALL:
+        bFallsThrough = false;
+        if (bImmediate)
+        {
+            return sCount + "SP -= 2; NativeWrite (Mem, iRom, " + sNext + ", SP); " + sJump (iSpec);
+        }
+        return sCount + "SP -= 2; NativeWrite (Mem, iRom, " + sNext + ", SP); PC = NativeRead (Mem, "
+            + sAddress (sD.eAddrMode, iSpec) + "); goto l_Dispatch;";
+    case eM_RETn:
+        bFallsThrough = false;
+        return sCount + "SP += " + to_string (sD.iNValue) + "; PC = NativeRead (Mem, SP); SP += 2; goto l_Dispatch;";
+    default:
+        break;
+    }
+    if (!sCondition.empty())
+    {
+        if (bImmediate)
+        {
+            return sCount + "if (" + sCondition + ") { " + sJump (iSpec) + " }";
+        }
+        return sCount + "if (" + sCondition + ") { PC = NativeRead (Mem, " + sAddress (sD.eAddrMode, iSpec)
+            + "); goto l_Dispatch; }";
+    }
+    bFallsThrough = false;                      // STOP, RETTR, CHARI, CHARO, traps
+    return "PC = " + sHex (iAddr) + "; goto l_Step;";
+}
+
+//**** Writes the translation unit: the object text for the loader, the
+//**** translated program and main
+void WriteProgram (ostream& output, const string& sName, const char* cObjFile)
+{
+    char cLine[16];
+    output << "//  File: " << sName << ".cpp" << endl;
+    output << "//  " << cObjFile << " translated to C++ by pep8aot.  Build with" << endl;
+    output << "//      c++ -O2 -pthread -o " << sName << " " << sName
+           << ".cpp pep8native.cpp pep8sim.cpp" << endl << endl;
+    output << "#include \"pep8native.h\"" << endl << endl;
+    output << "static const char cObjectText[] =" << endl;
+    for (int i = 0; i < iProgramLength; i++)
+    {
+        snprintf (cLine, sizeof (cLine), "%02X", iProgram[i]);
+        output << (i % 16 == 0 ? "    \"" : " ") << cLine << (i % 16 == 15 ? "\\n\"\n" : "");
+    }
+    output << (iProgramLength % 16 == 0 ? "    \"" : " ") << "zz\\n\";" << endl << endl;
+
+    output << "static void Program (Machine& machine, sNativeStateType& state, bool& bHalt)" << endl;
+    output << "{" << endl;
+    output << "    uint8_t* Mem = machine.NativeMemory ();" << endl;
+    output << "    const int iRom = machine.iRomStartAddr;" << endl;
+    output << "    sRegisterType A = state.A, X = state.X, SP = state.SP, PC = state.PC;" << endl;
+    output << "    int NZ = state.iNZValue;" << endl;
+    output << "    bool V = state.bV, C = state.bC, bOldC;" << endl;
+    output << "    long lCount = 0;" << endl;
+    output << "    (void) iRom; (void) bOldC;" << endl;
+    output << "l_Dispatch:" << endl;
+    output << "    switch (PC)" << endl;
+    output << "    {" << endl;
+    for (int iAddr = 0; iAddr < iProgramLength; iAddr++)
+    {
+        if (bCode[iAddr])
+        {
+            snprintf (cLine, sizeof (cLine), "L%04X", iAddr);
+            output << "    case " << sHex (iAddr) << ": goto " << cLine << ";" << endl;
+        }
+    }
+    output << "    default: break;" << endl;
+    output << "    }" << endl;
+    output << "l_Step:" << endl;
+    output << "    state.A = A; state.X = X; state.SP = SP; state.PC = PC;" << endl;
+    output << "    state.iNZValue = NZ; state.bV = V; state.bC = C; state.lInstrCount = lCount;" << endl;
+    output << "    machine.NativeStep (state, bHalt);" << endl;
+    output << "    if (bHalt)" << endl;
+    output << "    {" << endl;
+    output << "        return;" << endl;
+    output << "    }" << endl;
+    output << "    A = state.A; X = state.X; SP = state.SP; PC = state.PC;" << endl;
+    output << "    NZ = state.iNZValue; V = state.bV; C = state.bC; lCount = 0;" << endl;
+    output << "    goto l_Dispatch;" << endl;
+    int iFallTo = -1;                           // Address control falls through to
+    for (int iAddr = 0; iAddr < iProgramLength; iAddr++)
+    {
+        if (!bCode[iAddr])
+        {
+            continue;
+        }
+        if (iFallTo >= 0 && iFallTo != iAddr)
+        {
+            output << "    " << sJump (iFallTo) << endl;
+        }
+        bool bFallsThrough;
+        snprintf (cLine, sizeof (cLine), "L%04X", iAddr);
+        output << cLine << ":";
+        if (!sComment[iAddr].empty())
+        {
+            output << "  // " << sComment[iAddr];
+        }
+        output << endl << "    " << sTranslate (iAddr, bFallsThrough) << endl;
+        iFallTo = bFallsThrough ? iNextAddr (iAddr) : -1;
+    }
+    if (iFallTo >= 0)
+    {
+        output << "    " << sJump (iFallTo) << endl;
+    }
+    output << "}" << endl << endl;
+    output << "int main (int argc, char* argv[])" << endl;
+    output << "{" << endl;
+    output << "    return iNativeMain (argc, argv, \"" << sName << "\", cObjectText, Program);" << endl;
+    output << "}" << endl;
+}
+
+int main (int argc, char* argv[])
+{
+    const char* cListing = NULL;
+    const char* cObjFile = NULL;
+    const char* cCppFile = NULL;
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        if (strcmp(argv[iArg], "-l") == 0 && iArg + 1 < argc)
+        {
+            cListing = argv[++iArg];
+        }
+        else if (argv[iArg][0] != '-' && cObjFile == NULL)
+        {
+            cObjFile = argv[iArg];
+        }
+        else if (argv[iArg][0] != '-' && cCppFile == NULL)
+        {
+            cCppFile = argv[iArg];
+        }
+        else
+        {
+            cObjFile = NULL;
+            break;
+        }
+    }
+    if (cObjFile == NULL)
+    {
+        cerr << "usage: pep8aot [-l listing] objfile [cppfile]" << endl;
+        return 2;
+    }
+    if (!bReadObject (cObjFile) || (cListing != NULL && !bReadListing (cListing)))
+    {
+        return 4;
+    }
+    if (cListing == NULL)
+    {
+        FindCode ();
+    }
+    else if (iProgramLength > 0 && bInProgram (0))
+    {
+        bCode[0] = true;
+    }
+
+    //**** The program name is the object file name without directory and .pepo
+    string sName = cObjFile;
+    sName.erase (0, sName.find_last_of ('/') + 1);
+    if (sName.size() > 5 && sName.compare (sName.size() - 5, 5, ".pepo") == 0)
+    {
+        sName.erase (sName.size() - 5);
+    }
+    for (size_t i = 0; i < sName.size(); i++)
+    {
+        if (sName[i] == '"' || sName[i] == '\\')
+        {
+            sName[i] = '_';
+        }
+    }
+    string sCppFile = (cCppFile != NULL) ? string (cCppFile) : sName + ".cpp";
+    ofstream output (sCppFile.c_str());
+    if (!output.is_open())
+    {
+        cerr << "Error opening file " << sCppFile << endl;
+        return 4;
+    }
+    WriteProgram (output, sName, cObjFile);
+    output.close();
+    if (output.fail())
+    {
+        cerr << "Error writing file " << sCppFile << endl;
+        return 4;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+//  File: pep8native.cpp
+//  Runtime of Pep/8 programs translated to C++ by pep8aot, for the
+//  simulator of "Computer Systems", Fourth edition, J. Stanley Warford,
+//  Jones and Bartlett, Publishers, 2010.  ISBN 978-0-7637-7144-7
+//  Pepperdine University, Malibu, CA 90265
+//  Stan.Warford@pepperdine.edu
+
+//  Released under the GNU General Public License without warrenty
+//  as described in http://www.gnu.org/copyleft/gpl.html
+
+//  The main program of a translated program.  It reads trap and
+//  pep8os.pepo from the working directory as pep8 does, loads the object
+//  program it was translated from with the loader of the operating system,
+//  runs it and exits with the status of a pep8 batch run.
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include "pep8native.h"
+
+using namespace std;
+
+//**** Global Variables
+Machine nativeMachine;     // The simulated Pep/8
+
+int iNativeMain (int argc, char* argv[], const char* cProgramName,
+                 const char* cObjectText, NativeProgramType pProgram)
+{
+    bool bError = false;
+    const char* cInFile = NULL;
+    const char* cOutFile = NULL;
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        if (strcmp(argv[iArg], "-n") == 0)
+        {
+            nativeMachine.bNativeTraps = true;
+        }
+        else if (strcmp(argv[iArg], "-i") == 0 && iArg + 1 < argc)
+        {
+            cInFile = argv[++iArg];
+        }
+        else if (strcmp(argv[iArg], "-o") == 0 && iArg + 1 < argc)
+        {
+            cOutFile = argv[++iArg];
+        }
+        else
+        {
+            cerr << "usage: " << cProgramName << " [-n] [-i infile] [-o outfile]" << endl;
+            return 2;
+        }
+    }
+    if (!nativeMachine.bInstallImage())
+    {
+        nativeMachine.Initialize (bError);
+        if (bError)
+        {
+            return 1;
+        }
+        nativeMachine.InstallRom (bError);
+        if (bError)
+        {
+            return 3;
+        }
+        nativeMachine.SaveImage();
+    }
+    nativeMachine.SetInputString (cObjectText);
+    eRunStatus eStatus = nativeMachine.Load();
+    nativeMachine.SetKeyboardInput();
+    if (eStatus != eS_STOPPED)
+    {
+        cerr << "Could not load the object code of " << cProgramName << endl;
+        return 5;
+    }
+    if (cInFile != NULL && !nativeMachine.bSetInputFile(cInFile))
+    {
+        cerr << "Could not open input data file " << cInFile << endl;
+        return 4;
+    }
+    if (cOutFile != NULL && !nativeMachine.bSetOutputFile(cOutFile))
+    {
+        cerr << "Error opening file " << cOutFile << endl;
+        return 4;
+    }
+    eStatus = nativeMachine.RunNative (pProgram);
+    nativeMachine.SetScreenOutput();
+    return iWatchdogStatus (cerr, nativeMachine, eStatus);
+}
@@ -0,0 +1,116 @@
+//  File: pep8native.h
+//  Runtime of Pep/8 programs translated to C++ by pep8aot, for the
+//  simulator of "Computer Systems", Fourth edition, J. Stanley Warford,
+//  Jones and Bartlett, Publishers, 2010.  ISBN 978-0-7637-7144-7
+//  Pepperdine University, Malibu, CA 90265
+//  Stan.Warford@pepperdine.edu
+
+//  Released under the GNU General Public License without warrenty
+//  as described in http://www.gnu.org/copyleft/gpl.html
+
+//  A translated program keeps the registers and status bits in local
+//  variables and works on the memory of a Machine with the inline
+//  functions below, which have the effect of the Machine routines they
+//  are named after.  Instructions it does not translate, CHARI, CHARO and
+//  the traps among them, go to Machine::NativeStep.  A translated program
+//  is built with
+//
+//      c++ -O2 -pthread -o prog prog.cpp pep8native.cpp pep8sim.cpp
+
+#ifndef PEP8NATIVE_H
+#define PEP8NATIVE_H
+
+#include "pep8sim.h"
+
+//**** The main program of a translated program: pep8 in batch mode,
+//**** pep8 [-n] [-i infile] [-o outfile], with the object program
+//**** cObjectText loaded and the run made by pProgram
+int iNativeMain (int argc, char* argv[], const char* cProgramName,
+                 const char* cObjectText, NativeProgramType pProgram);
+
+//**** Reads one word, as Machine::MemRead
+inline sRegisterType NativeRead (const uint8_t* pMemory, sRegisterType Loc)
+{
+    if (Loc != TOP_OF_MEMORY)
+    {
+        return (pMemory[Loc] << 8) | pMemory[Loc + 1];
+    }
+    return pMemory[Loc] << 8;
+}
+
+//**** Writes one word to RAM, as Machine::MemWrite
+inline void NativeWrite (uint8_t* pMemory, int iRomStartAddr, sRegisterType Reg, sRegisterType Loc)
+{
+    if (Loc < iRomStartAddr - 1)
+    {
+        pMemory[Loc] = Reg >> 8;
+        pMemory[Loc + 1] = Reg & 0xFF;
+    }
+    else if (Loc == iRomStartAddr - 1)
+    {
+        pMemory[Loc] = Reg >> 8;
+    }
+}
+
+//**** Writes one byte to RAM, as Machine::MemByteWrite
+inline void NativeByteWrite (uint8_t* pMemory, int iRomStartAddr, int iByte, sRegisterType Loc)
+{
+    if (Loc < iRomStartAddr)
+    {
+        pMemory[Loc] = iByte;
+    }
+}
+
+inline bool bNativeN (int iNZValue)
+{
+    return (iNZValue & 0x18000) != 0;
+}
+
+inline bool bNativeZ (int iNZValue)
+{
+    return (iNZValue & 0xFFFF) == 0;
+}
+
+//**** Reg = Reg + Op with all four status bits, as Adder
+inline void NativeAdd (sRegisterType& Reg, sRegisterType Op, int& iNZValue, bool& bV, bool& bC)
+{
+    int iSum = Reg + Op;
+    sRegisterType Result = static_cast <sRegisterType> (iSum);
+    bC = iSum > 0xFFFF;
+    bV = ((~(Reg ^ Op) & (Reg ^ Result)) & 0x8000) != 0;
+    Reg = Result;
+    iNZValue = Result;
+}
+
+//**** Reg = Reg - Op with all four status bits, as Subtractor
+inline void NativeSub (sRegisterType& Reg, sRegisterType Op, int& iNZValue, bool& bV, bool& bC)
+{
+    sRegisterType Result = static_cast <sRegisterType> (Reg - Op);
+    bC = Reg < Op;
+    bV = (((Reg ^ Op) & (Reg ^ Result)) & 0x8000) != 0;
+    Reg = Result;
+    iNZValue = Result;
+}
+
+//**** The status bits of Reg - Op, as Machine::SimCPr
+inline void NativeCompare (sRegisterType Reg, sRegisterType Op, int& iNZValue, bool& bV, bool& bC)
+{
+    sRegisterType Result = Reg;
+    NativeSub (Result, Op, iNZValue, bV, bC);
+    if (!(Reg & 0x8000) && (Op & 0x8000))
+    {
+        iNZValue = 1;
+    }
+    else if ((Reg & 0x8000) && !(Op & 0x8000))
+    {
+        iNZValue = 0x8000;
+    }
+}
+
+//**** The status bits as the four bits NZVC, as Machine::iStatusBits
+inline int iNativeFlags (int iNZValue, bool bV, bool bC)
+{
+    return (bNativeN (iNZValue) * 8) + (bNativeZ (iNZValue) * 4) + (bV * 2) + bC;
+}
+
+#endif
@@ -0,0 +1,186 @@
+//  File: pep8run.cpp
+//  Assembles and runs a program for the Pep/8 computer as described in
+//  "Computer Systems", Fourth edition, J. Stanley Warford, Jones and
+//  Bartlett, Publishers, 2010.  ISBN 978-0-7637-7144-7
+//  Pepperdine University, Malibu, CA 90265
+//  Stan.Warford@pepperdine.edu
+
+//  Released under the GNU General Public License without warrenty
+//  as described in http://www.gnu.org/copyleft/gpl.html
+
+//  asem8 followed by a pep8 batch run in one process.  The source file is
+//  assembled in memory and its object code is loaded straight into the
+//  simulator, so no .pepo or .pepl file is written unless -p or -l asks
+//  for it.  The exit status is that of pep8 in batch mode, or 8, which
+//  pep8 does not use, if the program has assembly errors.
+
+#include <iostream>
+#include <fstream>
+#include <stdlib.h>
+#include <string>
+#include <cstring>
+#include "asem8.h"
+#include "pep8sim.h"
+
+using namespace std;
+
+//**** Global Variables
+Machine pep8Machine;       // The simulated Pep/8
+
+//**** Writes sText to the file named sFileName.  Returns false if the file
+//**** cannot be written.
+bool bWriteFile (const string& sFileName, const string& sText)
+{
+    ofstream file (sFileName.c_str());
+    file.write (sText.data(), sText.size());
+    return file.good();
+}
+
+void Usage ()
+{
+    cerr << "usage: pep8run [-b] [-x] [-n] [-s] [-l] [-p] [-m count] [-w seconds] [-i infile] [-o outfile] sourcefile" << endl;
+}
+
+int main (int argc, char *argv[])
+{
+    bool bError = false;
+    bool bListing = false;
+    bool bObjectFile = false;
+    const char* cSourceFile = NULL;
+    const char* cInFile = NULL;
+    const char* cOutFile = NULL;
+    long lMaxInstr = 0;
+    double dTimeLimit = 0;
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        if (strcmp(argv[iArg], "-b") == 0)
+        {
+            pep8Machine.bBlockCache = true;
+        }
+        else if (strcmp(argv[iArg], "-x") == 0)
+        {
+            pep8Machine.bBlockCache = true;
+            pep8Machine.bTranslate = true;
+        }
+        else if (strcmp(argv[iArg], "-n") == 0)
+        {
+            pep8Machine.bNativeTraps = true;
+        }
+        else if (strcmp(argv[iArg], "-s") == 0)
+        {
+            pep8Machine.bStatistics = true;
+        }
+        else if (strcmp(argv[iArg], "-l") == 0)
+        {
+            bListing = true;
+        }
+        else if (strcmp(argv[iArg], "-p") == 0)
+        {
+            bObjectFile = true;
+        }
+        else if (strcmp(argv[iArg], "-m") == 0 && iArg + 1 < argc)
+        {
+            lMaxInstr = atol(argv[++iArg]);
+        }
+        else if (strcmp(argv[iArg], "-w") == 0 && iArg + 1 < argc)
+        {
+            dTimeLimit = atof(argv[++iArg]);
+        }
+        else if (strcmp(argv[iArg], "-i") == 0 && iArg + 1 < argc)
+        {
+            cInFile = argv[++iArg];
+        }
+        else if (strcmp(argv[iArg], "-o") == 0 && iArg + 1 < argc)
+        {
+            cOutFile = argv[++iArg];
+        }
+        else if (argv[iArg][0] != '-' && cSourceFile == NULL)
+        {
+            cSourceFile = argv[iArg];
+        }
+        else
+        {
+            Usage ();
+            return 2;
+        }
+    }
+    int iLength = (cSourceFile == NULL) ? 0 : strlen(cSourceFile);
+    if (iLength < 4 || strcmp(cSourceFile + iLength - 4, ".pep") != 0)
+    {
+        Usage ();
+        return 2;
+    }
+    if (!bInitAssembler())
+    {
+        return 1;
+    }
+    if (!pep8Machine.bInstallImage())
+    {
+        pep8Machine.Initialize (bError);
+        if (bError)
+        {
+            return 1;
+        }
+        pep8Machine.InstallRom (bError);
+        if (bError)
+        {
+            return 3;
+        }
+        pep8Machine.SaveImage();
+    }
+
+    //**** Assemble
+    ifstream source (cSourceFile);
+    if (!source.is_open())
+    {
+        cerr << "Could not open source file " << cSourceFile << endl;
+        return 4;
+    }
+    string sListing, sObject;
+    int iLoadAddr;
+    bool bGenerated = bAssembleSource (source, bListing, sListing, sObject, iLoadAddr);
+    source.close();
+    cerr << sAssemblerErrors();
+    string sBaseName (cSourceFile, iLength - 4);
+    if (bGenerated && bListing && !bWriteFile (sBaseName + ".pepl", sListing))
+    {
+        cerr << "Error opening file " << sBaseName << ".pepl" << endl;
+        return 4;
+    }
+    if (!bGenerated)
+    {
+        return 8;
+    }
+    if (bObjectFile && !bWriteFile (sBaseName + ".pepo", sObject))
+    {
+        cerr << "Error opening file " << sBaseName << ".pepo" << endl;
+        return 4;
+    }
+
+    //**** Load and run
+    pep8Machine.SetInputString (sObject);
+    eRunStatus eStatus = pep8Machine.Load();
+    pep8Machine.SetKeyboardInput();
+    if (eStatus != eS_STOPPED)
+    {
+        cerr << "Could not load the object code of " << cSourceFile << endl;
+        return 5;
+    }
+    if (cInFile != NULL && !pep8Machine.bSetInputFile(cInFile))
+    {
+        cerr << "Could not open input data file " << cInFile << endl;
+        return 4;
+    }
+    if (cOutFile != NULL && !pep8Machine.bSetOutputFile(cOutFile))
+    {
+        cerr << "Error opening file " << cOutFile << endl;
+        return 4;
+    }
+    eStatus = pep8Machine.Run(lMaxInstr, dTimeLimit);
+    pep8Machine.SetScreenOutput();
+    if (pep8Machine.bStatistics)
+    {
+        pep8Machine.PrintStatistics(cerr);
+    }
+    return iWatchdogStatus (cerr, pep8Machine, eStatus);
+}
@@ -0,0 +1,4671 @@
+//  File: pep8sim.cpp
+//  Pep/8 machine for the simulator of "Computer Systems", Fourth edition,
+//  J. Stanley Warford, Jones and Bartlett, Publishers, 2010.
+//  Pepperdine University, Malibu, CA 90265
+//  Stan.Warford@pepperdine.edu
+
+//  Released under the GNU General Public License without warrenty
+//  as described in http://www.gnu.org/copyleft/gpl.html
+
+//  The fetch/execute cycle, the instruction and trap implementations, the
+//  block cache and the tracer.  All machine state is in class Machine;
+//  the tables here are shared by every machine and never change after
+//  InitDecodeTable().
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <iomanip>
+#include <ctype.h>
+#include <string>
+#include <cstring>
+#include <climits>
+#include <stdio.h>
+#include <stdint.h>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "pep8sim.h"
+
+using namespace std;
+
+//**** Shared tables
+const char cHexTable[] = "0123456789ABCDEF";
+sDecodeType sDecodeTable[INSTR_SPECIFIERS];
+const char* const cModeName[8] = { "i", "d", "n", "s", "sf", "x", "sx", "sxf" };
+const char* const cStandardTrapMnemon[TRAPS] =
+{
+    "NOP0    ", "NOP1    ", "NOP2    ", "NOP3    ",
+    "NOP     ", "DECI    ", "DECO    ", "STRO    "
+};
+
+//**** Stores the next line of assembly language code to be translated in global cLine[].
+//**** A line that ends in <CR><LF> ends in <LF> alone.
+void Machine::vGetLine(istream& input)
+{
+    input.getline(cLine, LINE_LENGTH);
+    if ((!input.eof ()) && (input.gcount() > 0))
+    {
+        cLine[input.gcount() - 1] = '\n';
+        if (input.gcount() > 1 && cLine[input.gcount() - 2] == '\r')
+        {
+            cLine[input.gcount() - 2] = '\n';
+        }
+    }
+    else
+    {
+        cLine[input.gcount()] = '\n';
+    }
+    pLine = cLine;
+    iLineIndex = 0;
+    bBufferIsEmpty = false;
+}
+
+//**** Makes the next line of the file or string bound to CHARI the current
+//**** line, in place.  As with vGetLine, only a line ending in <LF> counts;
+//**** returns false at end of file.
+bool Machine::bChariLine ()
+{
+    size_t iEnd = sChariText.find ('\n', iChariPos);
+    if (iEnd == string::npos)
+    {
+        iChariPos = sChariText.size();
+        return false;
+    }
+    pLine = sChariText.data() + iChariPos;
+    iChariPos = iEnd + 1;
+    iLineIndex = 0;
+    bBufferIsEmpty = false;
+    return true;
+}
+
+//**** Gets the next character to be processed
+void Machine::vAdvanceInput (char& ch)
+{
+    ch = pLine[iLineIndex++];
+    bBufferIsEmpty = (ch == '\n');
+}
+
+//**** Backs up the input
+void Machine::vBackUpInput ()
+{
+    iLineIndex--;
+}
+
+bool bIsHexDigit (char cChar)
+{
+    return (((cChar >= 'A') && (cChar <= 'F')) ||
+            ((cChar >= 'a') && (cChar <= 'f')) || isdigit(cChar));
+}
+
+//**** iInstr_Spec procedures ****
+//**** Adds 2 byte pairs and returns in result.  (One word adder)
+void Adder (sRegisterType Op1, sRegisterType Op2, sRegisterType& Result,
+            bool& Carry, bool& Ovflw)
+{
+    int iSum = Op1 + Op2;
+    Result = static_cast <sRegisterType> (iSum);
+    Carry = iSum > 0xFFFF;
+    Ovflw = ((~(Op1 ^ Op2) & (Op1 ^ Result)) & 0x8000) != 0; // Operands agree, result differs
+}
+
+//**** Adds 2 byte pairs and returns in result.  (One word adder)
+//**** Same as Adder except carry and overflow are not detected.
+void FastAdder (sRegisterType Op1, sRegisterType Op2, sRegisterType& Result)
+{
+    Result = static_cast <sRegisterType> (Op1 + Op2);
+}
+
+//**** Subtracts Op2 from Op1 and returns in result.  (One word)
+void Subtractor (sRegisterType Op1, sRegisterType Op2, sRegisterType& Result,
+                 bool& Carry, bool& Ovflw)
+{
+    Result = static_cast <sRegisterType> (Op1 - Op2);
+    Carry = Op1 < Op2;                                      // Borrow from high order
+    Ovflw = (((Op1 ^ Op2) & (Op1 ^ Result)) & 0x8000) != 0; // Pos/Neg/Neg or Neg/Pos/Pos
+}
+
+//**** Process the Instruction Specifier (8 bits)
+int GetAddressingModeOneBit (int iInstr_Spec) 
+{
+    return iInstr_Spec % 2 == 0 ? 0 : 5;
+}
+
+int GetAddressingModeThreeBits (int iInstr_Spec) 
+{
+    return (iInstr_Spec % 8);
+}
+
+int GetRegisterTypeLastBit (int iInstr_Spec) 
+{
+    return (iInstr_Spec % 2);
+}
+
+int GetRegisterTypeFourthBit (int iInstr_Spec) 
+{
+    return ((iInstr_Spec / 8) % 2);
+}
+
+int GetNValueThreeBits (int iInstr_Spec) 
+{
+    return (iInstr_Spec % 8);
+}
+
+MnemonicOpcodes instr_SpecToMnemon(int iInstr_Spec) 
+{
+    if (iInstr_Spec == 0) { return eM_STOP; }
+    else if (iInstr_Spec == 1) { return eM_RETTR; }
+    else if (iInstr_Spec == 2) { return eM_MOVSPA; }
+    else if (iInstr_Spec == 3) { return eM_MOVFLGA; }
+    else if (iInstr_Spec <= 5) { return eM_BR; }
+    else if (iInstr_Spec <= 7) { return eM_BRLE; }
+    else if (iInstr_Spec <= 9) { return eM_BRLT; }
+    else if (iInstr_Spec <= 11) { return eM_BREQ; }
+    else if (iInstr_Spec <= 13) { return eM_BRNE; }
+    else if (iInstr_Spec <= 15) { return eM_BRGE; }
+    else if (iInstr_Spec <= 17) { return eM_BRGT; }
+    else if (iInstr_Spec <= 19) { return eM_BRV; }
+    else if (iInstr_Spec <= 21) { return eM_BRC; }
+    else if (iInstr_Spec <= 23) { return eM_CALL; }
+    else if (iInstr_Spec <= 25) { return eM_NOTr; }
+    else if (iInstr_Spec <= 27) { return eM_NEGr; }
+    else if (iInstr_Spec <= 29) { return eM_ASLr; }
+    else if (iInstr_Spec <= 31) { return eM_ASRr; }
+    else if (iInstr_Spec <= 33) { return eM_ROLr; }
+    else if (iInstr_Spec <= 35) { return eM_RORr; } 
+    else if (iInstr_Spec == 36) { return eM_UNIMP0; }
+    else if (iInstr_Spec == 37) { return eM_UNIMP1; }
+    else if (iInstr_Spec == 38) { return eM_UNIMP2; }
+    else if (iInstr_Spec == 39) { return eM_UNIMP3; }
+    else if (iInstr_Spec <= 47) { return eM_UNIMP4; }
+    else if (iInstr_Spec <= 55) { return eM_UNIMP5; }
+    else if (iInstr_Spec <= 63) { return eM_UNIMP6; }
+    else if (iInstr_Spec <= 71) { return eM_UNIMP7; }    
+    else if (iInstr_Spec <= 79) { return eM_CHARI; }
+    else if (iInstr_Spec <= 87) { return eM_CHARO; }
+    else if (iInstr_Spec <= 95) { return eM_RETn; }
+    else if (iInstr_Spec <= 103) { return eM_ADDSP; }
+    else if (iInstr_Spec <= 111) { return eM_SUBSP; }
+    else if (iInstr_Spec <= 127) { return eM_ADDr; }
+    else if (iInstr_Spec <= 143) { return eM_SUBr; }
+    else if (iInstr_Spec <= 159) { return eM_ANDr; }
+    else if (iInstr_Spec <= 175) { return eM_ORr; }
+    else if (iInstr_Spec <= 191) { return eM_CPr; }
+    else if (iInstr_Spec <= 207) { return eM_LDr; }
+    else if (iInstr_Spec <= 223) { return eM_LDBYTEr; }
+    else if (iInstr_Spec <= 239) { return eM_STr; }
+    else { return eM_STBYTEr; }
+}
+
+eAddrModeType ProcessAddressingMode (int AddrMode) 
+{
+    switch (AddrMode) 
+    {
+    case 0: return eA_IMMEDIATE; break;
+    case 1: return eA_DIRECT; break;
+    case 2: return eA_INDIRECT; break;
+    case 3: return eA_STACK_REL; break;
+    case 4: return eA_STACK_REL_DEF; break;
+    case 5: return eA_INDEXED; break;
+    case 6: return eA_STACK_IND; break;
+    case 7: return eA_STACK_IND_DEF; break;
+    default: return eA_IMMEDIATE;
+    }
+}
+
+eRegSpecType ProcessRegisterType (int RegType) 
+{
+    switch (RegType) 
+    {
+    case 0: return eR_R_IS_ACCUMULATOR; break;
+    case 1: return eR_R_IS_INDEX_REG; break;
+    default: return eR_R_IS_ACCUMULATOR; break; // Should not occur
+    }
+}
+
+void Machine::PrntMnemon (ostream& output)
+{
+    PrntMnemon (output, sIR_InstrRegister.iInstr_Spec);
+}
+
+void Machine::PrntMnemon (ostream& output, int iInstr_Spec)
+{
+    switch (sDecodeTable[iInstr_Spec].eMnemon)
+    {
+    case eM_STOP: output << "STOP     "; break;
+    case eM_RETTR: output << "RETTR    "; break;
+    case eM_MOVSPA: output << "MOVESPA  "; break;
+    case eM_MOVFLGA: output << "MOVFLGA  "; break;
+
+    case eM_BR: output << "BR       "; break;
+    case eM_BRLE: output << "BRLE     "; break;
+    case eM_BRLT: output << "BRLT     "; break;
+    case eM_BREQ: output << "BREQ     "; break;
+    case eM_BRNE: output << "BRNE     "; break;
+    case eM_BRGE: output << "BRGE     "; break;
+    case eM_BRGT: output << "BRGT     "; break;
+    case eM_BRV: output << "BRV      "; break;
+    case eM_BRC: output << "BRC      "; break;
+    case eM_CALL: output << "CALL     "; break;
+
+    case eM_NOTr: output << "NOT"; break; 
+    case eM_NEGr: output << "NEG"; break;   
+    case eM_ASLr: output << "ASL"; break;    
+    case eM_ASRr: output << "ASR"; break;    
+    case eM_ROLr: output << "ROL"; break;    
+    case eM_RORr: output << "ROR"; break;   
+
+    case eM_UNIMP0: output << TrapMnemon[0]; break;  // NOP0
+    case eM_UNIMP1: output << TrapMnemon[1]; break;  // NOP1
+    case eM_UNIMP2: output << TrapMnemon[2]; break;  // NOP2
+    case eM_UNIMP3: output << TrapMnemon[3]; break;  // NOP3
+    case eM_UNIMP4: output << TrapMnemon[4]; break;  // NOP
+    case eM_UNIMP5: output << TrapMnemon[5]; break;  // DECI 
+    case eM_UNIMP6: output << TrapMnemon[6]; break;  // DECO 
+    case eM_UNIMP7: output << TrapMnemon[7]; break;  // STRO 
+
+    case eM_CHARI: output << "CHARI    "; break;
+    case eM_CHARO: output << "CHARO    "; break;
+
+    case eM_RETn: output << "RET"; break; 
+           
+    case eM_ADDSP: output << "ADDSP    "; break;
+    case eM_SUBSP: output << "SUBSP    "; break;
+                 
+    case eM_ADDr: output << "ADD"; break;
+    case eM_SUBr: output << "SUB"; break;
+    case eM_ANDr: output << "AND"; break;
+    case eM_ORr: output << "OR"; break;
+    case eM_CPr: output << "CP"; break;
+
+    case eM_LDr: output << "LD"; break; 
+    case eM_LDBYTEr: output << "LDBYTE"; break; 
+    case eM_STr: output << "ST"; break;  
+    case eM_STBYTEr: output << "STBYTE"; break;  
+    }
+      
+    MnemonicOpcodes tempMn = sDecodeTable[iInstr_Spec].eMnemon;
+    if ((eM_NOTr <= tempMn && tempMn <= eM_RORr) || eM_ADDr <= tempMn)
+    {
+        switch (sDecodeTable[iInstr_Spec].eRegType)
+        {
+        case eR_R_IS_ACCUMULATOR: output << "A"; break;
+        case eR_R_IS_INDEX_REG: output << "X"; break;
+        }
+      
+        //Column alignment adjustment
+        if (tempMn <= eM_ANDr) {
+            output << "     ";
+        }
+        else if (tempMn == eM_ORr || tempMn == eM_CPr || tempMn == eM_LDr || tempMn == eM_STr) {
+            output << "      ";
+        }
+        else {
+            output << "  ";
+        }
+    }
+    else if (tempMn == eM_RETn) 
+    {
+        output << sDecodeTable[iInstr_Spec].iNValue << "     ";
+    }
+    else if (eM_UNIMP0 <= tempMn && tempMn <= eM_UNIMP7)
+    {
+        output << " ";
+    }
+}
+
+//**** The mnemonic of a specifier as the statistics report names it
+string Machine::sMnemonName (int iInstr_Spec)
+{
+    ostringstream name;
+    PrntMnemon (name, iInstr_Spec);
+    string sName = name.str();
+    sName.erase (sName.find_last_not_of (' ') + 1);
+    return sName;
+}
+
+//**** Tests the bit of Loc in the bitmap of eType
+inline bool Machine::bBreakBit (eBreakType eType, sRegisterType Loc) const
+{
+    return (iBreakMap[eType][Loc >> 3] >> (Loc & 7)) & 1;
+}
+
+//**** Notes the first watched byte that the current instruction touches
+inline void Machine::CheckWatch (eBreakType eType, sRegisterType Loc)
+{
+    if (!bWatchHit && bBreakBit (eType, Loc))
+    {
+        bWatchHit = true;
+        eWatchType = eType;
+        WatchAddr = Loc;
+    }
+}
+
+//**** Reads one word:  Rslt = Mem [Loc] * 256 + Mem [Loc + 1]
+inline void Machine::MemRead (sRegisterType Loc, sRegisterType& Rslt)
+{
+    if (bWatchpoints)
+    {
+        CheckWatch (eB_READ, Loc);
+        if (Loc != TOP_OF_MEMORY)
+        {
+            CheckWatch (eB_READ, Loc + 1);
+        }
+    }
+    if (Loc != TOP_OF_MEMORY)
+    {
+        Rslt = (iMemory[Loc] << 8) | iMemory[Loc + 1];
+    }
+    else                                  // No wraparound past the top of memory
+    {
+        Rslt = iMemory[Loc] << 8;
+    }
+}
+
+//**** Reads one byte from Mem [Loc] and returns in Byte
+inline void Machine::MemByteRead (sRegisterType Loc, int& iByte)
+{
+    if (bWatchpoints)
+    {
+        CheckWatch (eB_READ, Loc);
+    }
+    iByte = iMemory[Loc];
+}
+
+//**** Writes one word:  high byte of Reg to Mem [Loc] and low byte to Mem[Loc + 1]
+inline void Machine::MemWrite (sRegisterType Reg, sRegisterType Loc)
+{
+    if (bWatchpoints)
+    {
+        CheckWatch (eB_WRITE, Loc);
+        if (Loc != TOP_OF_MEMORY)
+        {
+            CheckWatch (eB_WRITE, Loc + 1);
+        }
+    }
+    if (Loc < iRomStartAddr - 1)          // Both bytes are in RAM
+    {
+        iMemory[Loc] = Reg >> 8;
+        iMemory[Loc + 1] = Reg & 0xFF;
+        iDirtyPage[Loc / PAGE_SIZE] = 1;
+        iDirtyPage[(Loc + 1) / PAGE_SIZE] = 1;
+        if (iCodeMap[Loc] || iCodeMap[Loc + 1])
+        {
+            InvalidateBlocks (Loc);
+            InvalidateBlocks (Loc + 1);
+        }
+    }
+    else if (Loc == iRomStartAddr - 1)    // Low byte would land in ROM
+    {
+        iMemory[Loc] = Reg >> 8;
+        iDirtyPage[Loc / PAGE_SIZE] = 1;
+        if (iCodeMap[Loc])
+        {
+            InvalidateBlocks (Loc);
+        }
+    }
+}
+
+//**** Writes one byte to Mem [Loc]
+inline void Machine::MemByteWrite (int iByte, sRegisterType Loc)
+{
+    if (bWatchpoints)
+    {
+        CheckWatch (eB_WRITE, Loc);
+    }
+    if (Loc < iRomStartAddr)
+    {
+        iMemory[Loc] = iByte;
+        iDirtyPage[Loc / PAGE_SIZE] = 1;
+        if (iCodeMap[Loc])
+        {
+            InvalidateBlocks (Loc);
+        }
+    }
+}
+
+//**** Determine operand based on addressing mode in instr. register
+//**** Sets Oprnd to the operand when the addressing mode is immediate,
+//**** but to the address of the operand for the other seven modes
+void Machine::AddrProcessor (sRegisterType& Operand)
+{
+    sRegisterType temp;
+    switch (eA_AddrMode)
+    {
+    case eA_IMMEDIATE:
+        Operand = sIR_InstrRegister.sR_OprndSpec;
+        break;
+    case eA_DIRECT:
+        Operand = sIR_InstrRegister.sR_OprndSpec;
+        break;
+    case eA_INDIRECT:
+        MemRead (sIR_InstrRegister.sR_OprndSpec, Operand);
+        break;
+    case eA_STACK_REL:
+        Operand = sR_StackPointer + sIR_InstrRegister.sR_OprndSpec;
+        break;
+    case eA_STACK_REL_DEF:
+        MemRead (sR_StackPointer + sIR_InstrRegister.sR_OprndSpec, Operand);
+        break;
+    case eA_INDEXED:
+        Operand = sR_IndexRegister + sIR_InstrRegister.sR_OprndSpec;
+        break;
+    case eA_STACK_IND: 
+        Operand = sR_StackPointer + sIR_InstrRegister.sR_OprndSpec + sR_IndexRegister;
+        break;
+    case eA_STACK_IND_DEF: 
+        MemRead (sR_StackPointer + sIR_InstrRegister.sR_OprndSpec, temp);
+        Operand = temp + sR_IndexRegister;
+        break;
+    }
+}
+
+void Machine::LoadReg (sRegisterType& Reg)
+{
+    sRegisterType Operand;
+    AddrProcessor (Operand);
+    if (eA_AddrMode == eA_IMMEDIATE)
+    {
+        Reg = Operand;
+    }
+    else
+    {
+        MemRead (Operand, Reg);
+    }
+}
+
+void Machine::SetNZBits (sRegisterType Reg)
+{
+    iNZValue = Reg;
+}
+
+inline bool Machine::bStatusN () const
+{
+    return (iNZValue & 0x18000) != 0;
+}
+
+inline bool Machine::bStatusZ () const
+{
+    return (iNZValue & 0xFFFF) == 0;
+}
+
+//**** Computes V and C from the operands of the last addition or subtraction
+inline void Machine::SettleVC ()
+{
+    sRegisterType Result;
+    if (eVCSource == eV_ADD)
+    {
+        Adder (VCOp1, VCOp2, Result, bStatusC, bStatusV);
+    }
+    else if (eVCSource == eV_SUB)
+    {
+        Subtractor (VCOp1, VCOp2, Result, bStatusC, bStatusV);
+    }
+    eVCSource = eV_SETTLED;
+}
+
+//**** Reg = Reg + Op, setting NZ and leaving V and C to SettleVC
+inline void Machine::AddLazy (sRegisterType& Reg, sRegisterType Op)
+{
+    eVCSource = eV_ADD;
+    VCOp1 = Reg;
+    VCOp2 = Op;
+    Reg = static_cast <sRegisterType> (Reg + Op);
+    iNZValue = Reg;
+}
+
+//**** Reg = Reg - Op, setting NZ and leaving V and C to SettleVC
+inline void Machine::SubLazy (sRegisterType& Reg, sRegisterType Op)
+{
+    eVCSource = eV_SUB;
+    VCOp1 = Reg;
+    VCOp2 = Op;
+    Reg = static_cast <sRegisterType> (Reg - Op);
+    iNZValue = Reg;
+}
+
+//**** The status bits of Reg - Op as CPr sets them.  N is the sign of the
+//**** true difference when the subtraction overflows.
+inline void Machine::CompareLazy (sRegisterType Reg, sRegisterType Op)
+{
+    sRegisterType Result = Reg;
+    SubLazy (Result, Op);
+    if (!(Reg & 0x8000) && (Op & 0x8000)) //Pos minus Neg
+    {
+        iNZValue = 1;                     // N = 0, Z = 0
+    }
+    else if ((Reg & 0x8000) && !(Op & 0x8000)) //Neg minus Pos
+    {
+        iNZValue = 0x8000;                // N = 1, Z = 0
+    }
+}
+
+//**** The status bits as the four bits NZVC
+int Machine::iStatusBits ()
+{
+    SettleVC ();
+    return (bStatusN () * 8) + (bStatusZ () * 4) + (bStatusV * 2) + bStatusC;
+}
+
+void Machine::SetStatusBits (int iFlags)
+{
+    iNZValue = ((iFlags & 8) ? 0x10000 : 0) | ((iFlags & 4) ? 0 : 1);
+    bStatusV = (iFlags & 2) != 0;
+    bStatusC = (iFlags & 1) != 0;
+    eVCSource = eV_SETTLED;
+}
+
+//**** Writes the pending CHARO output to the screen, file or string
+void Machine::vFlushCharo ()
+{
+    if (iCharoCount > 0)
+    {
+        pCharoOutput->write (cCharoBuffer, iCharoCount);
+        pCharoOutput->flush ();
+        iCharoCount = 0;
+    }
+}
+
+//**** Prints program counter value of instruction that caused machine
+//**** error.  Message is 20 characters long.
+void Machine::PrntRunLoc()
+{
+    sRegisterType LastLoc;
+    vFlushCharo ();
+    if (sDecodeTable[sIR_InstrRegister.iInstr_Spec].bUnary)
+    {  // undo increment step
+        LastLoc = sR_ProgramCounter - 1;
+    }
+    else
+    {
+        LastLoc = sR_ProgramCounter - 3;
+    }
+    *pMessage << "Runtime error at " << cHexTable[LastLoc >> 12] <<
+        cHexTable[(LastLoc >> 8) & 15] << cHexTable[(LastLoc >> 4) & 15] <<
+        cHexTable[LastLoc & 15] << ":  ";
+}
+
+void Machine::IllegalAddr (bool& bError)
+{
+    bError = true;
+    PrntRunLoc();
+    *pMessage << "Illegal addressing mode ";
+    switch (eA_AddrMode)
+    {
+    case eA_IMMEDIATE: 
+        *pMessage << "immediate "; 
+        break;
+    case eA_DIRECT: 
+        *pMessage << "direct "; 
+        break;
+    case eA_INDIRECT: 
+        *pMessage << "indirect "; 
+        break;
+    case eA_STACK_REL: 
+        *pMessage << "stack relative "; 
+        break;
+    case eA_STACK_REL_DEF: 
+        *pMessage << "stack relative deferred "; 
+        break;
+    case eA_INDEXED: 
+        *pMessage << "indexed ";
+        break;
+    case eA_STACK_IND: 
+        *pMessage << "stack indexed "; 
+        break;
+    case eA_STACK_IND_DEF: 
+        *pMessage << "stack indexed deferred "; 
+        break;
+    }
+    *pMessage << "with ";
+    PrntMnemon (*pMessage);
+    *pMessage << endl;
+}
+
+void Machine::SimSTOP (bool& Halt)
+{
+    Halt = true;
+    bStopped = true;
+    vFlushCharo ();
+}
+
+void Machine::Pop (sRegisterType& Reg, int iSize)
+{
+    MemRead (sR_StackPointer, Reg);   
+    sR_StackPointer += iSize;
+}
+
+void Machine::SimRETTR (bool& bHalt)
+{
+    int Flags;
+    MemByteRead (sR_StackPointer, Flags);   
+    sR_StackPointer++;
+    SetStatusBits (Flags);
+
+    Pop (sR_Accumulator, 2);
+    Pop (sR_IndexRegister, 2);
+    Pop (sR_ProgramCounter, 2);
+    Pop (sR_StackPointer, 0);
+}
+
+void Machine::SimMOVSPA (bool& Halt)
+{
+    sR_Accumulator = sR_StackPointer;
+}
+
+void Machine::SimMOVFLGA(bool& Halt)
+{
+    sR_Accumulator = iStatusBits ();
+}
+
+void Machine::SimBR (bool& bHalt)
+{
+    LoadReg (sR_ProgramCounter);
+}
+
+void Machine::SimBRLE (bool& bHalt)
+{
+    if (bStatusN () || bStatusZ ())
+    {
+        LoadReg (sR_ProgramCounter);
+    }
+}
+
+void Machine::SimBRLT (bool& bHalt)
+{
+    if (bStatusN ())
+    {
+        LoadReg (sR_ProgramCounter);
+    }
+}
+
+void Machine::SimBREQ (bool& bHalt)
+{
+    if (bStatusZ ())
+    {
+        LoadReg (sR_ProgramCounter);
+    }
+}
+
+void Machine::SimBRNE (bool& bHalt)
+{
+    if (!bStatusZ ())
+    {  
+        LoadReg (sR_ProgramCounter);
+    }
+}
+
+void Machine::SimBRGE (bool& bHalt)
+{
+    if (!bStatusN ())
+    {  
+        LoadReg (sR_ProgramCounter);
+    }
+}
+
+void Machine::SimBRGT (bool& bHalt)
+{
+    if (!bStatusN () && !bStatusZ ())
+    { 
+        LoadReg (sR_ProgramCounter);
+    }
+}
+
+void Machine::SimBRV (bool& bHalt)
+{
+    SettleVC ();
+    if (bStatusV)
+    { 
+        LoadReg (sR_ProgramCounter);
+    }
+}
+
+void Machine::SimBRC (bool& bHalt)
+{
+    SettleVC ();
+    if (bStatusC)
+    {   
+        LoadReg (sR_ProgramCounter);
+    }
+}
+
+void Machine::SimCALL (bool& bError)
+{
+    if ((eA_AddrMode == eA_IMMEDIATE) || (eA_AddrMode == eA_INDEXED))
+    {
+        sR_StackPointer -= 2;
+        MemWrite (sR_ProgramCounter, sR_StackPointer);     // Mem [SP] = PC
+        LoadReg (sR_ProgramCounter);
+    }
+    else
+    {
+        IllegalAddr (bError);
+    }
+}
+
+void Machine::SimNOTr (bool& bHalt)
+{
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        sR_Accumulator = ~sR_Accumulator;
+        SetNZBits (sR_Accumulator);
+        break;
+    case eR_R_IS_INDEX_REG:
+        sR_IndexRegister = ~sR_IndexRegister;
+        SetNZBits (sR_IndexRegister);
+        break;
+    }
+}
+
+void Machine::SimNEGr (bool& bHalt)
+{
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        sR_Accumulator = -sR_Accumulator;
+        SetNZBits (sR_Accumulator);
+        break;
+    case eR_R_IS_INDEX_REG:
+        sR_IndexRegister = -sR_IndexRegister;
+        SetNZBits (sR_IndexRegister);
+        break;
+    }
+    // v = overflow ?
+}
+
+void Machine::SimASLr (bool& bHalt)
+{
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        AddLazy (sR_Accumulator, sR_Accumulator);
+        break;
+    case eR_R_IS_INDEX_REG:
+        AddLazy (sR_IndexRegister, sR_IndexRegister);
+        break;
+    }
+}
+
+void Machine::SimASRr (bool& bHalt)
+{
+    SettleVC ();                      // Keeps V
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        bStatusC = (sR_Accumulator & 1) != 0;
+        sR_Accumulator = (sR_Accumulator >> 1) | (sR_Accumulator & 0x8000);
+        SetNZBits (sR_Accumulator);
+        break;
+    case eR_R_IS_INDEX_REG:
+        bStatusC = (sR_IndexRegister & 1) != 0;
+        sR_IndexRegister = (sR_IndexRegister >> 1) | (sR_IndexRegister & 0x8000);
+        SetNZBits (sR_IndexRegister);
+        break;
+    }
+}
+
+//**** Rotates through the carry bit: C gets bit 15, bit 0 gets the old C
+void Machine::SimROLr (bool& bHalt)
+{
+    SettleVC ();
+    bool bOldCarry = bStatusC;
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        bStatusC = (sR_Accumulator & 0x8000) != 0;
+        sR_Accumulator = (sR_Accumulator << 1) | bOldCarry;
+        break;
+    case eR_R_IS_INDEX_REG:
+        bStatusC = (sR_IndexRegister & 0x8000) != 0;
+        sR_IndexRegister = (sR_IndexRegister << 1) | bOldCarry;
+        break;
+    }
+}
+
+//**** Rotates through the carry bit: C gets bit 0, bit 15 gets the old C
+void Machine::SimRORr (bool& bHalt)
+{
+    SettleVC ();
+    bool bOldCarry = bStatusC;
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        bStatusC = (sR_Accumulator & 1) != 0;
+        sR_Accumulator = (sR_Accumulator >> 1) | (bOldCarry << 15);
+        break;
+    case eR_R_IS_INDEX_REG:
+        bStatusC = (sR_IndexRegister & 1) != 0;
+        sR_IndexRegister = (sR_IndexRegister >> 1) | (bOldCarry << 15);
+        break;
+    }
+}
+
+void Machine::SimCHARI (bool& bError)
+{
+    char Ch;
+    sRegisterType Operand;
+   
+    if (bBufferIsEmpty)
+    {
+        if (bLoading || !bKeyboardInput)
+        {
+            if (!bChariLine())
+            {
+                bError = true;
+                PrntRunLoc();
+                *pMessage << "File read error or read past end of file." << endl;
+                return;
+            }
+        }
+        else
+        {
+            vFlushCharo ();  // Show any prompt before waiting for the user
+            vGetLine(cin);
+        }
+    }
+    vAdvanceInput(Ch);
+
+    if (eA_AddrMode == eA_IMMEDIATE)
+    {
+        IllegalAddr (bError);
+    }
+    else  //Addressing mode is valid
+    {
+        AddrProcessor (Operand);
+        MemByteWrite (Ch, Operand);
+    }
+}
+
+//**** Sends one character to the CHARO output. Output is buffered and
+//**** written at STOP, before keyboard input, on trace output and at exit.
+inline void Machine::CompareCharo (char cChar)
+{
+    long lExpectedSize = sExpectedText.size();
+    if (lFirstMismatch < 0
+        && (lExpectedPos >= lExpectedSize || sExpectedText[lExpectedPos] != cChar))
+    {
+        lFirstMismatch = lExpectedPos;
+    }
+    lExpectedPos++;
+    if (lCompareMargin >= 0 && lFirstMismatch >= 0
+        && (lFirstMismatch < lExpectedSize || lExpectedPos > lExpectedSize + lCompareMargin))
+    {
+        bMismatchHalt = true;
+    }
+}
+
+void Machine::vCharOut (int iData)
+{
+    if (iCharoCount == CHARO_BUFFER_SIZE)
+    {
+        vFlushCharo ();
+    }
+    if (iData == LINE_FEED || iData == CARRIAGE_RETURN)
+    {
+        cCharoBuffer[iCharoCount++] = '\n';
+    }
+    else
+    {
+        cCharoBuffer[iCharoCount++] = static_cast <char> (iData);
+    }
+    if (bCompareOutput)
+    {
+        CompareCharo (cCharoBuffer[iCharoCount - 1]);
+    }
+}
+
+bool Machine::bSetExpectedOutput (const char* cFileName, long lMargin)
+{
+    ifstream expectedFile (cFileName, ios::binary);
+    if (!expectedFile.is_open())
+    {
+        return false;
+    }
+    ostringstream text;
+    text << expectedFile.rdbuf();
+    sExpectedText = text.str();
+    bCompareOutput = true;
+    lCompareMargin = lMargin;
+    lExpectedPos = 0;
+    lFirstMismatch = -1;
+    bMismatchHalt = false;
+    return true;
+}
+
+void Machine::ClearExpectedOutput ()
+{
+    string().swap (sExpectedText);
+    bCompareOutput = false;
+    lFirstMismatch = -1;
+    bMismatchHalt = false;
+}
+
+long Machine::lMismatchOffset () const
+{
+    if (!bCompareOutput || lFirstMismatch >= 0)
+    {
+        return lFirstMismatch;
+    }
+    return (lExpectedPos < static_cast <long> (sExpectedText.size())) ? lExpectedPos : -1;
+}
+
+void Machine::SimCHARO (bool& bHalt)
+{
+    sRegisterType Operand;
+    int iData;
+   
+    AddrProcessor (Operand);
+    if (eA_AddrMode == eA_IMMEDIATE)
+    {
+        iData = Operand & 0xFF;
+    }
+    else
+    {
+        MemByteRead (Operand, iData);
+    }
+    vCharOut (iData);
+    if (bMismatchHalt)
+    {
+        bHalt = true;
+    }
+}
+
+void Machine::SimRETn (bool& bHalt)
+{
+    sR_StackPointer += nValue;                    // SP = SP + n
+    MemRead (sR_StackPointer, sR_ProgramCounter); // PC = Mem [SP]
+    sR_StackPointer += 2;                         // SP = SP + 2
+}
+
+void Machine::SimADDSP (bool& bError)
+{
+    sRegisterType R0;
+   
+    LoadReg (R0);
+    AddLazy (sR_StackPointer, R0);
+}
+
+void Machine::SimSUBSP (bool& bError)
+{
+    sRegisterType R0;
+   
+    LoadReg (R0);
+    SubLazy (sR_StackPointer, R0);
+}
+
+void Machine::SimADDr (bool& bHalt)
+{
+    sRegisterType R0;
+   
+    LoadReg (R0);
+        
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        AddLazy (sR_Accumulator, R0);
+        break;
+    case eR_R_IS_INDEX_REG:
+        AddLazy (sR_IndexRegister, R0);
+        break;
+    }
+}
+
+void Machine::SimSUBr (bool& bHalt)
+{
+    sRegisterType R0;
+   
+    LoadReg (R0);
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        SubLazy (sR_Accumulator, R0);
+        break;
+    case eR_R_IS_INDEX_REG:
+        SubLazy (sR_IndexRegister, R0);
+        break;
+    }
+}
+
+void Machine::SimANDr (bool& bHalt)
+{
+    sRegisterType R0;
+   
+    LoadReg (R0);
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        sR_Accumulator &= R0;
+        SetNZBits (sR_Accumulator);
+        break;
+    case eR_R_IS_INDEX_REG:
+        sR_IndexRegister &= R0;
+        SetNZBits (sR_IndexRegister);
+        break;
+    }
+}
+
+void Machine::SimORr (bool& bHalt)
+{  
+    sRegisterType R0;
+   
+    LoadReg (R0);
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        sR_Accumulator |= R0;
+        SetNZBits (sR_Accumulator);
+        break;
+    case eR_R_IS_INDEX_REG:
+        sR_IndexRegister |= R0;
+        SetNZBits (sR_IndexRegister);
+        break;
+    }
+}
+
+void Machine::SimCPr (bool& bHalt)
+{
+    sRegisterType R0 = sR_Accumulator, R1;
+   
+    if (eR_RegType == eR_R_IS_INDEX_REG)
+    {
+        R0 = sR_IndexRegister;
+    }
+    LoadReg (R1);
+    CompareLazy (R0, R1);
+}
+
+void Machine::SimLDr (bool& bHalt)
+{
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        LoadReg (sR_Accumulator);
+        SetNZBits (sR_Accumulator);
+        break;
+    case eR_R_IS_INDEX_REG:
+        LoadReg (sR_IndexRegister);
+        SetNZBits (sR_IndexRegister);
+        break;
+    }
+}
+
+void Machine::SimLDBYTEr (bool& bHalt)
+{
+
+    int Temp;
+    sRegisterType Operand;
+   
+    AddrProcessor (Operand);
+    if (eA_AddrMode == eA_IMMEDIATE)
+    {
+        Temp = Operand & 0xFF;
+    }
+    else
+    {
+        MemByteRead (Operand, Temp);
+    }
+    switch (eR_RegType)
+    {
+    case eR_R_IS_ACCUMULATOR:
+        sR_Accumulator = (sR_Accumulator & 0xFF00) | Temp;
+        SetNZBits (sR_Accumulator);
+        break;
+    case eR_R_IS_INDEX_REG:
+        sR_IndexRegister = (sR_IndexRegister & 0xFF00) | Temp;
+        SetNZBits (sR_IndexRegister);
+        break;
+    }
+}
+
+void Machine::SimSTr (bool& bError)
+{
+    sRegisterType Operand;
+   
+    if (eA_AddrMode == eA_IMMEDIATE)
+    {
+        IllegalAddr (bError);
+    }
+    else  // addressing mode is valid
+    {
+        AddrProcessor (Operand);
+        switch (eR_RegType)
+        {
+        case eR_R_IS_ACCUMULATOR:
+            MemWrite (sR_Accumulator, Operand);
+            break;
+        case eR_R_IS_INDEX_REG:
+            MemWrite (sR_IndexRegister, Operand);
+            break;
+        }
+    }
+}
+
+void Machine::SimSTBYTEr (bool& bError)
+{
+    sRegisterType Operand;
+   
+    if (eA_AddrMode == eA_IMMEDIATE)
+    {
+        IllegalAddr (bError);
+    }
+    else  // addressing mode is valid
+    {
+        AddrProcessor (Operand);
+        switch (eR_RegType)
+        {
+        case eR_R_IS_ACCUMULATOR:
+            MemByteWrite (sR_Accumulator & 0xFF, Operand); break;
+        case eR_R_IS_INDEX_REG:
+            MemByteWrite (sR_IndexRegister & 0xFF, Operand); break;
+        }
+    }
+}
+
+void Machine::Push (sRegisterType Reg, int iSize)
+{
+    sR_StackPointer += iSize;
+    MemWrite (Reg, sR_StackPointer);
+}
+
+//**** Native versions of the trap handlers in the distributed pep8os.pep,
+//**** used with -n. Each one has the same effect on registers, status bits,
+//**** memory and I/O as the OS routine it replaces, down to the variables,
+//**** return addresses and locals the routine leaves in OS RAM. They return
+//**** false, leaving the trap to the OS, in every case where the OS would
+//**** halt with an error, except a DECI input error after a new keyboard
+//**** line has already been read. That case prints the same message
+//**** natively. They also leave the trap to the OS when an operand pointer
+//**** or the operand is in OS RAM, where the OS routine reads values that
+//**** it has itself just written.
+
+//**** Prints a message the way the OS prntMsg subroutine does
+void Machine::vNativeMessage (const char* cMessage)
+{
+    vCharOut ('\n');
+    for (int i = 0; cMessage[i] != '\0'; i++)
+    {
+        vCharOut (cMessage[i]);
+    }
+}
+
+//**** True when some of the iLength bytes from iLoc are in OS RAM
+bool Machine::bInOSRam (int iLoc, int iLength)
+{
+    return iLoc <= OS_OP_ADDR + 1 && iLoc + iLength - 1 >= OS_RAM;
+}
+
+//**** True when the OS routine of a nonunary trap would read no OS RAM
+//**** but its own frame: the pointer of the n, sf and sxf modes and the
+//**** iLength bytes of the operand are all outside it
+bool Machine::bNativeSafe (sRegisterType Operand, int iLength)
+{
+    sRegisterType UserSP;
+    sRegisterType OprndSpec = sIR_InstrRegister.sR_OprndSpec;
+    MemRead (sR_StackPointer + 7, UserSP);
+    if (bInOSRam (Operand, iLength))
+    {
+        return false;
+    }
+    switch (eA_AddrMode)
+    {
+    case eA_INDIRECT:
+        return !bInOSRam (OprndSpec, 2);
+    case eA_STACK_REL_DEF: case eA_STACK_IND_DEF:
+        return !bInOSRam (static_cast <sRegisterType> (UserSP + OprndSpec), 2);
+    default:
+        return true;
+    }
+}
+
+//**** What every nonunary trap routine but NOP leaves in OS RAM: the
+//**** return address of the trap handler's call, the mask of legal modes,
+//**** the operand address of setAddr, and the return address of the call
+//**** to setAddr, which overwrote that of assertAd
+void Machine::NativeScratch (int iAddrMask, sRegisterType OpAddr, sRegisterType RetAddr)
+{
+    MemWrite (OS_RET_NONUNARY, sR_StackPointer - 2);
+    MemWrite (iAddrMask, OS_ADDR_MASK);
+    MemWrite (OpAddr, OS_OP_ADDR);
+    MemWrite (RetAddr, sR_StackPointer - 4);
+}
+
+//**** Gets the next DECI character with the buffering of SimCHARI. Records
+//**** where the first line read from a file started so that the input can
+//**** be rewound for the OS. Returns false at end of file.
+bool Machine::bNativeDeciChar (int& iChar, bool& bFileRead, size_t& FilePos,
+                      bool& bKeyboardRead)
+{
+    char Ch;
+    if (bBufferIsEmpty)
+    {
+        if (!bKeyboardInput)
+        {
+            if (!bFileRead)
+            {
+                FilePos = iChariPos;
+                bFileRead = true;
+            }
+            if (!bChariLine())
+            {
+                return false;
+            }
+        }
+        else
+        {
+            vFlushCharo ();
+            vGetLine(cin);
+            bKeyboardRead = true;
+        }
+    }
+    vAdvanceInput(Ch);
+    iChar = static_cast <uint8_t> (Ch);
+    return true;
+}
+
+//**** DECI: opcode30 of pep8os.pep
+bool Machine::bNativeDECI (sRegisterType Operand, int& iFlags, bool& bHalt)
+{
+    enum { eInit, eSign, eDigit } eState = eInit;
+    const char* pStartLine = pLine;
+    int iStartIndex = iLineIndex;
+    bool bStartEmpty = bBufferIsEmpty;
+    bool bFileRead = false;
+    size_t FilePos = iChariPos;
+    bool bEndOfFile = false;
+    bool bKeyboardRead = false;
+    bool bIsNeg = false;
+    bool bIsOvfl = false;
+    bool bTempSet = false;
+    bool bCarry, bOvfl;
+    sRegisterType Total = 0;
+    sRegisterType Temp = 0;
+    sRegisterType SP = sR_StackPointer - 2;          // In the DECI routine
+    int iChar = 0;
+    if (eA_AddrMode == eA_IMMEDIATE || !bNativeSafe (Operand, 2))
+    {
+        return false;
+    }
+    for (;;)
+    {
+        if (!bNativeDeciChar (iChar, bFileRead, FilePos, bKeyboardRead))
+        {
+            bEndOfFile = true;
+            break;                                   // Let the OS report it
+        }
+        bool bIsDigit = ('0' <= iChar && iChar <= '9');
+        if (eState == eDigit)
+        {
+            if (!bIsDigit)
+            {
+                break;
+            }
+            Adder (Total, Total, Total, bCarry, bOvfl);  // 2 * total
+            bIsOvfl = bIsOvfl || bOvfl;
+            Temp = Total;
+            bTempSet = true;
+            Adder (Total, Total, Total, bCarry, bOvfl);  // 4 * total
+            bIsOvfl = bIsOvfl || bOvfl;
+            Adder (Total, Total, Total, bCarry, bOvfl);  // 8 * total
+            bIsOvfl = bIsOvfl || bOvfl;
+            Adder (Total, Temp, Total, bCarry, bOvfl);   // 10 * total
+            bIsOvfl = bIsOvfl || bOvfl;
+            Adder (Total, iChar & 0x0F, Total, bCarry, bOvfl);
+            bIsOvfl = bIsOvfl || bOvfl;
+        }
+        else if (bIsDigit)
+        {
+            Total = iChar & 0x0F;
+            eState = eDigit;
+        }
+        else if (eState == eInit && (iChar == '+' || iChar == '-'))
+        {
+            bIsNeg = (iChar == '-');
+            eState = eSign;
+        }
+        else if (eState == eInit && (iChar == ' ' || iChar == '\n'))
+        {
+            ;
+        }
+        else if (bKeyboardRead)
+        {
+            NativeScratch (0x00FE, Operand, OS_RET_DECI_SETADDR);
+            MemWrite (0, SP - 6);                    // isOvfl
+            MemWrite (eState, SP - 10);              // state
+            if (eState == eSign)
+            {
+                MemWrite (bIsNeg, SP - 8);           // isNeg
+            }
+            MemWrite (iChar & 0x0F, SP - 4);         // valAscii
+            MemWrite (iChar, OS_WORD_BUFF);
+            MemWrite (OS_DECI_MSG, SP - 14);         // The parameter of prntMsg
+            MemWrite (OS_RET_DECI_PRNTMSG, SP - 16);
+            vNativeMessage ("ERROR: Invalid DECI input");
+            bHalt = true;
+            return true;
+        }
+        else
+        {
+            break;                                   // Let the OS report it
+        }
+    }
+    if (eState != eDigit || bEndOfFile)
+    {
+        if (bFileRead)                               // Rewind the input
+        {
+            iChariPos = FilePos;
+        }
+        pLine = pStartLine;                          // Lines of a file are read in place
+        iLineIndex = iStartIndex;
+        bBufferIsEmpty = bStartEmpty;
+        return false;
+    }
+    if (bIsNeg)
+    {
+        if (Total != 0x8000)
+        {
+            Total = -Total;
+        }
+        else
+        {
+            bIsOvfl = false;                          // -32768 is a special case
+        }
+    }
+    iFlags = (iFlags & 1) | ((Total & 0x8000) ? 8 : 0) | ((Total == 0) ? 4 : 0)
+        | (bIsOvfl ? 2 : 0);
+    NativeScratch (0x00FE, Operand, OS_RET_DECI_SETADDR);
+    if (bTempSet)
+    {
+        MemWrite (Temp, SP - 12);                    // temp
+    }
+    MemWrite (eDigit, SP - 10);                      // state
+    MemWrite (bIsNeg, SP - 8);                       // isNeg
+    MemWrite (bIsOvfl, SP - 6);                      // isOvfl
+    MemWrite (iChar & 0x0F, SP - 4);                 // valAscii
+    MemWrite (Total, SP - 2);                        // total, over the return address
+    MemWrite (iChar, OS_WORD_BUFF);                  // The character after the number
+    MemWrite (Total, Operand);
+    return true;
+}
+
+//**** DECO: opcode38 of pep8os.pep, including its repeated subtraction
+//**** so that the digits are the same for every operand
+bool Machine::bNativeDECO (sRegisterType Operand)
+{
+    static const int iPlace[4] = { 10000, 1000, 100, 10 };
+    sRegisterType Remain, A, OldPC;
+    sRegisterType SP = sR_StackPointer - 8;          // After SUBSP 6,i
+    int iDigit;
+    int iLastDigit = 0;
+    bool bChOut = false;
+    if (eA_AddrMode == eA_IMMEDIATE)
+    {
+        Remain = Operand;
+        MemRead (sR_StackPointer + 5, OldPC);
+        NativeScratch (0x00FF, OldPC - 2, OS_RET_DECO_SETADDR);  // Oprnd = OprndSpec
+    }
+    else if (!bNativeSafe (Operand, 2))
+    {
+        return false;
+    }
+    else
+    {
+        MemRead (Operand, Remain);
+        NativeScratch (0x00FF, Operand, OS_RET_DECO_SETADDR);
+    }
+    if (Remain & 0x8000)
+    {
+        vCharOut ('-');
+        Remain = -Remain;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        A = Remain;
+        iDigit = 0;
+        for (;;)
+        {
+            A -= iPlace[i];
+            if (A & 0x8000)
+            {
+                break;
+            }
+            iDigit++;
+            Remain = A;
+        }
+        if (iDigit != 0 || bChOut)
+        {
+            bChOut = true;
+            iLastDigit = iDigit;
+            vCharOut ((iDigit | 0x30) & 0xFF);
+        }
+    }
+    MemWrite (Remain, SP);                           // remain
+    MemWrite (bChOut, SP + 2);                       // chOut
+    MemWrite (10, SP + 4);                           // place
+    MemWrite (OS_RET_DECO_DIVIDE, SP - 2);
+    if (bChOut)
+    {
+        MemWrite (iLastDigit | 0x30, OS_WORD_BUFF);  // STX wordBuff,d of printDgt
+    }
+    MemByteWrite ((Remain | 0x30) & 0xFF, OS_BYTE_BUFF);
+    vCharOut ((Remain | 0x30) & 0xFF);
+    return true;
+}
+
+//**** STRO: opcode40 of pep8os.pep
+bool Machine::bNativeSTRO (sRegisterType Operand)
+{
+    int iByte;
+    sRegisterType Loc = Operand;
+    if (eA_AddrMode != eA_DIRECT && eA_AddrMode != eA_INDIRECT
+        && eA_AddrMode != eA_STACK_REL_DEF)
+    {
+        return false;
+    }
+    do
+    {
+        if (!bNativeSafe (Loc, 1))
+        {
+            return false;
+        }
+        iByte = iMemory[Loc++];
+    } while (iByte != 0);
+    NativeScratch (0x0016, Operand, OS_RET_STRO_SETADDR);
+    MemWrite (Operand, sR_StackPointer - 4);         // The parameter of prntMsg
+    MemWrite (OS_RET_STRO_PRNTMSG, sR_StackPointer - 6);
+    MemByteRead (Operand, iByte);
+    while (iByte != 0)
+    {
+        vCharOut (iByte);
+        Operand++;
+        MemByteRead (Operand, iByte);
+    }
+    return true;
+}
+
+//**** Services a trap natively. Called after the trap has pushed its frame
+//**** on the system stack, so returning true is followed by RETTR.
+bool Machine::bNativeTrap (sRegisterType Operand, bool& bHalt)
+{
+    int iFlags;
+    switch (sDecodeTable[sIR_InstrRegister.iInstr_Spec].eMnemon)
+    {
+    case eM_UNIMP4:                                  // NOP
+        if (eA_AddrMode != eA_IMMEDIATE)
+        {
+            return false;
+        }
+        MemWrite (OS_RET_NONUNARY, sR_StackPointer - 2);
+        MemWrite (0x0001, OS_ADDR_MASK);
+        MemWrite (OS_RET_NOP_ASSERT, sR_StackPointer - 4);
+        return true;
+    case eM_UNIMP5:                                  // DECI
+        MemByteRead (sR_StackPointer, iFlags);
+        if (!bNativeDECI (Operand, iFlags, bHalt))
+        {
+            return false;
+        }
+        MemByteWrite (iFlags, sR_StackPointer);     // Stacked NZVC
+        return true;
+    case eM_UNIMP6:                                  // DECO
+        return bNativeDECO (Operand);
+    case eM_UNIMP7:                                  // STRO
+        return bNativeSTRO (Operand);
+    default:                                         // NOP0 - NOP3
+        MemWrite (OS_RET_UNARY, sR_StackPointer - 2);
+        return true;
+    }
+}
+
+//**** The loader CHARI at InstrAddr: gets the next object file character
+//**** with the buffering of SimCHARI and stores it in byteBuff.  Returns
+//**** false, with the runtime error of the loader, at end of file.
+bool Machine::bLoaderChar (sRegisterType InstrAddr, int& iChar)
+{
+    char Ch;
+    if (bBufferIsEmpty)
+    {
+        if (!bChariLine())
+        {
+            sIR_InstrRegister.iInstr_Spec = 0x49;    // CHARI byteBuff,d
+            sIR_InstrRegister.sR_OprndSpec = OS_BYTE_BUFF;
+            sR_ProgramCounter = InstrAddr + 3;
+            PrntRunLoc();
+            *pMessage << "File read error or read past end of file." << endl;
+            return false;
+        }
+    }
+    vAdvanceInput(Ch);
+    MemByteWrite (Ch, OS_BYTE_BUFF);
+    iChar = static_cast <uint8_t> (Ch);
+    return true;
+}
+
+//**** Does what the loader of the distributed operating system does, without
+//**** interpreting it: each pair of characters up to the zz sentinel is one
+//**** byte, stored from address 0 up.  Memory, the registers and the status
+//**** bits are left as the loader leaves them when it executes STOP.
+void Machine::NativeLoad ()
+{
+    int iChar;
+    int iByte;
+    bool bLoaded = false;
+    sR_IndexRegister = 0;                            // LDX 0,i
+    MemWrite (sR_IndexRegister, OS_WORD_BUFF);       // STX wordBuff,d
+    while (!bLoaded)
+    {
+        if (!bLoaderChar (OS_LOADER_CHARI1, iChar))
+        {
+            break;
+        }
+        if (iChar == 'z')
+        {
+            bLoaded = true;
+        }
+        else
+        {
+            iByte = ((iChar <= '9' ? iChar : iChar + 9) & 15) << 4;
+            sR_Accumulator = (iChar <= '9' ? iChar : iChar + 9) << 4;
+            MemByteWrite (iByte, OS_BYTE_TEMP);      // STBYTEA byteTemp,d
+            if (!bLoaderChar (OS_LOADER_CHARI2, iChar))
+            {
+                break;
+            }
+            iByte |= (iChar <= '9' ? iChar : iChar + 9) & 15;
+            sR_Accumulator = (iMemory[OS_BYTE_TEMP - 1] << 8) | iByte;  // ORA wordTemp,d
+            MemByteWrite (iByte, sR_IndexRegister);  // STBYTEA 0,x
+            sR_IndexRegister++;
+            if (!bLoaderChar (OS_LOADER_CHARI2, iChar))  // Skip blank or <LF>
+            {
+                break;
+            }
+        }
+    }
+    if (bLoaded)
+    {
+        sR_Accumulator = 'z';                        // CPA 'z',i leaves only Z set
+        SetStatusBits (4);
+        sIR_InstrRegister.iInstr_Spec = 0x00;        // STOP
+        sIR_InstrRegister.sR_OprndSpec = OS_LOADER_STOP;
+        sR_ProgramCounter = OS_LOADER_STOP + 1;
+    }
+    bStopped = bLoaded;
+    if (!bKeyboardInput)
+    {
+        iChariPos = 0;  // Reset input file to its beginning
+    }
+}
+
+//**** NativeLoad for the bytes of a binary object file, which are already
+//**** in sChariText.  Leaves the machine as the loader leaves it after
+//**** reading the same program as text.
+void Machine::BinaryLoad ()
+{
+    int iLast = 0;
+    sR_IndexRegister = 0;
+    MemWrite (sR_IndexRegister, OS_WORD_BUFF);
+    for (size_t i = 0; i < sChariText.size(); i++)
+    {
+        iLast = static_cast <uint8_t> (sChariText[i]);
+        MemByteWrite (iLast, sR_IndexRegister);
+        sR_IndexRegister++;
+    }
+    if (!sChariText.empty())
+    {
+        MemByteWrite (iLast & 0xF0, OS_BYTE_TEMP);
+    }
+    MemByteWrite ('z', OS_BYTE_BUFF);
+    sR_Accumulator = 'z';
+    SetStatusBits (4);
+    sIR_InstrRegister.iInstr_Spec = 0x00;
+    sIR_InstrRegister.sR_OprndSpec = OS_LOADER_STOP;
+    sR_ProgramCounter = OS_LOADER_STOP + 1;
+    bStopped = true;
+}
+
+void Machine::SimTRAP (bool& bHalt)
+{
+    sRegisterType oldSP;
+    sRegisterType Operand;
+    bool bNative = bNativeTraps && bStandardTraps && bStandardOS
+        && eTraceMode == eT_TR_OFF;
+    if (bNative && !sDecodeTable[sIR_InstrRegister.iInstr_Spec].bUnary)
+    {
+        AddrProcessor (Operand);                     // With the user registers
+    }
+   
+    oldSP = sR_StackPointer;                         // Save initial SP value to push later
+    MemRead (SYSTEM_SP, sR_StackPointer);            // Get system SP value
+     
+    sR_StackPointer--;
+    MemByteWrite (sIR_InstrRegister.iInstr_Spec, sR_StackPointer);      // Push instruction specifier
+    Push (oldSP, -2);
+    Push (sR_ProgramCounter, -2);
+    Push (sR_IndexRegister, -2);
+    Push (sR_Accumulator, -2);
+
+    sR_StackPointer--;
+    MemByteWrite (iStatusBits (), sR_StackPointer);                                    // Push status flags
+    MemRead (INTR_PC, sR_ProgramCounter);                              // Branch to Pep/8 OS
+    if (bNative && bNativeTrap (Operand, bHalt) && !bHalt)
+    {
+        SimRETTR (bHalt);
+    }
+    if (bMismatchHalt)
+    {
+        bHalt = true;           // A native DECO or STRO left the expected output
+    }
+}
+
+//**** End of Opcode procedures ****
+
+//**** Decodes all 256 instruction specifiers once at startup so that the
+//**** execution cycle does a single table lookup per instruction.
+void Machine::InitDecodeTable ()
+{
+    MnemonicOpcodes eMn;
+    for (int iSpec = 0; iSpec < INSTR_SPECIFIERS; iSpec++)
+    {
+        sDecodeType& sD_Decode = sDecodeTable[iSpec];
+        eMn = instr_SpecToMnemon (iSpec);
+        sD_Decode.eMnemon = eMn;
+        sD_Decode.bUnary = (eMn <= eM_MOVFLGA) || (eM_NOTr <= eMn && eMn <= eM_UNIMP3)
+            || eMn == eM_RETn;
+        if (eM_BR <= eMn && eMn <= eM_CALL)
+        {
+            sD_Decode.eAddrMode = ProcessAddressingMode (GetAddressingModeOneBit (iSpec));
+        }
+        else if (!sD_Decode.bUnary)
+        {
+            sD_Decode.eAddrMode = ProcessAddressingMode (GetAddressingModeThreeBits (iSpec));
+        }
+        else
+        {
+            sD_Decode.eAddrMode = eA_IMMEDIATE;
+        }
+        if (eM_NOTr <= eMn && eMn <= eM_RORr)
+        {
+            sD_Decode.eRegType = ProcessRegisterType (GetRegisterTypeLastBit (iSpec));
+        }
+        else if (eM_ADDr <= eMn)
+        {
+            sD_Decode.eRegType = ProcessRegisterType (GetRegisterTypeFourthBit (iSpec));
+        }
+        else
+        {
+            sD_Decode.eRegType = eR_R_IS_ACCUMULATOR;
+        }
+        sD_Decode.iNValue = (eMn == eM_RETn) ? GetNValueThreeBits (iSpec) : 0;
+        sD_Decode.bEndsBlock = (eMn <= eM_RETTR) || (eM_BR <= eMn && eMn <= eM_CALL)
+            || (eM_UNIMP0 <= eMn && eMn <= eM_UNIMP7) || eMn == eM_RETn;
+        switch (eMn) {
+        case eM_STOP: sD_Decode.pSimProc = SimThunk <&Machine::SimSTOP>; break;
+        case eM_RETTR: sD_Decode.pSimProc = SimThunk <&Machine::SimRETTR>; break;
+        case eM_MOVSPA: sD_Decode.pSimProc = SimThunk <&Machine::SimMOVSPA>; break;
+        case eM_MOVFLGA: sD_Decode.pSimProc = SimThunk <&Machine::SimMOVFLGA>; break;
+
+        case eM_BR: sD_Decode.pSimProc = SimThunk <&Machine::SimBR>; break;
+        case eM_BRLE: sD_Decode.pSimProc = SimThunk <&Machine::SimBRLE>; break;
+        case eM_BRLT: sD_Decode.pSimProc = SimThunk <&Machine::SimBRLT>; break;
+        case eM_BREQ: sD_Decode.pSimProc = SimThunk <&Machine::SimBREQ>; break;
+        case eM_BRNE: sD_Decode.pSimProc = SimThunk <&Machine::SimBRNE>; break;
+        case eM_BRGE: sD_Decode.pSimProc = SimThunk <&Machine::SimBRGE>; break;
+        case eM_BRGT: sD_Decode.pSimProc = SimThunk <&Machine::SimBRGT>; break;
+        case eM_BRV: sD_Decode.pSimProc = SimThunk <&Machine::SimBRV>; break;
+        case eM_BRC: sD_Decode.pSimProc = SimThunk <&Machine::SimBRC>; break;
+        case eM_CALL: sD_Decode.pSimProc = SimThunk <&Machine::SimCALL>; break;
+
+        case eM_NOTr: sD_Decode.pSimProc = SimThunk <&Machine::SimNOTr>; break;
+        case eM_NEGr: sD_Decode.pSimProc = SimThunk <&Machine::SimNEGr>; break;
+        case eM_ASLr: sD_Decode.pSimProc = SimThunk <&Machine::SimASLr>; break;
+        case eM_ASRr: sD_Decode.pSimProc = SimThunk <&Machine::SimASRr>; break;
+        case eM_ROLr: sD_Decode.pSimProc = SimThunk <&Machine::SimROLr>; break;
+        case eM_RORr: sD_Decode.pSimProc = SimThunk <&Machine::SimRORr>; break;
+
+        case eM_UNIMP0: case eM_UNIMP1: case eM_UNIMP2: case eM_UNIMP3:
+        case eM_UNIMP4: case eM_UNIMP5: case eM_UNIMP6: case eM_UNIMP7:
+            sD_Decode.pSimProc = SimThunk <&Machine::SimTRAP>; break;
+
+        case eM_CHARI: sD_Decode.pSimProc = SimThunk <&Machine::SimCHARI>; break;
+        case eM_CHARO: sD_Decode.pSimProc = SimThunk <&Machine::SimCHARO>; break;
+
+        case eM_RETn: sD_Decode.pSimProc = SimThunk <&Machine::SimRETn>; break;
+
+        case eM_ADDSP: sD_Decode.pSimProc = SimThunk <&Machine::SimADDSP>; break;
+        case eM_SUBSP: sD_Decode.pSimProc = SimThunk <&Machine::SimSUBSP>; break;
+
+        case eM_ADDr: sD_Decode.pSimProc = SimThunk <&Machine::SimADDr>; break;
+        case eM_SUBr: sD_Decode.pSimProc = SimThunk <&Machine::SimSUBr>; break;
+        case eM_ANDr: sD_Decode.pSimProc = SimThunk <&Machine::SimANDr>; break;
+        case eM_ORr: sD_Decode.pSimProc = SimThunk <&Machine::SimORr>; break;
+        case eM_CPr: sD_Decode.pSimProc = SimThunk <&Machine::SimCPr>; break;
+
+        case eM_LDr: sD_Decode.pSimProc = SimThunk <&Machine::SimLDr>; break;
+        case eM_LDBYTEr: sD_Decode.pSimProc = SimThunk <&Machine::SimLDBYTEr>; break;
+        case eM_STr: sD_Decode.pSimProc = SimThunk <&Machine::SimSTr>; break;
+        case eM_STBYTEr: sD_Decode.pSimProc = SimThunk <&Machine::SimSTBYTEr>; break;
+        }
+    }
+}
+
+const sDecodeType& Machine::Decode (int iInstr_Spec)
+{
+    static bool bTableBuilt = (InitDecodeTable (), true);  // Once per process
+    (void) bTableBuilt;
+    return sDecodeTable[iInstr_Spec];
+}
+
+//**** The default cost of a specifier: one cycle for each memory access.
+//**** The fetch reads the instruction specifier and, unless the
+//**** instruction is unary, the operand specifier.  The n, sf and sxf
+//**** modes read the address of the operand first.  A trap reads the
+//**** system stack pointer and the trap vector and pushes five registers
+//**** and the status bits.
+int DefaultCycleCost (const sDecodeType& sD)
+{
+    MnemonicOpcodes eMn = sD.eMnemon;
+    bool bOperand = !sD.bUnary && sD.eAddrMode != eA_IMMEDIATE;
+    int iCycles = sD.bUnary ? 1 : 2;
+    if (sD.eAddrMode == eA_INDIRECT || sD.eAddrMode == eA_STACK_REL_DEF
+        || sD.eAddrMode == eA_STACK_IND_DEF)
+    {
+        iCycles++;
+    }
+    if (eM_UNIMP0 <= eMn && eMn <= eM_UNIMP7)
+    {
+        return iCycles + 8;
+    }
+    switch (eMn)
+    {
+    case eM_STOP: case eM_MOVSPA: case eM_MOVFLGA:
+    case eM_NOTr: case eM_NEGr: case eM_ASLr: case eM_ASRr: case eM_ROLr: case eM_RORr:
+        break;
+    case eM_RETTR: iCycles += 5; break;             // Pops the status bits and four registers
+    case eM_RETn: iCycles += 1; break;              // Pops the return address
+    case eM_CALL: iCycles += bOperand ? 2 : 1; break;   // Pushes the return address
+    case eM_STr: case eM_STBYTEr: case eM_CHARI: iCycles += 1; break;
+    default: iCycles += bOperand ? 1 : 0; break;
+    }
+    return iCycles;
+}
+
+Machine::Machine ()
+{
+    Decode (0);                             // Builds the decode table
+    memset (iMemory, 0, sizeof (iMemory));
+    memset (iDirtyPage, 0, sizeof (iDirtyPage));
+    memset (pBlockCache, 0, sizeof (pBlockCache));
+    memset (iCodeMap, 0, sizeof (iCodeMap));
+    pBlockList = NULL;
+    pRetiredBlocks = NULL;
+    bBlockInvalidated = false;
+    bBlockCache = false;
+    bTranslate = false;
+    bNativeTraps = false;
+    bStatistics = false;
+    bProfile = false;
+    bCallGraph = false;
+    lHistoryCount = 0;
+    memset (iBreakMap, 0, sizeof (iBreakMap));
+    bBreakpoints = false;
+    bWatchpoints = false;
+    bAtBreak = false;
+    bAtLimit = false;
+    bResumeBreak = false;
+    bBreakHit = false;
+    bWatchHit = false;
+    iTraceCount = 0;
+    memset (lSpecCount, 0, sizeof (lSpecCount));
+    for (int iSpec = 0; iSpec < INSTR_SPECIFIERS; iSpec++)
+    {
+        iCycleCost[iSpec] = DefaultCycleCost (sDecodeTable[iSpec]);
+    }
+    memset (lFusedCount, 0, sizeof (lFusedCount));
+    memset (lAddrCount, 0, sizeof (lAddrCount));
+    ResetCallGraph ();
+    lRomCount = 0;
+    lTransCount = 0;
+    lTransBlocks = 0;
+    dRunSeconds = 0;
+    bStandardTraps = false;
+    bStandardOS = false;
+    eTraceMode = eT_TR_OFF;
+    bLoading = false;
+    bMachineReset = false;
+    bStopped = false;
+    bKeyboardInput = true;
+    bBinaryObject = false;
+    bScreenOutput = true;
+    bBufferIsEmpty = true;
+    bSingleStep = false;
+    bScrollingTrace = false;
+    iChariPos = 0;
+    pLine = cLine;
+    pCharoOutput = &cout;
+    pMessage = &cout;
+    iCharoCount = 0;
+    bCompareOutput = false;
+    lExpectedPos = 0;
+    lFirstMismatch = -1;
+    lCompareMargin = -1;
+    bMismatchHalt = false;
+    iLineIndex = 0;
+    iRomStartAddr = MEMORY_SIZE;
+    StartWatchdog (0, 0);
+    sR_Accumulator = 0;                     // Must be initialized if trace used
+    sR_IndexRegister = 0;
+    sR_StackPointer = 0;
+    sR_ProgramCounter = 0;
+    sIR_InstrRegister.iInstr_Spec = 0;
+    sIR_InstrRegister.sR_OprndSpec = 0;
+    SetStatusBits (0);
+    numTerminalLines = 22;
+}
+
+Machine::~Machine ()
+{
+    CloseBinaryTrace ();
+    pRetiredBlocks = NULL;
+    while (pBlockList != NULL)
+    {
+        sBlockType* pBlock = pBlockList;
+        pBlockList = pBlock->pNext;
+        DeleteBlock (pBlock);
+    }
+}
+
+void Machine::Initialize (bool& bError)
+{
+    char ch;
+    ifstream trapFile;
+    trapFile.open("trap");
+    if (!trapFile.is_open()) {
+        bError = true;
+        *pMessage << "Could not open trap file." << endl;
+    } 
+    else {
+        bError = false;
+        for (int iLine = 0; iLine < UNIMPLEMENTED_INSTRUCTIONS; iLine++)
+        {
+            vGetLine(trapFile);
+            vAdvanceInput(ch);
+            for (int i = 0; i < MNEMON_LENGTH; i++)
+            {
+                if (isspace(ch)) 
+                {
+                    TrapMnemon[iLine][i] = ' ';
+                }
+                else
+                {
+                    TrapMnemon[iLine][i] = toupper(ch);
+                    vAdvanceInput(ch);
+                }
+            }
+            TrapMnemon[iLine][MNEMON_LENGTH] = '\0';
+        }
+        bStandardTraps = true;
+        for (int iLine = 0; iLine < UNIMPLEMENTED_INSTRUCTIONS; iLine++)
+        {
+            bStandardTraps = bStandardTraps
+                && strcmp (TrapMnemon[iLine], cStandardTrapMnemon[iLine]) == 0;
+        }
+        trapFile.close();
+    }
+}
+
+//**** Converts a HEX number to a decimal number and returns the decimal number.
+//**** Static, like vDecToHexByte, because pep8run also links asem8.cpp.
+static int iHexToDec (char ch)
+{
+    switch (ch)
+    {
+    case '0':  return 0; break;
+    case '1':  return 1; break;
+    case '2':  return 2; break;
+    case '3':  return 3; break;
+    case '4':  return 4; break;
+    case '5':  return 5; break;
+    case '6':  return 6; break;
+    case '7':  return 7; break;
+    case '8':  return 8; break;
+    case '9':  return 9; break;
+    case 'A':  return 10; break;
+    case 'B':  return 11; break;
+    case 'C':  return 12; break;
+    case 'D':  return 13; break;
+    case 'E':  return 14; break;
+    case 'F':  return 15; break;
+    default: return -1;
+    }
+}
+
+//**** Converts a decimal value between -256 to 255 to a HEX array of characters
+//**** Used to convert opcodes to hex
+static void vDecToHexByte (int iDec, char cHex[HEX_BYTE_LENGTH + 1])
+{
+    cHex[0] = cHexTable[iDec / 16];
+    cHex[1] = cHexTable[iDec % 16];
+    cHex[2] = '\0';
+}
+
+//**** Converts a HEX byte to a positive decimal integer
+int iHexByteToDecInt (char cHex[HEX_BYTE_LENGTH + 1])
+{
+    return 16 * iHexToDec(cHex[0]) + iHexToDec(cHex[1]);
+}
+
+//**** Converts a 16 bit register into a 4 digit HEX no.
+void RegToHex (sRegisterType Reg, char HexNum[])
+{
+    HexNum[0] = cHexTable[Reg >> 12];
+    HexNum[1] = cHexTable[(Reg >> 8) & 15];
+    HexNum[2] = cHexTable[(Reg >> 4) & 15];
+    HexNum[3] = cHexTable[Reg & 15];
+    HexNum[4] = '\0';
+}
+
+//**** Gets the size and the FNV-1a hash of the contents of a file
+bool bHashFile (const char* cFileName, long long& lSize, unsigned int& iHash)
+{
+    ifstream file (cFileName, ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    const string& sFile = contents.str();
+    iHash = 2166136261u;
+    for (size_t i = 0; i < sFile.size(); i++)
+    {
+        iHash = (iHash ^ static_cast <uint8_t> (sFile[i])) * 16777619u;
+    }
+    lSize = sFile.size();
+    return true;
+}
+
+//**** The binary object file that goes with the text object file
+//**** cTextName: the same name ending in .pepb instead of .pepo.  Returns
+//**** false if there is none, or if the size and hash of the text file it
+//**** was written with, recorded in its header, are not those of cTextName.
+bool bBinaryIsCurrent (const char* cTextName, string& sBinaryName)
+{
+    uint8_t iHeader[BINARY_HEADER_LENGTH];
+    long long lSize;
+    unsigned int iHash;
+    sBinaryName = cTextName;
+    if (sBinaryName.size() < 5
+        || sBinaryName.compare (sBinaryName.size() - 5, 5, ".pepo") != 0)
+    {
+        return false;
+    }
+    sBinaryName[sBinaryName.size() - 1] = 'b';
+    ifstream binaryFile (sBinaryName.c_str(), ios::binary);
+    binaryFile.read (reinterpret_cast <char*> (iHeader), BINARY_HEADER_LENGTH);
+    if (binaryFile.gcount() != BINARY_HEADER_LENGTH || memcmp (iHeader, "PEPB", 4) != 0)
+    {
+        return false;
+    }
+    if (!bHashFile (cTextName, lSize, iHash))
+    {
+        return true;
+    }
+    return lSize == ((static_cast <unsigned int> (iHeader[8]) << 24) | (iHeader[9] << 16) | (iHeader[10] << 8) | iHeader[11])
+        && iHash == ((static_cast <unsigned int> (iHeader[12]) << 24) | (iHeader[13] << 16)
+                     | (iHeader[14] << 8) | iHeader[15]);
+}
+
+//**** Reads a binary object file written by asem8 -b: "PEPB", the load
+//**** address and the byte count as big-endian words, the size and FNV-1a
+//**** hash of the .pepo file as big-endian longs, the bytes, and their
+//**** sum as a big-endian word.  Returns false if the file is malformed.
+bool bReadBinaryObject (const string& sFileName, string& sBytes, int& iLoadAddr)
+{
+    ifstream binaryFile (sFileName.c_str(), ios::binary);
+    ostringstream contents;
+    contents << binaryFile.rdbuf();
+    const string& sFile = contents.str();
+    if (sFile.size() < BINARY_HEADER_LENGTH + 2 || sFile.compare (0, 4, "PEPB") != 0)
+    {
+        return false;
+    }
+    const uint8_t* pFile = reinterpret_cast <const uint8_t*> (sFile.data());
+    int iLength = (pFile[6] << 8) | pFile[7];
+    if (sFile.size() != static_cast <size_t> (BINARY_HEADER_LENGTH + iLength + 2))
+    {
+        return false;
+    }
+    int iSum = 0;
+    for (int i = 0; i < iLength; i++)
+    {
+        iSum += pFile[BINARY_HEADER_LENGTH + i];
+    }
+    if ((iSum & 0xFFFF) != ((pFile[BINARY_HEADER_LENGTH + iLength] << 8)
+                            | pFile[BINARY_HEADER_LENGTH + iLength + 1]))
+    {
+        return false;
+    }
+    iLoadAddr = (pFile[4] << 8) | pFile[5];
+    sBytes.assign (sFile, BINARY_HEADER_LENGTH, iLength);
+    return true;
+}
+
+//**** The operating system file that InstallRom reads
+const char* cRomFileName ()
+{
+    string sBinaryName;
+    return bBinaryIsCurrent ("pep8os.pepo", sBinaryName) ? "pep8os.pepb" : "pep8os.pepo";
+}
+
+//**** Initialize RAM using data from pep8os.pepb, or the pep8os.pepo file.
+//**** The ROM ends at the top of memory whatever the load address.
+void Machine::InstallRom (bool& bError)
+{
+    string sBinaryName, sRom;
+    int iLoadAddr;
+    if (bBinaryIsCurrent ("pep8os.pepo", sBinaryName))
+    {
+        if (bReadBinaryObject (sBinaryName, sRom, iLoadAddr)
+            && sRom.size() < static_cast <size_t> (MEMORY_SIZE))
+        {
+            iRomStartAddr = MEMORY_SIZE - sRom.size();
+            memcpy (iMemory + iRomStartAddr, sRom.data(), sRom.size());
+            SetStandardOS ();
+            return;
+        }
+        *pMessage << "Invalid binary object file " << sBinaryName << endl;
+    }
+    ifstream ROMFile;
+    int iNumBytes = 0;
+    char cByte[HEX_BYTE_LENGTH + 1];
+    int iCounter = 0;
+    char cNext;
+    ROMFile.open("pep8os.pepo");
+    if (ROMFile.fail())
+    {
+        bError = true;
+        *pMessage << "Could not open file pep8os.pepo" << endl;
+    }
+    else
+    {
+        iCounter = 0;
+        int i;
+        vGetLine(ROMFile);
+        vAdvanceInput(cNext);
+        while (!ROMFile.eof())
+        {
+            if (bIsHexDigit(cNext))
+            {
+                iCounter++;
+            }
+            else if (cNext == '\n')
+            {
+                vGetLine(ROMFile);
+            }
+            vAdvanceInput(cNext);
+        }
+        iNumBytes = iCounter / 2;
+        ROMFile.close();
+        ROMFile.clear();
+        if (iNumBytes >= MEMORY_SIZE)
+        {
+            bError = true;
+            *pMessage << "OS is too big to fit into main memory." << endl;
+            *pMessage << "NumBytes = " << iNumBytes;
+            *pMessage << ", MemorySize = " << MEMORY_SIZE << endl;
+        }
+        else
+        {
+            ROMFile.open ("pep8os.pepo");
+            iRomStartAddr = TOP_OF_MEMORY - iNumBytes + 1;
+            bool bIsEnd = false;
+            vGetLine(ROMFile);
+            vAdvanceInput(cNext);
+            iCounter = 0;
+            i = iRomStartAddr;
+            while (!ROMFile.eof() && !bIsEnd)
+            {
+                if (iCounter == 2)
+                {
+                    cByte[iCounter] = '\0';
+                    iMemory[i++] = iHexByteToDecInt(cByte);
+                    iCounter = 0;
+                    vBackUpInput();
+                }
+                else if (bIsHexDigit(cNext))
+                {
+                    cByte[iCounter++] = cNext;
+                }
+                else if (cNext == '\n')
+                {
+                    vGetLine(ROMFile);
+                }
+                else if (cNext == 'z')
+                {
+                    bIsEnd = true;
+                }
+                else if (cNext != ' ')
+                {
+                    *pMessage << "Invalid input in pep8os.pepo" << endl;
+                    bError = true;
+                    return;
+                }
+                vAdvanceInput(cNext);
+            }
+            if (bIsEnd)
+            {
+                if (cNext != 'z')
+                {
+                    *pMessage << "File must end in 'zz'" << endl;
+                }
+            }
+            ROMFile.close();
+            ROMFile.clear();
+            SetStandardOS ();
+        }
+    }
+}
+
+//**** Recognizes the distributed operating system by its FNV-1a hash
+void Machine::SetStandardOS ()
+{
+    unsigned int iHash = 2166136261u;
+    for (int i = iRomStartAddr; i < MEMORY_SIZE; i++)
+    {
+        iHash = (iHash ^ iMemory[i]) * 16777619u;
+    }
+    bStandardOS = (iHash == STANDARD_OS_CHECKSUM);
+}
+
+//**** Installs the ROM and trap table of a machine that has already read
+//**** trap and pep8os.pepo, without opening the files again
+void Machine::CopyRom (const Machine& source)
+{
+    iRomStartAddr = source.iRomStartAddr;
+    memcpy (iMemory + iRomStartAddr, source.iMemory + iRomStartAddr,
+            MEMORY_SIZE - iRomStartAddr);
+    memcpy (TrapMnemon, source.TrapMnemon, sizeof (TrapMnemon));
+    bStandardTraps = source.bStandardTraps;
+    bStandardOS = source.bStandardOS;
+}
+
+//**** Header of pep8os.img.  The sizes and FNV-1a hashes of trap and
+//**** pep8os.pepo tell whether the image is stale.  The image is a local
+//**** cache in the byte order of the machine that wrote it.
+const char cImageMagic[8] = {'P', 'E', 'P', '8', 'I', 'M', 'G', '2'};
+struct sImageHeaderType
+{
+    char cMagic[8];
+    long long lTrapSize, lOSSize;
+    unsigned int iTrapHash, iOSHash;
+    int iRomStartAddr;
+    bool bStandardTraps;
+    bool bStandardOS;
+    char TrapMnemon[TRAPS][MNEMON_LENGTH + 1];
+};
+
+//**** Fills in the source file stamps of an image header
+bool bStampSources (sImageHeaderType& header)
+{
+    return bHashFile ("trap", header.lTrapSize, header.iTrapHash)
+        && bHashFile (cRomFileName (), header.lOSSize, header.iOSHash);
+}
+
+bool Machine::bInstallImage ()
+{
+    sImageHeaderType header, sources;
+    uint8_t iRom[MEMORY_SIZE];
+    ifstream imageFile ("pep8os.img", ios::binary);
+    if (!imageFile.is_open() || !bStampSources (sources))
+    {
+        return false;
+    }
+    imageFile.read (reinterpret_cast <char*> (&header), sizeof (header));
+    if (imageFile.gcount() != sizeof (header)
+        || memcmp (header.cMagic, cImageMagic, sizeof (cImageMagic)) != 0
+        || header.lTrapSize != sources.lTrapSize || header.iTrapHash != sources.iTrapHash
+        || header.lOSSize != sources.lOSSize || header.iOSHash != sources.iOSHash
+        || header.iRomStartAddr <= 0 || header.iRomStartAddr > MEMORY_SIZE)
+    {
+        return false;
+    }
+    imageFile.read (reinterpret_cast <char*> (iRom), MEMORY_SIZE - header.iRomStartAddr);
+    if (imageFile.gcount() != MEMORY_SIZE - header.iRomStartAddr)
+    {
+        return false;
+    }
+    iRomStartAddr = header.iRomStartAddr;
+    memcpy (iMemory + iRomStartAddr, iRom, MEMORY_SIZE - iRomStartAddr);
+    memcpy (TrapMnemon, header.TrapMnemon, sizeof (TrapMnemon));
+    bStandardTraps = header.bStandardTraps;
+    bStandardOS = header.bStandardOS;
+    return true;
+}
+
+//**** Writes the image under a temporary name and renames it, so that a
+//**** simulator starting at the same time never reads half an image.
+//**** A directory that cannot be written to just goes without the cache.
+void Machine::SaveImage ()
+{
+    sImageHeaderType header;
+    ostringstream tempName;
+    memset (&header, 0, sizeof (header));
+    if (!bStampSources (header))
+    {
+        return;
+    }
+    memcpy (header.cMagic, cImageMagic, sizeof (cImageMagic));
+    header.iRomStartAddr = iRomStartAddr;
+    header.bStandardTraps = bStandardTraps;
+    header.bStandardOS = bStandardOS;
+    memcpy (header.TrapMnemon, TrapMnemon, sizeof (TrapMnemon));
+    tempName << "pep8os.img." << getpid();
+    ofstream imageFile (tempName.str().c_str(), ios::binary);
+    imageFile.write (reinterpret_cast <const char*> (&header), sizeof (header));
+    imageFile.write (reinterpret_cast <const char*> (iMemory + iRomStartAddr),
+                     MEMORY_SIZE - iRomStartAddr);
+    imageFile.close();
+    if (imageFile.fail() || rename (tempName.str().c_str(), "pep8os.img") != 0)
+    {
+        remove (tempName.str().c_str());
+    }
+}
+
+void Machine::Reset ()
+{
+    for (int iPage = 0; iPage < MEMORY_SIZE / PAGE_SIZE; iPage++)
+    {
+        if (iDirtyPage[iPage])
+        {
+            int iStart = iPage * PAGE_SIZE;
+            int iEnd = (iStart + PAGE_SIZE < iRomStartAddr) ? iStart + PAGE_SIZE : iRomStartAddr;
+            if (iEnd > iStart)
+            {
+                memset (iMemory + iStart, 0, iEnd - iStart);  // RAM is clear after InstallRom
+            }
+            iDirtyPage[iPage] = 0;
+        }
+    }
+    if (bBreakpoints || bWatchpoints)
+    {
+        memset (iBreakMap, 0, sizeof (iBreakMap));
+        bBreakpoints = false;
+        bWatchpoints = false;
+    }
+    ClearBlocks ();
+    CloseBinaryTrace ();
+    SetKeyboardInput ();
+    SetScreenOutput ();
+    SetMessageStream (cout);
+    ClearExpectedOutput ();
+    bBlockInvalidated = false;
+    lTransBlocks = 0;
+    lHistoryCount = 0;
+    bAtBreak = false;
+    bAtLimit = false;
+    bResumeBreak = false;
+    bBreakHit = false;
+    bWatchHit = false;
+    bLoading = false;
+    bMachineReset = false;
+    bStopped = false;
+    bBufferIsEmpty = true;
+    pLine = cLine;
+    iLineIndex = 0;
+    StartWatchdog (0, 0);
+    sR_Accumulator = 0;
+    sR_IndexRegister = 0;
+    sR_StackPointer = 0;
+    sR_ProgramCounter = 0;
+    sIR_InstrRegister.iInstr_Spec = 0;
+    sIR_InstrRegister.sR_OprndSpec = 0;
+    SetStatusBits (0);
+}
+
+//**** Header of a checkpoint file, which is followed by all of memory.
+//**** A checkpoint is in the byte order of the machine that wrote it.
+const char cCheckpointMagic[8] = {'P', 'E', 'P', '8', 'C', 'K', 'P', '1'};
+struct sCheckpointHeaderType
+{
+    char cMagic[8];
+    int iRomStartAddr;
+    sRegisterType Accumulator, IndexRegister, StackPointer, ProgramCounter;
+    int iInstr_Spec;
+    sRegisterType OprndSpec;
+    int iStatusBits;
+    bool bStopped;
+    bool bAtBreak;
+    bool bAtLimit;
+    bool bKeyboardInput;
+    bool bBufferIsEmpty;
+    long long lChariPos;                // Start of the next CHARI line
+    long long lLineOffset;              // Of the current line in the file, -1 for cLine
+    int iLineIndex;
+    long long lCharoPos;                // Bytes of CHARO output, -1 if not a file
+    char cLine[LINE_LENGTH];
+};
+
+bool Machine::bSaveCheckpoint (const char* cFileName)
+{
+    sCheckpointHeaderType header;
+    memset (&header, 0, sizeof (header));
+    memcpy (header.cMagic, cCheckpointMagic, sizeof (cCheckpointMagic));
+    vFlushCharo ();
+    header.iRomStartAddr = iRomStartAddr;
+    header.Accumulator = sR_Accumulator;
+    header.IndexRegister = sR_IndexRegister;
+    header.StackPointer = sR_StackPointer;
+    header.ProgramCounter = sR_ProgramCounter;
+    header.iInstr_Spec = sIR_InstrRegister.iInstr_Spec;
+    header.OprndSpec = sIR_InstrRegister.sR_OprndSpec;
+    header.iStatusBits = iStatusBits ();
+    header.bStopped = bStopped;
+    header.bAtBreak = bAtBreak;
+    header.bAtLimit = bAtLimit;
+    header.bKeyboardInput = bKeyboardInput;
+    header.bBufferIsEmpty = bBufferIsEmpty;
+    header.lChariPos = iChariPos;
+    header.lLineOffset = -1;
+    header.iLineIndex = iLineIndex;
+    memcpy (header.cLine, cLine, sizeof (cLine));
+    if (pLine != cLine && !bKeyboardInput)
+    {
+        header.lLineOffset = pLine - sChariText.data();
+    }
+    header.lCharoPos = -1;
+    if (pCharoOutput == &charoOutputStream)
+    {
+        header.lCharoPos = charoOutputStream.tellp();
+    }
+    ofstream checkpointFile (cFileName, ios::binary);
+    if (!checkpointFile.is_open())
+    {
+        return false;
+    }
+    checkpointFile.write (reinterpret_cast <const char*> (&header), sizeof (header));
+    checkpointFile.write (reinterpret_cast <const char*> (iMemory), MEMORY_SIZE);
+    checkpointFile.close();
+    return !checkpointFile.fail();
+}
+
+//**** The CHARI input must be the file of the checkpoint, or one that
+//**** starts the same way, if the checkpoint read from a file.  An output
+//**** file longer than the output of the checkpoint is cut back to it;
+//**** output to a shorter one continues at its end.
+bool Machine::bRestoreCheckpoint (const char* cFileName)
+{
+    sCheckpointHeaderType header;
+    ifstream checkpointFile (cFileName, ios::binary);
+    if (!checkpointFile.is_open())
+    {
+        *pMessage << "Could not open checkpoint file " << cFileName << endl;
+        return false;
+    }
+    checkpointFile.read (reinterpret_cast <char*> (&header), sizeof (header));
+    if (checkpointFile.gcount() != sizeof (header)
+        || memcmp (header.cMagic, cCheckpointMagic, sizeof (cCheckpointMagic)) != 0
+        || header.iRomStartAddr != iRomStartAddr
+        || header.iLineIndex < 0 || header.iLineIndex > LINE_LENGTH)
+    {
+        *pMessage << "Invalid checkpoint file " << cFileName << endl;
+        return false;
+    }
+    if (!header.bKeyboardInput
+        && (bKeyboardInput || header.lChariPos > static_cast <long long> (sChariText.size())
+            || header.lLineOffset >= static_cast <long long> (sChariText.size())))
+    {
+        *pMessage << "Input file does not cover the input read by checkpoint " << cFileName << endl;
+        return false;
+    }
+    checkpointFile.read (reinterpret_cast <char*> (iMemory), MEMORY_SIZE);
+    memset (iDirtyPage, 1, sizeof (iDirtyPage));
+    if (checkpointFile.gcount() != MEMORY_SIZE)
+    {
+        *pMessage << "Invalid checkpoint file " << cFileName << endl;
+        return false;
+    }
+    ClearBlocks ();
+    sR_Accumulator = header.Accumulator;
+    sR_IndexRegister = header.IndexRegister;
+    sR_StackPointer = header.StackPointer;
+    sR_ProgramCounter = header.ProgramCounter;
+    sIR_InstrRegister.iInstr_Spec = header.iInstr_Spec & 0xFF;
+    sIR_InstrRegister.sR_OprndSpec = header.OprndSpec;
+    SetStatusBits (header.iStatusBits);
+    bMachineReset = true;
+    bLoading = false;
+    bStopped = header.bStopped;
+    bAtBreak = header.bAtBreak;
+    bAtLimit = header.bAtLimit;
+    bResumeBreak = false;
+    lHistoryCount = 0;
+    lExpectedPos = (header.lCharoPos > 0) ? header.lCharoPos : 0;  // Compared before the checkpoint
+    lFirstMismatch = -1;
+    bMismatchHalt = false;
+    memset (lSpecCount, 0, sizeof (lSpecCount));
+    memset (lFusedCount, 0, sizeof (lFusedCount));
+    if (bProfile)
+    {
+        memset (lAddrCount, 0, sizeof (lAddrCount));
+    }
+    ResetCallGraph ();
+    lRomCount = 0;
+    lTransCount = 0;
+    dRunSeconds = 0;
+    memcpy (cLine, header.cLine, sizeof (cLine));
+    pLine = cLine;
+    iLineIndex = header.iLineIndex;
+    bBufferIsEmpty = header.bBufferIsEmpty;
+    if (!header.bKeyboardInput)
+    {
+        iChariPos = header.lChariPos;
+        if (header.lLineOffset >= 0)
+        {
+            pLine = sChariText.data() + header.lLineOffset;
+        }
+    }
+    if (header.lCharoPos >= 0 && pCharoOutput == &charoOutputStream)
+    {
+        struct stat outputStat;
+        vFlushCharo ();
+        charoOutputStream.close();
+        if (stat (sCharoFileName.c_str(), &outputStat) == 0 && outputStat.st_size > header.lCharoPos
+            && truncate (sCharoFileName.c_str(), header.lCharoPos) != 0)
+        {
+            *pMessage << "Could not cut back output file " << sCharoFileName << endl;
+        }
+        charoOutputStream.clear();
+        charoOutputStream.open (sCharoFileName.c_str(), ios::out | ios::app);
+        if (!charoOutputStream.is_open())
+        {
+            *pMessage << "Error opening file " << sCharoFileName << endl;
+            SetScreenOutput ();
+            return false;
+        }
+    }
+    return true;
+}
+
+void PrintLine (ostream& output)
+{
+    output << "--------------------------------------------------";
+    output << "-----------------------" << endl;
+}
+
+void PrintHeading (ostream& output)
+{
+    PrintLine (output);
+    output << "               Oprnd     Instr           Index   Stack   Status" << endl;
+    output << "Addr  Mnemon   Spec       Reg     Accum   Reg   Pointer  N Z V C  Operand" << endl;
+    PrintLine (output);
+}
+
+//**** Fills in a trace record from the registers, except the operand
+inline void Machine::MakeTraceRecord (sRegisterType Address, sTraceRecType& record)
+{
+    record.Address = Address;
+    record.iInstr_Spec = sIR_InstrRegister.iInstr_Spec;
+    record.OprndSpec = sIR_InstrRegister.sR_OprndSpec;
+    record.Accumulator = sR_Accumulator;
+    record.IndexRegister = sR_IndexRegister;
+    record.StackPointer = sR_StackPointer;
+    SettleVC ();
+    record.bN = bStatusN ();
+    record.bZ = bStatusZ ();
+    record.bV = bStatusV;
+    record.bC = bStatusC;
+}
+
+void Machine::PrintTraceLine (ostream& output, sRegisterType Address)
+{
+    sTraceRecType record;
+    MakeTraceRecord (Address, record);
+    record.Operand = 0;
+    if (!sDecodeTable[record.iInstr_Spec].bUnary)
+    {
+        LoadReg (record.Operand);   // calculate operand
+    }
+    PrintTraceRecord (output, record);
+}
+
+//**** Prints the address and instruction columns of a trace line
+void Machine::PrintTraceInstr (ostream& output, const sTraceRecType& record)
+{
+    char cHexByte[HEX_BYTE_LENGTH + 1];
+    char cHexWord[HEX_WORD_LENGTH + 1];
+    RegToHex (record.Address, cHexWord);
+    output << cHexWord << "  "; // Print address
+    PrntMnemon (output, record.iInstr_Spec);    // Print mnemonic
+    if (sDecodeTable[record.iInstr_Spec].bUnary)
+    {
+        output << "                   ";
+    }
+    else
+    {
+        RegToHex (record.OprndSpec, cHexWord);
+        output << cHexWord << ",";
+        switch (sDecodeTable[record.iInstr_Spec].eAddrMode)
+        {         
+        case eA_IMMEDIATE: output << "i    "; break;
+        case eA_DIRECT: output << "d    "; break;
+        case eA_INDIRECT: output << "n    "; break;
+        case eA_STACK_REL: output << "s    "; break;
+        case eA_STACK_REL_DEF: output << "sf   "; break;
+        case eA_INDEXED: output << "x    "; break;
+        case eA_STACK_IND: output << "sx   "; break;
+        case eA_STACK_IND_DEF: output << "sxf  "; break;
+        }
+      
+        vDecToHexByte (record.iInstr_Spec, cHexByte);
+        output << cHexByte;
+        RegToHex (record.OprndSpec, cHexWord);
+        output << cHexWord << "   ";    // Print instruction reg
+    }
+}
+
+void Machine::PrintTraceRecord (ostream& output, const sTraceRecType& record)
+{
+    char cHexWord[HEX_WORD_LENGTH + 1];
+    PrintTraceInstr (output, record);
+    RegToHex (record.Accumulator, cHexWord);
+    output << cHexWord << "   ";                // Print accumulator
+    RegToHex (record.IndexRegister, cHexWord);
+    output << cHexWord << "    ";               // Print index register
+    RegToHex (record.StackPointer, cHexWord);
+    output << cHexWord << "    ";               // Print stack pointer
+    output << record.bN << " " << record.bZ << " " << record.bV << " " << record.bC << "   ";  // Print status bit
+    if (sDecodeTable[record.iInstr_Spec].bUnary)
+    {
+        for (int i = 0; i < HEX_WORD_LENGTH; i++)
+        {
+            cHexWord[i] = '0';
+        }
+    }
+    else
+    {
+        RegToHex (record.Operand, cHexWord);
+    }
+    output << cHexWord; // Print iMemory [Oprnd Spec]
+}
+
+//**** Binary trace file: the 8 byte magic number, the ROM start address and
+//**** the trap mnemonics, then one record per instruction, all big-endian:
+//****   address, instruction specifier, NZVC in the low four bits,
+//****   operand specifier, A, X, SP, and the operand as the trace shows it.
+const char cTraceMagic[8] = {'P', 'E', 'P', '8', 'T', 'R', 'C', '1'};
+
+bool Machine::bOpenBinaryTrace (const char* cFileName)
+{
+    CloseBinaryTrace ();
+    binaryTraceStream.open (cFileName, ios::binary);
+    if (!binaryTraceStream.is_open())
+    {
+        binaryTraceStream.clear();
+        return false;
+    }
+    binaryTraceStream.write (cTraceMagic, sizeof (cTraceMagic));
+    binaryTraceStream.put (static_cast <char> (iRomStartAddr >> 8));
+    binaryTraceStream.put (static_cast <char> (iRomStartAddr & 0xFF));
+    for (int i = 0; i < TRAPS; i++)
+    {
+        binaryTraceStream.write (TrapMnemon[i], MNEMON_LENGTH);
+    }
+    traceBuffer.resize (TRACE_BUFFER_SIZE);
+    iTraceCount = 0;
+    return true;
+}
+
+void Machine::CloseBinaryTrace ()
+{
+    if (binaryTraceStream.is_open())
+    {
+        binaryTraceStream.write (reinterpret_cast <char*> (&traceBuffer[0]), iTraceCount);
+        binaryTraceStream.close();
+    }
+    binaryTraceStream.clear();
+    iTraceCount = 0;
+}
+
+void Machine::WriteTraceRecord (sRegisterType Address)
+{
+    sTraceRecType record;
+    if (iTraceCount + TRACE_RECORD_SIZE > traceBuffer.size())
+    {
+        binaryTraceStream.write (reinterpret_cast <char*> (&traceBuffer[0]), iTraceCount);
+        iTraceCount = 0;
+    }
+    MakeTraceRecord (Address, record);
+    record.Operand = 0;
+    if (!sDecodeTable[record.iInstr_Spec].bUnary)
+    {
+        LoadReg (record.Operand);
+    }
+    uint8_t* pRecord = &traceBuffer[iTraceCount];
+    pRecord[0] = record.Address >> 8;
+    pRecord[1] = record.Address & 0xFF;
+    pRecord[2] = record.iInstr_Spec;
+    pRecord[3] = (record.bN << 3) | (record.bZ << 2) | (record.bV << 1) | record.bC;
+    pRecord[4] = record.OprndSpec >> 8;
+    pRecord[5] = record.OprndSpec & 0xFF;
+    pRecord[6] = record.Accumulator >> 8;
+    pRecord[7] = record.Accumulator & 0xFF;
+    pRecord[8] = record.IndexRegister >> 8;
+    pRecord[9] = record.IndexRegister & 0xFF;
+    pRecord[10] = record.StackPointer >> 8;
+    pRecord[11] = record.StackPointer & 0xFF;
+    pRecord[12] = record.Operand >> 8;
+    pRecord[13] = record.Operand & 0xFF;
+    iTraceCount += TRACE_RECORD_SIZE;
+}
+
+//**** Prints each record of a binary trace with PrintTraceRecord
+bool Machine::bDecodeBinaryTrace (istream& input, ostream& output, bool bTraps,
+                                  bool& bTruncated)
+{
+    char cHeader[sizeof (cTraceMagic) + 2];
+    uint8_t iRecord[TRACE_RECORD_SIZE];
+    sTraceRecType record;
+    input.read (cHeader, sizeof (cHeader));
+    if (input.gcount() != sizeof (cHeader)
+        || memcmp (cHeader, cTraceMagic, sizeof (cTraceMagic)) != 0)
+    {
+        return false;
+    }
+    iRomStartAddr = (static_cast <uint8_t> (cHeader[8]) << 8) | static_cast <uint8_t> (cHeader[9]);
+    for (int i = 0; i < TRAPS; i++)
+    {
+        input.read (TrapMnemon[i], MNEMON_LENGTH);
+        TrapMnemon[i][MNEMON_LENGTH] = '\0';
+        if (input.gcount() != MNEMON_LENGTH)
+        {
+            return false;
+        }
+    }
+    output << (bTraps ? "User Program Trace with Traps:" : "User Program Trace:") << endl;
+    output << endl;
+    PrintHeading (output);
+    while (input.read (reinterpret_cast <char*> (iRecord), TRACE_RECORD_SIZE))
+    {
+        record.Address = (iRecord[0] << 8) | iRecord[1];
+        if (record.Address < iRomStartAddr || bTraps)
+        {
+            record.iInstr_Spec = iRecord[2];
+            record.bN = (iRecord[3] & 8) != 0;
+            record.bZ = (iRecord[3] & 4) != 0;
+            record.bV = (iRecord[3] & 2) != 0;
+            record.bC = (iRecord[3] & 1) != 0;
+            record.OprndSpec = (iRecord[4] << 8) | iRecord[5];
+            record.Accumulator = (iRecord[6] << 8) | iRecord[7];
+            record.IndexRegister = (iRecord[8] << 8) | iRecord[9];
+            record.StackPointer = (iRecord[10] << 8) | iRecord[11];
+            record.Operand = (iRecord[12] << 8) | iRecord[13];
+            PrintTraceRecord (output, record);
+            output << endl;
+        }
+    }
+    bTruncated = (input.gcount() != 0);              // Part of a last record
+    PrintLine (output);
+    return true;
+}
+
+void Machine::PrintHistory (ostream& output)
+{
+    unsigned long lFirst = lHistoryCount > HISTORY_SIZE ? lHistoryCount - HISTORY_SIZE : 0;
+    sTraceRecType record;
+    if (lHistoryCount == 0)
+    {
+        return;
+    }
+    output << endl << "Last " << lHistoryCount - lFirst << " instructions executed:" << endl;
+    PrintHeading (output);
+    for (unsigned long l = lFirst; l + 1 < lHistoryCount; l++)
+    {
+        record.Address = HistoryAddr[l & (HISTORY_SIZE - 1)];
+        record.iInstr_Spec = iMemory[record.Address];
+        MemRead (record.Address + 1, record.OprndSpec);
+        PrintTraceInstr (output, record);
+        output << endl;
+    }
+    PrintTraceLine (output, HistoryAddr[(lHistoryCount - 1) & (HISTORY_SIZE - 1)]);
+    output << endl;
+    PrintLine (output);
+}
+
+char GetTracePrompt ()
+{
+    char cResponse[LINE_LENGTH];
+    char ch;
+    do
+    {
+        cin.getline(cResponse, LINE_LENGTH);
+        ch = toupper(cResponse[0]);
+        if (ch != 'N' && ch != 'C' && ch != 'S' && ch != 'Q' && ch != ' ')
+        {
+            cout << "Invalid response" << endl;
+            cout << "(n)ext page  s(c)roll  (s)ingle step  (q)uit trace: ";
+        }
+    }
+    while (ch != 'N' && ch != 'C' && ch != 'S' && ch != 'Q' && ch != ' ');
+    return ch;
+}
+
+void Machine::Trace (sRegisterType Address, int& LineCount, bool& Halt)
+{
+    int iTempAddr = Address;
+    char ch;
+
+    if (iTempAddr < iRomStartAddr
+        || (iTempAddr >= iRomStartAddr && eTraceMode == eT_TR_TRAPS)
+        || eTraceMode == eT_TR_LOADER)
+    {
+        PrintTraceLine (cout, Address);
+        if (bScrollingTrace)
+        {
+            cout << endl;
+        }
+        else if (bSingleStep)
+        {
+            cout << ": ";
+            ch = GetTracePrompt ();
+            switch (ch)
+            {
+            case 'N':
+                bSingleStep = false;
+                cout << endl;
+                PrintHeading (cout);
+                LineCount = 4;
+                break;
+            case 'C':
+                bSingleStep = false;
+                bScrollingTrace = true;
+                cout << endl;
+                PrintHeading (cout);
+                break;
+            case 'Q':
+                bSingleStep = false;
+                bScrollingTrace = false;
+                cout << endl;
+                PrintLine (cout);
+                Halt = true;
+                break;
+            default:
+                break;
+            }
+        }
+        else  // Not single stepping or scrolling trace to completion
+        {
+            cout << endl;
+            LineCount++;
+            if (LineCount >= numTerminalLines)
+            {
+                cout << "(n)ext page  s(c)roll  (s)ingle step  (q)uit trace: ";
+                ch = GetTracePrompt ();
+                switch (ch)
+                {
+                case 'N':
+                    cout << endl;
+                    PrintHeading (cout);
+                    LineCount = 4;
+                    break;
+                case 'C':
+                    bScrollingTrace = true;
+                    cout << endl;
+                    PrintHeading (cout);
+                    break;
+                case 'S':
+                    bSingleStep = true;
+                    break;
+                case 'Q':
+                    bSingleStep = false;
+                    bScrollingTrace = false;
+                    cout << endl;
+                    PrintLine (cout);
+                    Halt = true;
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    }
+}
+
+//****  The von Neumann execution cycle
+inline void Machine::FetchIncrPC()
+{
+    //**** Fetch instruction spec.
+    MemByteRead (sR_ProgramCounter, sIR_InstrRegister.iInstr_Spec);
+    sR_ProgramCounter++;
+    if (!sDecodeTable[sIR_InstrRegister.iInstr_Spec].bUnary)
+    {
+        MemRead (sR_ProgramCounter, sIR_InstrRegister.sR_OprndSpec);
+        sR_ProgramCounter += 2;
+    }
+}
+
+inline void Machine::Execute (bool& bHalt)
+{
+    sDecodeType& sD_Decode = sDecodeTable[sIR_InstrRegister.iInstr_Spec];
+    eA_AddrMode = sD_Decode.eAddrMode;
+    eR_RegType = sD_Decode.eRegType;
+    nValue = sD_Decode.iNValue;
+    sD_Decode.pSimProc (*this, bHalt);
+}
+
+//**** Block cache execution engine, selected with -b.  Straight-line code
+//**** is fetched and decoded once into a block keyed by its start address.
+//**** A store into cached code invalidates every block that covers it.
+
+//**** Marks the code bytes covered by a block in iCodeMap
+void Machine::MarkBlock (sBlockType* pBlock)
+{
+    for (int i = 0; i < pBlock->iLength; i++)
+    {
+        iCodeMap[(pBlock->iStartAddr + i) & TOP_OF_MEMORY] = 1;
+    }
+}
+
+void Machine::InvalidateBlocks (int iAddr)
+{
+    sBlockType** ppBlock = &pBlockList;
+    sBlockType* pBlock;
+    while (*ppBlock != NULL)
+    {
+        pBlock = *ppBlock;
+        if (((iAddr - pBlock->iStartAddr) & TOP_OF_MEMORY) < pBlock->iLength)
+        {
+            *ppBlock = pBlock->pNext;
+            pBlockCache[pBlock->iStartAddr] = NULL;
+            for (int i = 0; i < pBlock->iLength; i++)
+            {
+                iCodeMap[(pBlock->iStartAddr + i) & TOP_OF_MEMORY] = 0;
+            }
+            pBlock->pNext = pRetiredBlocks;  // Might be executing, free later
+            pRetiredBlocks = pBlock;
+        }
+        else
+        {
+            ppBlock = &pBlock->pNext;
+        }
+    }
+    for (pBlock = pBlockList; pBlock != NULL; pBlock = pBlock->pNext)
+    {
+        MarkBlock (pBlock);                  // Blocks may overlap
+    }
+    bBlockInvalidated = true;
+}
+
+void Machine::FreeRetiredBlocks ()
+{
+    sBlockType* pBlock;
+    while (pRetiredBlocks != NULL)
+    {
+        pBlock = pRetiredBlocks;
+        pRetiredBlocks = pBlock->pNext;
+        DeleteBlock (pBlock);
+    }
+}
+
+//**** Empties the cache, for when memory is replaced as a whole.  Only
+//**** the entries of the cached blocks are cleared, the others are empty.
+void Machine::ClearBlocks ()
+{
+    FreeRetiredBlocks ();
+    while (pBlockList != NULL)
+    {
+        sBlockType* pBlock = pBlockList;
+        pBlockList = pBlock->pNext;
+        pBlockCache[pBlock->iStartAddr] = NULL;
+        for (int i = 0; i < pBlock->iLength; i++)
+        {
+            iCodeMap[(pBlock->iStartAddr + i) & TOP_OF_MEMORY] = 0;
+        }
+        DeleteBlock (pBlock);
+    }
+}
+
+void Machine::DeleteBlock (sBlockType* pBlock)
+{
+    delete [] pBlock->pTrans;
+    delete pBlock;
+}
+
+//**** Fetches and decodes instructions from Addr up to the first one that
+//**** may change the program counter
+sBlockType* Machine::BuildBlock (sRegisterType Addr)
+{
+    sBlockType* pBlock = new sBlockType;
+    sRegisterType PC = Addr;
+    bool bEnd;
+    pBlock->iStartAddr = Addr;
+    pBlock->iLength = 0;
+    pBlock->iInstrCount = 0;
+    pBlock->lRunCount = 0;
+    pBlock->pTrans = NULL;
+    do
+    {
+        sBlockInstrType& sBI = pBlock->sInstr[pBlock->iInstrCount++];
+        sBI.sR_Addr = PC;
+        MemByteRead (PC, sBI.iInstr_Spec);
+        sBI.pDecode = &sDecodeTable[sBI.iInstr_Spec];
+        sBI.iOp = sBI.pDecode->eMnemon;
+        PC++;
+        pBlock->iLength++;
+        if (!sBI.pDecode->bUnary)
+        {
+            MemRead (PC, sBI.sR_OprndSpec);
+            PC += 2;
+            pBlock->iLength += 2;
+        }
+        sBI.sR_NextPC = PC;
+        bEnd = sBI.pDecode->bEndsBlock || pBlock->iInstrCount == MAX_BLOCK_LENGTH
+            || pBlock->iStartAddr + pBlock->iLength > TOP_OF_MEMORY - 2;
+    }
+    while (!bEnd);
+    FuseBlock (pBlock);
+    pBlock->pNext = pBlockList;
+    pBlockList = pBlock;
+    pBlockCache[Addr] = pBlock;
+    MarkBlock (pBlock);
+    return pBlock;
+}
+
+//**** Superinstructions.  FuseBlock looks for the sequences of eFusedType
+//**** that compiled C code is made of, with operands in the immediate,
+//**** direct and stack-relative modes, and RunBlocks executes each one
+//**** with a single dispatch.  The status bits, memory, registers and
+//**** history are left as the separate instructions would leave them.
+
+//**** True if the mode is one a fused instruction may use
+inline bool bFusedMode (const sBlockInstrType& sBI, bool bImmediate)
+{
+    eAddrModeType eMode = sBI.pDecode->eAddrMode;
+    return (bImmediate && eMode == eA_IMMEDIATE) || eMode == eA_DIRECT || eMode == eA_STACK_REL;
+}
+
+void Machine::FuseBlock (sBlockType* pBlock)
+{
+    for (int i = 0; i + 1 < pBlock->iInstrCount; i++)
+    {
+        sBlockInstrType* pInstr = &pBlock->sInstr[i];
+        MnemonicOpcodes eMn0 = pInstr[0].pDecode->eMnemon;
+        MnemonicOpcodes eMn1 = pInstr[1].pDecode->eMnemon;
+        if (eMn0 == eM_LDr && (eMn1 == eM_ADDr || eMn1 == eM_SUBr) && i + 2 < pBlock->iInstrCount
+            && pInstr[2].pDecode->eMnemon == eM_STr
+            && pInstr[1].pDecode->eRegType == pInstr[0].pDecode->eRegType
+            && pInstr[2].pDecode->eRegType == pInstr[0].pDecode->eRegType
+            && bFusedMode (pInstr[0], true) && bFusedMode (pInstr[1], true)
+            && bFusedMode (pInstr[2], false))
+        {
+            pInstr->iOp = (eMn1 == eM_ADDr) ? eF_LOAD_ADD_STORE : eF_LOAD_SUB_STORE;
+            i += 2;
+        }
+        else if (eMn0 == eM_CPr && eM_BRLE <= eMn1 && eMn1 <= eM_BRGT
+                 && pInstr[1].pDecode->eAddrMode == eA_IMMEDIATE && bFusedMode (pInstr[0], true))
+        {
+            pInstr->iOp = eF_COMPARE_BRANCH;
+            i++;
+        }
+        else if (eMn0 == eM_SUBSP && eMn1 == eM_CALL && pInstr[0].pDecode->eAddrMode == eA_IMMEDIATE
+                 && pInstr[1].pDecode->eAddrMode == eA_IMMEDIATE)
+        {
+            pInstr->iOp = eF_SUBSP_CALL;
+            i++;
+        }
+    }
+}
+
+//**** The word operand of a fused instruction that may be immediate
+inline sRegisterType Machine::FusedOperand (const sBlockInstrType* pInstr)
+{
+    sRegisterType Operand;
+    if (pInstr->pDecode->eAddrMode == eA_IMMEDIATE)
+    {
+        return pInstr->sR_OprndSpec;
+    }
+    MemRead (FusedAddr (pInstr), Operand);
+    return Operand;
+}
+
+//**** The operand address of a fused instruction, direct or stack-relative
+inline sRegisterType Machine::FusedAddr (const sBlockInstrType* pInstr)
+{
+    if (pInstr->pDecode->eAddrMode == eA_DIRECT)
+    {
+        return pInstr->sR_OprndSpec;
+    }
+    return sR_StackPointer + pInstr->sR_OprndSpec;
+}
+
+//**** LDr, ADDr or SUBr, STr.  The NZ bits of LDr are replaced by those
+//**** of the addition or subtraction, and STr sets no status bits.
+inline void Machine::FusedArith (const sBlockInstrType* pInstr, bool bSubtract)
+{
+    sRegisterType& Reg = (pInstr->pDecode->eRegType == eR_R_IS_ACCUMULATOR)
+        ? sR_Accumulator : sR_IndexRegister;
+    Reg = FusedOperand (pInstr);
+    if (bSubtract)
+    {
+        SubLazy (Reg, FusedOperand (pInstr + 1));
+    }
+    else
+    {
+        AddLazy (Reg, FusedOperand (pInstr + 1));
+    }
+    MemWrite (Reg, FusedAddr (pInstr + 2));
+}
+
+inline void Machine::FusedCompareBranch (const sBlockInstrType* pInstr)
+{
+    bool bTaken = false;
+    CompareLazy ((pInstr->pDecode->eRegType == eR_R_IS_ACCUMULATOR) ? sR_Accumulator : sR_IndexRegister,
+                 FusedOperand (pInstr));
+    switch (pInstr[1].pDecode->eMnemon)
+    {
+    case eM_BRLE: bTaken = bStatusN () || bStatusZ (); break;
+    case eM_BRLT: bTaken = bStatusN (); break;
+    case eM_BREQ: bTaken = bStatusZ (); break;
+    case eM_BRNE: bTaken = !bStatusZ (); break;
+    case eM_BRGE: bTaken = !bStatusN (); break;
+    case eM_BRGT: bTaken = !bStatusN () && !bStatusZ (); break;
+    default: break;
+    }
+    sR_ProgramCounter = bTaken ? pInstr[1].sR_OprndSpec : pInstr[1].sR_NextPC;
+}
+
+inline void Machine::FusedSubspCall (const sBlockInstrType* pInstr)
+{
+    SubLazy (sR_StackPointer, pInstr->sR_OprndSpec);
+    sR_StackPointer -= 2;
+    MemWrite (pInstr[1].sR_NextPC, sR_StackPointer);
+    sR_ProgramCounter = pInstr[1].sR_OprndSpec;
+}
+
+//**** Counts a fused sequence, records all but its last instruction in the
+//**** history and returns the last, which RunBlocks finishes as usual
+inline sBlockInstrType* Machine::FusedTail (sBlockInstrType* pInstr, eFusedType eForm, int iLength)
+{
+    lFusedCount[eForm - eF_LOAD_ADD_STORE]++;
+    for (int i = 0; i < iLength - 1; i++)
+    {
+        HistoryAddr[lHistoryCount++ & (HISTORY_SIZE - 1)] = pInstr[i].sR_Addr;
+    }
+    pInstr += iLength - 1;
+    sIR_InstrRegister.iInstr_Spec = pInstr->iInstr_Spec;
+    sIR_InstrRegister.sR_OprndSpec = pInstr->sR_OprndSpec;
+    if (!pInstr->pDecode->bEndsBlock)
+    {
+        sR_ProgramCounter = pInstr->sR_NextPC;
+    }
+    return pInstr;
+}
+
+//**** Dispatches with computed goto when compiled with GCC or Clang,
+//**** otherwise with a switch statement
+#ifdef __GNUC__
+#define BLOCK_OP(eMn) l_##eMn:
+#define BLOCK_NEXT    goto l_Next
+#else
+#define BLOCK_OP(eMn) case eMn:
+#define BLOCK_NEXT    break
+#endif
+
+//**** Counts the instructions of a block from pFirst up to pEnd for -s
+//**** and -P
+void Machine::CountBlock (const sBlockInstrType* pFirst, const sBlockInstrType* pEnd)
+{
+    for (const sBlockInstrType* pInstr = pFirst; pInstr < pEnd; pInstr++)
+    {
+        lSpecCount[pInstr->iInstr_Spec]++;
+        lRomCount += (pInstr->sR_NextPC - 1 >= iRomStartAddr);
+        if (bProfile)
+        {
+            lAddrCount[pInstr->sR_Addr]++;
+        }
+    }
+}
+
+//**** Translation of hot blocks, selected with -x.  Once a cached block
+//**** has run HOT_BLOCK_COUNT times, each of its loads, stores, arithmetic
+//**** and compare instructions and its branches and calls in immediate mode
+//**** are bound to a handler compiled for that mnemonic, register and
+//**** addressing mode, so the addressing mode arithmetic and status bits
+//**** take no decoding at run time.  Traps, CHARI, CHARO and every other
+//**** instruction run their Sim routine as in the block cache.  A store
+//**** into a translated block discards it with the cached block.
+
+//**** The address of the operand, as AddrProcessor computes it
+template <eAddrModeType eMode>
+inline sRegisterType Machine::TransAddr (sRegisterType OprndSpec)
+{
+    sRegisterType temp;
+    switch (eMode)
+    {
+    case eA_IMMEDIATE:
+    case eA_DIRECT:
+        return OprndSpec;
+    case eA_INDIRECT:
+        MemRead (OprndSpec, temp);
+        return temp;
+    case eA_STACK_REL:
+        return sR_StackPointer + OprndSpec;
+    case eA_STACK_REL_DEF:
+        MemRead (sR_StackPointer + OprndSpec, temp);
+        return temp;
+    case eA_INDEXED:
+        return sR_IndexRegister + OprndSpec;
+    case eA_STACK_IND:
+        return sR_StackPointer + OprndSpec + sR_IndexRegister;
+    case eA_STACK_IND_DEF:
+        MemRead (sR_StackPointer + OprndSpec, temp);
+        return temp + sR_IndexRegister;
+    }
+    return 0;
+}
+
+//**** The word operand, as LoadReg reads it
+template <eAddrModeType eMode>
+inline sRegisterType Machine::TransOperand (sRegisterType OprndSpec)
+{
+    sRegisterType Operand;
+    if (eMode == eA_IMMEDIATE)
+    {
+        return OprndSpec;
+    }
+    MemRead (TransAddr <eMode> (OprndSpec), Operand);
+    return Operand;
+}
+
+template <MnemonicOpcodes eMn, eRegSpecType eReg, eAddrModeType eMode>
+void Machine::TransOp (Machine& machine, const sTransInstrType& sTI, bool& bHalt)
+{
+    sRegisterType& Reg = (eReg == eR_R_IS_ACCUMULATOR) ? machine.sR_Accumulator
+                                                        : machine.sR_IndexRegister;
+    int iByte;
+    bool bTaken = false;
+    switch (eMn)
+    {
+    case eM_LDr:
+        Reg = machine.TransOperand <eMode> (sTI.sR_OprndSpec);
+        machine.iNZValue = Reg;
+        break;
+    case eM_LDBYTEr:
+        if (eMode == eA_IMMEDIATE)
+        {
+            iByte = sTI.sR_OprndSpec & 0xFF;
+        }
+        else
+        {
+            machine.MemByteRead (machine.TransAddr <eMode> (sTI.sR_OprndSpec), iByte);
+        }
+        Reg = (Reg & 0xFF00) | iByte;
+        machine.iNZValue = Reg;
+        break;
+    case eM_STr:
+        machine.MemWrite (Reg, machine.TransAddr <eMode> (sTI.sR_OprndSpec));
+        break;
+    case eM_STBYTEr:
+        machine.MemByteWrite (Reg & 0xFF, machine.TransAddr <eMode> (sTI.sR_OprndSpec));
+        break;
+    case eM_ADDr:
+        machine.AddLazy (Reg, machine.TransOperand <eMode> (sTI.sR_OprndSpec));
+        break;
+    case eM_SUBr:
+        machine.SubLazy (Reg, machine.TransOperand <eMode> (sTI.sR_OprndSpec));
+        break;
+    case eM_ANDr:
+        Reg &= machine.TransOperand <eMode> (sTI.sR_OprndSpec);
+        machine.iNZValue = Reg;
+        break;
+    case eM_ORr:
+        Reg |= machine.TransOperand <eMode> (sTI.sR_OprndSpec);
+        machine.iNZValue = Reg;
+        break;
+    case eM_CPr:
+        machine.CompareLazy (Reg, machine.TransOperand <eMode> (sTI.sR_OprndSpec));
+        break;
+    case eM_ADDSP:
+        machine.AddLazy (machine.sR_StackPointer, machine.TransOperand <eMode> (sTI.sR_OprndSpec));
+        break;
+    case eM_SUBSP:
+        machine.SubLazy (machine.sR_StackPointer, machine.TransOperand <eMode> (sTI.sR_OprndSpec));
+        break;
+    case eM_CALL:                       // Immediate mode only
+        machine.sR_StackPointer -= 2;
+        machine.MemWrite (sTI.sR_NextPC, machine.sR_StackPointer);
+        machine.sR_ProgramCounter = sTI.sR_OprndSpec;
+        break;
+    case eM_BR:                         // Immediate mode only, as are the rest
+        bTaken = true;
+        break;
+    case eM_BRLE: bTaken = machine.bStatusN () || machine.bStatusZ (); break;
+    case eM_BRLT: bTaken = machine.bStatusN (); break;
+    case eM_BREQ: bTaken = machine.bStatusZ (); break;
+    case eM_BRNE: bTaken = !machine.bStatusZ (); break;
+    case eM_BRGE: bTaken = !machine.bStatusN (); break;
+    case eM_BRGT: bTaken = !machine.bStatusN () && !machine.bStatusZ (); break;
+    default:
+        break;
+    }
+    if (eM_BR <= eMn && eMn <= eM_BRGT)
+    {
+        machine.sR_ProgramCounter = bTaken ? sTI.sR_OprndSpec : sTI.sR_NextPC;
+    }
+}
+
+template <MnemonicOpcodes eMn, eRegSpecType eReg>
+TransProcType Machine::pTransMode (eAddrModeType eMode)
+{
+    switch (eMode)
+    {
+    case eA_IMMEDIATE: return TransOp <eMn, eReg, eA_IMMEDIATE>;
+    case eA_DIRECT: return TransOp <eMn, eReg, eA_DIRECT>;
+    case eA_INDIRECT: return TransOp <eMn, eReg, eA_INDIRECT>;
+    case eA_STACK_REL: return TransOp <eMn, eReg, eA_STACK_REL>;
+    case eA_STACK_REL_DEF: return TransOp <eMn, eReg, eA_STACK_REL_DEF>;
+    case eA_INDEXED: return TransOp <eMn, eReg, eA_INDEXED>;
+    case eA_STACK_IND: return TransOp <eMn, eReg, eA_STACK_IND>;
+    case eA_STACK_IND_DEF: return TransOp <eMn, eReg, eA_STACK_IND_DEF>;
+    }
+    return TransSim;
+}
+
+template <MnemonicOpcodes eMn>
+TransProcType Machine::pTransReg (const sDecodeType& sD)
+{
+    if (sD.eRegType == eR_R_IS_ACCUMULATOR)
+    {
+        return pTransMode <eMn, eR_R_IS_ACCUMULATOR> (sD.eAddrMode);
+    }
+    return pTransMode <eMn, eR_R_IS_INDEX_REG> (sD.eAddrMode);
+}
+
+//**** Runs the Sim routine of an instruction the translator leaves alone,
+//**** with the machine state the block cache would give it
+void Machine::TransSim (Machine& machine, const sTransInstrType& sTI, bool& bHalt)
+{
+    const sBlockInstrType* pSource = sTI.pSource;
+    machine.sIR_InstrRegister.iInstr_Spec = pSource->iInstr_Spec;
+    machine.sIR_InstrRegister.sR_OprndSpec = pSource->sR_OprndSpec;
+    machine.sR_ProgramCounter = pSource->sR_NextPC;
+    machine.eA_AddrMode = pSource->pDecode->eAddrMode;
+    machine.eR_RegType = pSource->pDecode->eRegType;
+    machine.nValue = pSource->pDecode->iNValue;
+    pSource->pDecode->pSimProc (machine, bHalt);
+}
+
+//**** The handler of an instruction in a translated block
+TransProcType Machine::pTranslate (const sDecodeType& sD)
+{
+    bool bImmediate = (sD.eAddrMode == eA_IMMEDIATE);
+    switch (sD.eMnemon)
+    {
+    case eM_LDr: return pTransReg <eM_LDr> (sD);
+    case eM_LDBYTEr: return pTransReg <eM_LDBYTEr> (sD);
+    case eM_STr: return bImmediate ? TransSim : pTransReg <eM_STr> (sD);
+    case eM_STBYTEr: return bImmediate ? TransSim : pTransReg <eM_STBYTEr> (sD);
+    case eM_ADDr: return pTransReg <eM_ADDr> (sD);
+    case eM_SUBr: return pTransReg <eM_SUBr> (sD);
+    case eM_ANDr: return pTransReg <eM_ANDr> (sD);
+    case eM_ORr: return pTransReg <eM_ORr> (sD);
+    case eM_CPr: return pTransReg <eM_CPr> (sD);
+    case eM_ADDSP: return pTransMode <eM_ADDSP, eR_R_IS_ACCUMULATOR> (sD.eAddrMode);
+    case eM_SUBSP: return pTransMode <eM_SUBSP, eR_R_IS_ACCUMULATOR> (sD.eAddrMode);
+    case eM_CALL: return bImmediate ? TransOp <eM_CALL, eR_R_IS_ACCUMULATOR, eA_IMMEDIATE> : TransSim;
+    case eM_BR: return bImmediate ? TransOp <eM_BR, eR_R_IS_ACCUMULATOR, eA_IMMEDIATE> : TransSim;
+    case eM_BRLE: return bImmediate ? TransOp <eM_BRLE, eR_R_IS_ACCUMULATOR, eA_IMMEDIATE> : TransSim;
+    case eM_BRLT: return bImmediate ? TransOp <eM_BRLT, eR_R_IS_ACCUMULATOR, eA_IMMEDIATE> : TransSim;
+    case eM_BREQ: return bImmediate ? TransOp <eM_BREQ, eR_R_IS_ACCUMULATOR, eA_IMMEDIATE> : TransSim;
+    case eM_BRNE: return bImmediate ? TransOp <eM_BRNE, eR_R_IS_ACCUMULATOR, eA_IMMEDIATE> : TransSim;
+    case eM_BRGE: return bImmediate ? TransOp <eM_BRGE, eR_R_IS_ACCUMULATOR, eA_IMMEDIATE> : TransSim;
+    case eM_BRGT: return bImmediate ? TransOp <eM_BRGT, eR_R_IS_ACCUMULATOR, eA_IMMEDIATE> : TransSim;
+    default: return TransSim;
+    }
+}
+
+void Machine::TranslateBlock (sBlockType* pBlock)
+{
+    pBlock->pTrans = new sTransInstrType[pBlock->iInstrCount];
+    for (int i = 0; i < pBlock->iInstrCount; i++)
+    {
+        const sBlockInstrType& sBI = pBlock->sInstr[i];
+        sTransInstrType& sTI = pBlock->pTrans[i];
+        sTI.pTransProc = pTranslate (*sBI.pDecode);
+        sTI.sR_OprndSpec = sBI.sR_OprndSpec;
+        sTI.sR_Addr = sBI.sR_Addr;
+        sTI.sR_NextPC = sBI.sR_NextPC;
+        sTI.pSource = &sBI;
+    }
+    lTransBlocks++;
+}
+
+//**** Runs a translated block, up to an instruction that halts or stores
+//**** into cached code, and returns the number of instructions it ran.
+//**** Only TransSim and the handlers of instructions that end a block set
+//**** the program counter, so it is set here after any other.
+inline int Machine::RunTranslated (const sBlockType* pBlock, bool& Halt)
+{
+    const sTransInstrType* pFirst = pBlock->pTrans;
+    const sTransInstrType* pLast = pFirst + pBlock->iInstrCount;
+    const sTransInstrType* pTI = pFirst;
+    do
+    {
+        pTI->pTransProc (*this, *pTI, Halt);
+        HistoryAddr[lHistoryCount++ & (HISTORY_SIZE - 1)] = pTI->sR_Addr;
+    }
+    while (++pTI < pLast && !Halt && !bBlockInvalidated);
+    const sBlockInstrType* pSource = pTI[-1].pSource;
+    sIR_InstrRegister.iInstr_Spec = pSource->iInstr_Spec;
+    sIR_InstrRegister.sR_OprndSpec = pSource->sR_OprndSpec;
+    if (pTI[-1].pTransProc != TransSim && !pSource->pDecode->bEndsBlock)
+    {
+        sR_ProgramCounter = pSource->sR_NextPC;
+    }
+    return pTI - pFirst;
+}
+
+void Machine::RunBlocks (bool& Halt)
+{
+#ifdef __GNUC__
+    static void* pDispatch[] =
+    {
+        &&l_eM_STOP, &&l_eM_RETTR, &&l_eM_MOVSPA, &&l_eM_MOVFLGA, &&l_eM_BR,
+        &&l_eM_BRLE, &&l_eM_BRLT, &&l_eM_BREQ, &&l_eM_BRNE, &&l_eM_BRGE,
+        &&l_eM_BRGT, &&l_eM_BRV, &&l_eM_BRC, &&l_eM_CALL, &&l_eM_NOTr,
+        &&l_eM_NEGr, &&l_eM_ASLr, &&l_eM_ASRr, &&l_eM_ROLr, &&l_eM_RORr,
+        &&l_eM_UNIMP0, &&l_eM_UNIMP1, &&l_eM_UNIMP2, &&l_eM_UNIMP3,
+        &&l_eM_UNIMP4, &&l_eM_UNIMP5, &&l_eM_UNIMP6, &&l_eM_UNIMP7,
+        &&l_eM_CHARI, &&l_eM_CHARO, &&l_eM_RETn, &&l_eM_ADDSP, &&l_eM_SUBSP,
+        &&l_eM_ADDr, &&l_eM_SUBr, &&l_eM_ANDr, &&l_eM_ORr, &&l_eM_CPr,
+        &&l_eM_LDr, &&l_eM_LDBYTEr, &&l_eM_STr, &&l_eM_STBYTEr,
+        &&l_eF_LOAD_ADD_STORE, &&l_eF_LOAD_SUB_STORE, &&l_eF_COMPARE_BRANCH,
+        &&l_eF_SUBSP_CALL
+    };
+#endif
+    sBlockType* pBlock;
+    sBlockInstrType* pInstr;
+    sBlockInstrType* pLast;
+    int iExecuted;
+    do
+    {
+        FreeRetiredBlocks ();
+        pBlock = pBlockCache[sR_ProgramCounter];
+        if (pBlock == NULL)
+        {
+            pBlock = BuildBlock (sR_ProgramCounter);
+        }
+        bBlockInvalidated = false;
+        if (bTranslate && pBlock->pTrans == NULL && ++pBlock->lRunCount == HOT_BLOCK_COUNT)
+        {
+            TranslateBlock (pBlock);
+        }
+        if (pBlock->pTrans != NULL)
+        {
+            iExecuted = RunTranslated (pBlock, Halt);
+            lTransCount += iExecuted;
+        }
+        else
+        {
+            pInstr = pBlock->sInstr;
+            pLast = pInstr + pBlock->iInstrCount;
+            for (;;)
+            {
+                sIR_InstrRegister.iInstr_Spec = pInstr->iInstr_Spec;
+                sIR_InstrRegister.sR_OprndSpec = pInstr->sR_OprndSpec;
+                sR_ProgramCounter = pInstr->sR_NextPC;
+                eA_AddrMode = pInstr->pDecode->eAddrMode;
+                eR_RegType = pInstr->pDecode->eRegType;
+                nValue = pInstr->pDecode->iNValue;
+#ifdef __GNUC__
+                goto *pDispatch[pInstr->iOp];
+#else
+                switch (pInstr->iOp)
+                {
+#endif
+                BLOCK_OP(eM_STOP) SimSTOP (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_RETTR) SimRETTR (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_MOVSPA) SimMOVSPA (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_MOVFLGA) SimMOVFLGA (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_BR) SimBR (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_BRLE) SimBRLE (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_BRLT) SimBRLT (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_BREQ) SimBREQ (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_BRNE) SimBRNE (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_BRGE) SimBRGE (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_BRGT) SimBRGT (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_BRV) SimBRV (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_BRC) SimBRC (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_CALL) SimCALL (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_NOTr) SimNOTr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_NEGr) SimNEGr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_ASLr) SimASLr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_ASRr) SimASRr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_ROLr) SimROLr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_RORr) SimRORr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_UNIMP0)
+                BLOCK_OP(eM_UNIMP1)
+                BLOCK_OP(eM_UNIMP2)
+                BLOCK_OP(eM_UNIMP3)
+                BLOCK_OP(eM_UNIMP4)
+                BLOCK_OP(eM_UNIMP5)
+                BLOCK_OP(eM_UNIMP6)
+                BLOCK_OP(eM_UNIMP7) SimTRAP (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_CHARI) SimCHARI (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_CHARO) SimCHARO (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_RETn) SimRETn (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_ADDSP) SimADDSP (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_SUBSP) SimSUBSP (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_ADDr) SimADDr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_SUBr) SimSUBr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_ANDr) SimANDr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_ORr) SimORr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_CPr) SimCPr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_LDr) SimLDr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_LDBYTEr) SimLDBYTEr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_STr) SimSTr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eM_STBYTEr) SimSTBYTEr (Halt); BLOCK_NEXT;
+                BLOCK_OP(eF_LOAD_ADD_STORE)
+                    FusedArith (pInstr, false);
+                    pInstr = FusedTail (pInstr, eF_LOAD_ADD_STORE, 3);
+                    BLOCK_NEXT;
+                BLOCK_OP(eF_LOAD_SUB_STORE)
+                    FusedArith (pInstr, true);
+                    pInstr = FusedTail (pInstr, eF_LOAD_SUB_STORE, 3);
+                    BLOCK_NEXT;
+                BLOCK_OP(eF_COMPARE_BRANCH)
+                    FusedCompareBranch (pInstr);
+                    pInstr = FusedTail (pInstr, eF_COMPARE_BRANCH, 2);
+                    BLOCK_NEXT;
+                BLOCK_OP(eF_SUBSP_CALL)
+                    FusedSubspCall (pInstr);
+                    pInstr = FusedTail (pInstr, eF_SUBSP_CALL, 2);
+                    BLOCK_NEXT;
+#ifdef __GNUC__
+            l_Next:
+#else
+                }
+#endif
+                HistoryAddr[lHistoryCount++ & (HISTORY_SIZE - 1)] = pInstr->sR_Addr;
+                if (Halt || bBlockInvalidated)
+                {
+                    pInstr++;
+                    break;
+                }
+                if (++pInstr == pLast)
+                {
+                    break;
+                }
+            }
+            iExecuted = pInstr - pBlock->sInstr;
+        }
+        lInstrLeft -= iExecuted;
+        if (bStatistics || bProfile)
+        {
+            CountBlock (pBlock->sInstr, pBlock->sInstr + iExecuted);
+        }
+        if (lInstrLeft < MAX_BLOCK_LENGTH && !Halt)
+        {
+            WatchdogSlice (Halt);
+        }
+    }
+    while (!Halt && lInstrLeft >= MAX_BLOCK_LENGTH);
+    FreeRetiredBlocks ();
+}
+
+//**** The von Neumann execution cycle, specialized at compile time on the
+//**** trace mode so that untraced execution carries no trace bookkeeping,
+//**** and on bDebug so that only a run with breakpoints checks for them
+template <eTraceMd eMode, bool bRecord, bool bDebug>
+void Machine::RunInterpreter (bool& Halt, int& iLineCount)
+{
+    sRegisterType TraceAddr;
+    do
+    {
+        TraceAddr = sR_ProgramCounter;
+        if (bDebug)
+        {
+            if (bBreakBit (eB_EXECUTE, TraceAddr) && !bResumeBreak)
+            {
+                bBreakHit = true;
+                Halt = true;
+                break;
+            }
+            bResumeBreak = false;
+        }
+        FetchIncrPC();
+        if (bDebug)
+        {
+            bWatchHit = false;  // Only the accesses of Execute are watched
+        }
+        if (bStatistics)
+        {
+            lSpecCount[sIR_InstrRegister.iInstr_Spec]++;
+            lRomCount += (TraceAddr >= iRomStartAddr);
+        }
+        if (bProfile)
+        {
+            lAddrCount[TraceAddr]++;
+        }
+        Execute (Halt);
+        if (bDebug && bWatchHit && !Halt)
+        {
+            bBreakHit = true;
+            Halt = true;
+        }
+        if (--lInstrLeft == 0 && !Halt)
+        {
+            WatchdogSlice (Halt);
+        }
+        HistoryAddr[lHistoryCount++ & (HISTORY_SIZE - 1)] = TraceAddr;
+        if (bRecord)
+        {
+            if (binaryTraceStream.is_open())
+            {
+                WriteTraceRecord (TraceAddr);
+            }
+            if (bCallGraph)
+            {
+                TrackCall (Halt);
+            }
+        }
+        if (eMode != eT_TR_OFF)
+        {
+            vFlushCharo ();
+            if (bScreenOutput && sDecodeTable[sIR_InstrRegister.iInstr_Spec].eMnemon == eM_CHARO)
+            {
+                cout << endl;   // Keep CHARO output off the trace line
+            }
+            Trace (TraceAddr, iLineCount, Halt);
+        }
+    }
+    while (!Halt);
+}
+
+void Machine::StartExecution ()
+{
+    bool Halt;
+    int iLineCount;
+    if (!bMachineReset && !bLoading)
+    {
+        *pMessage << "Execution error: Machine state not initialized." << endl;
+        *pMessage << "Use (l)oad command." << endl;
+    }
+    else
+    {
+        if (eTraceMode != eT_TR_OFF && !bSingleStep)
+        {
+            switch (eTraceMode)
+            {
+            case eT_TR_PROGRAM : cout << "User Program Trace:" << endl; break;
+            case eT_TR_TRAPS : cout << "User Program Trace with Traps:" << endl; break;
+            case eT_TR_LOADER : cout << "Loader Trace of Operating System:" << endl; break;
+            case eT_TR_OFF : break;
+            }
+            cout << endl;
+            PrintHeading (cout);
+            iLineCount = 6;
+        }
+        //**** The von Neumann execution cycle
+        Halt = false;
+        bStopped = false;
+        bBreakHit = false;
+        switch (eTraceMode)
+        {
+        case eT_TR_OFF:
+            if (binaryTraceStream.is_open() || (bCallGraph && !bLoading))
+            {
+                RunInterpreter <eT_TR_OFF, true, false> (Halt, iLineCount);
+                break;
+            }
+            if ((bBreakpoints || bWatchpoints) && !bLoading)
+            {
+                RunInterpreter <eT_TR_OFF, false, true> (Halt, iLineCount);
+                break;
+            }
+            if (bBlockCache && lInstrLeft >= MAX_BLOCK_LENGTH)
+            {
+                RunBlocks (Halt);       // Leaves the end of a budget to the interpreter
+            }
+            if (!Halt)
+            {
+                RunInterpreter <eT_TR_OFF, false, false> (Halt, iLineCount);
+            }
+            break;
+        case eT_TR_PROGRAM: RunInterpreter <eT_TR_PROGRAM, false, false> (Halt, iLineCount); break;
+        case eT_TR_TRAPS: RunInterpreter <eT_TR_TRAPS, false, false> (Halt, iLineCount); break;
+        case eT_TR_LOADER: RunInterpreter <eT_TR_LOADER, false, false> (Halt, iLineCount); break;
+        }
+        vFlushCharo ();
+        if (eTraceMode != eT_TR_OFF)
+        {
+            PrintLine (cout);
+        }
+        if (bBreakHit)
+        {
+            PrintBreak ();
+        }
+        else if (!bKeyboardInput && !bBudgetExhausted && !bTimedOut)
+        {
+            iChariPos = 0;  // Reset input file to its beginning
+        }
+    }
+}
+
+
+//**** The execution loops count instructions down in slices of at most
+//**** WATCHDOG_SLICE, so the budget and the clock are looked at only when
+//**** a slice runs out.
+void Machine::StartWatchdog (long lBudget, double dSeconds)
+{
+    lBudgetLeft = lBudget > 0 ? lBudget : LONG_MAX;
+    lInstrLeft = 0;
+    lInstrGiven = 0;
+    bBudgetExhausted = false;
+    bTimedOut = false;
+    bTimeLimit = dSeconds > 0;
+    if (bTimeLimit)
+    {
+        tDeadline = std::chrono::steady_clock::now()
+            + std::chrono::duration_cast <std::chrono::steady_clock::duration>
+              (std::chrono::duration <double> (dSeconds));
+    }
+    bool Halt = false;
+    WatchdogSlice (Halt);
+}
+
+//**** Called when the current slice is empty, or from RunBlocks when it has
+//**** fewer than MAX_BLOCK_LENGTH instructions left.  Halts when the budget
+//**** or the time is used up, otherwise tops up the slice.
+void Machine::WatchdogSlice (bool& Halt)
+{
+    long lSlice;
+    if (bTimeLimit && std::chrono::steady_clock::now() >= tDeadline)
+    {
+        bTimedOut = true;
+        Halt = true;
+    }
+    else if (lBudgetLeft > 0)
+    {
+        lSlice = lBudgetLeft < WATCHDOG_SLICE ? lBudgetLeft : WATCHDOG_SLICE;
+        lBudgetLeft -= lSlice;
+        lInstrLeft += lSlice;
+        lInstrGiven += lSlice;
+    }
+    else if (lInstrLeft == 0)
+    {
+        bBudgetExhausted = true;
+        Halt = true;
+    }
+}
+
+//**** Runs the loader in ROM, which reads the object program from the
+//**** CHARI input binding.  The loader of the distributed operating system
+//**** runs natively unless it is being traced.
+eRunStatus Machine::Load ()
+{
+    bMachineReset = true;
+    bBufferIsEmpty = true;
+    bLoading = true;
+    bAtBreak = false;
+    bAtLimit = false;
+    MemRead (SYSTEM_SP, sR_StackPointer);
+    MemRead (LOADER_PC, sR_ProgramCounter);
+    StartWatchdog (0, 0);
+    if (bBinaryObject && bStandardOS && eTraceMode == eT_TR_OFF)
+    {
+        BinaryLoad ();
+    }
+    else
+    {
+        if (bBinaryObject)
+        {
+            ExpandBinaryObject ();
+        }
+        if (bStandardOS && eTraceMode == eT_TR_OFF)
+        {
+            NativeLoad ();
+        }
+        else
+        {
+            StartExecution ();
+        }
+    }
+    bLoading = false;
+    return bStopped ? eS_STOPPED : eS_RUNTIME_ERROR;
+}
+
+//**** Executes the loaded program from address 0.  With a budget, at most
+//**** lBudget instructions are executed; a native trap counts as one.
+//**** With a time limit, execution stops once dSeconds have passed.
+eRunStatus Machine::Run (long lBudget, double dSeconds)
+{
+    bBufferIsEmpty = true;
+    MemRead (USER_SP, sR_StackPointer);
+    sR_ProgramCounter = 0;
+    StartWatchdog (lBudget, dSeconds);
+    memset (lSpecCount, 0, sizeof (lSpecCount));
+    memset (lFusedCount, 0, sizeof (lFusedCount));
+    if (bProfile)
+    {
+        memset (lAddrCount, 0, sizeof (lAddrCount));
+    }
+    ResetCallGraph ();
+    lRomCount = 0;
+    lTransCount = 0;
+    lHistoryCount = 0;
+    bResumeBreak = false;
+    lExpectedPos = 0;
+    lFirstMismatch = -1;
+    bMismatchHalt = false;
+    std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+    StartExecution ();
+    dRunSeconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - tStart).count();
+    return RunStatus ();
+}
+
+//**** Runs the loaded program with its code translated by pep8aot, with
+//**** no limits.  History and statistics see only the instructions that
+//**** NativeStep executes.
+eRunStatus Machine::RunNative (NativeProgramType pProgram)
+{
+    sNativeStateType state;
+    bool bHalt = false;
+    memset (iDirtyPage, 1, sizeof (iDirtyPage));  // Translated code writes memory directly
+    bBufferIsEmpty = true;
+    MemRead (USER_SP, sR_StackPointer);
+    sR_ProgramCounter = 0;
+    StartWatchdog (0, 0);
+    memset (lSpecCount, 0, sizeof (lSpecCount));
+    memset (lFusedCount, 0, sizeof (lFusedCount));
+    if (bProfile)
+    {
+        memset (lAddrCount, 0, sizeof (lAddrCount));
+    }
+    ResetCallGraph ();
+    lRomCount = 0;
+    lTransCount = 0;
+    lHistoryCount = 0;
+    bStopped = false;
+    bBreakHit = false;
+    SettleVC ();
+    state.A = sR_Accumulator;
+    state.X = sR_IndexRegister;
+    state.SP = sR_StackPointer;
+    state.PC = sR_ProgramCounter;
+    state.iNZValue = iNZValue;
+    state.bV = bStatusV;
+    state.bC = bStatusC;
+    state.lInstrCount = 0;
+    std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+    pProgram (*this, state, bHalt);
+    vFlushCharo ();
+    if (!bKeyboardInput)
+    {
+        iChariPos = 0;  // Reset input file to its beginning
+    }
+    dRunSeconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - tStart).count();
+    return RunStatus ();
+}
+
+void Machine::NativeStep (sNativeStateType& state, bool& bHalt)
+{
+    sRegisterType TraceAddr;
+    lInstrGiven += state.lInstrCount;   // Counted as given and run
+    state.lInstrCount = 0;
+    sR_Accumulator = state.A;
+    sR_IndexRegister = state.X;
+    sR_StackPointer = state.SP;
+    sR_ProgramCounter = state.PC;
+    iNZValue = state.iNZValue;
+    bStatusV = state.bV;
+    bStatusC = state.bC;
+    eVCSource = eV_SETTLED;
+    do
+    {
+        TraceAddr = sR_ProgramCounter;
+        FetchIncrPC ();
+        if (bStatistics)
+        {
+            lSpecCount[sIR_InstrRegister.iInstr_Spec]++;
+            lRomCount += (TraceAddr >= iRomStartAddr);
+        }
+        if (bProfile)
+        {
+            lAddrCount[TraceAddr]++;
+        }
+        Execute (bHalt);
+        if (--lInstrLeft == 0 && !bHalt)
+        {
+            WatchdogSlice (bHalt);
+        }
+        HistoryAddr[lHistoryCount++ & (HISTORY_SIZE - 1)] = TraceAddr;
+    }
+    while (!bHalt && sR_ProgramCounter >= iRomStartAddr);
+    SettleVC ();
+    state.A = sR_Accumulator;
+    state.X = sR_IndexRegister;
+    state.SP = sR_StackPointer;
+    state.PC = sR_ProgramCounter;
+    state.iNZValue = iNZValue;
+    state.bV = bStatusV;
+    state.bC = bStatusC;
+}
+
+//**** Resumes a program stopped at a breakpoint or watchpoint, or by the
+//**** watchdog, with the limits of Run.  The statistics of -s cover the
+//**** whole run.
+eRunStatus Machine::Continue (long lBudget, double dSeconds)
+{
+    if (!bAtBreak && !bAtLimit)
+    {
+        *pMessage << "Execution error: No stopped program to continue." << endl;
+        *pMessage << "Use e(x)ecute command." << endl;
+        return eS_RUNTIME_ERROR;
+    }
+    StartWatchdog (lBudget, dSeconds);
+    bResumeBreak = bAtBreak;
+    std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+    StartExecution ();
+    dRunSeconds += std::chrono::duration <double> (std::chrono::steady_clock::now() - tStart).count();
+    return RunStatus ();
+}
+
+eRunStatus Machine::RunStatus ()
+{
+    bAtBreak = bBreakHit;
+    bAtLimit = !bBreakHit && (bBudgetExhausted || bTimedOut);
+    if (bBreakHit)
+    {
+        return eS_BREAKPOINT;
+    }
+    if (bBudgetExhausted)
+    {
+        return eS_BUDGET_EXHAUSTED;
+    }
+    if (bTimedOut)
+    {
+        return eS_TIMED_OUT;
+    }
+    if (bMismatchHalt)
+    {
+        return eS_OUTPUT_MISMATCH;
+    }
+    return bStopped ? eS_STOPPED : eS_RUNTIME_ERROR;
+}
+
+//**** Reports where a run stopped at a breakpoint or watchpoint, with the
+//**** registers after the last instruction executed
+void Machine::PrintBreak ()
+{
+    char cHexWord[HEX_WORD_LENGTH + 1];
+    if (bWatchHit)
+    {
+        RegToHex (WatchAddr, cHexWord);
+        *pMessage << "Watchpoint: " << (eWatchType == eB_READ ? "read from " : "write to ")
+                  << cHexWord << " by the instruction at ";
+        RegToHex (HistoryAddr[(lHistoryCount - 1) & (HISTORY_SIZE - 1)], cHexWord);
+        *pMessage << cHexWord << "." << endl;
+    }
+    else
+    {
+        RegToHex (sR_ProgramCounter, cHexWord);
+        *pMessage << "Breakpoint at " << cHexWord << "." << endl;
+    }
+    if (lHistoryCount > 0)
+    {
+        PrintHeading (*pMessage);
+        PrintTraceLine (*pMessage, HistoryAddr[(lHistoryCount - 1) & (HISTORY_SIZE - 1)]);
+        *pMessage << endl;
+        PrintLine (*pMessage);
+    }
+    *pMessage << "Use (c)ontinue to resume execution." << endl;
+}
+
+//**** Sets or clears the breakpoints of eType from StartAddress through
+//**** EndAddress
+void Machine::SetBreakpoints (eBreakType eType, sRegisterType StartAddress,
+                              sRegisterType EndAddress, bool bSet)
+{
+    for (int iAddr = StartAddress; iAddr <= EndAddress; iAddr++)
+    {
+        if (bSet)
+        {
+            iBreakMap[eType][iAddr >> 3] |= 1 << (iAddr & 7);
+        }
+        else
+        {
+            iBreakMap[eType][iAddr >> 3] &= ~(1 << (iAddr & 7));
+        }
+    }
+    UpdateBreakFlags ();
+}
+
+void Machine::ClearBreakpoints ()
+{
+    memset (iBreakMap, 0, sizeof (iBreakMap));
+    UpdateBreakFlags ();
+}
+
+void Machine::UpdateBreakFlags ()
+{
+    bool bAny[eB_BREAK_TYPES] = {false, false, false};
+    for (int i = 0; i < eB_BREAK_TYPES; i++)
+    {
+        for (int j = 0; j < MEMORY_SIZE / 8 && !bAny[i]; j++)
+        {
+            bAny[i] = iBreakMap[i][j] != 0;
+        }
+    }
+    bBreakpoints = bAny[eB_EXECUTE];
+    bWatchpoints = bAny[eB_READ] || bAny[eB_WRITE];
+}
+
+//**** Lists the breakpoints of each kind, runs of addresses as ranges
+void Machine::ListBreakpoints (ostream& output)
+{
+    const char* cTitle[eB_BREAK_TYPES] =
+        {"Breakpoints:      ", "Read watchpoints: ", "Write watchpoints:"};
+    char cHexWord[HEX_WORD_LENGTH + 1];
+    bool bNone;
+    int iEnd;
+    for (int i = 0; i < eB_BREAK_TYPES; i++)
+    {
+        output << cTitle[i];
+        bNone = true;
+        for (int iAddr = 0; iAddr < MEMORY_SIZE; iAddr++)
+        {
+            if (bBreakBit (eBreakType (i), iAddr))
+            {
+                for (iEnd = iAddr; iEnd + 1 < MEMORY_SIZE && bBreakBit (eBreakType (i), iEnd + 1); iEnd++)
+                {
+                }
+                RegToHex (iAddr, cHexWord);
+                output << " " << cHexWord;
+                if (iEnd > iAddr)
+                {
+                    RegToHex (iEnd, cHexWord);
+                    output << "-" << cHexWord;
+                }
+                iAddr = iEnd;
+                bNone = false;
+            }
+        }
+        output << (bNone ? " none" : "") << endl;
+    }
+}
+
+void Machine::SetKeyboardInput ()
+{
+    string().swap (sChariText);
+    iChariPos = 0;
+    bKeyboardInput = true;
+    bBinaryObject = false;
+}
+
+//**** Removes the <CR> of each <CR><LF> in sText
+void StripCRLF (string& sText)
+{
+    size_t iTo = sText.find ("\r\n");
+    if (iTo == string::npos)
+    {
+        return;
+    }
+    for (size_t iFrom = iTo; iFrom < sText.size(); iFrom++)
+    {
+        if (sText[iFrom] != '\r' || iFrom + 1 == sText.size() || sText[iFrom + 1] != '\n')
+        {
+            sText[iTo++] = sText[iFrom];
+        }
+    }
+    sText.resize (iTo);
+}
+
+//**** Falls back to cFileName itself when the binary object file is
+//**** invalid, after saying so.  An object file with <CR><LF> line ends
+//**** loads like one with <LF> alone.
+bool Machine::bSetObjectFile (const char* cFileName)
+{
+    string sBinaryName, sBytes;
+    int iLoadAddr;
+    if (bBinaryIsCurrent (cFileName, sBinaryName))
+    {
+        if (bReadBinaryObject (sBinaryName, sBytes, iLoadAddr))
+        {
+            SetKeyboardInput ();
+            sChariText.swap (sBytes);
+            bKeyboardInput = false;
+            bBinaryObject = true;
+            return true;
+        }
+        *pMessage << "Invalid binary object file " << sBinaryName << endl;
+    }
+    if (!bSetInputFile (cFileName))
+    {
+        return false;
+    }
+    StripCRLF (sChariText);
+    return true;
+}
+
+//**** Turns the bytes of a binary object file back into object text for
+//**** a loader that is interpreted
+void Machine::ExpandBinaryObject ()
+{
+    string sText;
+    sText.reserve (3 * sChariText.size() + 3);
+    for (size_t i = 0; i < sChariText.size(); i++)
+    {
+        sText += cHexTable[static_cast <uint8_t> (sChariText[i]) >> 4];
+        sText += cHexTable[sChariText[i] & 15];
+        sText += ' ';
+    }
+    sText += "zz\n";
+    sChariText.swap (sText);
+    iChariPos = 0;
+    bBinaryObject = false;
+}
+
+//**** Reads the whole file into memory with one read, so that CHARI takes
+//**** its lines in place.  Files that cannot report their size, such as
+//**** pipes, are copied through the stream buffer instead.
+//**** Returns false and reverts to the keyboard if the file cannot be opened
+bool Machine::bSetInputFile (const char* cFileName)
+{
+    ifstream inputFile;
+    streamoff iSize;
+    SetKeyboardInput ();
+    inputFile.open(cFileName, ios::binary);
+    if (!inputFile.is_open())
+    {
+        return false;
+    }
+    inputFile.seekg (0, ios::end);
+    iSize = inputFile.tellg();
+    if (iSize > 0)
+    {
+        sChariText.resize (iSize);
+        inputFile.seekg (0, ios::beg);
+        inputFile.read (&sChariText[0], iSize);
+        sChariText.resize (inputFile.gcount());
+    }
+    else
+    {
+        ostringstream text;
+        inputFile.clear();
+        text << inputFile.rdbuf();
+        sChariText = text.str();
+    }
+    bKeyboardInput = false;
+    return true;
+}
+
+void Machine::SetInputString (const string& sInput)
+{
+    SetKeyboardInput ();
+    sChariText = sInput;
+    bKeyboardInput = false;
+}
+
+void Machine::SetScreenOutput ()
+{
+    vFlushCharo ();
+    if (charoOutputStream.is_open())
+    {
+        charoOutputStream.close();
+    }
+    pCharoOutput = &cout;
+    bScreenOutput = true;
+}
+
+//**** Returns false and reverts to the screen if the file cannot be opened
+bool Machine::bSetOutputFile (const char* cFileName, bool bAppend)
+{
+    SetScreenOutput ();
+    charoOutputStream.clear();
+    charoOutputStream.open(cFileName, bAppend ? ios::out | ios::app : ios::out);
+    if (!charoOutputStream.is_open())
+    {
+        return false;
+    }
+    sCharoFileName = cFileName;
+    pCharoOutput = &charoOutputStream;
+    bScreenOutput = false;
+    return true;
+}
+
+void Machine::SetOutputString ()
+{
+    SetScreenOutput ();
+    charoStringStream.str("");
+    pCharoOutput = &charoStringStream;
+    bScreenOutput = false;
+}
+
+//**** Binds CHARO to a stream owned by the caller
+void Machine::SetOutputStream (ostream& output)
+{
+    SetScreenOutput ();
+    pCharoOutput = &output;
+    bScreenOutput = false;
+}
+
+//**** Returns the CHARO output captured since the last call
+string Machine::Output ()
+{
+    vFlushCharo ();
+    string sOutput = charoStringStream.str();
+    charoStringStream.str("");
+    return sOutput;
+}
+
+//**** Prints one table of the statistics report, largest count first
+void PrintCountTable (ostream& output, const char* cTitle,
+                      vector <pair <long, string> >& rows, long lTotal)
+{
+    sort (rows.begin(), rows.end(), greater <pair <long, string> > ());
+    output << endl << left << setw(10) << cTitle << right << setw(14) << "Count"
+           << setw(9) << "Percent" << endl;
+    for (size_t i = 0; i < rows.size(); i++)
+    {
+        if (rows[i].first > 0)
+        {
+            output << left << setw(10) << rows[i].second << right << setw(14) << rows[i].first
+                   << setw(9) << fixed << setprecision(1)
+                   << 100.0 * rows[i].first / lTotal << endl;
+        }
+    }
+}
+
+void Machine::PrintStatistics (ostream& output)
+{
+    const char* const cFusedName[FUSED_FORMS] = { "LD+ADD+ST", "LD+SUB+ST", "CP+BR", "SUBSP+CALL" };
+    long lTotal = 0;
+    long lModeCount[8] = { 0 };
+    long lUnaryCount = 0;
+    long lTrapCount[TRAPS] = { 0 };
+    bool bAnyTrap = false;
+    bool bAnyFused = false;
+    map <string, long> mnemonCount;
+    vector <pair <long, string> > rows;
+    for (int iSpec = 0; iSpec < INSTR_SPECIFIERS; iSpec++)
+    {
+        if (lSpecCount[iSpec] > 0)
+        {
+            lTotal += lSpecCount[iSpec];
+            mnemonCount[sMnemonName (iSpec)] += lSpecCount[iSpec];
+            if (sDecodeTable[iSpec].bUnary)
+            {
+                lUnaryCount += lSpecCount[iSpec];
+            }
+            else
+            {
+                lModeCount[sDecodeTable[iSpec].eAddrMode] += lSpecCount[iSpec];
+            }
+        }
+    }
+    output << endl << "Execution statistics" << endl;
+    output << "Instructions executed " << setw(14) << lTotal << endl;
+    output << "  from user RAM       " << setw(14) << lTotal - lRomCount << endl;
+    output << "  from ROM            " << setw(14) << lRomCount << endl;
+    output << "Estimated cycles      " << setw(14) << lEstimatedCycles() << endl;
+    if (lTotal > 0)
+    {
+        output << "  per instruction     " << setw(14) << fixed << setprecision(2)
+               << (double) lEstimatedCycles() / lTotal << endl;
+    }
+    if (bTranslate)
+    {
+        output << "  translated          " << setw(14) << lTransCount << endl;
+        output << "Blocks translated     " << setw(14) << lTransBlocks << endl;
+    }
+    output << "Seconds               " << setw(14) << fixed << setprecision(3) << dRunSeconds << endl;
+    if (dRunSeconds > 0)
+    {
+        output << "Simulated MIPS        " << setw(14) << setprecision(2)
+               << lTotal / dRunSeconds / 1e6 << endl;
+    }
+    if (lTotal == 0)
+    {
+        return;
+    }
+    for (map <string, long>::iterator it = mnemonCount.begin(); it != mnemonCount.end(); ++it)
+    {
+        rows.push_back (make_pair (it->second, it->first));
+    }
+    PrintCountTable (output, "Mnemonic", rows, lTotal);
+    rows.clear();
+    rows.push_back (make_pair (lUnaryCount, string ("unary")));
+    for (int iMode = 0; iMode < 8; iMode++)
+    {
+        rows.push_back (make_pair (lModeCount[iMode], string (cModeName[iMode])));
+    }
+    PrintCountTable (output, "Mode", rows, lTotal);
+    rows.clear();
+    for (int iSpec = 0; iSpec < INSTR_SPECIFIERS; iSpec++)
+    {
+        MnemonicOpcodes eMn = sDecodeTable[iSpec].eMnemon;
+        if (eM_UNIMP0 <= eMn && eMn <= eM_UNIMP7)
+        {
+            lTrapCount[eMn - eM_UNIMP0] += lSpecCount[iSpec];
+            bAnyTrap = bAnyTrap || lSpecCount[iSpec] > 0;
+        }
+    }
+    if (bAnyTrap)
+    {
+        for (int iTrap = 0; iTrap < TRAPS; iTrap++)
+        {
+            string sName = TrapMnemon[iTrap];
+            sName.erase (sName.find_last_not_of (' ') + 1);
+            rows.push_back (make_pair (lTrapCount[iTrap], sName));
+        }
+        PrintCountTable (output, "Trap", rows, lTotal);
+    }
+    rows.clear();
+    for (int iForm = 0; iForm < FUSED_FORMS; iForm++)
+    {
+        rows.push_back (make_pair (lFusedCount[iForm], string (cFusedName[iForm])));
+        bAnyFused = bAnyFused || lFusedCount[iForm] > 0;
+    }
+    if (bAnyFused)
+    {
+        PrintCountTable (output, "Fused", rows, lTotal);
+    }
+    output << defaultfloat << setprecision(6);
+}
+
+bool Machine::bWriteProfile (const char* cFileName)
+{
+    char cHexWord[HEX_WORD_LENGTH + 1];
+    ofstream profileFile (cFileName);
+    if (!profileFile.is_open())
+    {
+        return false;
+    }
+    for (int iAddr = 0; iAddr < MEMORY_SIZE; iAddr++)
+    {
+        if (lAddrCount[iAddr] > 0)
+        {
+            RegToHex (iAddr, cHexWord);
+            profileFile << cHexWord << " " << lAddrCount[iAddr] << "\n";
+        }
+    }
+    profileFile.close();
+    return !profileFile.fail();
+}
+
+//**** Empties the call graph and the shadow stack, which then holds the
+//**** frame of the program itself
+void Machine::ResetCallGraph ()
+{
+    sCallFrameType frame;
+    callRoutines.clear();
+    callEdges.clear();
+    callStack.clear();
+    lCallInstrCount = 0;
+    frame.iRoutine = -1;
+    frame.ReturnSlot = 0;
+    frame.bTrap = false;
+    frame.lEntry = 0;
+    frame.pRoutine = &callRoutines[-1];
+    frame.pRoutine->lCalls = 1;
+    frame.pRoutine->iActive = 1;
+    frame.pEdge = NULL;
+    callStack.push_back (frame);
+}
+
+//**** Counts the instruction just executed for the routine on top of the
+//**** shadow stack, and then follows a CALL or a trap into the routine
+//**** it enters, or a RETn or RETTR out of the routine it leaves.  A trap
+//**** serviced natively is entered and left at once.
+void Machine::TrackCall (bool bHalt)
+{
+    MnemonicOpcodes eMnemon = sDecodeTable[sIR_InstrRegister.iInstr_Spec].eMnemon;
+    sRegisterType Handler;
+    lCallInstrCount++;
+    callStack.back().pRoutine->lExclusive++;
+    if (bHalt)
+    {
+        return;
+    }
+    switch (eMnemon)
+    {
+    case eM_CALL:
+        EnterRoutine (sR_ProgramCounter, sR_StackPointer, false);
+        break;
+    case eM_RETn:
+        LeaveRoutine (sR_StackPointer - 2, false);
+        break;
+    case eM_RETTR:
+        LeaveRoutine (0, true);
+        break;
+    case eM_UNIMP0: case eM_UNIMP1: case eM_UNIMP2: case eM_UNIMP3:
+    case eM_UNIMP4: case eM_UNIMP5: case eM_UNIMP6: case eM_UNIMP7:
+        EnterRoutine (MEMORY_SIZE + (eMnemon - eM_UNIMP0), 0, true);
+        MemRead (INTR_PC, Handler);
+        if (sR_ProgramCounter != Handler)
+        {
+            LeaveRoutine (0, true);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void Machine::EnterRoutine (int iRoutine, sRegisterType ReturnSlot, bool bTrap)
+{
+    sCallFrameType frame;
+    frame.iRoutine = iRoutine;
+    frame.ReturnSlot = ReturnSlot;
+    frame.bTrap = bTrap;
+    frame.lEntry = lCallInstrCount;
+    frame.pRoutine = &callRoutines[iRoutine];
+    frame.pEdge = &callEdges[make_pair (callStack.back().iRoutine, iRoutine)];
+    frame.pRoutine->lCalls++;
+    frame.pRoutine->iActive++;
+    frame.pEdge->lCalls++;
+    frame.pEdge->iActive++;
+    callStack.push_back (frame);
+}
+
+//**** Pops the frames down to the one that RETn or RETTR returns from.
+//**** A RETn must return to the address its CALL pushed, and does not
+//**** look below a trap.  A return that matches no frame, as from a
+//**** routine entered by a jump, is ignored.
+void Machine::LeaveRoutine (sRegisterType ReturnSlot, bool bTrap)
+{
+    size_t iFrame = callStack.size() - 1;
+    while (iFrame > 0 && !(bTrap ? callStack[iFrame].bTrap
+                                 : callStack[iFrame].ReturnSlot == ReturnSlot))
+    {
+        if (callStack[iFrame].bTrap && !bTrap)
+        {
+            return;
+        }
+        iFrame--;
+    }
+    if (iFrame == 0 || callStack[iFrame].bTrap != bTrap)
+    {
+        return;
+    }
+    while (callStack.size() > iFrame)
+    {
+        PopFrame ();
+    }
+}
+
+//**** Only the outermost activation of a recursive routine adds to its
+//**** inclusive count, so that no instruction is counted twice
+void Machine::PopFrame ()
+{
+    sCallFrameType& frame = callStack.back();
+    if (--frame.pRoutine->iActive == 0)
+    {
+        frame.pRoutine->lInclusive += lCallInstrCount - frame.lEntry;
+    }
+    if (--frame.pEdge->iActive == 0)
+    {
+        frame.pEdge->lInclusive += lCallInstrCount - frame.lEntry;
+    }
+    callStack.pop_back();
+}
+
+//**** The cycles of the run so far, at the cost of each specifier executed
+long Machine::lEstimatedCycles () const
+{
+    long lCycles = 0;
+    for (int iSpec = 0; iSpec < INSTR_SPECIFIERS; iSpec++)
+    {
+        lCycles += lSpecCount[iSpec] * iCycleCost[iSpec];
+    }
+    return lCycles;
+}
+
+//**** A key of two hex digits is one specifier.  A mnemonic names every
+//**** specifier the report counts under it, and with a mode only those in
+//**** that mode, so "LDA 5" and then "LDA,i 2" leave LDA,i at 2.  Later
+//**** lines override earlier ones.  Blank lines and lines that start with
+//**** # or ; are skipped.
+bool Machine::bReadCycleCosts (const char* cFileName, int& iBadLine)
+{
+    ifstream costFile (cFileName);
+    string sLine, sKey, sMode, sRest;
+    int iCycles;
+    iBadLine = 0;
+    if (!costFile.is_open())
+    {
+        return false;
+    }
+    for (int iLine = 1; getline (costFile, sLine); iLine++)
+    {
+        istringstream fields (sLine);
+        if (!(fields >> sKey) || sKey[0] == '#' || sKey[0] == ';')
+        {
+            continue;
+        }
+        if (!(fields >> iCycles) || iCycles < 0 || (fields >> sRest && sRest[0] != ';'))
+        {
+            iBadLine = iLine;
+            return false;
+        }
+        sMode.clear();
+        if (sKey.find (',') != string::npos)
+        {
+            sMode = sKey.substr (sKey.find (',') + 1);
+            sKey.erase (sKey.find (','));
+        }
+        for (size_t i = 0; i < sKey.size(); i++)
+        {
+            sKey[i] = toupper (sKey[i]);
+        }
+        bool bFound = false;
+        if (sKey.size() == 2 && sMode.empty() && isxdigit (sKey[0]) && isxdigit (sKey[1]))
+        {
+            iCycleCost[strtol (sKey.c_str(), NULL, 16)] = iCycles;
+            bFound = true;
+        }
+        else
+        {
+            for (int iSpec = 0; iSpec < INSTR_SPECIFIERS; iSpec++)
+            {
+                const sDecodeType& sD = sDecodeTable[iSpec];
+                if (sMnemonName (iSpec) == sKey
+                    && (sMode.empty() || (!sD.bUnary && sMode == cModeName[sD.eAddrMode])))
+                {
+                    iCycleCost[iSpec] = iCycles;
+                    bFound = true;
+                }
+            }
+        }
+        if (!bFound)
+        {
+            iBadLine = iLine;
+            return false;
+        }
+    }
+    return costFile.eof();
+}
+
+//**** Reads the code symbols of a symbol file of asem8 -y, with lines
+//**** of a symbol, its value in hex and its kind: code, data or equate
+bool Machine::bReadSymbols (const char* cFileName)
+{
+    ifstream symbolFile (cFileName);
+    string sSymbol, sKind;
+    unsigned int iValue;
+    if (!symbolFile.is_open())
+    {
+        return false;
+    }
+    while (symbolFile >> sSymbol >> hex >> iValue >> dec >> sKind)
+    {
+        if (sKind == "code" && iValue < MEMORY_SIZE)
+        {
+            symbolNames[iValue] = sSymbol;
+        }
+    }
+    return symbolFile.eof();
+}
+
+string Machine::sRoutineName (int iRoutine)
+{
+    char cHexWord[HEX_WORD_LENGTH + 1];
+    if (iRoutine < 0)
+    {
+        return "(program)";
+    }
+    if (iRoutine >= MEMORY_SIZE)
+    {
+        string sMnemon = TrapMnemon[iRoutine - MEMORY_SIZE];
+        return sMnemon.substr (0, sMnemon.find (' '));
+    }
+    map<int, string>::const_iterator name = symbolNames.find (iRoutine);
+    if (name != symbolNames.end())
+    {
+        return name->second;
+    }
+    RegToHex (iRoutine, cHexWord);
+    return string ("0x") + cHexWord;
+}
+
+//**** Routines come by inclusive count, most first, and the calls of each
+//**** caller after it.  The frames still open when the run ended are
+//**** closed at its last instruction.
+bool Machine::bWriteCallGraph (const char* cFileName)
+{
+    ofstream graphFile (cFileName);
+    vector<pair<long, int> > order;
+    if (!graphFile.is_open())
+    {
+        return false;
+    }
+    while (callStack.size() > 1)
+    {
+        PopFrame ();
+    }
+    callRoutines[-1].lInclusive = lCallInstrCount;
+    for (map<int, sCallCountType>::const_iterator it = callRoutines.begin(); it != callRoutines.end(); ++it)
+    {
+        order.push_back (make_pair (-it->second.lInclusive, it->first));
+    }
+    sort (order.begin(), order.end());
+    double dTotal = (lCallInstrCount > 0) ? lCallInstrCount : 1;
+    graphFile << "Call graph of " << lCallInstrCount << " instructions" << endl << endl;
+    graphFile << "Routine         Calls     Inclusive       %     Exclusive       %" << endl;
+    graphFile << fixed << setprecision(2);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        const sCallCountType& routine = callRoutines[order[i].second];
+        graphFile << left << setw(10) << sRoutineName (order[i].second) << right
+                  << setw(11) << routine.lCalls
+                  << setw(14) << routine.lInclusive << setw(8) << 100.0 * routine.lInclusive / dTotal
+                  << setw(14) << routine.lExclusive << setw(8) << 100.0 * routine.lExclusive / dTotal << endl;
+    }
+    graphFile << endl << "Caller    Callee          Calls     Inclusive" << endl;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        for (map<pair<int, int>, sCallCountType>::const_iterator it = callEdges.lower_bound (make_pair (order[i].second, INT_MIN));
+             it != callEdges.end() && it->first.first == order[i].second; ++it)
+        {
+            graphFile << left << setw(10) << sRoutineName (it->first.first)
+                      << setw(10) << sRoutineName (it->first.second) << right
+                      << setw(11) << it->second.lCalls << setw(14) << it->second.lInclusive << endl;
+        }
+    }
+    graphFile.close();
+    return !graphFile.fail();
+}
+
+//**** Each line is formatted in a buffer and written at once
+void Machine::Dump (ostream& output, sRegisterType StartAddress, sRegisterType EndAddress)
+{
+    const int DUMP_LINE_LENGTH = 4 + 3 + 16 * 3 + 1 + 16 + 1;
+    char cLine[DUMP_LINE_LENGTH];
+    output << "DUMP    0  1  2  3  4  5  6  7  8  9  ";
+    output << "A  B  C  D  E  F       ASCII" << endl << endl;
+    for (long lLine = StartAddress & 0xFFF0; lLine <= EndAddress; lLine += 16)
+    {
+        char* pChar = cLine;
+        *pChar++ = cHexTable[(lLine >> 12) & 0xF];
+        *pChar++ = cHexTable[(lLine >> 8) & 0xF];
+        *pChar++ = cHexTable[(lLine >> 4) & 0xF];
+        *pChar++ = cHexTable[lLine & 0xF];
+        *pChar++ = ':';
+        *pChar++ = ' ';
+        *pChar++ = ' ';
+        for (int i = 0; i < 16; i++)
+        {
+            *pChar++ = cHexTable[iMemory[lLine + i] >> 4];
+            *pChar++ = cHexTable[iMemory[lLine + i] & 0xF];
+            *pChar++ = ' ';
+        }
+        *pChar++ = ' ';
+        for (int i = 0; i < 16; i++)
+        {
+            uint8_t iByte = iMemory[lLine + i];
+            *pChar++ = (iByte >= ' ' && iByte <= '~') ? static_cast <char> (iByte) : '.';
+        }
+        *pChar++ = '\n';
+        output.write (cLine, DUMP_LINE_LENGTH);
+    }
+    output.flush();
+}
+
+void Machine::DumpImage (ostream& output, sRegisterType StartAddress, sRegisterType EndAddress)
+{
+    if (StartAddress <= EndAddress)
+    {
+        output.write (reinterpret_cast <const char*> (&iMemory[StartAddress]),
+                      EndAddress - StartAddress + 1);
+    }
+}
+
+bool Machine::bDumpFile (const char* cFileName, sRegisterType StartAddress,
+                         sRegisterType EndAddress, bool bImage)
+{
+    ofstream dumpFile (cFileName, ios::out | ios::binary);
+    if (!dumpFile.is_open())
+    {
+        return false;
+    }
+    if (bImage)
+    {
+        DumpImage (dumpFile, StartAddress, EndAddress);
+    }
+    else
+    {
+        Dump (dumpFile, StartAddress, EndAddress);
+    }
+    dumpFile.close();
+    return !dumpFile.fail();
+}
+
+//**** Returns the exit status of a run.  For a run that did not end with
+//**** STOP, prints its last instructions and tells why the watchdog stopped it.
+int iWatchdogStatus (ostream& output, Machine& machine, eRunStatus eStatus)
+{
+    if (eStatus == eS_STOPPED || eStatus == eS_OUTPUT_MISMATCH)
+    {
+        if (machine.lMismatchOffset() < 0)
+        {
+            return 0;
+        }
+        output << "Output differs from the expected output at offset "
+               << machine.lMismatchOffset() << endl;
+        return 9;
+    }
+    machine.PrintHistory (output);
+    if (eStatus == eS_RUNTIME_ERROR)
+    {
+        return 6;
+    }
+    output << (eStatus == eS_TIMED_OUT ? "Time limit" : "Instruction limit")
+           << " reached after " << machine.InstrCount() << " instructions, PC = "
+           << hex << uppercase << setfill('0') << setw(4) << machine.ProgramCounter()
+           << dec << setfill(' ') << endl;
+    return 7;
+}
@@ -0,0 +1,676 @@
+//  File: pep8sim.h
+//  Pep/8 machine for the simulator of "Computer Systems", Fourth edition,
+//  J. Stanley Warford, Jones and Bartlett, Publishers, 2010.
+//  Pepperdine University, Malibu, CA 90265
+//  Stan.Warford@pepperdine.edu
+
+//  Released under the GNU General Public License without warrenty
+//  as described in http://www.gnu.org/copyleft/gpl.html
+
+//  A Machine holds everything one simulated Pep/8 needs: main memory, the
+//  CPU registers, the trap mnemonics, the CHARI and CHARO bindings and the
+//  trace state.  Any number of machines can live in one process.  Typical
+//  embedded use:
+//
+//      Machine pep8;
+//      bool bError;
+//      pep8.Initialize (bError);            // Reads trap from the
+//      pep8.InstallRom (bError);            //   working directory
+//      pep8.SetInputString (sObjectText);   // Object file contents
+//      pep8.Load ();
+//      pep8.SetInputString (sProgramInput);
+//      pep8.SetOutputString ();
+//      eRunStatus eStatus = pep8.Run (1000000);
+//      std::string sOutput = pep8.Output ();
+
+#ifndef PEP8SIM_H
+#define PEP8SIM_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <stdint.h>
+
+const int MEMORY_SIZE        = 65536;
+const int TOP_OF_MEMORY      = 65535;
+const int USER_SP            = 65528; //User stack pointer vector.
+const int SYSTEM_SP          = 65530; //System stack pointer vector.
+const int LOADER_PC          = 65532; //Program counter vector.
+const int INTR_PC            = 65534; //Interrupt program counter vector.
+const int FILE_NAME_LENGTH   = 64;
+const int HEX_BYTE_LENGTH    = 2;
+const int HEX_WORD_LENGTH    = 4;
+const int INSTR_SPECIFIERS    = 256;   //Number of distinct instruction specifiers
+const int BYTE_INSTRUCTION   = 4;
+const int LINE_FEED          = 10;
+const int CARRIAGE_RETURN    = 13;
+const int LINE_LENGTH        = 1024;  //Maximum length of a line of code
+const int TRAPS              = 8;     //Number of Traps
+const int MNEMON_LENGTH      = 8;
+const int MAX_BLOCK_LENGTH   = 64;    //Maximum instructions in a cached block
+const long HOT_BLOCK_COUNT   = 64;    //Runs of a cached block before -x translates it
+const int CHARO_BUFFER_SIZE  = 8192;  //Pending CHARO output before a write
+const long WATCHDOG_SLICE    = 65536; //Instructions between budget and clock checks
+const int TRACE_RECORD_SIZE  = 14;    //Bytes per instruction in a binary trace
+const int TRACE_BUFFER_SIZE  = 65536; //Pending binary trace bytes before a write
+const int HISTORY_SIZE       = 64;    //Recent instruction addresses kept, a power of 2
+const int PAGE_SIZE          = 256;   //Bytes per page of the dirty page map
+const int BINARY_HEADER_LENGTH = 16; //"PEPB", load address, length, .pepo size and hash in a .pepb file
+const unsigned int STANDARD_OS_CHECKSUM = 0x14916145; //FNV-1a hash of the distributed pep8os.pepo ROM
+const int OS_WORD_BUFF       = 0xFC4F; //wordBuff of the distributed operating system
+const int OS_BYTE_BUFF       = 0xFC50; //byteBuff
+const int OS_BYTE_TEMP       = 0xFC52; //byteTemp
+const int OS_LOADER_CHARI1   = 0xFC5D; //CHARI of the first hex digit in the loader
+const int OS_LOADER_CHARI2   = 0xFC79; //CHARI of the second hex digit
+const int OS_LOADER_STOP     = 0xFC9A; //stopLoad
+const int OS_RAM             = 0xFBCF; //osRAM, the system stack area and the OS variables up to opAddr
+const int OS_ADDR_MASK       = 0xFC53; //addrMask
+const int OS_OP_ADDR         = 0xFC55; //opAddr
+const int OS_RET_UNARY       = 0xFCAE; //Return address of CALL unaryJT,x in the trap handler
+const int OS_RET_NONUNARY    = 0xFCC1; //return, the return address of CALL nonUnJT,x
+const int OS_RET_NOP_ASSERT  = 0xFDC3; //Return address of CALL assertAd in the NOP routine
+const int OS_RET_DECI_SETADDR = 0xFDD0; //Return address of CALL setAddr in the DECI routine
+const int OS_DECI_MSG        = 0xFF21; //deciMsg
+const int OS_RET_DECI_PRNTMSG = 0xFF20; //Return address of CALL prntMsg in deciErr
+const int OS_RET_DECO_SETADDR = 0xFF47; //Return address of CALL setAddr in the DECO routine
+const int OS_RET_DECO_DIVIDE = 0xFF84; //Return address of the last CALL divide
+const int OS_RET_STRO_SETADDR = 0xFFD2; //Return address of CALL setAddr in the STRO routine
+const int OS_RET_STRO_PRNTMSG = 0xFFDE; //Return address of CALL prntMsg in the STRO routine
+const int UNIMPLEMENTED_INSTRUCTIONS = 8; // Number of unimplemented mnemonics
+const int UNARY_TRAPS = 4;                // Number of unimplemented mnemonics guaranteed to be unary
+const int IMMEDIATE = 1;                // 2^0. Powers of two to represent addressing mode bitset
+const int DIRECT = 2;                   // 2^1
+const int INDIRECT = 4;                 // 2^2
+const int STACK_RELATIVE = 8;           // 2^3
+const int STACK_RELATIVE_DEFERRED = 16; // 2^4
+const int INDEXED = 32;                 // 2^5
+const int STACK_INDEXED = 64;           // 2^6
+const int STACK_INDEXED_DEFERRED = 128; // 2^7
+
+//Enumerated Types
+enum MnemonicOpcodes   //All possible opcodes
+{
+    eM_STOP, eM_RETTR, eM_MOVSPA, eM_MOVFLGA, eM_BR, eM_BRLE, eM_BRLT, eM_BREQ,
+    eM_BRNE, eM_BRGE, eM_BRGT, eM_BRV, eM_BRC, eM_CALL, eM_NOTr, eM_NEGr,
+    eM_ASLr, eM_ASRr, eM_ROLr, eM_RORr, eM_UNIMP0, eM_UNIMP1, eM_UNIMP2,
+    eM_UNIMP3, eM_UNIMP4, eM_UNIMP5, eM_UNIMP6, eM_UNIMP7, eM_CHARI, eM_CHARO,
+    eM_RETn, eM_ADDSP, eM_SUBSP, eM_ADDr, eM_SUBr, eM_ANDr, eM_ORr, eM_CPr,
+    eM_LDr, eM_LDBYTEr, eM_STr, eM_STBYTEr
+};
+
+//**** Instruction sequences that the block cache executes as one, numbered
+//**** after the mnemonics so that either indexes its dispatch table
+enum eFusedType
+{
+    eF_LOAD_ADD_STORE = eM_STBYTEr + 1, // LDr, ADDr and STr of one register
+    eF_LOAD_SUB_STORE,                  // LDr, SUBr and STr of one register
+    eF_COMPARE_BRANCH,                  // CPr and a conditional branch
+    eF_SUBSP_CALL,                      // SUBSP and CALL, both immediate
+    eF_END
+};
+const int FUSED_FORMS = eF_END - eF_LOAD_ADD_STORE;
+
+enum eRegSpecType  { eR_R_IS_ACCUMULATOR, eR_R_IS_INDEX_REG }; // 8 bits, unsigned
+
+enum eAddrModeType
+{
+    eA_IMMEDIATE, eA_DIRECT, eA_INDIRECT, eA_STACK_REL,
+    eA_STACK_REL_DEF, eA_INDEXED, eA_STACK_IND, eA_STACK_IND_DEF
+};
+
+enum eTraceMd { eT_TR_OFF, eT_TR_PROGRAM, eT_TR_TRAPS, eT_TR_LOADER };
+
+//**** What the V and C bits are still to be computed from
+enum eVCSourceType { eV_SETTLED, eV_ADD, eV_SUB };
+
+//**** Kinds of breakpoint, each kept in its own bitmap of all addresses
+enum eBreakType { eB_EXECUTE, eB_READ, eB_WRITE, eB_BREAK_TYPES };
+
+//**** How a call to Load or Run ended
+enum eRunStatus
+{
+    eS_STOPPED,                     // The program executed STOP
+    eS_RUNTIME_ERROR,               // Halted any other way
+    eS_BUDGET_EXHAUSTED,            // Ran the whole instruction budget
+    eS_TIMED_OUT,                   // Ran past the time limit
+    eS_BREAKPOINT,                  // Reached a breakpoint or watchpoint
+    eS_OUTPUT_MISMATCH              // CHARO output left the expected output
+};
+
+//**** Global Records
+typedef uint16_t sRegisterType;     // internal CPU registers, 16 bits
+struct sIRRecType
+{
+    int iInstr_Spec;                //  8 bits
+    sRegisterType sR_OprndSpec;     // 16 bits
+};
+
+class Machine;
+
+//**** Everything the execution cycle needs to know about one instruction
+//**** specifier. The table is filled once by InitDecodeTable().
+struct sDecodeType
+{
+    MnemonicOpcodes eMnemon;
+    bool bUnary;                    // No operand specifier follows
+    eAddrModeType eAddrMode;
+    eRegSpecType eRegType;
+    int iNValue;                    // n field of RETn
+    bool bEndsBlock;                // May change the program counter
+    void (*pSimProc) (Machine&, bool&); // Executes the instruction, see SimThunk
+};
+
+//**** One instruction of a cached block, fetched and decoded in advance
+struct sBlockInstrType
+{
+    int iInstr_Spec;
+    sRegisterType sR_OprndSpec;
+    sRegisterType sR_Addr;          // Address of the instruction
+    sRegisterType sR_NextPC;        // Program counter after the fetch
+    sDecodeType* pDecode;
+    int iOp;                        // eMnemon, or the eFusedType of a sequence starting here
+};
+
+struct sTransInstrType;
+typedef void (*TransProcType) (Machine& machine, const sTransInstrType& sTI, bool& bHalt);
+
+//**** One instruction of a translated block.  The handler is compiled for
+//**** its mnemonic, register and addressing mode, or runs the Sim routine
+//**** of an instruction that is not translated.
+struct sTransInstrType
+{
+    TransProcType pTransProc;
+    sRegisterType sR_OprndSpec;
+    sRegisterType sR_Addr;
+    sRegisterType sR_NextPC;
+    const sBlockInstrType* pSource; // The instruction as the block cache decoded it
+};
+
+//**** A straight-line run of code ending at an instruction that may branch
+struct sBlockType
+{
+    int iStartAddr;                 // Address of the first instruction
+    int iLength;                    // Number of code bytes covered
+    int iInstrCount;
+    long lRunCount;                 // Times the block has run, counted for -x
+    sTransInstrType* pTrans;        // iInstrCount translated instructions, or NULL
+    sBlockInstrType sInstr[MAX_BLOCK_LENGTH];
+    sBlockType* pNext;              // Next block in pBlockList
+};
+
+//**** One line of a trace: the instruction and the registers after it
+struct sTraceRecType
+{
+    sRegisterType Address;
+    int iInstr_Spec;
+    sRegisterType OprndSpec;
+    sRegisterType Accumulator, IndexRegister, StackPointer;
+    bool bN, bZ, bV, bC;
+    sRegisterType Operand;          // As the trace shows it
+};
+
+//**** The registers and status bits of a program translated to C++ by
+//**** pep8aot, which it keeps in host variables while it runs natively
+struct sNativeStateType
+{
+    sRegisterType A, X, SP, PC;
+    int iNZValue;                   // N and Z as Machine keeps them
+    bool bV, bC;
+    long lInstrCount;               // Instructions run natively since the last NativeStep
+};
+
+typedef void (*NativeProgramType) (Machine& machine, sNativeStateType& state, bool& bHalt);
+
+//**** Counts of a routine, or of the calls from one routine to another,
+//**** in the call graph of a run
+struct sCallCountType
+{
+    long lCalls;
+    long lInclusive;                // Instructions while it was active
+    long lExclusive;                // Instructions of the routine itself
+    int iActive;                    // Activations on the shadow stack
+};
+
+//**** An activation on the shadow stack of the call graph.  A routine is
+//**** numbered by its address, a trap by MEMORY_SIZE plus its number, and
+//**** the program itself is -1.
+struct sCallFrameType
+{
+    int iRoutine;
+    sRegisterType ReturnSlot;       // Where CALL pushed the return address
+    bool bTrap;                     // Entered by a trap, left by RETTR
+    long lEntry;                    // lCallInstrCount when it was entered
+    sCallCountType* pRoutine;
+    sCallCountType* pEdge;          // The calls from the routine below it
+};
+
+bool bIsHexDigit (char cChar);
+void RegToHex (sRegisterType Reg, char HexNum[]);
+
+class Machine
+{
+public:
+    Machine ();
+    ~Machine ();
+
+    //**** Setup: reads the trap file and installs pep8os.pepo, or the binary
+    //**** pep8os.pepb when it is not older, in ROM
+    void Initialize (bool& bError);
+    void InstallRom (bool& bError);
+    void CopyRom (const Machine& source);
+
+    //**** The binary image pep8os.img caches what Initialize and InstallRom
+    //**** read.  bInstallImage returns false if the image is missing or was
+    //**** made from other contents of trap or pep8os.pepo, and SaveImage
+    //**** writes a fresh one.
+    bool bInstallImage ();
+    void SaveImage ();
+
+    //**** Returns the machine to the state InstallRom left it in, for the
+    //**** next of many jobs: the RAM pages written since then are cleared,
+    //**** and the registers, the breakpoints, the block cache and the
+    //**** CHARI, CHARO and message bindings are reset.  The options are kept.
+    void Reset ();
+
+    //**** CHARI input: the keyboard, a file or a string.  Load reads the
+    //**** object program from the same binding.
+    void SetKeyboardInput ();
+    bool bSetInputFile (const char* cFileName);
+    void SetInputString (const std::string& sInput);
+    bool bIsKeyboardInput () const { return bKeyboardInput; }
+
+    //**** Binds the object program for Load.  The binary object file of
+    //**** the same name ending in .pepb is preferred when it is there and
+    //**** not older than cFileName; otherwise this is bSetInputFile.
+    bool bSetObjectFile (const char* cFileName);
+
+    //**** CHARO output: the screen, a file or a string read with Output()
+    void SetScreenOutput ();
+    bool bSetOutputFile (const char* cFileName, bool bAppend = false);
+    void SetOutputString ();
+    void SetOutputStream (std::ostream& output);
+    std::string Output ();
+
+    //**** Output comparison: after bSetExpectedOutput, each byte of CHARO
+    //**** output is compared with the file as it is produced.  With
+    //**** lMargin 0 or more, Run halts with eS_OUTPUT_MISMATCH at the first
+    //**** byte that differs, or once the output is more than lMargin bytes
+    //**** longer than the file.  lMismatchOffset is the offset of the first
+    //**** byte of the last Run that differs, or where its output ended
+    //**** short, or -1 if the output matched or is not compared.
+    bool bSetExpectedOutput (const char* cFileName, long lMargin = -1);
+    void ClearExpectedOutput ();
+    long lMismatchOffset () const;
+
+    //**** Runtime error messages go to cout unless redirected
+    void SetMessageStream (std::ostream& output) { pMessage = &output; }
+
+    //**** Execution.  A budget of 0 means no instruction limit and a time
+    //**** limit of 0 seconds means no time limit.
+    eRunStatus Load ();
+    eRunStatus Run (long lBudget = 0, double dSeconds = 0);
+    long InstrCount () const { return lInstrGiven - lInstrLeft; }
+    sRegisterType ProgramCounter () const { return sR_ProgramCounter; }
+
+    //**** Memory dumps.  Dump prints the lines that cover StartAddress to
+    //**** EndAddress, 16 bytes in hex and ASCII per line.  DumpImage writes
+    //**** the bytes from StartAddress to EndAddress as they are.  bDumpFile
+    //**** writes either one to the file cFileName.
+    void Dump (std::ostream& output, sRegisterType StartAddress, sRegisterType EndAddress);
+    void DumpImage (std::ostream& output, sRegisterType StartAddress, sRegisterType EndAddress);
+    bool bDumpFile (const char* cFileName, sRegisterType StartAddress,
+                    sRegisterType EndAddress, bool bImage);
+
+    //**** Breakpoints and watchpoints.  While any are set, Run and Continue
+    //**** execute untraced programs with the interpreter, and stop before
+    //**** the instruction at a breakpoint or after the instruction that reads
+    //**** or writes a watched byte.  Continue resumes the program where it
+    //**** stopped.
+    void SetBreakpoints (eBreakType eType, sRegisterType StartAddress,
+                         sRegisterType EndAddress, bool bSet);
+    void ClearBreakpoints ();
+    void ListBreakpoints (std::ostream& output);
+    bool bCanContinue () const { return bAtBreak || bAtLimit; }
+    bool bHasStopped () const { return bStopped; }
+    eRunStatus Continue (long lBudget = 0, double dSeconds = 0);
+
+    //**** Checkpoints.  bSaveCheckpoint writes memory, the registers, the
+    //**** status bits, the positions of the CHARI input and CHARO output
+    //**** and the current input line to cFileName, after a Load, Run or
+    //**** Continue.  bRestoreCheckpoint puts them back, once the input and
+    //**** output are bound as they were.  A program that was stopped at a
+    //**** breakpoint or by the watchdog can then be continued.
+    bool bSaveCheckpoint (const char* cFileName);
+    bool bRestoreCheckpoint (const char* cFileName);
+
+    //**** Binary trace: while a trace file is open, Run records every
+    //**** instruction it executes as a TRACE_RECORD_SIZE record, with the
+    //**** interpreter.  DecodeBinaryTrace prints a trace file in the format
+    //**** of the (t)race command; bTraps includes the instructions in ROM.
+    //**** bTruncated tells that the file ends in the middle of a record.
+    bool bOpenBinaryTrace (const char* cFileName);
+    void CloseBinaryTrace ();
+    bool bDecodeBinaryTrace (std::istream& input, std::ostream& output, bool bTraps,
+                             bool& bTruncated);
+
+    //**** Runtime of programs translated to C++ by pep8aot.  RunNative is
+    //**** Run with the code of the loaded program compiled in pProgram,
+    //**** which calls NativeStep for each instruction it does not translate.
+    //**** NativeStep executes that instruction, and then the operating
+    //**** system until it returns to user code, with the interpreter.
+    eRunStatus RunNative (NativeProgramType pProgram);
+    void NativeStep (sNativeStateType& state, bool& bHalt);
+    uint8_t* NativeMemory () { return iMemory; }
+
+    //**** The decoded fields of an instruction specifier
+    static const sDecodeType& Decode (int iInstr_Spec);
+
+    //**** Prints the last HISTORY_SIZE instructions of the last Run, oldest
+    //**** first, decoded from memory, with the registers after the last one
+    void PrintHistory (std::ostream& output);
+
+    //**** With bStatistics, reports what the last Run executed by mnemonic,
+    //**** addressing mode, trap and memory region, and its simulated MIPS
+    void PrintStatistics (std::ostream& output);
+
+    //**** With bProfile, writes how many times the last Run executed the
+    //**** instruction at each address, one line per address that ran:
+    //**** the address in hex and the count.  asem8 -P merges the file
+    //**** into a listing.
+    bool bWriteProfile (const char* cFileName);
+
+    //**** With bCallGraph, Run follows CALL and RETn, and the traps and
+    //**** RETTR, on a shadow stack, with the interpreter.  bWriteCallGraph
+    //**** reports the calls and the inclusive and exclusive instruction
+    //**** counts of each subroutine and trap handler of the last Run, and
+    //**** of each caller and callee pair.  Routines are named from the
+    //**** code symbols of the symbol files of asem8 -y that bReadSymbols
+    //**** has read, or else by address.
+    bool bReadSymbols (const char* cFileName);
+    bool bWriteCallGraph (const char* cFileName);
+
+    //**** The -s report estimates the cycles a run took from iCycleCost,
+    //**** the cost of each instruction specifier.  By default it is one
+    //**** cycle per memory access the instruction makes, its fetch
+    //**** included.  bReadCycleCosts changes the costs named in a file of
+    //**** "key cycles" lines, where the key is a specifier in hex, or a
+    //**** mnemonic of the report with an optional ",mode".  Returns false
+    //**** with the number of the first line not understood in iBadLine, or
+    //**** 0 there when the file could not be opened.
+    bool bReadCycleCosts (const char* cFileName, int& iBadLine);
+    long lEstimatedCycles () const;
+
+    //**** Options and trace state, set by the front end between runs
+    bool bBlockCache;               // Execute with the block cache (-b)
+    bool bTranslate;                // Translate hot cached blocks (-x)
+    bool bNativeTraps;              // Service the standard traps natively (-n)
+    bool bStatistics;               // Count what each Run executes (-s)
+    bool bProfile;                  // Count the instructions at each address (-P)
+    bool bCallGraph;                // Follow calls and traps (-g)
+    int iCycleCost[INSTR_SPECIFIERS];   // Estimated cycles per specifier (-k)
+    eTraceMd eTraceMode;
+    bool bSingleStep;               // For tracing single step
+    bool bScrollingTrace;           // For tracing until completion
+    int numTerminalLines;
+    int iRomStartAddr;
+
+private:
+    static void InitDecodeTable ();
+    //**** Plain function entry for a Sim routine, so that the decode table
+    //**** holds ordinary function pointers instead of member pointers
+    template <void (Machine::*pProc) (bool&)>
+    static void SimThunk (Machine& machine, bool& bHalt) { (machine.*pProc) (bHalt); }
+
+    void vGetLine (std::istream& input);
+    bool bChariLine ();
+    void vAdvanceInput (char& ch);
+    void vBackUpInput ();
+    void PrntMnemon (std::ostream& output);
+    void PrntMnemon (std::ostream& output, int iInstr_Spec);
+    std::string sMnemonName (int iInstr_Spec);
+    inline void MemRead (sRegisterType Loc, sRegisterType& Rslt);
+    inline void MemByteRead (sRegisterType Loc, int& iByte);
+    inline void MemWrite (sRegisterType Reg, sRegisterType Loc);
+    inline void MemByteWrite (int iByte, sRegisterType Loc);
+    void AddrProcessor (sRegisterType& Operand);
+    void LoadReg (sRegisterType& Reg);
+    void SetNZBits (sRegisterType Reg);
+    inline bool bStatusN () const;
+    inline bool bStatusZ () const;
+    inline void SettleVC ();
+    inline void AddLazy (sRegisterType& Reg, sRegisterType Op);
+    inline void SubLazy (sRegisterType& Reg, sRegisterType Op);
+    inline void CompareLazy (sRegisterType Reg, sRegisterType Op);
+    int iStatusBits ();
+    void SetStatusBits (int iFlags);
+    void vFlushCharo ();
+    void PrntRunLoc ();
+    void IllegalAddr (bool& bError);
+    void Pop (sRegisterType& Reg, int iSize);
+    void Push (sRegisterType Reg, int iSize);
+    void vCharOut (int iData);
+    inline void CompareCharo (char cChar);
+
+    void SimSTOP (bool& Halt);
+    void SimRETTR (bool& bHalt);
+    void SimMOVSPA (bool& Halt);
+    void SimMOVFLGA (bool& Halt);
+    void SimBR (bool& bHalt);
+    void SimBRLE (bool& bHalt);
+    void SimBRLT (bool& bHalt);
+    void SimBREQ (bool& bHalt);
+    void SimBRNE (bool& bHalt);
+    void SimBRGE (bool& bHalt);
+    void SimBRGT (bool& bHalt);
+    void SimBRV (bool& bHalt);
+    void SimBRC (bool& bHalt);
+    void SimCALL (bool& bError);
+    void SimNOTr (bool& bHalt);
+    void SimNEGr (bool& bHalt);
+    void SimASLr (bool& bHalt);
+    void SimASRr (bool& bHalt);
+    void SimROLr (bool& bHalt);
+    void SimRORr (bool& bHalt);
+    void SimCHARI (bool& bError);
+    void SimCHARO (bool& bHalt);
+    void SimRETn (bool& bHalt);
+    void SimADDSP (bool& bError);
+    void SimSUBSP (bool& bError);
+    void SimADDr (bool& bHalt);
+    void SimSUBr (bool& bHalt);
+    void SimANDr (bool& bHalt);
+    void SimORr (bool& bHalt);
+    void SimCPr (bool& bHalt);
+    void SimLDr (bool& bHalt);
+    void SimLDBYTEr (bool& bHalt);
+    void SimSTr (bool& bError);
+    void SimSTBYTEr (bool& bError);
+    void SimTRAP (bool& bHalt);
+
+    void vNativeMessage (const char* cMessage);
+    bool bNativeDeciChar (int& iChar, bool& bFileRead, size_t& FilePos,
+                          bool& bKeyboardRead);
+    bool bNativeDECI (sRegisterType Operand, int& iFlags, bool& bHalt);
+    bool bNativeDECO (sRegisterType Operand);
+    bool bNativeSTRO (sRegisterType Operand);
+    bool bNativeTrap (sRegisterType Operand, bool& bHalt);
+    bool bInOSRam (int iLoc, int iLength);
+    bool bNativeSafe (sRegisterType Operand, int iLength);
+    void NativeScratch (int iAddrMask, sRegisterType OpAddr, sRegisterType RetAddr);
+    bool bLoaderChar (sRegisterType InstrAddr, int& iChar);
+    void NativeLoad ();
+    void BinaryLoad ();
+    void ExpandBinaryObject ();
+    void SetStandardOS ();
+
+    void PrintTraceLine (std::ostream& output, sRegisterType Address);
+    void PrintTraceInstr (std::ostream& output, const sTraceRecType& record);
+    void PrintTraceRecord (std::ostream& output, const sTraceRecType& record);
+    inline void MakeTraceRecord (sRegisterType Address, sTraceRecType& record);
+    void WriteTraceRecord (sRegisterType Address);
+    void Trace (sRegisterType Address, int& LineCount, bool& Halt);
+    inline void FetchIncrPC ();
+    inline void Execute (bool& bHalt);
+
+    void MarkBlock (sBlockType* pBlock);
+    void InvalidateBlocks (int iAddr);
+    void FreeRetiredBlocks ();
+    void ClearBlocks ();
+    sBlockType* BuildBlock (sRegisterType Addr);
+    static void DeleteBlock (sBlockType* pBlock);
+    void FuseBlock (sBlockType* pBlock);
+    inline sRegisterType FusedOperand (const sBlockInstrType* pInstr);
+    inline sRegisterType FusedAddr (const sBlockInstrType* pInstr);
+    inline void FusedArith (const sBlockInstrType* pInstr, bool bSubtract);
+    inline void FusedCompareBranch (const sBlockInstrType* pInstr);
+    inline void FusedSubspCall (const sBlockInstrType* pInstr);
+    inline sBlockInstrType* FusedTail (sBlockInstrType* pInstr, eFusedType eForm, int iLength);
+    void RunBlocks (bool& Halt);
+
+    //**** Translation of hot blocks for -x
+    template <eAddrModeType eMode> inline sRegisterType TransAddr (sRegisterType OprndSpec);
+    template <eAddrModeType eMode> inline sRegisterType TransOperand (sRegisterType OprndSpec);
+    template <MnemonicOpcodes eMn, eRegSpecType eReg, eAddrModeType eMode>
+    static void TransOp (Machine& machine, const sTransInstrType& sTI, bool& bHalt);
+    template <MnemonicOpcodes eMn, eRegSpecType eReg>
+    static TransProcType pTransMode (eAddrModeType eMode);
+    template <MnemonicOpcodes eMn>
+    static TransProcType pTransReg (const sDecodeType& sD);
+    static void TransSim (Machine& machine, const sTransInstrType& sTI, bool& bHalt);
+    static TransProcType pTranslate (const sDecodeType& sD);
+    void TranslateBlock (sBlockType* pBlock);
+    inline int RunTranslated (const sBlockType* pBlock, bool& Halt);
+    template <eTraceMd eMode, bool bRecord, bool bDebug>
+    void RunInterpreter (bool& Halt, int& iLineCount);
+    void StartExecution ();
+    void StartWatchdog (long lBudget, double dSeconds);
+    void WatchdogSlice (bool& Halt);
+    eRunStatus RunStatus ();
+    void UpdateBreakFlags ();
+    void PrintBreak ();
+    inline bool bBreakBit (eBreakType eType, sRegisterType Loc) const;
+    inline void CheckWatch (eBreakType eType, sRegisterType Loc);
+
+    //**** Main memory and the machine state
+    uint8_t iMemory[MEMORY_SIZE];   // Main memory, one byte per cell
+    uint8_t iDirtyPage[MEMORY_SIZE / PAGE_SIZE];  // Nonzero if RAM in the page was written
+    char TrapMnemon[TRAPS][MNEMON_LENGTH + 1];
+    bool bLoading;              // Set when loading object file
+    bool bMachineReset;         // To insure initial load on startup
+    bool bStopped;              // Last execution ended with STOP
+    eAddrModeType eA_AddrMode;  // Addressing mode enumerated type
+    eRegSpecType eR_RegType;    // Register type enumerated type
+    int nValue;                 // n values
+    long lInstrLeft;            // Instructions left in the current slice
+    long lBudgetLeft;           // Budget not yet handed out in slices
+    long lInstrGiven;           // Instructions handed out in slices
+    bool bBudgetExhausted;
+    bool bTimedOut;
+    bool bTimeLimit;
+    std::chrono::steady_clock::time_point tDeadline;
+
+    //**** Pep/8 CPU registers
+    sRegisterType sR_Accumulator, sR_IndexRegister, sR_StackPointer, sR_ProgramCounter; // 16 bits
+    sIRRecType sIR_InstrRegister; // 24 bits
+
+    //**** Status bits, computed only when they are read.  N and Z come from
+    //**** the value that last set them, and V and C from the operands of
+    //**** the last addition or subtraction until SettleVC.
+    int iNZValue;               // N if bit 15 or 16 is set, Z if bits 0-15 are clear
+    bool bStatusV, bStatusC;    // Valid when eVCSource is eV_SETTLED
+    eVCSourceType eVCSource;
+    sRegisterType VCOp1, VCOp2;
+
+    // Input/Output
+    std::string sChariText;             // The file or string bound to CHARI
+    size_t iChariPos;                   // Where its next line starts
+    std::ofstream charoOutputStream;
+    std::string sCharoFileName;         // The file of charoOutputStream
+    std::ostringstream charoStringStream;
+    std::ostream* pCharoOutput;         // Where CHARO output is written
+    std::ostream* pMessage;             // Where runtime errors are reported
+    bool bKeyboardInput;       // for program application, used by CHARI
+    bool bBinaryObject;        // sChariText holds the bytes of a .pepb file
+    bool bScreenOutput;        // for program application, used by CHARO
+    bool bBufferIsEmpty;
+    char cCharoBuffer[CHARO_BUFFER_SIZE];  // CHARO output not yet written
+    int iCharoCount;                       // Characters in cCharoBuffer
+    bool bCompareOutput;                   // CHARO output is compared with sExpectedText
+    std::string sExpectedText;
+    long lExpectedPos;                     // Bytes of output compared by this Run
+    long lFirstMismatch;                   // Offset of the first that differed, or -1
+    long lCompareMargin;                   // Excess output allowed, -1 to never halt
+    bool bMismatchHalt;                    // The output left the expected output
+
+    //**** Native trap handlers for the -n option
+    bool bStandardTraps;                    // Trap file has the distributed mnemonics
+    bool bStandardOS;                       // ROM is the distributed operating system
+
+    //**** Block cache for the -b execution engine
+    sBlockType* pBlockCache[MEMORY_SIZE];   // Cached block starting at each address
+    sBlockType* pBlockList;                 // All cached blocks
+    sBlockType* pRetiredBlocks;             // Invalidated blocks waiting to be freed
+    uint8_t iCodeMap[MEMORY_SIZE];          // Nonzero if a cached block covers the byte
+
+    //**** Binary trace for the -T option
+    std::ofstream binaryTraceStream;
+    std::vector <uint8_t> traceBuffer;      // Records not yet written
+    size_t iTraceCount;                     // Bytes used in traceBuffer
+
+    //**** Ring of the addresses of the most recent instructions, kept by
+    //**** every Run for PrintHistory
+    sRegisterType HistoryAddr[HISTORY_SIZE];
+    unsigned long lHistoryCount;            // Instructions recorded by this Run
+
+    //**** Breakpoint and watchpoint bitmaps, one bit per address
+    uint8_t iBreakMap[eB_BREAK_TYPES][MEMORY_SIZE / 8];
+    bool bBreakpoints;                      // Some eB_EXECUTE bit is set
+    bool bWatchpoints;                      // Some eB_READ or eB_WRITE bit is set
+    bool bAtBreak;                          // The last run stopped at one
+    bool bAtLimit;                          // The last run was stopped by the watchdog
+    bool bResumeBreak;                      // Continue past the breakpoint at the PC
+    bool bBreakHit;                         // Stop after this instruction
+    bool bWatchHit;                         // This instruction hit a watchpoint
+    eBreakType eWatchType;                  // How it touched WatchAddr
+    sRegisterType WatchAddr;
+
+    //**** Execution statistics for the -s option
+    void CountBlock (const sBlockInstrType* pFirst, const sBlockInstrType* pEnd);
+    long lSpecCount[INSTR_SPECIFIERS];      // Instructions executed per specifier
+    long lRomCount;                         // Of those, fetched from ROM
+    long lTransCount;                       // Of those, run in translated blocks
+    long lTransBlocks;                      // Blocks translated since the machine was made
+    long lFusedCount[FUSED_FORMS];          // Fused sequences executed, by eFusedType
+    long lAddrCount[MEMORY_SIZE];           // Instructions executed per address, for -P
+    double dRunSeconds;                     // Wall clock time of the last Run
+    bool bBlockInvalidated;                 // A store hit cached code
+
+    //**** Call graph for the -g option
+    void ResetCallGraph ();
+    void TrackCall (bool bHalt);
+    void EnterRoutine (int iRoutine, sRegisterType ReturnSlot, bool bTrap);
+    void LeaveRoutine (sRegisterType ReturnSlot, bool bTrap);
+    void PopFrame ();
+    std::string sRoutineName (int iRoutine);
+    std::map<int, sCallCountType> callRoutines;
+    std::map<std::pair<int, int>, sCallCountType> callEdges;   // By caller and callee
+    std::vector<sCallFrameType> callStack;  // The program's frame at the bottom
+    std::map<int, std::string> symbolNames; // Code symbols by address
+    long lCallInstrCount;                   // Instructions followed by this Run
+
+    //**** Keyboard buffer for unbuffering the UNIX buffered line on
+    //**** interactive input
+    char cLine[LINE_LENGTH]; //Array of characters for a line of code
+    const char* pLine;       //The current line: cLine, or a line of sChariText
+    int iLineIndex; //Index of line array
+};
+
+//**** The batch mode exit status of a run, which is reported on output
+//**** unless the program executed STOP and its output was as expected
+int iWatchdogStatus (std::ostream& output, Machine& machine, eRunStatus eStatus);
+
+#endif
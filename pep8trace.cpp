@@ -0,0 +1,70 @@
+//  File: pep8trace.cpp
+//  Binary trace decoder for the simulator of the Pep/8 computer as described
+//  in "Computer Systems", Fourth edition, J. Stanley Warford, Jones and
+//  Bartlett, Publishers, 2010.  ISBN 978-0-7637-7144-7
+//  Pepperdine University, Malibu, CA 90265
+//  Stan.Warford@pepperdine.edu
+
+//  Released under the GNU General Public License without warrenty
+//  as described in http://www.gnu.org/copyleft/gpl.html
+
+//  Prints a binary trace recorded with pep8 -T in the format of the trace
+//  of the simulator's (t)race command. The program trace is printed unless
+//  -t is given, which includes the instructions of the trap handlers.
+//  CHARO output is not part of a binary trace.  A trace that ends in the
+//  middle of a record is printed up to there and exits with status 6.
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include "pep8sim.h"
+
+using namespace std;
+
+int main (int argc, char *argv[])
+{
+    bool bTraps = false;
+    const char* cTraceFile = NULL;
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        if (strcmp(argv[iArg], "-t") == 0)
+        {
+            bTraps = true;
+        }
+        else if (argv[iArg][0] != '-' && cTraceFile == NULL)
+        {
+            cTraceFile = argv[iArg];
+        }
+        else
+        {
+            cTraceFile = NULL;
+            break;
+        }
+    }
+    if (cTraceFile == NULL)
+    {
+        cerr << "usage: pep8trace [-t] tracefile" << endl;
+        return 2;
+    }
+    ifstream traceFile (cTraceFile, ios::binary);
+    if (!traceFile.is_open())
+    {
+        cerr << "Could not open trace file " << cTraceFile << endl;
+        return 4;
+    }
+    Machine* pMachine = new Machine;
+    bool bTruncated = false;
+    bool bValid = pMachine->bDecodeBinaryTrace (traceFile, cout, bTraps, bTruncated);
+    delete pMachine;
+    if (!bValid)
+    {
+        cerr << cTraceFile << " is not a pep8 binary trace" << endl;
+        return 5;
+    }
+    if (bTruncated)
+    {
+        cerr << cTraceFile << " is truncated in its last record" << endl;
+        return 6;
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+#!/bin/sh
+#  File: regress/regress.sh
+#  Regression tests of the assembler.  Assembles each program in this
+#  directory and compares what asem8 prints, error messages included, with
+#  the .out file of the same name.  Prints one line per program that
+#  differs and exits with status 1 if any does.  Also checks that pep8 -n
+#  services the traps of fig0621 natively, executing fewer instructions,
+#  and that the figure programs of chap05 and chap06 and the workloads of
+#  bench give the same output, exit status and memory with -b, -x, -n and
+#  -x -n as with the interpreter.
+#  Usage, from the directory of the makefile:
+#      sh regress/regress.sh
+
+ROOT=`cd \`dirname "$0"\`/.. && pwd`
+WORK=`mktemp -d "${TMPDIR:-/tmp}/asemregress.XXXXXX"` || exit 1
+trap 'rm -rf "$WORK"' 0
+cp "$ROOT/trap" "$ROOT/pep8os.pepo" "$WORK"
+cd "$WORK"
+
+status=0
+for f in "$ROOT"/regress/*.pep
+do
+    n=`basename "$f" .pep`
+    cp "$f" .
+    "$ROOT/asem8" "$n.pep" > "$n.txt" 2>&1
+    if ! cmp -s "$n.txt" "$ROOT/regress/$n.out"
+    then
+        echo "FAIL $n"
+        status=1
+    fi
+done
+
+#  request file text: appends a whole program request to the file
+request () {
+    wc -c < "$2" | tr -d ' ' >> "$1"
+    cat "$2" >> "$1"
+}
+#  edit file first count text: appends an edit request to the file
+edit () {
+    echo "edit $2 $3 `wc -c < \"$4\" | tr -d ' '`" >> "$1"
+    cat "$4" >> "$1"
+}
+printf '         LDA     foo bar     ;two undefined symbols\n' > typo.txt
+: > empty.txt
+for f in "$ROOT"/chap06/fig0621.pep "$ROOT"/bench/cpu.pep
+do
+    n=`basename "$f" .pep`
+    last=`grep -n "^ *\.END" "$f" | cut -d: -f1`
+    : > edits.txt
+    : > fresh.txt
+    edit edits.txt 1 0 "$f"
+    request fresh.txt "$f"
+    for at in 1 5 $last
+    do
+        head -n `expr $at - 1` "$f" > typoed.pep
+        cat typo.txt >> typoed.pep
+        tail -n +$at "$f" >> typoed.pep
+        edit edits.txt $at 0 typo.txt
+        request fresh.txt typoed.pep
+        edit edits.txt $at 1 empty.txt
+        request fresh.txt "$f"
+    done
+    "$ROOT/asem8" -d < edits.txt > edits.ans 2>&1
+    "$ROOT/asem8" -d < fresh.txt > fresh.ans 2>&1
+    if ! cmp -s edits.ans fresh.ans || [ `grep -c '^1 0 0 ' fresh.ans` -ne 3 ]
+    then
+        echo "FAIL edit $n"
+        status=1
+    fi
+done
+#  executed file flags: prints the instruction count of a pep8 -s run
+executed () {
+    f=$1
+    shift
+    "$ROOT/pep8" -s "$@" -i "$ROOT/chap06/fig0621.in" "$f" 2>&1 |
+        sed -n 's/^Instructions executed *//p'
+}
+cp "$ROOT/chap06/fig0621.pep" .
+"$ROOT/asem8" fig0621.pep > /dev/null 2>&1
+os=`executed fig0621.pepo`
+native=`executed fig0621.pepo -n`
+if [ -z "$os" ] || [ -z "$native" ] || [ "$native" -ge "$os" ]
+then
+    echo "FAIL native fig0621"
+    status=1
+fi
+#  Input for the figures without an input file of their own, with <LF>
+#  and with <CR><LF> line ends, and a short input that runs out early
+printf '12   3 13 17 34 27 23 25 29 16 10 0 2\n-5 7 x\nhello world*\n42\n0\n*\n' > figure.in
+sed 's/$/\r/' figure.in > figure.crlf
+printf '1\r\n2\r\n' > short.crlf
+#  run name flags: runs name.pepo on $in, leaving name.out, name.img and name.status
+run () {
+    r=$1
+    shift
+    "$ROOT/pep8" "$@" -i "$in" -o "$r.out" -D "$r.img" "$r.pepo" > "$r.msg" 2> /dev/null
+    echo $? > "$r.status"
+}
+for f in "$ROOT"/chap05/*.pep "$ROOT"/chap06/*.pep "$ROOT"/bench/*.pep
+do
+    n=`basename "$f" .pep`
+    cp "$f" .
+    "$ROOT/asem8" "$n.pep" > /dev/null 2>&1
+    if [ ! -f "$n.pepo" ]
+    then
+        continue
+    fi
+    inputs="figure.in figure.crlf short.crlf"
+    if [ -f "`dirname "$f"`/$n.in" ]
+    then
+        cp "`dirname "$f"`/$n.in" .
+        inputs=$n.in
+    fi
+    for in in $inputs
+    do
+        run "$n"
+        for flags in -b -x -n "-x -n"
+        do
+            cp "$n.pepo" mode.pepo
+            run mode $flags
+            for x in out img msg status
+            do
+                if ! cmp -s "$n.$x" "mode.$x"
+                then
+                    echo "FAIL $n $flags $in $x"
+                    status=1
+                fi
+            done
+        done
+    done
+done
+if [ $status -eq 0 ]
+then
+    echo "All regression tests passed"
+fi
+exit $status
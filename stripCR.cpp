@@ -12,25 +12,113 @@
 // use <CR><LF> at the end of each line, to make the source files compatible
 // with the <LF> terminated lines of Unix/Linux/OS X. This utility takes a
 // stream of characters from the standard input and produces an output
-// stream of characters to the standard output. You should run DOS files
-// through this utility or its equivalent before using asem8, as the Pep/8
-// assembler assumes <LF> terminated lines. It also appends a <LF> character
-// at the end of the file to assure that the last line terminates with a
-// newline.
+// stream of characters to the standard output. asem8 and pep8 accept
+// <CR><LF> line ends themselves, so DOS source and object files no longer
+// need this step; it remains for other tools and for CHARI input files,
+// which are read as they are. It also appends a <LF> character at the end
+// of the file to assure that the last line terminates with a newline.
+//
+// With file names, stripCR rewrites each file in place instead, and
+// appends a <LF> only to a file whose last line has none. The input is
+// processed in blocks, so large files take one pass of memchr.
 
 #include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
 
-int main ()
+const size_t BLOCK_SIZE = 65536;
+
+// Copies input to output without <CR> characters. Sets iLast to the last
+// character written, or EOF if none was, and returns false if a read or
+// write fails.
+bool bStrip (FILE* input, FILE* output, int& iLast)
 {
-   char c;
-   while ((c = getchar()) != EOF)
+   char cBlock[BLOCK_SIZE];
+   size_t iCount;
+   iLast = EOF;
+   while ((iCount = fread (cBlock, 1, BLOCK_SIZE, input)) > 0)
    {
-      if (c != '\r')
+      const char* pStart = cBlock;
+      const char* pEnd = cBlock + iCount;
+      while (pStart < pEnd)
       {
-         putchar (c);
+         const char* pCR = static_cast<const char*> (memchr (pStart, '\r', pEnd - pStart));
+         const char* pStop = (pCR == NULL) ? pEnd : pCR;
+         if (pStop > pStart)
+         {
+            if (fwrite (pStart, 1, pStop - pStart, output) != static_cast<size_t> (pStop - pStart))
+            {
+               return false;
+            }
+            iLast = static_cast<unsigned char> (pStop[-1]);
+         }
+         pStart = (pCR == NULL) ? pEnd : pCR + 1;
       }
    }
-   putchar ('\n');
-   return 0;
+   return !ferror (input);
+}
+
+// Rewrites the file cName without <CR> characters, through a temporary
+// file that replaces it only when it is complete and has its permissions
+bool bStripFile (const char* cName)
+{
+   int iLast;
+   struct stat inputStat;
+   std::string sTemp = std::string (cName) + ".stripCR";
+   FILE* input = fopen (cName, "rb");
+   if (input == NULL)
+   {
+      std::cerr << "Could not open " << cName << std::endl;
+      return false;
+   }
+   if (fstat (fileno (input), &inputStat) != 0)
+   {
+      std::cerr << "Could not open " << cName << std::endl;
+      fclose (input);
+      return false;
+   }
+   FILE* output = fopen (sTemp.c_str(), "wb");
+   if (output == NULL)
+   {
+      std::cerr << "Could not write " << sTemp << std::endl;
+      fclose (input);
+      return false;
+   }
+   bool bOK = (fchmod (fileno (output), inputStat.st_mode & 07777) == 0)
+      && bStrip (input, output, iLast);
+   if (bOK && iLast != '\n' && iLast != EOF)
+   {
+      bOK = (putc ('\n', output) != EOF);
+   }
+   fclose (input);
+   bOK = (fclose (output) == 0) && bOK;
+   if (!bOK || rename (sTemp.c_str(), cName) != 0)
+   {
+      std::cerr << "Could not rewrite " << cName << std::endl;
+      remove (sTemp.c_str());
+      return false;
+   }
+   return true;
 }
 
+int main (int argc, char* argv[])
+{
+   int iLast;
+   int iStatus = 0;
+   if (argc == 1)
+   {
+      bool bOK = bStrip (stdin, stdout, iLast);
+      putchar ('\n');
+      return bOK ? 0 : 1;
+   }
+   for (int iArg = 1; iArg < argc; iArg++)
+   {
+      if (!bStripFile (argv[iArg]))
+      {
+         iStatus = 1;
+      }
+   }
+   return iStatus;
+}